@@ -1,7 +1,7 @@
 #ifndef H_ANDROIDFILEMANAGER
 #define H_ANDROIDFILEMANAGER
 
-#include "..\\..\\framework\\include\\common.h"
+#include "../../framework/include/common.h"
 #include <android/asset_manager.h>
 
 class CAndroidFileManager final{
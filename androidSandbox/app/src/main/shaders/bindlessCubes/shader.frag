@@ -0,0 +1,19 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+//every texture of the scene in one array (VK_EXT_descriptor_indexing), the object picks its slot with a push constant
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform BindlessTexture {
+    layout(offset = 64) vec4 uvRect; //unused here: no atlas with descriptor indexing
+    uint textureIndex;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[nonuniformEXT(pc.textureIndex)], fragTexCoord);
+}
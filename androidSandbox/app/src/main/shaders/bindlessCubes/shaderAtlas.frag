@@ -0,0 +1,67 @@
+#version 450
+
+//fallback without descriptor indexing: fixed array of atlas pages and large textures.
+//Only constant indices are used, so shaderSampledImageArrayDynamicIndexing is not required.
+layout(set = 1, binding = 0) uniform sampler2D textures[16];
+
+layout(push_constant) uniform BindlessTexture {
+    layout(offset = 64) vec4 uvRect; //scale.xy, offset.xy inside the atlas page; (1,1,0,0) for an own slot
+    uint textureIndex;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+vec4 sampleSlot(uint index, vec2 uv){
+    switch(index){
+        case 0: return texture(textures[0], uv);
+        case 1: return texture(textures[1], uv);
+        case 2: return texture(textures[2], uv);
+        case 3: return texture(textures[3], uv);
+        case 4: return texture(textures[4], uv);
+        case 5: return texture(textures[5], uv);
+        case 6: return texture(textures[6], uv);
+        case 7: return texture(textures[7], uv);
+        case 8: return texture(textures[8], uv);
+        case 9: return texture(textures[9], uv);
+        case 10: return texture(textures[10], uv);
+        case 11: return texture(textures[11], uv);
+        case 12: return texture(textures[12], uv);
+        case 13: return texture(textures[13], uv);
+        case 14: return texture(textures[14], uv);
+        default: return texture(textures[15], uv);
+    }
+}
+
+ivec2 slotSize(uint index){
+    switch(index){
+        case 0: return textureSize(textures[0], 0);
+        case 1: return textureSize(textures[1], 0);
+        case 2: return textureSize(textures[2], 0);
+        case 3: return textureSize(textures[3], 0);
+        case 4: return textureSize(textures[4], 0);
+        case 5: return textureSize(textures[5], 0);
+        case 6: return textureSize(textures[6], 0);
+        case 7: return textureSize(textures[7], 0);
+        case 8: return textureSize(textures[8], 0);
+        case 9: return textureSize(textures[9], 0);
+        case 10: return textureSize(textures[10], 0);
+        case 11: return textureSize(textures[11], 0);
+        case 12: return textureSize(textures[12], 0);
+        case 13: return textureSize(textures[13], 0);
+        case 14: return textureSize(textures[14], 0);
+        default: return textureSize(textures[15], 0);
+    }
+}
+
+void main() {
+    vec2 uv = fragTexCoord;
+    if(pc.uvRect != vec4(1, 1, 0, 0)){
+        //repeat inside the rectangle and keep bilinear taps away from the neighbours
+        vec2 halfTexel = 0.5 / (pc.uvRect.xy * vec2(slotSize(pc.textureIndex)));
+        uv = pc.uvRect.zw + clamp(fract(uv), halfTexel, 1.0 - halfTexel) * pc.uvRect.xy;
+    }
+    outColor = sampleSlot(pc.textureIndex, uv);
+}
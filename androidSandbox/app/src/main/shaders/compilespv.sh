@@ -23,7 +23,11 @@ for entry in */*.comp
 do
     count=$((count+1))
     echo Compile ${entry}
-    glslc.exe ${entry} -o ${entry}.spv
+    if [[ ${entry} == *Subgroup.comp ]]; then
+        glslc.exe --target-env=vulkan1.1 ${entry} -o ${entry}.spv #subgroup operations need SPIR-V 1.3
+    else
+        glslc.exe ${entry} -o ${entry}.spv
+    fi
 done
 echo Total compiled: ${count}
 
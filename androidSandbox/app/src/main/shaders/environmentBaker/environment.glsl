@@ -0,0 +1,63 @@
+//Shared by the environment baking passes (CEnvironmentBaker). Cube outputs are written as 2D arrays, one layer per
+//face in Vulkan order (+X -X +Y -Y +Z -Z), one dispatch per mip level with gl_GlobalInvocationID.z as the face.
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (set = 0, binding = 1, rgba16f) uniform writeonly image2DArray outputImage;
+
+layout (push_constant) uniform Params {
+    int size;           //output level size in texels
+    int sourceMip;      //irradiance: environment level to integrate
+    float roughness;    //prefilter
+    uint sampleCount;
+} params;
+
+const float PI = 3.14159265358979;
+
+//texel center of a face -> direction, same table as the cube sampler (and CCubemapFaces on the CPU)
+vec3 FaceDirection(uint face, ivec2 texel){
+    vec2 uv = 2.0 * (vec2(texel) + 0.5) / float(params.size) - 1.0;
+    vec3 dir;
+    switch(int(face)){
+        case 0: dir = vec3( 1.0, -uv.y, -uv.x); break;
+        case 1: dir = vec3(-1.0, -uv.y,  uv.x); break;
+        case 2: dir = vec3( uv.x,  1.0,  uv.y); break;
+        case 3: dir = vec3( uv.x, -1.0, -uv.y); break;
+        case 4: dir = vec3( uv.x, -uv.y,  1.0); break;
+        default: dir = vec3(-uv.x, -uv.y, -1.0); break;
+    }
+    return normalize(dir);
+}
+
+bool OutOfRange(){
+    return any(greaterThanEqual(ivec2(gl_GlobalInvocationID.xy), ivec2(params.size)));
+}
+
+float RadicalInverse(uint bits){
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10;
+}
+vec2 Hammersley(uint i, uint n){ return vec2(float(i) / float(n), RadicalInverse(i)); }
+
+//GGX importance sample around N, alpha = roughness^2
+vec3 ImportanceSampleGGX(vec2 xi, vec3 N, float roughness){
+    float a = roughness * roughness;
+    float phi = 2.0 * PI * xi.x;
+    float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+    float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+    vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+    vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent = normalize(cross(up, N));
+    vec3 bitangent = cross(N, tangent);
+    return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+float DistributionGGX(float NdotH, float roughness){
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float d = NdotH * NdotH * (a2 - 1.0) + 1.0;
+    return a2 / (PI * d * d);
+}
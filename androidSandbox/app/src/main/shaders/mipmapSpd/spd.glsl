@@ -0,0 +1,120 @@
+//Single pass mip generation, included by shader.comp (shared memory) and shaderSubgroup.comp (quad subgroup operations).
+//Each 256 thread workgroup reduces a 64x64 tile of level 0 down to level 6. The last workgroup of each layer then
+//reduces level 6 (at most 64x64, so level 0 is at most 4096) down to level 12. Layers come from gl_WorkGroupID.z.
+//Images are bound through RGBA8 UNORM storage views; sRGB images are converted to linear here.
+layout (local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+#define MAX_LEVELS 13
+layout (set = 0, binding = 0, rgba8) uniform coherent image2DArray mips[MAX_LEVELS];
+layout (set = 0, binding = 1) coherent buffer Counter { uint counter[]; };
+
+layout (push_constant) uniform Params {
+    ivec2 size;      //level 0
+    uint mipCount;
+    uint groupCount; //workgroups per layer
+    uint bSrgb;
+} params;
+
+shared vec4 sharedTexels[256];
+shared uint sharedIsLast;
+
+vec4 ToLinear(vec4 c){
+    if(params.bSrgb == 0u) return c;
+    return vec4(mix(c.rgb / 12.92, pow((c.rgb + 0.055) / 1.055, vec3(2.4)), greaterThan(c.rgb, vec3(0.04045))), c.a);
+}
+vec4 ToStored(vec4 c){
+    c = clamp(c, 0.0, 1.0);
+    if(params.bSrgb == 0u) return c;
+    return vec4(mix(c.rgb * 12.92, 1.055 * pow(c.rgb, vec3(1.0 / 2.4)) - 0.055, greaterThan(c.rgb, vec3(0.0031308))), c.a);
+}
+
+ivec2 LevelSize(uint level){ return max(params.size >> int(level), ivec2(1)); }
+
+//only levels 0 and 6 are ever read; constant indices keep dynamic indexing features out of the picture
+vec4 Load(uint level, ivec2 p, uint layer){
+    p = min(p, LevelSize(level) - 1);
+    return ToLinear(level == 0u ? imageLoad(mips[0], ivec3(p, layer)) : imageLoad(mips[6], ivec3(p, layer)));
+}
+
+#define STORE_CASE(i) case i: imageStore(mips[i], q, c); break;
+void Store(uint level, ivec2 p, uint layer, vec4 v){
+    if(level >= params.mipCount || any(greaterThanEqual(p, LevelSize(level)))) return;
+    ivec3 q = ivec3(p, layer);
+    vec4 c = ToStored(v);
+    switch(int(level)){
+        STORE_CASE(1) STORE_CASE(2) STORE_CASE(3) STORE_CASE(4) STORE_CASE(5) STORE_CASE(6)
+        STORE_CASE(7) STORE_CASE(8) STORE_CASE(9) STORE_CASE(10) STORE_CASE(11) STORE_CASE(12)
+    }
+}
+
+//thread index -> position in a 16x16 block, Morton order: indices 4k..4k+3 form a 2x2 quad, 16k..16k+15 a 4x4 block
+uvec2 Morton(uint i){
+    uvec2 p = uvec2(i, i >> 1) & 0x55u;
+    p = (p | (p >> 1)) & 0x33u;
+    p = (p | (p >> 2)) & 0x0fu;
+    return p;
+}
+
+//values of threads [0, active) are 2x2 quads in Morton order; afterwards thread k < active/4 holds the mean of quad k
+vec4 ReduceQuad(vec4 v, uint idx, uint active){
+#ifdef SPD_SUBGROUP
+    if(idx < active) v = (v + subgroupQuadSwapHorizontal(v) + subgroupQuadSwapVertical(v) + subgroupQuadSwapDiagonal(v)) * 0.25;
+    barrier();
+    if(idx < active && (idx & 3u) == 0u) sharedTexels[idx >> 2] = v;
+    barrier();
+    if(idx < active / 4u) v = sharedTexels[idx];
+#else
+    barrier();
+    if(idx < active) sharedTexels[idx] = v;
+    barrier();
+    if(idx < active / 4u) v = (sharedTexels[4u * idx] + sharedTexels[4u * idx + 1u] + sharedTexels[4u * idx + 2u] + sharedTexels[4u * idx + 3u]) * 0.25;
+#endif
+    return v;
+}
+
+//levels base+1 .. base+6 of the 64x64 tile at tile (in units of 64 texels of level base)
+void Downsample6(ivec2 tile, uint layer, uint base){
+    uint idx = gl_LocalInvocationIndex;
+    ivec2 t = ivec2(Morton(idx));
+
+    //base+1: each thread writes a 2x2 block from a 4x4 block of base
+    vec4 sum = vec4(0.0);
+    for(int j = 0; j < 2; j++){
+        for(int i = 0; i < 2; i++){
+            ivec2 p1 = t * 2 + ivec2(i, j);
+            ivec2 p0 = tile * 64 + p1 * 2;
+            vec4 v = (Load(base, p0, layer) + Load(base, p0 + ivec2(1, 0), layer) + Load(base, p0 + ivec2(0, 1), layer) + Load(base, p0 + ivec2(1, 1), layer)) * 0.25;
+            Store(base + 1u, tile * 32 + p1, layer, v);
+            sum += v;
+        }
+    }
+
+    //base+2: one texel per thread
+    vec4 v = sum * 0.25;
+    Store(base + 2u, tile * 16 + t, layer, v);
+
+    //base+3 .. base+6: 64, 16, 4, 1 texels
+    uint active = 256u;
+    for(uint level = base + 3u; level <= base + 6u; level++){
+        v = ReduceQuad(v, idx, active);
+        active /= 4u;
+        int tileSize = 64 >> int(level - base);
+        if(idx < active) Store(level, tile * tileSize + ivec2(Morton(idx)), layer, v);
+    }
+}
+
+void main(){
+    uint layer = gl_WorkGroupID.z;
+    Downsample6(ivec2(gl_WorkGroupID.xy), layer, 0u);
+    if(params.mipCount <= 7u) return;
+
+    //make this group's level 6 visible, then let the last group of the layer finish the chain
+    memoryBarrierImage();
+    barrier();
+    if(gl_LocalInvocationIndex == 0u) sharedIsLast = (atomicAdd(counter[layer], 1u) == params.groupCount - 1u) ? 1u : 0u;
+    barrier();
+    if(sharedIsLast == 0u) return;
+    memoryBarrierImage();
+    if(gl_LocalInvocationIndex == 0u) counter[layer] = 0u; //ready for the next dispatch
+    Downsample6(ivec2(0), layer, 6u);
+}
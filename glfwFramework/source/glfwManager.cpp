@@ -54,39 +54,35 @@ void CGLFWManager::GLFWKeyboard(GLFWwindow * window, int key, int scancode, int
 		case GLFW_KEY_LEFT:
 			break;
 		case GLFW_KEY_DOWN: 
-			CApplication::mainCamera.Velocity.y = 1 * keyboard_sensitive;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 1 * keyboard_sensitive);
 			break;
 		case GLFW_KEY_UP: 
-			CApplication::mainCamera.Velocity.y = -1 * keyboard_sensitive;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, -1 * keyboard_sensitive);
 			break;
 		case 'w':
 		case 'W':
-			CApplication::mainCamera.Velocity.z = 1 * keyboard_sensitive;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 1 * keyboard_sensitive);
 			break;
 		case 's':
 		case 'S':
-			CApplication::mainCamera.Velocity.z = -1 * keyboard_sensitive;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, -1 * keyboard_sensitive);
 			break;
 		case 'a':
 		case 'A':
-			CApplication::mainCamera.Velocity.x = 1 * keyboard_sensitive; 
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 1 * keyboard_sensitive); 
 			break;
 		case 'd':
 		case 'D':
-			CApplication::mainCamera.Velocity.x = -1 * keyboard_sensitive; 
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, -1 * keyboard_sensitive); 
 			break;
 
 		case 'f':
 		case 'F':
-			if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) CApplication::mainCamera.cameraType = Camera::CameraType::FREE;
-        	else if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE) CApplication::mainCamera.cameraType = Camera::CameraType::LOCK;
+			CApplication::inputLog.Push(CInputLog::CAMERA_TOGGLE_TYPE);
             break;
 
 		case GLFW_KEY_TAB:
-			if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) {
-				CApplication::focusObjectId += 1;
-				CApplication::focusObjectId = CApplication::focusObjectId % CApplication::objects.size();
-			}
+			CApplication::inputLog.Push(CInputLog::FOCUS_NEXT_OBJECT);
 			break;
 
 		case GLFW_KEY_ESCAPE:
@@ -141,26 +137,26 @@ void CGLFWManager::GLFWKeyboard(GLFWwindow * window, int key, int scancode, int
 		case GLFW_KEY_LEFT:
 			break;
 		case GLFW_KEY_DOWN:
-			CApplication::mainCamera.Velocity.y = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 0);
 			break;
 		case GLFW_KEY_UP:
-			CApplication::mainCamera.Velocity.y = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 0);
 			break;
 		case 'w':
 		case 'W':
-			CApplication::mainCamera.Velocity.z = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 0);
 			break;
 		case 's':
 		case 'S':
-			CApplication::mainCamera.Velocity.z = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 0);
 			break;
 		case 'a':
 		case 'A':
-			CApplication::mainCamera.Velocity.x = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 0);
 			break;
 		case 'd':
 		case 'D':
-			CApplication::mainCamera.Velocity.x = 0;
+			CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 0);
 			break;
 		default:
 			break;
@@ -187,10 +183,7 @@ void CGLFWManager::GLFWMouseMotion(GLFWwindow *window, double xpos, double ypos)
 	lastX = xpos;
 	lastY = ypos;
 
-	if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE){
-        CApplication::mainCamera.AngularVelocity.x = -mouse_sensitive*deltaY;
-        CApplication::mainCamera.AngularVelocity.y = mouse_sensitive*deltaX;
-    }
+	CApplication::inputLog.Push(CInputLog::CAMERA_ANGULAR_VELOCITY, 0, -mouse_sensitive*deltaY, mouse_sensitive*deltaX); //FREE camera only
 
 
 	/* Legacy code
@@ -263,14 +256,7 @@ void CGLFWManager::GLFWMouseButton(GLFWwindow *window, int button, int action, i
 		Ymouse = (int)ypos;
 		ActiveButton |= b;		// set the proper bit
 
-		if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) {
-			CApplication::mainCamera.cameraType = Camera::CameraType::FREE;
-			//std::cout<<"Free Mode"<<std::endl;
-		}
-        else if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE) {
-			CApplication::mainCamera.cameraType = Camera::CameraType::LOCK;
-			//std::cout<<"Lock Mode"<<std::endl;
-		}
+		CApplication::inputLog.Push(CInputLog::CAMERA_TOGGLE_TYPE);
 
 	}
 	else
@@ -282,21 +268,9 @@ void CGLFWManager::GLFWMouseButton(GLFWwindow *window, int button, int action, i
 void CGLFWManager::GLFWMouseScroll(GLFWwindow* window, double xoffset, double yoffset) {
     //std::cout << "Scroll Event: xoffset = " << xoffset << ", yoffset = " << yoffset << std::endl;
 
-	//vertical
-    if (yoffset > 0) {
-        //std::cout << "Scrolled Up" << std::endl;
-        CApplication::mainCamera.MoveForward(1, 2);
-    } else if (yoffset < 0) {
-        //std::cout << "Scrolled Down" << std::endl;
-        CApplication::mainCamera.MoveBackward(1, 2);
-    }
-	//horizontal
-	if (xoffset > 0) {
-		CApplication::mainCamera.MoveRight(1, 2);
-    } else if (xoffset < 0) {
-		CApplication::mainCamera.MoveLeft(1, 2);
-    }
-
+	CApplication::inputLog.Push(CInputLog::CAMERA_WHEEL, 0,
+		xoffset > 0 ? 1.0f : (xoffset < 0 ? -1.0f : 0.0f),
+		yoffset > 0 ? 1.0f : (yoffset < 0 ? -1.0f : 0.0f));
 }
 
 
@@ -1,4 +1,4 @@
-#include "..\\vulkanFramework\\include\\application.h"
+#include "../vulkanFramework/include/application.h"
 #define TEST_CLASS_NAME CSimpleDepthImage
 class TEST_CLASS_NAME: public CApplication{
 public:
@@ -82,7 +82,7 @@ public:
 			objects[i].m_graphics_pipeline_id = 2;
 			objects[i].Draw();
 		}
-		vkCmdNextSubpass(renderer.commandBuffers[renderer.graphicsCmdId][renderer.currentFrame], VK_SUBPASS_CONTENTS_INLINE);
+		renderer.NextSubpass();
 
 		//draw all items with pipeline 0
 		//TODO: pipeline 0 should enable depth test
@@ -92,7 +92,7 @@ public:
 		}
 
 		//TODO: change depth test layout
-		vkCmdNextSubpass(renderer.commandBuffers[renderer.graphicsCmdId][renderer.currentFrame], VK_SUBPASS_CONTENTS_INLINE);
+		renderer.NextSubpass();
 
 		//draw the screen with depthimage as texture with pipeline 1 disable depth test
 		objects[objects.size()-1].Draw();
@@ -108,5 +108,5 @@ public:
 };
 
 #ifndef ANDROID
-#include "..\\vulkanFramework\\include\\main.hpp"
+#include "../vulkanFramework/include/main.hpp"
 #endif
\ No newline at end of file
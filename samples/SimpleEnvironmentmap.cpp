@@ -1,4 +1,4 @@
-#include "..\\vulkanFramework\\include\\application.h"
+#include "../vulkanFramework/include/application.h"
 #define TEST_CLASS_NAME CSimpleEnvironmentmap
 class TEST_CLASS_NAME: public CApplication{
 public:
@@ -44,5 +44,5 @@ public:
 };
 
 #ifndef ANDROID
-#include "..\\vulkanFramework\\include\\main.hpp"
+#include "../vulkanFramework/include/main.hpp"
 #endif
\ No newline at end of file
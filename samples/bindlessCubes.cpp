@@ -0,0 +1,31 @@
+/************
+ * This sample is to test bindless textures: all cubes share one sampler array (set = 1)
+ * and select their texture with a push constant (modified from multiCubes)
+ * feature_graphics_bindless_textures: auto uses descriptor indexing, or the atlas fallback if the device lacks it
+ * *********** */
+
+#include "../vulkanFramework/include/application.h"
+#define TEST_CLASS_NAME CBindlessCubes
+
+class TEST_CLASS_NAME: public CApplication{
+public:
+    void initialize(){
+		CApplication::initialize();
+		PRINT("BindlessCubes: %d slots, %d atlas pages", (int)bindlessTextures.GetSlotCount(), (int)bindlessTextures.GetAtlasPageCount());
+	}
+
+	void update(){
+		objects[0].SetVelocity(0, 3*sin(durationTime * 2), 0);
+		objects[1].SetAngularVelocity(50,0,50); //rotation around x and z axis
+		objects[2].SetVelocity(0, 3*sin(durationTime * 4), 0);
+		CApplication::update();
+	}
+
+	void recordGraphicsCommandBuffer(){
+		for(int i = 0; i < objects.size(); i++) objects[i].Draw();
+	}
+};
+
+#ifndef ANDROID
+#include "../vulkanFramework/include/main.hpp"
+#endif
@@ -0,0 +1,130 @@
+/************
+ * This sample compares the CPU cost of recording draws with the descriptor backends (modified from multiCubes)
+ * Every frame records DRAWS_PER_FRAME draws of the cubes; the average recording time is printed every REPORT_FRAMES frames
+ * Without --descriptor-backend it runs itself once per backend (sets, push, buffer) and prints the results side by side,
+ * with it (sets, push, buffer or auto), or in a regression run (--golden, --capture, --report), only one backend is measured
+ * *********** */
+
+#include "../vulkanFramework/include/application.h"
+#define TEST_CLASS_NAME CDescriptorBackends
+
+class TEST_CLASS_NAME: public CApplication{
+public:
+	static const int DRAWS_PER_FRAME = 10000;
+	static const int REPORT_FRAMES = 100;
+	float recordTime = 0; //milliseconds, since the last report
+	int recordFrames = 0;
+	float totalRecordTime = 0; //milliseconds, every report but the first (warm up)
+	int totalRecordFrames = 0;
+	int drawsPerFrame = 0;
+	bool bWarmedUp = false;
+
+    void initialize(){
+		CApplication::initialize();
+		PRINT("DescriptorBackends: %s", std::string(CDescriptorBackend::GetModeName(CGraphicsDescriptorManager::descriptorBackend.mode)));
+	}
+
+	void update(){
+		for(int i = 0; i < objects.size(); i++) objects[i].SetAngularVelocity(0, 30 * (i + 1), 0);
+		CApplication::update();
+	}
+
+	void recordGraphicsCommandBuffer(){
+		auto startTime = std::chrono::high_resolution_clock::now();
+		int rounds = DRAWS_PER_FRAME / std::max((int)objects.size(), 1);
+		for(int round = 0; round < rounds; round++)
+			for(int i = 0; i < objects.size(); i++) objects[i].Draw();
+		auto endTime = std::chrono::high_resolution_clock::now();
+		recordTime += std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+		drawsPerFrame = rounds * (int)objects.size();
+
+		if(++recordFrames == REPORT_FRAMES){
+			PRINT("DescriptorBackends: %s %d draws, %f ms per frame, %f ns per draw", std::string(CDescriptorBackend::GetModeName(CGraphicsDescriptorManager::descriptorBackend.mode)),
+				drawsPerFrame, recordTime / recordFrames, recordTime * 1000000.0f / (recordFrames * std::max(drawsPerFrame, 1)));
+			if(bWarmedUp){
+				totalRecordTime += recordTime;
+				totalRecordFrames += recordFrames;
+			}
+			bWarmedUp = true;
+			recordTime = 0;
+			recordFrames = 0;
+		}
+	}
+
+	//one line per run: requested backend, backend used, draws per frame, ms per frame, ns per draw
+	void AppendResult(const std::string &path, const std::string &requested){
+		if(totalRecordFrames == 0 && recordFrames > 0){ //shorter than two reports: use what was measured
+			totalRecordTime = recordTime;
+			totalRecordFrames = recordFrames;
+		}
+		std::ofstream file(path, std::ios::app);
+		file<<requested<<" "<<(int)CGraphicsDescriptorManager::descriptorBackend.mode<<" "<<drawsPerFrame<<" "
+			<<(totalRecordFrames ? totalRecordTime / totalRecordFrames : 0)<<" "
+			<<(totalRecordFrames ? totalRecordTime * 1000000.0f / (totalRecordFrames * std::max(drawsPerFrame, 1)) : 0)<<std::endl;
+	}
+};
+
+#ifndef ANDROID
+//[--descriptor-backend sets|push|buffer|auto] [--results file] and the arguments of main.hpp
+int main(int argc, char **argv){
+	std::vector<std::string> args;
+	std::string resultsPath, backendName;
+	bool bSingleRun = false;
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "--results" && i + 1 < argc) resultsPath = argv[++i];
+		else{
+			if(arg == "--descriptor-backend" && i + 1 < argc) backendName = argv[i + 1];
+			if(arg == "--golden" || arg == "--capture" || arg == "--report") bSingleRun = true; //regression runs check one image with the YAML's backend
+			args.push_back(arg);
+		}
+	}
+	bSingleRun = bSingleRun || !backendName.empty();
+
+	if(!bSingleRun){
+		//run every backend in its own process: the framework keeps descriptor state in statics
+		const char *backends[] = {"sets", "push", "buffer"};
+		bool bFramesGiven = std::find(args.begin(), args.end(), "--frames") != args.end();
+		std::string tablePath = "descriptorBackends_results.txt";
+		std::remove(tablePath.c_str());
+		for(const char *backend : backends){
+			std::string command = std::string("\"") + argv[0] + "\" --descriptor-backend " + backend + " --results " + tablePath;
+			if(!bFramesGiven) command += " --frames " + std::to_string(5 * TEST_CLASS_NAME::REPORT_FRAMES);
+			for(auto &arg : args) command += " " + arg;
+			if(std::system(command.c_str()) != 0) std::cerr<<"DescriptorBackends: the "<<backend<<" run failed"<<std::endl;
+		}
+
+		CContext::Init(); //PRINT outside of an application
+		PRINT("DescriptorBackends: %s", std::string("requested   used                draws/frame  ms/frame   ns/draw"));
+		std::ifstream file(tablePath);
+		std::string requested;
+		int mode = 0, draws = 0;
+		float msPerFrame = 0, nsPerDraw = 0;
+		while(file>>requested>>mode>>draws>>msPerFrame>>nsPerDraw){
+			char row[128];
+			snprintf(row, sizeof(row), "%-10s  %-18s  %11d  %8.3f  %8.1f", requested.c_str(), CDescriptorBackend::GetModeName((CDescriptorBackend::Mode)mode), draws, msPerFrame, nsPerDraw);
+			PRINT("DescriptorBackends: %s", std::string(row));
+		}
+		file.close();
+		std::remove(tablePath.c_str());
+		CContext::Quit();
+		return EXIT_SUCCESS;
+	}
+
+	TEST_CLASS_NAME app;
+	app.m_sampleName = TOSTRING(TEST_CLASS_NAME);
+	try {
+		std::vector<char*> appArgv{argv[0]};
+		for(auto &arg : args) appArgv.push_back(&arg[0]);
+		app.ParseCommandLine((int)appArgv.size(), appArgv.data());
+		app.run();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	if(!resultsPath.empty()) app.AppendResult(resultsPath, backendName);
+
+	return app.exitCode;
+}
+#endif
@@ -3,7 +3,7 @@
  * (modified from simpleMSAA, shader to use multiCubes, model to use cube.obj)
  * *********** */
 
-#include "..\\vulkanFramework\\include\\application.h"
+#include "../vulkanFramework/include/application.h"
 #define TEST_CLASS_NAME CMultiCubes
 
 //CApplication CSkyvision::*m_app;
@@ -39,5 +39,5 @@ public:
 };
 
 #ifndef ANDROID
-#include "..\\vulkanFramework\\include\\main.hpp"
+#include "../vulkanFramework/include/main.hpp"
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+/************
+ * This sample measures the asynchronous readback service (modified from basicTriangles)
+ * Every frame requests a copy of a 1080p, then a 4K RGBA8 image; the callback copies the pixels out like an encoder would
+ * After FRAMES_PER_SIZE frames per size, throughput (MB/s), average request-to-delivery latency and dropped requests are printed
+ * Run with --headless to measure without present/vsync; the sample exits after both sizes
+ * *********** */
+
+#include "../vulkanFramework/include/application.h"
+#define TEST_CLASS_NAME CReadbackThroughput
+class TEST_CLASS_NAME: public CApplication{
+public:
+	std::vector<Vertex3D> vertices3D = {
+		{ { -0.5f, 0.5f, 0.0f },{ 1.0f, 0.0f, 0.0f },{ 0.0f, 0.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { -0.5f, -0.5f, 0.0f },{ 0.0f, 1.0f, 0.0f },{ 0.0f, 1.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { 0.5f, 0.5f, 0.0f },{ 0.0f, 0.0f, 1.0f },{ 1.0f, 0.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { 0.5f, -0.5f, 0.0f },{ 1.0f, 1.0f, 1.0f },{ 1.0f, 1.0f } ,{ 0.0f, 0.0f, 1.0f }}
+	};
+	std::vector<uint32_t> indices3D = { 0, 1, 2, 2, 1, 3};
+
+	struct CustomUniformBufferObject {
+		glm::vec3 color;
+
+		static VkDescriptorSetLayoutBinding GetBinding(){
+			VkDescriptorSetLayoutBinding binding;
+			binding.binding = 0;//not important, will be reset
+			binding.descriptorCount = 1;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			binding.pImmutableSamplers = nullptr;
+			binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			return binding;
+		}
+	};
+	CustomUniformBufferObject customUBO{};
+
+	static const int FRAMES_PER_SIZE = 300;
+	const VkExtent2D sizes[2] = {{1920, 1080}, {3840, 2160}};
+	CWxjImageBuffer targets[2];
+	std::vector<uint8_t> encoderInput; //where the callback copies the pixels
+	int sizeId = 0;
+	int frameCount = 0;
+	uint64_t startBytes = 0;
+	uint32_t startDropped = 0;
+	std::chrono::high_resolution_clock::time_point startTime;
+
+	void initialize(){
+		modelManager.CreateCustomModel3D(vertices3D, indices3D); //create the 0th custom model 3D (CUSTOM3D0)
+
+		appInfo.Uniform.GraphicsCustom.Size = sizeof(CustomUniformBufferObject);
+		appInfo.Uniform.GraphicsCustom.Binding = CustomUniformBufferObject::GetBinding();
+		CApplication::initialize();
+
+		//fill the test images with a gradient through the upload service, they stay in GENERAL
+		for(int i = 0; i < 2; i++){
+			targets[i].createImage(sizes[i].width, sizes[i].height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+			std::vector<uint8_t> texels((size_t)sizes[i].width * sizes[i].height * 4);
+			for(size_t p = 0; p < texels.size(); p++) texels[p] = (uint8_t)(p * 7);
+			renderer.uploadService.UploadImage(texels.data(), texels.size(), targets[i].image, sizes[i].width, sizes[i].height, 1, VK_IMAGE_LAYOUT_GENERAL);
+		}
+		renderer.uploadService.Flush();
+		encoderInput.resize((size_t)sizes[1].width * sizes[1].height * 4);
+		maxFrames = 2 * FRAMES_PER_SIZE; //both sizes, also when headless
+		startTime = std::chrono::high_resolution_clock::now();
+	}
+
+	void update(){
+		customUBO.color = {(sin(durationTime) + 1.0f) / 2.0f, 0.0f, (cos(durationTime) + 1.0f) / 2.0f};
+		graphicsDescriptorManager.updateCustomUniformBuffer<CustomUniformBufferObject>(renderer.currentFrame, durationTime, customUBO);
+		CApplication::update();
+	}
+
+	void recordGraphicsCommandBuffer(){
+		objects[0].Draw();
+
+		//recorded by the renderer after the render pass of this frame
+		renderer.readbackService.RequestImage(targets[sizeId].image, VK_IMAGE_LAYOUT_GENERAL, sizes[sizeId].width, sizes[sizeId].height, VK_FORMAT_R8G8B8A8_UNORM,
+			[this](const CReadbackService::Pixels &pixels){
+				memcpy(encoderInput.data(), pixels.data, (size_t)pixels.rowPitch * pixels.height);
+			});
+
+		if(++frameCount < FRAMES_PER_SIZE) return;
+		CReadbackService &service = renderer.readbackService;
+		float seconds = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+		std::cout<<"ReadbackThroughput: "<<sizes[sizeId].width<<"x"<<sizes[sizeId].height<<" "
+			<<(service.readbackBytes - startBytes) / (1024.0 * 1024.0) / seconds<<" MB/s, "
+			<<service.averageLatency<<" ms latency, "<<service.droppedRequests - startDropped<<" dropped"<<std::endl;
+
+		frameCount = 0;
+		startBytes = service.readbackBytes;
+		startDropped = service.droppedRequests;
+		startTime = std::chrono::high_resolution_clock::now();
+		if(++sizeId == 2) NeedToExit = true;
+	}
+
+	~TEST_CLASS_NAME(){
+		renderer.readbackService.Flush(); //nothing may still copy from the targets
+		for(int i = 0; i < 2; i++) targets[i].destroy();
+	}
+};
+
+#ifndef ANDROID
+#include "../vulkanFramework/include/main.hpp"
+#endif
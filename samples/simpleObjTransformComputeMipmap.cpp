@@ -0,0 +1,20 @@
+#include "../vulkanFramework/include/application.h"
+#define TEST_CLASS_NAME CSimpleObjTransformComputeMipmap
+class TEST_CLASS_NAME: public CApplication{
+public:
+    void initialize(){
+		CApplication::initialize();
+	}
+
+	void update(){
+		CApplication::update();
+	}
+
+	void recordGraphicsCommandBuffer(){
+		for(int i = 0; i < objects.size(); i++) objects[i].Draw();
+	}
+};
+
+#ifndef ANDROID
+#include "../vulkanFramework/include/main.hpp"
+#endif
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "..\\vulkanFramework\\include\\application.h"
+#include "../vulkanFramework/include/application.h"
 #include <random>
 #define TEST_CLASS_NAME CSimpleParticles
 class TEST_CLASS_NAME: public CApplication{
@@ -122,7 +122,9 @@ public:
 	}
 
 	void postUpdate(){
-		vkDeviceWaitIdle(CContext::GetHandle().GetLogicalDevice());
+		//no vkDeviceWaitIdle here: the frame scheduler already waits for the frame slot, and idling would stop
+		//the simulation of the next frame from overlapping the rendering of this one
+		//vkDeviceWaitIdle(CContext::GetHandle().GetLogicalDevice());
 
 		//CApplication::update(); //update deltaTime and durationTime (and mainCamera and MVP, VP)
 		//PRINT("update(): Delta Time: %f, Duration Time: %f", deltaTime, durationTime);
@@ -136,6 +138,6 @@ public:
 };
 
 #ifndef ANDROID
-#include "..\\vulkanFramework\\include\\main.hpp"
+#include "../vulkanFramework/include/main.hpp"
 #endif
 
@@ -0,0 +1,29 @@
+#include "../vulkanFramework/include/application.h"
+#define TEST_CLASS_NAME CSimpleTextureStreaming
+class TEST_CLASS_NAME: public CApplication{
+public:
+	std::vector<Vertex3D> vertices3D = {
+		{ { -0.5f, -0.5f, 0.0f },{ 1.0f, 0.0f, 0.0f },{ 1.0f, 0.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { 0.5f, -0.5f, 0.0f },{ 0.0f, 1.0f, 0.0f },{ 0.0f, 0.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { 0.5f, 0.5f, 0.0f },{ 0.0f, 0.0f, 1.0f },{ 0.0f, 1.0f } ,{ 0.0f, 0.0f, 1.0f }},
+		{ { -0.5f, 0.5f, 0.0f },{ 1.0f, 1.0f, 1.0f },{ 1.0f, 1.0f } ,{ 0.0f, 0.0f, 1.0f }}
+	};
+	std::vector<uint32_t> indices3D = { 0, 1, 2, 2, 3, 0};
+
+	void initialize(){
+		modelManager.CreateCustomModel3D(vertices3D, indices3D);
+		CApplication::initialize();
+	}
+
+	void update(){
+		CApplication::update();
+	}
+
+	void recordGraphicsCommandBuffer(){
+		objects[0].Draw();
+	}	
+};
+
+#ifndef ANDROID
+#include "../vulkanFramework/include/main.hpp"
+#endif
\ No newline at end of file
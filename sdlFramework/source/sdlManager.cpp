@@ -60,34 +60,30 @@ void CSDLManager::eventHandle(){
                 //std::cout<<"Key Down"<<event.key.key<<std::endl;
                 switch(event.key.key){ //need 6 directions and 6 turns to translate camera
                     case SDLK_UP:
-                        CApplication::mainCamera.Velocity.y = -1 * keyboard_sensitive;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, -1 * keyboard_sensitive);
                         break;
                     case SDLK_DOWN:
-                        CApplication::mainCamera.Velocity.y = 1 * keyboard_sensitive;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 1 * keyboard_sensitive);
                         break;
                     case SDLK_W:
-                        CApplication::mainCamera.Velocity.z = 1 * keyboard_sensitive;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 1 * keyboard_sensitive);
                         break;
                     case SDLK_S:
-                        CApplication::mainCamera.Velocity.z = -1 * keyboard_sensitive;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, -1 * keyboard_sensitive);
                         break;
                     case SDLK_A:
-                        CApplication::mainCamera.Velocity.x = 1 * keyboard_sensitive; 
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 1 * keyboard_sensitive); 
                         break;
                     case SDLK_D:
-                        CApplication::mainCamera.Velocity.x = -1 * keyboard_sensitive; 
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, -1 * keyboard_sensitive); 
                         break;
 
                     case SDLK_F:
-                        if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) CApplication::mainCamera.cameraType = Camera::CameraType::FREE;
-                        else if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE) CApplication::mainCamera.cameraType = Camera::CameraType::LOCK;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_TOGGLE_TYPE);
                         break;
 
                     case SDLK_TAB:
-                        if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) {
-                            CApplication::focusObjectId += 1;
-                            CApplication::focusObjectId = CApplication::focusObjectId % CApplication::objects.size();
-                        }
+                        CApplication::inputLog.Push(CInputLog::FOCUS_NEXT_OBJECT);
                         break;
 
                     case SDLK_ESCAPE:
@@ -100,30 +96,29 @@ void CSDLManager::eventHandle(){
                 //std::cout<<"Key Up"<<event.key.scancode<<std::endl;
                 switch(event.key.key){
                     case SDLK_UP:
-                        CApplication::mainCamera.Velocity.y = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 0);
                         break;
                     case SDLK_DOWN:
-                        CApplication::mainCamera.Velocity.y = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 1, 0);
                         break;
                     case SDLK_W:
-                        CApplication::mainCamera.Velocity.z = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 0);
                         break;
                     case SDLK_S:
-                        CApplication::mainCamera.Velocity.z = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 2, 0);
                         break;
                     case SDLK_A:
-                        CApplication::mainCamera.Velocity.x = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 0);
                         break;
                     case SDLK_D:
-                        CApplication::mainCamera.Velocity.x = 0;
+                        CApplication::inputLog.Push(CInputLog::CAMERA_VELOCITY, 0, 0);
                         break;
                 }
                 bKeyDown = false;
                 break;
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
                 //std::cout<<"Mouse Down: "<<event.pmotion.x<<", "<<event.pmotion.y<<std::endl;
-                if(CApplication::mainCamera.cameraType == Camera::CameraType::LOCK) CApplication::mainCamera.cameraType = Camera::CameraType::FREE;
-                else if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE) CApplication::mainCamera.cameraType = Camera::CameraType::LOCK;
+                CApplication::inputLog.Push(CInputLog::CAMERA_TOGGLE_TYPE);
                 //bMouseDown = true;
                 break;
             case SDL_EVENT_MOUSE_BUTTON_UP:
@@ -134,10 +129,10 @@ void CSDLManager::eventHandle(){
                 ref_diff_y = mouse_sensitive*event.motion.xrel;
                 break;
             case SDL_EVENT_MOUSE_WHEEL:
-                if(event.wheel.x == 1) CApplication::mainCamera.MoveLeft(1, 2);
-                else if(event.wheel.x == -1) CApplication::mainCamera.MoveRight(1, 2);
-                if(event.wheel.y == 1) CApplication::mainCamera.MoveForward(1, 2);
-                else if(event.wheel.y == -1) CApplication::mainCamera.MoveBackward(1, 2);
+                //x > 0 moves right: SDL's horizontal wheel is mirrored
+                CApplication::inputLog.Push(CInputLog::CAMERA_WHEEL, 0,
+                    event.wheel.x == 1 ? -1.0f : (event.wheel.x == -1 ? 1.0f : 0.0f),
+                    event.wheel.y == 1 ? 1.0f : (event.wheel.y == -1 ? -1.0f : 0.0f));
                 break;
 
             case SDL_EVENT_QUIT:
@@ -149,10 +144,5 @@ void CSDLManager::eventHandle(){
         }
     }
     //std::cout<<"ref: "<<ref_diff_x<<", "<<ref_diff_y<<std::endl;
-    if(CApplication::mainCamera.cameraType == Camera::CameraType::FREE){
-        CApplication::mainCamera.AngularVelocity.x = ref_diff_x;
-        CApplication::mainCamera.AngularVelocity.y = ref_diff_y;
-    }
-
-    SDL_Delay(1);//delay 1ms. otherwise it could run millians of times per second
+    CApplication::inputLog.Push(CInputLog::CAMERA_ANGULAR_VELOCITY, 0, (float)ref_diff_x, (float)ref_diff_y); //FREE camera only
 }
\ No newline at end of file
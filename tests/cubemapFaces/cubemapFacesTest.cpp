@@ -0,0 +1,109 @@
+/*******************
+*	cubemapFacesTest: checks CCubemapFaces against the layouts it documents, CPU only
+*
+*	Cross: every texel of every extracted face is compared with the texel of its cell in the 4x3 cross
+*	(up above front; left, front, right, back in the middle row; bottom below front), for 1 and 4 threads,
+*	4 and 8 bytes per texel and cross sizes that do not split into whole rows per thread.
+*	Half: exact values survive FloatToHalf/HalfToFloat, and rounding goes to nearest even.
+*	Equirect: a source that is bright above the horizon and dark below gives a bright up face and a dark bottom face.
+*
+*	cubemapFacesTest (exit code 1 if a check fails)
+********************/
+#include "../../vulkanFramework/include/cubemapFaces.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static int failures = 0;
+
+static void Check(bool bPass, const std::string &what){
+    if(bPass) return;
+    if(failures < 20) std::cout<<"FAILED: "<<what<<std::endl;
+    failures++;
+}
+
+//every byte of a texel is derived from its cross position, so a texel copied from the wrong place can't match
+static uint8_t CrossByte(uint32_t x, uint32_t y, uint32_t byte){
+    return (uint8_t)(x * 7 + y * 131 + byte * 29 + (x >> 8) * 3 + (y >> 8) * 5);
+}
+
+static void TestCross(uint32_t crossWidth, uint32_t crossHeight, uint32_t bytesPerTexel, unsigned threads){
+    std::vector<uint8_t> cross((size_t)crossWidth * crossHeight * bytesPerTexel);
+    for(uint32_t y = 0; y < crossHeight; y++)
+        for(uint32_t x = 0; x < crossWidth; x++)
+            for(uint32_t b = 0; b < bytesPerTexel; b++)
+                cross[((size_t)y * crossWidth + x) * bytesPerTexel + b] = CrossByte(x, y, b);
+
+    std::vector<uint8_t> faces;
+    CCubemapFaces::ExtractFromCross(cross.data(), crossWidth, crossHeight, bytesPerTexel, faces, threads);
+
+    uint32_t faceWidth = crossWidth / 4, faceHeight = crossHeight / 3;
+    std::string name = std::to_string(crossWidth) + "x" + std::to_string(crossHeight) + ", " + std::to_string(bytesPerTexel)
+        + " bytes, " + std::to_string(threads) + " threads";
+    Check(faces.size() == (size_t)faceWidth * faceHeight * bytesPerTexel * CCubemapFaces::FACE_COUNT, "face size, " + name);
+    if(faces.size() != (size_t)faceWidth * faceHeight * bytesPerTexel * CCubemapFaces::FACE_COUNT) return;
+
+    //cell (column, row) of each layer, written out from the cross drawing rather than copied from the implementation
+    struct { int face; uint32_t column, row; } cells[] = {
+        {CCubemapFaces::FACE_UP, 1, 0},
+        {CCubemapFaces::FACE_LEFT, 0, 1}, {CCubemapFaces::FACE_FRONT, 1, 1}, {CCubemapFaces::FACE_RIGHT, 2, 1}, {CCubemapFaces::FACE_BACK, 3, 1},
+        {CCubemapFaces::FACE_BOTTOM, 1, 2}};
+    for(auto &cell : cells){
+        size_t mismatches = 0;
+        const uint8_t *face = faces.data() + (size_t)cell.face * faceWidth * faceHeight * bytesPerTexel;
+        for(uint32_t y = 0; y < faceHeight; y++)
+            for(uint32_t x = 0; x < faceWidth; x++)
+                for(uint32_t b = 0; b < bytesPerTexel; b++)
+                    if(face[((size_t)y * faceWidth + x) * bytesPerTexel + b] != CrossByte(cell.column * faceWidth + x, cell.row * faceHeight + y, b)) mismatches++;
+        Check(mismatches == 0, std::string(CCubemapFaces::GetFaceName(cell.face)) + " face, " + name + ": " + std::to_string(mismatches) + " bytes differ");
+    }
+}
+
+static void TestHalf(){
+    const float exact[] = {0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 65504.0f, 0.000061035156f, 0.000000059604645f, 1.5f, 1000.0f};
+    for(float value : exact){
+        float back = CCubemapFaces::HalfToFloat(CCubemapFaces::FloatToHalf(value));
+        Check(back == value && std::signbit(back) == std::signbit(value), "half round trip of " + std::to_string(value));
+    }
+    Check(CCubemapFaces::FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3c00, "half rounds a tie to even (down)");
+    Check(CCubemapFaces::FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3c02, "half rounds a tie to even (up)");
+    Check(CCubemapFaces::FloatToHalf(100000.0f) == 0x7c00, "half overflow is infinity");
+    Check(std::isnan(CCubemapFaces::HalfToFloat(CCubemapFaces::FloatToHalf(NAN))), "half keeps nan");
+}
+
+static void TestEquirect(){
+    const uint32_t width = 64, height = 32, faceSize = 8;
+    std::vector<float> rgba((size_t)width * height * 4);
+    for(uint32_t y = 0; y < height; y++)
+        for(uint32_t x = 0; x < width; x++)
+            for(int c = 0; c < 4; c++) rgba[((size_t)y * width + x) * 4 + c] = (y < height / 2) ? 1.0f : 0.0f;
+
+    std::vector<uint8_t> faces;
+    CCubemapFaces::FromEquirect(rgba.data(), width, height, faceSize, faces, 1);
+    const uint16_t *texels = reinterpret_cast<const uint16_t*>(faces.data());
+    size_t faceTexels = (size_t)faceSize * faceSize;
+    float upMin = 1.0f, bottomMax = 0.0f;
+    for(size_t i = 0; i < faceTexels * 4; i++){
+        upMin = std::min(upMin, CCubemapFaces::HalfToFloat(texels[CCubemapFaces::FACE_UP * faceTexels * 4 + i]));
+        bottomMax = std::max(bottomMax, CCubemapFaces::HalfToFloat(texels[CCubemapFaces::FACE_BOTTOM * faceTexels * 4 + i]));
+    }
+    Check(upMin == 1.0f, "equirect: up face is the upper half of the source");
+    Check(bottomMax == 0.0f, "equirect: bottom face is the lower half of the source");
+}
+
+int main(){
+    const uint32_t sizes[][2] = {{4, 3}, {64, 48}, {100, 75}, {1024, 768}};
+    for(auto &size : sizes)
+        for(uint32_t bytesPerTexel : {4u, 8u})
+            for(unsigned threads : {1u, 4u})
+                TestCross(size[0], size[1], bytesPerTexel, threads);
+    TestHalf();
+    TestEquirect();
+
+    if(failures == 0) std::cout<<"cubemapFacesTest: passed"<<std::endl;
+    else std::cout<<"cubemapFacesTest: "<<failures<<" checks FAILED"<<std::endl;
+    return failures == 0 ? 0 : 1;
+}
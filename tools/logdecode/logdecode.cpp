@@ -0,0 +1,158 @@
+/*******************
+*	logdecode: renders a binary log (--binary-log) as text
+*
+*	The samples write only a call site id, a timestamp and the raw arguments of a binary log call into a ring of a
+*	memory mapped file; the format strings are in the call site table of the same file. logdecode reads the records
+*	that are still in the ring, oldest first, and formats them with the formatter of the text log (CLogFormat).
+*	A record that was being written when the process stopped, or that was partly overwritten by the ring, does not
+*	match its position and is skipped (counted in the summary).
+*
+*	logdecode <log.blog> [-o out.txt] [--sites]
+********************/
+#include "../../vulkanFramework/include/logFormat.h"
+
+#include <stdio.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+struct Site{
+    CLogFormat::BinarySite entry;
+    std::string file;
+    std::string format;
+    std::string signature;
+};
+
+static bool ReadFile(const std::string &path, std::vector<uint8_t> &data){
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file.is_open()) return false;
+    data.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read((char*)data.data(), data.size());
+    return (bool)file;
+}
+
+static bool ReadSites(const std::vector<uint8_t> &data, const CLogFormat::BinaryHeader &header, std::vector<Site> &sites){
+    const uint8_t *table = data.data() + header.headerSize;
+    uint64_t offset = 0;
+    while(offset + sizeof(CLogFormat::BinarySite) <= header.siteTableUsed){
+        Site site;
+        memcpy(&site.entry, table + offset, sizeof(site.entry));
+        if(site.entry.size < sizeof(site.entry) || offset + site.entry.size > header.siteTableUsed || site.entry.id != sites.size()) return false;
+        const char *strings = (const char*)table + offset + sizeof(site.entry);
+        const char *end = (const char*)table + offset + site.entry.size;
+        site.file = std::string(strings, strnlen(strings, end - strings));
+        strings += site.file.size() + 1;
+        site.format = strings < end ? std::string(strings, strnlen(strings, end - strings)) : "";
+        strings += site.format.size() + 1;
+        site.signature = strings < end ? std::string(strings, strnlen(strings, end - strings)) : "";
+        sites.push_back(site);
+        offset += site.entry.size;
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+    std::string inputPath, outputPath;
+    bool bSites = false;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "-o" && i + 1 < argc) outputPath = argv[++i];
+        else if(arg == "--sites") bSites = true;
+        else if(inputPath.empty()) inputPath = arg;
+        else{
+            std::cout<<"Unknown argument: "<<arg<<std::endl;
+            return 2;
+        }
+    }
+    if(inputPath.empty()){
+        std::cout<<"usage: logdecode <log.blog> [-o out.txt] [--sites]"<<std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if(!ReadFile(inputPath, data)){
+        std::cout<<"logdecode: could not read "<<inputPath<<std::endl;
+        return 1;
+    }
+    CLogFormat::BinaryHeader header;
+    if(data.size() < sizeof(header)){
+        std::cout<<"logdecode: "<<inputPath<<" is not a binary log"<<std::endl;
+        return 1;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if(memcmp(header.magic, "VKBLOG1", 8) != 0 || header.version != CLogFormat::BINARY_VERSION
+        || header.ringSize == 0 || (header.ringSize & (header.ringSize - 1)) != 0
+        || header.headerSize + header.siteTableSize + header.ringSize > data.size() || header.siteTableUsed > header.siteTableSize){
+        std::cout<<"logdecode: "<<inputPath<<" is not a binary log of version "<<CLogFormat::BINARY_VERSION<<std::endl;
+        return 1;
+    }
+
+    std::vector<Site> sites;
+    if(!ReadSites(data, header, sites)) std::cout<<"logdecode: call site table is damaged, read "<<sites.size()<<" sites"<<std::endl;
+
+    std::ofstream outputFile;
+    if(!outputPath.empty()){
+        outputFile.open(outputPath);
+        if(!outputFile.is_open()){
+            std::cout<<"logdecode: could not open "<<outputPath<<std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : outputFile;
+
+    if(bSites){
+        for(auto &site : sites)
+            out<<site.entry.id<<": "<<site.file<<":"<<site.entry.line<<" "<<CLogFormat::GetLevelName((LogLevel)site.entry.level)<<" "
+                <<CLogFormat::GetCategoryName((LogCategory)site.entry.category)<<" ("<<site.signature<<") \""<<site.format<<"\"\n";
+    }
+
+    //records are 8 byte aligned: walk from the oldest byte still in the ring, resynchronize on the next record that matches its position
+    const uint8_t *ring = data.data() + header.headerSize + header.siteTableSize;
+    uint64_t mask = header.ringSize - 1;
+    uint64_t end = header.writeOffset;
+    uint64_t position = end > header.ringSize ? end - header.ringSize : 0;
+    uint64_t records = 0, skippedBytes = 0;
+    std::vector<uint8_t> payload;
+    std::vector<CLogFormat::Arg> args;
+    auto copy = [&](uint64_t from, void *to, size_t size){
+        size_t start = (size_t)(from & mask);
+        size_t first = std::min(size, (size_t)(header.ringSize - start));
+        memcpy(to, ring + start, first);
+        if(first < size) memcpy((uint8_t*)to + first, ring, size - first);
+    };
+    char prefix[128];
+    while(position + sizeof(CLogFormat::BinaryRecord) <= end){
+        CLogFormat::BinaryRecord record;
+        copy(position, &record, sizeof(record));
+        bool bValid = record.offset == position && record.size >= sizeof(record) && record.size % 8 == 0
+            && position + record.size <= end && record.size <= header.ringSize && record.site < sites.size();
+        if(bValid){
+            const Site &site = sites[record.site];
+            payload.resize(record.size - sizeof(record));
+            copy(position + sizeof(record), payload.data(), payload.size());
+            args.clear();
+            bValid = CLogFormat::DecodeArgs(site.signature.c_str(), payload.data(), payload.size(), args);
+            if(bValid){
+                double ms = (double)(int64_t)(record.ticks - header.baseTicks) / header.ticksPerMicrosecond / 1000.0;
+                snprintf(prefix, sizeof(prefix), "[%12.3f %s %s] ", ms, CLogFormat::GetLevelName((LogLevel)site.entry.level),
+                    CLogFormat::GetCategoryName((LogCategory)site.entry.category));
+                out<<prefix<<CLogFormat::Format(site.format, args)<<"\n";
+                records++;
+                position += record.size;
+                continue;
+            }
+        }
+        skippedBytes += 8;
+        position += 8;
+    }
+
+    std::cout<<"logdecode: "<<records<<" records, "<<sites.size()<<" call sites";
+    if(end > header.ringSize) std::cout<<", "<<(end - header.ringSize)<<" older bytes overwritten by the ring";
+    if(skippedBytes) std::cout<<", "<<skippedBytes<<" bytes of incomplete or overwritten records skipped";
+    if(header.droppedRecords) std::cout<<", "<<header.droppedRecords<<" records dropped by the process";
+    std::cout<<std::endl;
+    return 0;
+}
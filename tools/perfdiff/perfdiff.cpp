@@ -0,0 +1,140 @@
+/*******************
+*	perfdiff: compares sample reports of two regression runs (CPU only)
+*
+*	The samples write a flat JSON report with --report (init, CPU frame and GPU queue times, golden image status).
+*	perfdiff matches the reports of a baseline run and a current run by sample name and prints every *_ms metric.
+*	A metric regresses when it grows by more than the threshold (relative) and by more than 0.05 ms (absolute,
+*	so tiny timings do not flicker). A failed golden image comparison is a regression too.
+*	The exit code is 1 when anything regressed, so a script or CI job can stop on it, and 3 when the baseline does not exist
+*	(nothing to compare, ctest reports the test as skipped).
+*
+*	perfdiff <baseline.json|dir> <current.json|dir> [--threshold 0.10]
+********************/
+#include <stdio.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+struct Report{
+    std::string sample;
+    std::string golden = "none";
+    std::map<std::string, double> metrics; //all numeric values
+};
+
+//the reports are flat: one "key": value per line, no nesting
+static bool ParseReport(const fs::path &path, Report &report){
+    std::ifstream file(path);
+    if(!file.is_open()) return false;
+    std::stringstream stream;
+    stream<<file.rdbuf();
+    std::string text = stream.str();
+
+    size_t pos = 0;
+    while((pos = text.find('"', pos)) != std::string::npos){
+        size_t keyEnd = text.find('"', pos + 1);
+        if(keyEnd == std::string::npos) break;
+        std::string key = text.substr(pos + 1, keyEnd - pos - 1);
+        size_t colon = text.find(':', keyEnd);
+        if(colon == std::string::npos) break;
+        size_t valueStart = text.find_first_not_of(" \t\r\n", colon + 1);
+        if(valueStart == std::string::npos) break;
+        if(text[valueStart] == '"'){
+            size_t valueEnd = text.find('"', valueStart + 1);
+            if(valueEnd == std::string::npos) break;
+            std::string value = text.substr(valueStart + 1, valueEnd - valueStart - 1);
+            if(key == "sample") report.sample = value;
+            else if(key == "golden") report.golden = value;
+            pos = valueEnd + 1;
+        }else{
+            size_t valueEnd = text.find_first_of(",}\r\n", valueStart);
+            report.metrics[key] = atof(text.substr(valueStart, valueEnd - valueStart).c_str());
+            pos = valueEnd;
+        }
+    }
+    if(report.sample.empty()) report.sample = path.stem().string();
+    return true;
+}
+
+static void CollectReports(const fs::path &path, std::map<std::string, Report> &reports){
+    std::vector<fs::path> files;
+    if(fs::is_directory(path)){
+        for(auto &entry : fs::directory_iterator(path))
+            if(entry.is_regular_file() && entry.path().extension() == ".json") files.push_back(entry.path());
+    }else files.push_back(path);
+
+    for(auto &file : files){
+        Report report;
+        if(ParseReport(file, report)) reports[report.sample] = report;
+        else std::cout<<"perfdiff: could not read "<<file.string()<<std::endl;
+    }
+}
+
+static bool EndsWith(const std::string &text, const std::string &suffix){
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char **argv){
+    std::vector<std::string> paths;
+    double threshold = 0.10;
+    const double minimumDelta = 0.05; //ms
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]);
+        else if(arg == "--help" || arg == "-h"){
+            std::cout<<"perfdiff <baseline.json|dir> <current.json|dir> [--threshold 0.10]"<<std::endl;
+            return 0;
+        }else paths.push_back(arg);
+    }
+    if(paths.size() != 2){
+        std::cout<<"perfdiff <baseline.json|dir> <current.json|dir> [--threshold 0.10]"<<std::endl;
+        return 2;
+    }
+
+    if(!fs::exists(paths[0])){
+        std::cout<<"perfdiff: no baseline at "<<paths[0]<<" (copy the reports of a known good run there)"<<std::endl;
+        return 3;
+    }
+
+    std::map<std::string, Report> baseline, current;
+    CollectReports(paths[0], baseline);
+    CollectReports(paths[1], current);
+
+    int regressions = 0;
+    for(auto &entry : current){
+        const Report &now = entry.second;
+        std::cout<<now.sample<<std::endl;
+        if(now.golden == "fail"){
+            std::cout<<"    golden image                 FAILED"<<std::endl;
+            regressions++;
+        }
+        auto before = baseline.find(entry.first);
+        if(before == baseline.end()){
+            std::cout<<"    no baseline"<<std::endl;
+            continue;
+        }
+        for(auto &metric : now.metrics){
+            if(!EndsWith(metric.first, "_ms")) continue;
+            auto old = before->second.metrics.find(metric.first);
+            if(old == before->second.metrics.end()) continue;
+            double delta = metric.second - old->second;
+            double relative = old->second > 0 ? delta / old->second : 0;
+            bool bRegressed = delta > minimumDelta && relative > threshold;
+            if(bRegressed) regressions++;
+            printf("    %-24s %10.3f -> %10.3f ms  %+7.1f%%%s\n", metric.first.c_str(), old->second, metric.second,
+                relative * 100.0, bRegressed ? "  REGRESSION" : "");
+        }
+    }
+    for(auto &entry : baseline)
+        if(current.find(entry.first) == current.end()) std::cout<<entry.first<<std::endl<<"    missing in the current run"<<std::endl;
+
+    std::cout<<"perfdiff: "<<current.size()<<" reports, "<<regressions<<" regressions (threshold "<<threshold * 100.0<<"%)"<<std::endl;
+    return regressions > 0 ? 1 : 0;
+}
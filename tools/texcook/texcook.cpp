@@ -0,0 +1,509 @@
+/*******************
+*	texcook: offline texture cooking (CPU only, no window or GPU needed)
+*
+*	Reads the textures referenced by the sample YAML files (or images given on the command line) and writes, per texture,
+*	a KTX2 file with the precomputed mip chain: sRGB data is filtered in linear space, 16 bit data as UNORM.
+*	Optional BC1/BC3 compression, 4x3 cross cubemaps are split into 6 faces. A manifest.yaml lists what was cooked.
+*	CTextureManager loads <texture dir>/cooked/<name>.ktx2 instead of the source when it is newer than the source.
+*
+*	texcook [--yaml <dir>] [--input <dir>] [--output <dir>] [--compress] [--threads N] [--mips N] [image ...]
+********************/
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../thirdparty/stb_image.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "../../thirdparty/yaml-cpp/yaml.h"
+
+namespace fs = std::filesystem;
+
+//VkFormat values written to the KTX2 header (the tool does not include Vulkan)
+enum CookFormat : uint32_t {
+    FORMAT_R8G8B8A8_UNORM = 37,
+    FORMAT_R8G8B8A8_SRGB = 43,
+    FORMAT_R16G16B16A16_UNORM = 91,
+    FORMAT_BC1_RGB_UNORM = 131,
+    FORMAT_BC1_RGB_SRGB = 132,
+    FORMAT_BC3_UNORM = 137,
+    FORMAT_BC3_SRGB = 138,
+};
+
+struct CookJob{
+    std::string name;       //relative to the input directory, as written in the YAML
+    int mipLevels = 0;      //0: full chain
+    bool bCubemap = false;
+    bool b16Bit = false;
+};
+
+struct CookResult{
+    std::string name;
+    std::string cooked;
+    uint32_t format;
+    int width, height, mipLevels, faces;
+    uint64_t sourceBytes, cookedBytes;
+    float milliseconds;
+};
+
+struct Options{
+    std::string yamlDir = "../samples/yaml/";
+    std::string inputDir = "../androidSandbox/app/src/main/assets/textures/";
+    std::string outputDir; //default: <input>/cooked/
+    bool bCompress = false;
+    bool bLinear = false; //treat 8 bit input as UNORM instead of sRGB
+    int threads = 0;
+    int mipLevels = 0;
+    std::vector<std::string> images;
+};
+
+/*******************
+*	Image
+********************/
+//one face, RGBA, float in linear space (8 bit sRGB is decoded, 16 bit is UNORM)
+struct Image{
+    int width = 0, height = 0;
+    std::vector<float> texels;
+};
+
+static float SrgbToLinear(float c){ return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f); }
+static float LinearToSrgb(float c){ return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f; }
+
+//2x2 box filter in linear space, odd sizes clamp the last row/column
+static Image Downsample(const Image &src){
+    Image dst;
+    dst.width = std::max(src.width / 2, 1);
+    dst.height = std::max(src.height / 2, 1);
+    dst.texels.resize((size_t)dst.width * dst.height * 4);
+    for(int y = 0; y < dst.height; y++){
+        int y0 = std::min(2 * y, src.height - 1), y1 = std::min(2 * y + 1, src.height - 1);
+        for(int x = 0; x < dst.width; x++){
+            int x0 = std::min(2 * x, src.width - 1), x1 = std::min(2 * x + 1, src.width - 1);
+            for(int c = 0; c < 4; c++){
+                float sum = src.texels[((size_t)y0 * src.width + x0) * 4 + c] + src.texels[((size_t)y0 * src.width + x1) * 4 + c]
+                          + src.texels[((size_t)y1 * src.width + x0) * 4 + c] + src.texels[((size_t)y1 * src.width + x1) * 4 + c];
+                dst.texels[((size_t)y * dst.width + x) * 4 + c] = sum * 0.25f;
+            }
+        }
+    }
+    return dst;
+}
+
+static std::vector<uint8_t> ToRGBA8(const Image &image, bool bSrgb){
+    std::vector<uint8_t> out(image.texels.size());
+    for(size_t i = 0; i < image.texels.size(); i++){
+        float c = std::min(std::max(image.texels[i], 0.0f), 1.0f);
+        if(bSrgb && (i & 3) != 3) c = LinearToSrgb(c); //alpha is always linear
+        out[i] = (uint8_t)(c * 255.0f + 0.5f);
+    }
+    return out;
+}
+
+static std::vector<uint8_t> ToRGBA16(const Image &image){
+    std::vector<uint8_t> out(image.texels.size() * 2);
+    for(size_t i = 0; i < image.texels.size(); i++){
+        uint16_t c = (uint16_t)(std::min(std::max(image.texels[i], 0.0f), 1.0f) * 65535.0f + 0.5f);
+        memcpy(out.data() + i * 2, &c, 2);
+    }
+    return out;
+}
+
+/*******************
+*	BC1/BC3 encoder (bounding box endpoints, nearest palette entry)
+********************/
+static uint16_t To565(const float *rgb){
+    int r = (int)(std::min(std::max(rgb[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    int g = (int)(std::min(std::max(rgb[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+    int b = (int)(std::min(std::max(rgb[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void EncodeColorBlock(const uint8_t texels[16][4], uint8_t *block){
+    float minColor[3] = {255, 255, 255}, maxColor[3] = {0, 0, 0};
+    for(int i = 0; i < 16; i++) for(int c = 0; c < 3; c++){
+        minColor[c] = std::min(minColor[c], (float)texels[i][c]);
+        maxColor[c] = std::max(maxColor[c], (float)texels[i][c]);
+    }
+    for(int c = 0; c < 3; c++){ //inset the box a little, the extremes are rarely hit exactly
+        float inset = (maxColor[c] - minColor[c]) / 16.0f;
+        minColor[c] += inset;
+        maxColor[c] -= inset;
+    }
+    uint16_t c0 = To565(maxColor), c1 = To565(minColor);
+    if(c0 < c1) std::swap(c0, c1);
+
+    //palette exactly as the decoder builds it
+    int palette[4][3];
+    auto expand = [](uint16_t c, int *rgb){ rgb[0] = ((c >> 11) & 31) * 255 / 31; rgb[1] = ((c >> 5) & 63) * 255 / 63; rgb[2] = (c & 31) * 255 / 31; };
+    expand(c0, palette[0]);
+    expand(c1, palette[1]);
+    for(int c = 0; c < 3; c++){
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if(c0 != c1){ //c0 == c1 would select the 3 color mode, index 0 everywhere is correct there
+        for(int i = 0; i < 16; i++){
+            int best = 0, bestDistance = INT32_MAX;
+            for(int p = 0; p < 4; p++){
+                int dr = texels[i][0] - palette[p][0], dg = texels[i][1] - palette[p][1], db = texels[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if(distance < bestDistance){ bestDistance = distance; best = p; }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    block[0] = c0 & 0xff; block[1] = c0 >> 8;
+    block[2] = c1 & 0xff; block[3] = c1 >> 8;
+    block[4] = indices & 0xff; block[5] = (indices >> 8) & 0xff; block[6] = (indices >> 16) & 0xff; block[7] = indices >> 24;
+}
+
+static void EncodeAlphaBlock(const uint8_t texels[16][4], uint8_t *block){
+    int a0 = 0, a1 = 255;
+    for(int i = 0; i < 16; i++){ a0 = std::max(a0, (int)texels[i][3]); a1 = std::min(a1, (int)texels[i][3]); }
+    int palette[8] = {a0, a1};
+    for(int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+    uint64_t indices = 0;
+    if(a0 != a1){ //a0 == a1 would select the 6 value mode, index 0 everywhere is correct there
+        for(int i = 0; i < 16; i++){
+            int best = 0, bestDistance = INT32_MAX;
+            for(int p = 0; p < 8; p++){
+                int distance = std::abs(texels[i][3] - palette[p]);
+                if(distance < bestDistance){ bestDistance = distance; best = p; }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    block[0] = (uint8_t)a0;
+    block[1] = (uint8_t)a1;
+    for(int i = 0; i < 6; i++) block[2 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+static std::vector<uint8_t> CompressBC(const std::vector<uint8_t> &rgba, int width, int height, bool bAlpha){
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockSize = bAlpha ? 16 : 8;
+    std::vector<uint8_t> out((size_t)blocksX * blocksY * blockSize);
+    for(int by = 0; by < blocksY; by++){
+        for(int bx = 0; bx < blocksX; bx++){
+            uint8_t texels[16][4];
+            for(int y = 0; y < 4; y++) for(int x = 0; x < 4; x++){
+                int sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+                memcpy(texels[y * 4 + x], rgba.data() + ((size_t)sy * width + sx) * 4, 4);
+            }
+            uint8_t *block = out.data() + ((size_t)by * blocksX + bx) * blockSize;
+            if(bAlpha){
+                EncodeAlphaBlock(texels, block);
+                EncodeColorBlock(texels, block + 8);
+            }else EncodeColorBlock(texels, block);
+        }
+    }
+    return out;
+}
+
+/*******************
+*	KTX2 writer
+********************/
+static void Append32(std::vector<uint8_t> &out, uint32_t value){ for(int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i))); }
+static void Append64(std::vector<uint8_t> &out, uint64_t value){ for(int i = 0; i < 8; i++) out.push_back((uint8_t)(value >> (8 * i))); }
+
+//Basic data format descriptor, one block
+static std::vector<uint8_t> BuildDFD(uint32_t format){
+    struct Sample{ uint32_t bitOffset, bitLength, channelType, lower, upper; };
+    const uint32_t LINEAR_QUALIFIER = 0x10;
+    uint32_t colorModel = 1, transfer = 1, blockDimension = 0, bytesPlane0 = 4;
+    std::vector<Sample> samples;
+    bool bSrgb = (format == FORMAT_R8G8B8A8_SRGB || format == FORMAT_BC1_RGB_SRGB || format == FORMAT_BC3_SRGB);
+    if(bSrgb) transfer = 2;
+    uint32_t alphaChannel = 15 | (bSrgb ? LINEAR_QUALIFIER : 0);
+    switch(format){
+        case FORMAT_R8G8B8A8_UNORM: case FORMAT_R8G8B8A8_SRGB:
+            samples = {{0, 7, 0, 0, 255}, {8, 7, 1, 0, 255}, {16, 7, 2, 0, 255}, {24, 7, alphaChannel, 0, 255}};
+        break;
+        case FORMAT_R16G16B16A16_UNORM:
+            bytesPlane0 = 8;
+            samples = {{0, 15, 0, 0, 65535}, {16, 15, 1, 0, 65535}, {32, 15, 2, 0, 65535}, {48, 15, 15, 0, 65535}};
+        break;
+        case FORMAT_BC1_RGB_UNORM: case FORMAT_BC1_RGB_SRGB:
+            colorModel = 128; blockDimension = 0x0303; bytesPlane0 = 8;
+            samples = {{0, 63, 0, 0, 0xffffffff}};
+        break;
+        default: //BC3
+            colorModel = 130; blockDimension = 0x0303; bytesPlane0 = 16;
+            samples = {{0, 63, alphaChannel, 0, 0xffffffff}, {64, 63, 0, 0, 0xffffffff}};
+        break;
+    }
+    std::vector<uint8_t> dfd;
+    uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+    Append32(dfd, 4 + blockSize);          //dfdTotalSize
+    Append32(dfd, 0);                      //vendorId, descriptorType
+    Append32(dfd, 2 | (blockSize << 16));  //versionNumber, descriptorBlockSize
+    Append32(dfd, colorModel | (1 << 8) | (transfer << 16)); //BT709 primaries, straight alpha
+    Append32(dfd, blockDimension);
+    Append32(dfd, bytesPlane0);
+    Append32(dfd, 0);
+    for(auto &sample : samples){
+        Append32(dfd, sample.bitOffset | (sample.bitLength << 16) | (sample.channelType << 24));
+        Append32(dfd, 0);
+        Append32(dfd, sample.lower);
+        Append32(dfd, sample.upper);
+    }
+    return dfd;
+}
+
+//levels[i] holds all faces of level i back to back
+static uint64_t WriteKTX2(const std::string &path, uint32_t format, uint32_t typeSize, int width, int height, int faces, const std::vector<std::vector<uint8_t>> &levels){
+    static const uint8_t identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    uint32_t levelCount = (uint32_t)levels.size();
+    std::vector<uint8_t> dfd = BuildDFD(format);
+    uint32_t alignment = (format == FORMAT_BC3_UNORM || format == FORMAT_BC3_SRGB) ? 16 : 8;
+
+    //levels are stored smallest first
+    uint64_t dfdOffset = 80 + 24 * (uint64_t)levelCount;
+    uint64_t offset = dfdOffset + dfd.size();
+    std::vector<uint64_t> levelOffsets(levelCount);
+    for(int i = (int)levelCount - 1; i >= 0; i--){
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelOffsets[i] = offset;
+        offset += levels[i].size();
+    }
+
+    std::vector<uint8_t> file(identifier, identifier + 12);
+    Append32(file, format);
+    Append32(file, typeSize);
+    Append32(file, width);
+    Append32(file, height);
+    Append32(file, 0);          //pixelDepth
+    Append32(file, 0);          //layerCount
+    Append32(file, faces);
+    Append32(file, levelCount);
+    Append32(file, 0);          //supercompressionScheme
+    Append32(file, (uint32_t)dfdOffset);
+    Append32(file, (uint32_t)dfd.size());
+    Append32(file, 0);          //kvdByteOffset
+    Append32(file, 0);          //kvdByteLength
+    Append64(file, 0);          //sgdByteOffset
+    Append64(file, 0);          //sgdByteLength
+    for(uint32_t i = 0; i < levelCount; i++){
+        Append64(file, levelOffsets[i]);
+        Append64(file, levels[i].size());
+        Append64(file, levels[i].size());
+    }
+    file.insert(file.end(), dfd.begin(), dfd.end());
+    file.resize(offset, 0);
+    for(uint32_t i = 0; i < levelCount; i++) memcpy(file.data() + levelOffsets[i], levels[i].data(), levels[i].size());
+
+    std::ofstream stream(path, std::ios::binary);
+    if(!stream.is_open()) throw std::runtime_error("failed to open " + path + " for writing!");
+    stream.write((const char*)file.data(), file.size());
+    return file.size();
+}
+
+/*******************
+*	Cook one texture
+********************/
+static CookResult Cook(const CookJob &job, const Options &options){
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::string sourcePath = options.inputDir + job.name;
+
+    //Step 1: decode to linear float
+    int width, height, channels;
+    Image source;
+    if(job.b16Bit){
+        uint16_t *texels = stbi_load_16(sourcePath.c_str(), &width, &height, &channels, 4);
+        if(!texels) throw std::runtime_error("failed to load " + sourcePath);
+        source.texels.resize((size_t)width * height * 4);
+        for(size_t i = 0; i < source.texels.size(); i++) source.texels[i] = texels[i] / 65535.0f;
+        stbi_image_free(texels);
+    }else{
+        uint8_t *texels = stbi_load(sourcePath.c_str(), &width, &height, &channels, 4);
+        if(!texels) throw std::runtime_error("failed to load " + sourcePath);
+        float table[256];
+        for(int i = 0; i < 256; i++) table[i] = options.bLinear ? i / 255.0f : SrgbToLinear(i / 255.0f);
+        source.texels.resize((size_t)width * height * 4);
+        for(size_t i = 0; i < source.texels.size(); i++) source.texels[i] = (i & 3) == 3 ? texels[i] / 255.0f : table[texels[i]];
+        stbi_image_free(texels);
+    }
+    source.width = width;
+    source.height = height;
+
+    //Step 2: faces. Cross layout as the runtime loader expects it: up / left front right back / down, layers +X -X +Y -Y +Z -Z
+    std::vector<Image> faces;
+    if(job.bCubemap){
+        int faceWidth = width / 4, faceHeight = height / 3;
+        const int cells[6][2] = {{2, 1}, {0, 1}, {1, 0}, {1, 2}, {1, 1}, {3, 1}}; //(column, row) of right, left, up, bottom, front, back
+        for(int f = 0; f < 6; f++){
+            Image face;
+            face.width = faceWidth;
+            face.height = faceHeight;
+            face.texels.resize((size_t)faceWidth * faceHeight * 4);
+            for(int y = 0; y < faceHeight; y++){
+                const float *row = source.texels.data() + (((size_t)cells[f][1] * faceHeight + y) * width + (size_t)cells[f][0] * faceWidth) * 4;
+                memcpy(face.texels.data() + (size_t)y * faceWidth * 4, row, (size_t)faceWidth * 4 * sizeof(float));
+            }
+            faces.push_back(face);
+        }
+    }else faces.push_back(source);
+
+    //Step 3: mip chain per face, then encode
+    int fullChain = (int)std::floor(std::log2(std::max(faces[0].width, faces[0].height))) + 1;
+    int mipLevels = job.mipLevels > 0 ? std::min(job.mipLevels, fullChain) : fullChain;
+    bool bSrgb = !job.b16Bit && !options.bLinear;
+    bool bCompress = options.bCompress && !job.b16Bit;
+    bool bAlpha = false;
+    for(auto &face : faces) for(size_t i = 3; i < face.texels.size() && !bAlpha; i += 4) bAlpha = face.texels[i] < 1.0f;
+
+    uint32_t format;
+    if(job.b16Bit) format = FORMAT_R16G16B16A16_UNORM;
+    else if(bCompress) format = bAlpha ? (bSrgb ? FORMAT_BC3_SRGB : FORMAT_BC3_UNORM) : (bSrgb ? FORMAT_BC1_RGB_SRGB : FORMAT_BC1_RGB_UNORM);
+    else format = bSrgb ? FORMAT_R8G8B8A8_SRGB : FORMAT_R8G8B8A8_UNORM;
+
+    std::vector<std::vector<uint8_t>> levels(mipLevels);
+    for(auto &face : faces){
+        Image level = face;
+        for(int i = 0; i < mipLevels; i++){
+            if(i > 0) level = Downsample(level);
+            std::vector<uint8_t> encoded;
+            if(job.b16Bit) encoded = ToRGBA16(level);
+            else{
+                encoded = ToRGBA8(level, bSrgb);
+                if(bCompress) encoded = CompressBC(encoded, level.width, level.height, bAlpha);
+            }
+            levels[i].insert(levels[i].end(), encoded.begin(), encoded.end());
+        }
+    }
+
+    //Step 4: write <output>/<name without extension>.ktx2
+    CookResult result;
+    result.name = job.name;
+    result.cooked = fs::path(job.name).replace_extension(".ktx2").generic_string();
+    fs::path outputPath = fs::path(options.outputDir) / result.cooked;
+    fs::create_directories(outputPath.parent_path());
+    result.cookedBytes = WriteKTX2(outputPath.string(), format, job.b16Bit ? 2 : 1, faces[0].width, faces[0].height, (int)faces.size(), levels);
+    result.format = format;
+    result.width = faces[0].width;
+    result.height = faces[0].height;
+    result.mipLevels = mipLevels;
+    result.faces = (int)faces.size();
+    result.sourceBytes = fs::file_size(sourcePath);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    result.milliseconds = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000;
+    return result;
+}
+
+/*******************
+*	Jobs from YAML
+********************/
+static void CollectYamlJobs(const std::string &yamlDir, std::map<std::string, CookJob> &jobs){
+    if(!fs::exists(yamlDir)) return;
+    for(auto &entry : fs::directory_iterator(yamlDir)){
+        if(entry.path().extension() != ".yaml") continue;
+        YAML::Node config = YAML::LoadFile(entry.path().string());
+        bool b16Bit = config["Features"]["feature_graphics_48pbt"] ? config["Features"]["feature_graphics_48pbt"].as<bool>() : false;
+        if(!config["Resources"]) continue;
+        for(const auto &resource : config["Resources"]){
+            if(!resource["Textures"]) continue;
+            for(const auto &texture : resource["Textures"]){
+                CookJob job;
+                job.name = texture["resource_texture_name"].as<std::string>();
+                job.mipLevels = texture["resource_texture_miplevels"] ? texture["resource_texture_miplevels"].as<int>() : 1;
+                job.bCubemap = texture["resource_texture_cubmap"] ? texture["resource_texture_cubmap"].as<bool>() : false;
+                job.b16Bit = b16Bit;
+                if(fs::path(job.name).extension() == ".ktx2" || fs::path(job.name).extension() == ".dds") continue; //already cooked
+                auto existing = jobs.find(job.name);
+                if(existing != jobs.end()) job.mipLevels = std::max(job.mipLevels, existing->second.mipLevels); //one asset serves every sample
+                jobs[job.name] = job;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    Options options;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--yaml" && i + 1 < argc) options.yamlDir = argv[++i];
+        else if(arg == "--input" && i + 1 < argc) options.inputDir = argv[++i];
+        else if(arg == "--output" && i + 1 < argc) options.outputDir = argv[++i];
+        else if(arg == "--threads" && i + 1 < argc) options.threads = atoi(argv[++i]);
+        else if(arg == "--mips" && i + 1 < argc) options.mipLevels = atoi(argv[++i]);
+        else if(arg == "--compress") options.bCompress = true;
+        else if(arg == "--linear") options.bLinear = true;
+        else if(arg == "--help" || arg == "-h"){
+            std::cout<<"texcook [--yaml <dir>] [--input <dir>] [--output <dir>] [--compress] [--linear] [--threads N] [--mips N] [image ...]"<<std::endl;
+            return 0;
+        }else options.images.push_back(arg);
+    }
+    if(!options.inputDir.empty() && options.inputDir.back() != '/' && options.inputDir.back() != '\\') options.inputDir += "/";
+    if(options.outputDir.empty()) options.outputDir = options.inputDir + "cooked/";
+    if(options.threads <= 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::map<std::string, CookJob> jobMap;
+    if(options.images.empty()) CollectYamlJobs(options.yamlDir, jobMap);
+    for(auto &image : options.images){
+        CookJob job;
+        job.name = image;
+        job.mipLevels = options.mipLevels;
+        jobMap[image] = job;
+    }
+    std::vector<CookJob> jobs;
+    for(auto &job : jobMap) jobs.push_back(job.second);
+    std::cout<<"texcook: "<<jobs.size()<<" textures, "<<options.threads<<" threads"<<std::endl;
+
+    //one texture per worker at a time
+    std::vector<CookResult> results;
+    std::mutex resultMutex;
+    std::atomic<size_t> nextJob{0};
+    std::atomic<int> failures{0};
+    auto worker = [&](){
+        for(size_t i = nextJob++; i < jobs.size(); i = nextJob++){
+            try{
+                CookResult result = Cook(jobs[i], options);
+                std::lock_guard<std::mutex> lock(resultMutex);
+                std::cout<<"  "<<result.name<<" -> "<<result.cooked<<": "<<result.width<<"x"<<result.height<<", "<<result.mipLevels<<" mips, "
+                    <<result.faces<<" faces, "<<result.cookedBytes<<" bytes, "<<result.milliseconds<<" ms"<<std::endl;
+                results.push_back(result);
+            }catch(const std::exception &e){
+                std::lock_guard<std::mutex> lock(resultMutex);
+                std::cerr<<"  "<<jobs[i].name<<": "<<e.what()<<std::endl;
+                failures++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(int i = 0; i < options.threads; i++) workers.emplace_back(worker);
+    for(auto &thread : workers) thread.join();
+
+    //manifest, sorted so reruns give the same file
+    std::sort(results.begin(), results.end(), [](const CookResult &a, const CookResult &b){ return a.name < b.name; });
+    fs::create_directories(options.outputDir);
+    std::ofstream manifest(fs::path(options.outputDir) / "manifest.yaml");
+    manifest<<"CookedTextures:"<<std::endl;
+    for(auto &result : results){
+        manifest<<"  - source: "<<result.name<<std::endl;
+        manifest<<"    cooked: "<<result.cooked<<std::endl;
+        manifest<<"    vk_format: "<<result.format<<std::endl;
+        manifest<<"    width: "<<result.width<<std::endl;
+        manifest<<"    height: "<<result.height<<std::endl;
+        manifest<<"    mip_levels: "<<result.mipLevels<<std::endl;
+        manifest<<"    faces: "<<result.faces<<std::endl;
+        manifest<<"    source_bytes: "<<result.sourceBytes<<std::endl;
+        manifest<<"    cooked_bytes: "<<result.cookedBytes<<std::endl;
+    }
+
+    std::cout<<"texcook: "<<results.size()<<" cooked, "<<failures.load()<<" failed"<<std::endl;
+    return failures.load() ? 1 : 0;
+}
@@ -13,6 +13,11 @@
 #include "shaderManager.h"
 #include "renderer.h"
 #include "texture.h" //this includes imageManager.h
+#include "textureStreamer.h"
+#include "bindlessTextures.h"
+#include "imageWriter.h"
+#include "goldenImage.h"
+#include "inputLog.h"
 #include "modelManager.h"
 #include "object.h"
 #include "light.h"
@@ -24,13 +29,13 @@
 #if WIN32
     #define YAML_CPP_STATIC_DEFINE
 #endif
-#include "../../thirdParty/yaml-cpp/yaml.h"
+#include "../../thirdparty/yaml-cpp/yaml.h"
 
 #ifndef ANDROID
     #ifndef SDL
-        #include "..\\..\\glfwFramework\\include\\glfwManager.h"
+        #include "../../glfwFramework/include/glfwManager.h"
     #else
-        #include "..\\..\\sdlFramework\\include\\sdlManager.h"
+        #include "../../sdlFramework/include/sdlManager.h"
     #endif
 #endif
 
@@ -69,6 +74,8 @@ public:
     CRenderer renderer;
     CModelManager modelManager;
     CTextureManager textureManager;
+    CTextureStreamer textureStreamer;
+    CBindlessTextures bindlessTextures;
 
     static int focusObjectId;
     static std::vector<CObject> objects;
@@ -85,6 +92,36 @@ public:
         CSDLManager sdlManager;
     #endif
     void run();
+
+    //command line (main.hpp): --headless, --headless-surface, --frames N, --capture file.png|file.exr,
+    //--golden file.png, --tolerance deltaE, --update-golden, --create-missing-golden, --report file.json,
+    //--fixed-step seconds, --record-input file, --replay-input file,
+    //--gpu-profile, --gpu-csv file.csv, --gpu-trace file.json, --pipeline-statistics, --cpu-profile, --cpu-trace file.json,
+    //--log-level verbose|info|warning|error, --log-categories general,device,swapchain,texture,renderer|all, --binary-log file.blog,
+    //--metrics, --metrics-port N, --metrics-log seconds,
+    //--present immediate|mailbox|fifo|fifo-relaxed, --target-fps N, --max-queued-frames N, --no-present-wait,
+    //--descriptor-backend sets|push|buffer|auto
+    void ParseCommandLine(int argc, char **argv);
+    bool bHeadless = false;        //no window system: offscreen images stand in for the swapchain
+    bool bHeadlessSurface = false; //headless, but present to a VK_EXT_headless_surface swapchain when the instance has it
+    int maxFrames = 0;             //0: until the window is closed
+    std::string capturePath;       //the last frame is written here (offscreen images only)
+    std::string goldenPath;        //the last frame is compared with this image (a missing image fails)
+    float goldenTolerance = 2.3f;  //delta E a pixel may differ by
+    bool bUpdateGolden = false;    //write the last frame to goldenPath instead (--update-golden, or environment VKP_UPDATE_GOLDEN=1)
+    bool bCreateMissingGolden = false; //write it only if goldenPath does not exist, and exit with EXIT_SKIPPED
+    std::string reportPath;        //init, CPU frame and GPU queue times as JSON
+    static const int EXIT_SKIPPED = 77; //ctest SKIP_RETURN_CODE: the golden image was created, nothing was compared
+    int exitCode = EXIT_SUCCESS;   //EXIT_FAILURE if the golden image comparison failed
+    bool CaptureFrame();
+    void WriteReport(const std::string &path);
+    float initTime = 0; //ms
+    std::vector<float> frameTimes; //ms, CPU time of UpdateRecordRender
+    CGoldenImage::Result goldenResult;
+    bool bGoldenCompared = false;
+    std::string recordInputPath;
+    std::string replayInputPath;
+    std::string descriptorBackendName; //overrides feature_graphics_descriptor_backend when set
 #endif
 
     //for static class member. But can not define and init them in the header file!
@@ -92,12 +129,23 @@ public:
     static Camera lightCamera;
     static bool NeedToExit;
     static bool NeedToPause;
+    static CInputLog inputLog; //window input for mainCamera, applied in update()
 
     /*Clean up Functions*/
     void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator);
     
     float durationTime = 0;
     float deltaTime = 0;
+    float fixedStepTime = 0;  //seconds; > 0: camera and objects move in fixed steps, frames interpolate between the last two;
+                              //headless, every frame is exactly one step (reproducible runs)
+    float interpolationAlpha = 0;
+    uint64_t simulationStep = 0;
+    void SimulateStep(float step);
+    void UpdateInterpolated(float alpha);
+    void ApplyInput(const CInputLog::Event &event);
+    float m_accumulator = 0;              //frame time not yet simulated
+    std::vector<CEntity> m_previousStates; //cameras and objects before the last step
+    std::vector<CEntity> m_currentStates;  //cameras and objects after the last step, while UpdateInterpolated renders the blend
 
     std::string m_sampleName;
     YAML::Node config;
@@ -121,6 +169,7 @@ public:
     ******************/
     void ReadFeatures();
     void ReadUniforms();
+    CSamplerCache::Key ReadSamplerKey(const YAML::Node &samplerUniform, int miplevel);
     void ReadAttachments();
     void ReadSubpasses();
     void ReadResources();
@@ -144,6 +193,12 @@ public:
         bool b_feature_graphics_rainbow_mipmap = false;
         int feature_graphics_pipeline_skybox_id = -1;
         int feature_graphics_observe_attachment_id = -1;
+        int feature_graphics_texture_budget_mb = 256; //GPU memory for streamed textures (resource_texture_streaming)
+        std::string feature_graphics_mipmap_generator = "blit"; //blit, cpu or compute; resource_texture_mipmap_generator overrides it per texture
+        std::string feature_graphics_mipmap_filter = "box"; //cpu generator: box, kaiser or lanczos
+        float feature_graphics_mipmap_alpha_cutoff = 0.0f; //cpu generator: > 0 keeps alpha test coverage at this cutoff
+        std::string feature_graphics_bindless_textures = "none"; //none, auto (descriptor indexing, else atlas) or atlas
+        std::string feature_graphics_descriptor_backend = "sets"; //sets, push (VK_KHR_push_descriptor), buffer (VK_EXT_descriptor_buffer) or auto
     };
     // struct AttachmentInfo{
     //     bool bAttachmentDepthLight;
@@ -181,6 +236,7 @@ public:
         UniformInfo Uniform;
         std::unique_ptr<std::vector<std::string>> VertexShader;
         std::unique_ptr<std::vector<std::string>> FragmentShader;
+        std::unique_ptr<std::vector<std::string>> FragmentShaderAtlas; //used instead of FragmentShader when bindless textures fall back to the atlas
         std::unique_ptr<std::vector<int>> Subpass;
         std::unique_ptr<std::vector<std::string>> ComputeShader;
         CRenderer::RenderModes RenderMode = CRenderer::GRAPHICS;
@@ -0,0 +1,105 @@
+#ifndef H_BINARYLOG
+#define H_BINARYLOG
+
+#include "common.h"
+#include "logger.h"
+#include "cpuProfiler.h"
+
+//Binary log for per-frame telemetry and hot log calls: nothing is formatted in the process.
+//Every call site (BLOG, LOG_SITE) registers its file, line, format string and argument types once, on its first call,
+//in the call site table of the file. A call then reserves space in a ring with one atomic add and copies a 24 byte
+//header (offset, size, site, ticks) and the raw arguments into it; the ring is a shared memory mapping of the file, so
+//the records reach the disk even if the process crashes. When the ring is full the oldest records are overwritten.
+//tools/logdecode renders the text offline with the same formatter as CLogger (CLogFormat).
+//A format string is only read on a site's first call: it must not change between calls (use a literal).
+//Command line: --binary-log file.blog
+class CBinaryLog final{
+public:
+    static const uint32_t SITE_NONE = 0xffffffffu;    //not registered yet
+    static const uint32_t SITE_DROPPED = 0xfffffffeu; //the call site table is full
+    static const uint64_t DEFAULT_RING_SIZE = 16 << 20;
+    static const uint64_t SITE_TABLE_SIZE = 256 << 10;
+
+    static bool Open(const std::string &path, uint64_t ringSize = DEFAULT_RING_SIZE); //ringSize is rounded up to a power of two
+    static void Close(); //also registered with atexit
+    static inline bool IsOpen(){ return s_pRing != nullptr; }
+
+    template<typename... Args>
+    static void Log(std::atomic<uint32_t> &site, LogLevel level, LogCategory category, const char *file, int line,
+        const char *format, const Args&... args){
+        if(!s_pRing || !CLogger::IsEnabled(level, category)) return;
+        uint32_t id = site.load(std::memory_order_acquire);
+        if(id == SITE_NONE) id = Register(site, level, category, file, line, format, Signature<Args...>());
+        if(id == SITE_DROPPED) return;
+
+        uint64_t size = (sizeof(CLogFormat::BinaryRecord) + (uint64_t(0) + ... + ArgSize(args)) + 7) & ~uint64_t(7);
+        uint64_t offset;
+        if(!Reserve(size, offset)) return;
+        CLogFormat::BinaryRecord header = {0, (uint32_t)size, id, CCpuProfiler::Now()};
+        uint64_t position = offset + sizeof(header.offset);
+        Copy(position, &header.size, sizeof(header) - sizeof(header.offset));
+        (WriteArg(position, args), ...);
+        Commit(offset);
+    }
+
+private:
+    template<typename... Args>
+    static const char *Signature(){
+        static const char signature[] = {CLogFormat::TypeCode<Args>()..., '\0'};
+        return signature;
+    }
+    template<typename T>
+    static uint64_t ArgSize(const T &value){
+        if constexpr(CLogFormat::TypeCode<T>() != 's') return 8;
+        else return sizeof(uint32_t) + StringOf(value).size();
+    }
+    template<typename T>
+    static void WriteArg(uint64_t &position, const T &value){
+        constexpr char code = CLogFormat::TypeCode<T>();
+        uint64_t raw = 0;
+        if constexpr(code == 'i'){ int64_t v = (int64_t)value; memcpy(&raw, &v, 8); }
+        else if constexpr(code == 'u') raw = (uint64_t)value;
+        else if constexpr(code == 'd'){ double v = (double)value; memcpy(&raw, &v, 8); }
+        else if constexpr(code == 'p') raw = (uint64_t)(uintptr_t)value;
+        else{
+            std::string_view s = StringOf(value);
+            uint32_t length = (uint32_t)s.size();
+            Copy(position, &length, sizeof(length));
+            Copy(position, s.data(), length);
+            return;
+        }
+        Copy(position, &raw, 8);
+    }
+    template<typename T>
+    static std::string_view StringOf(const T &value){
+        if constexpr(std::is_pointer_v<std::decay_t<T>>) return value ? std::string_view(value) : std::string_view("(null)");
+        else return std::string_view(value);
+    }
+
+    static uint32_t Register(std::atomic<uint32_t> &site, LogLevel level, LogCategory category, const char *file, int line,
+        const char *format, const char *signature);
+    static bool Reserve(uint64_t size, uint64_t &offset);
+    static void Copy(uint64_t &position, const void *data, size_t size); //into the ring at position (wraps), advances position
+    static void Commit(uint64_t offset);
+    static void Calibrate();
+
+    static CLogFormat::BinaryHeader *s_pHeader;
+    static uint8_t *s_pSiteTable;
+    static uint8_t *s_pRing;
+    static uint64_t s_ringMask;
+    static uint32_t s_siteCount;
+    static std::mutex s_siteMutex;
+    static size_t s_mappingSize;
+    static std::chrono::steady_clock::time_point s_openTime;
+#ifdef _WIN32
+    static void *s_hFile;
+    static void *s_hMapping;
+#endif
+};
+
+//BLOG(LOG_LEVEL_INFO, LOG_CATEGORY_RENDERER, "frame %d", n): a binary record when --binary-log is on, else nothing
+#define BLOG(level, category, ...) do{ if constexpr(CLogger::IsCompiledIn(level, category)){ \
+    static std::atomic<uint32_t> blogSite{CBinaryLog::SITE_NONE}; \
+    CBinaryLog::Log(blogSite, level, category, __FILE__, __LINE__, __VA_ARGS__); } }while(0)
+
+#endif
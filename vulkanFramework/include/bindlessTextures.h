@@ -0,0 +1,89 @@
+#ifndef H_BINDLESSTEXTURES
+#define H_BINDLESSTEXTURES
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "imageBuffer.h"
+#include "texture.h"
+
+//One sampler2D array (set = 1, binding = 0) holding every 2D texture of CTextureManager, instead of one sampler set
+//per object and frame. Objects select their texture with push constants (fragment stage, after ModelPushConstants).
+//MODE_DESCRIPTOR_INDEXING: VK_EXT_descriptor_indexing, runtime sized update-after-bind array, one slot per texture.
+//MODE_ATLAS: fallback for devices without it. Small single-mip textures with TRANSFER_SRC usage are copied into
+//atlas pages (grouped by format and sampler); pages and the remaining textures fill a fixed ATLAS_SLOTS array.
+//The shader maps uv into the texture's rectangle of the page (shaders/bindlessCubes/shaderAtlas.frag).
+class CBindlessTextures final{
+public:
+    enum Mode { MODE_DISABLED, MODE_DESCRIPTOR_INDEXING, MODE_ATLAS };
+    struct PushConstants{
+        glm::vec4 uvRect = glm::vec4(1, 1, 0, 0); //scale.xy, offset.xy of the texture inside its slot
+        uint32_t textureIndex = 0;                //slot in the sampler array
+        uint32_t padding[3] = {};
+    };
+    static const uint32_t PUSH_CONSTANT_OFFSET = sizeof(ModelPushConstants);
+    static const uint32_t MAX_TEXTURES = 4096;          //descriptor indexing: upper bound of the array in the layout
+    static const uint32_t ATLAS_SLOTS = 16;             //atlas: array size of the shader, the minimum maxPerStageDescriptorSamplers
+    static const uint32_t ATLAS_PAGE_SIZE = 2048;
+    static const uint32_t ATLAS_MAX_TEXTURE_SIZE = 256; //larger textures keep their own slot
+
+    CBindlessTextures();
+    ~CBindlessTextures();
+
+    static Mode ParseMode(const std::string &name, bool bDescriptorIndexing); //"none", "auto" or "atlas"
+
+    //call after all textures are loaded and the samplers exist
+    void Init(Mode requestedMode, CTextureManager *pTextureManager, std::vector<VkSampler> *pSamplers, VkCommandPool &commandPool);
+    void Destroy();
+    bool IsEnabled() { return mode != MODE_DISABLED; }
+
+    Mode mode = MODE_DISABLED;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> descriptorSets; //one per frame in flight
+
+    VkPushConstantRange GetPushConstantRange();
+    void GetPushConstants(int textureId, PushConstants &pushConstants);
+
+    //rewrite the slots of this frame whose texture changed its view (streaming), once per frameNumber
+    void Update(uint32_t frame, uint64_t frameNumber);
+
+    uint32_t GetSlotCount() { return static_cast<uint32_t>(m_slots.size()); }
+    uint32_t GetAtlasPageCount() { return static_cast<uint32_t>(m_atlasPages.size()); }
+    uint32_t GetAtlasTextureCount() { return m_atlasTextureCount; }
+
+private:
+    struct Slot{
+        int textureId = -1;  //-1: atlas page
+        int atlasPage = -1;
+    };
+    struct Placement{
+        uint32_t slot = 0;
+        glm::vec4 uvRect = glm::vec4(1, 1, 0, 0);
+        bool bAtlas = false;
+    };
+    struct AtlasPage{
+        CWxjImageBuffer image;
+        VkFormat format;
+        uint32_t samplerId;
+        uint32_t width = 0, height = 0;
+    };
+
+    CTextureManager *m_pTextureManager = nullptr;
+    std::vector<VkSampler> *m_pSamplers = nullptr;
+    VkCommandPool *m_pCommandPool = nullptr;
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+    std::vector<Slot> m_slots;
+    std::vector<Placement> m_placements;               //by texture id
+    std::vector<AtlasPage> m_atlasPages;
+    uint32_t m_atlasTextureCount = 0;
+    std::vector<std::vector<uint32_t>> m_boundVersions; //[frame][slot] CTextureImage::m_version written into the set
+    std::vector<uint64_t> m_updatedFrameNumbers;        //[frame]
+
+    bool IsBindable(int textureId);
+    bool IsAtlasCandidate(int textureId);
+    void BuildAtlas();
+    void CreateDescriptors();
+    void WriteSlots(uint32_t frame, const std::vector<uint32_t> &slots);
+};
+
+#endif
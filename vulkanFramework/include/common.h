@@ -39,7 +39,11 @@
 
 const uint32_t WINDOW_WIDTH = 800; //1024;//1080;
 const uint32_t WINDOW_HEIGHT = 800; //1280;//2400;
-const int MAX_FRAMES_IN_FLIGHT = 2;
+//frames the CPU may record ahead of the GPU; override at configure time with -DFRAMES_IN_FLIGHT=3
+#ifndef FRAMES_IN_FLIGHT
+#define FRAMES_IN_FLIGHT 2
+#endif
+const int MAX_FRAMES_IN_FLIGHT = FRAMES_IN_FLIGHT;
 
 const int MIPMAP_TEXTURE_COUNT = 7;
 
@@ -66,6 +70,16 @@ const bool enableValidationLayers = true;
 
 #define PALLOCATOR		(VkAllocationCallbacks *)nullptr
 
+//FNV-1a 64 of a byte range; pass a previous result as hash to continue it over the next range
+inline uint64_t HashBytes(const void *pData, size_t size, uint64_t hash = 14695981039346656037ULL){
+    const unsigned char *p = static_cast<const unsigned char*>(pData);
+    for(size_t i = 0; i < size; i++){
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 #include <vulkan/vulkan.h>
 
 #endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef H_COMPRESSEDTEXTURE
+#define H_COMPRESSEDTEXTURE
+
+#include "common.h"
+#include "context.h"
+
+//Pre-compressed textures from KTX2 (uncompressed payload, no supercompression) or DDS (legacy FourCC or DX10 header)
+//All mip levels stored in the file are kept, level i starts at levelOffsets[i] in data.
+//KTX2 cubemaps have faceCount 6: each level holds the 6 faces back to back, levelSizes[i] covers all of them.
+//If the device can not sample the block format, DecodeToRGBA8() unpacks BC1-BC5 on the CPU.
+class CCompressedTexture final{
+public:
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 0;
+    uint32_t faceCount = 1;
+    std::vector<uint8_t> data;
+    std::vector<VkDeviceSize> levelOffsets;
+    std::vector<VkDeviceSize> levelSizes;
+
+    static bool IsCompressedFile(const std::string &texturePath); //.ktx2 or .dds
+    void Load(const std::string &texturePath, bool bSrgb); //bSrgb picks the sRGB variant when the file does not say (legacy DDS)
+
+    bool IsBlockFormat();
+    uint32_t GetBlockSize(); //bytes per 4x4 block, 0 if not a block format
+    bool IsFormatSupported(); //optimal tiling sampled image support
+    bool CanDecode(); //CPU fallback available for this format
+    void DecodeToRGBA8(); //replace data with RGBA8 levels, format becomes R8G8B8A8_UNORM/SRGB
+
+    VkDeviceSize GetRGBA8Size(); //size the same mip chain would have as RGBA8, for comparisons
+
+private:
+    void LoadKTX2(const std::vector<uint8_t> &file);
+    void LoadDDS(const std::vector<uint8_t> &file, bool bSrgb);
+    void ReadFile(const std::string &texturePath, std::vector<uint8_t> &file);
+};
+
+#endif
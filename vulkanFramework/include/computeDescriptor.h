@@ -54,7 +54,7 @@ public:
 	static std::vector<CWxjBuffer> storageBuffers; 
     static std::vector<void*> storageBuffersMapped;
     static VkDeviceSize m_storageBufferSize;
-    static void addStorageBuffer(VkDeviceSize storageBufferSize, VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT); //the same function to add storage 1&2
+    static void addStorageBuffer(VkDeviceSize storageBufferSize, VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::vector<uint32_t> concurrentQueueFamilies = {}); //the same function to add storage 1&2
     template <typename T>
     void updateStorageBuffer(uint32_t currentFrame, float durationTime, T storageBufferObject){ 
         memcpy(storageBuffersMapped[currentFrame], &storageBufferObject, sizeof(storageBufferObject));
@@ -6,10 +6,11 @@
 #include "logManager.h"
 
 #ifdef ANDROID
-#include "..\\..\\androidFramework\\include\\androidFileManager.h"
+#include "../../androidFramework/include/androidFileManager.h"
 #endif
 
 #define PRINT CContext::GetHandle().logManager.print
+#define PRINT_SITE(...) LOG_SITE(CContext::GetHandle().logManager, __VA_ARGS__) //binary when --binary-log is on
 
 //CContext is to store some commonly used static variables(physical device, logical device in the current context)
 
@@ -0,0 +1,143 @@
+#ifndef H_CPUPROFILER
+#define H_CPUPROFILER
+
+#include "common.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#if defined(_M_X64)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+//CPU time per zone, from PROFILE_SCOPE("name") in the frame loop, the renderer and the worker threads.
+//Every thread writes its zones and counters into its own ring buffer, without locks: only that thread moves the head,
+//only EndFrame() (main thread, once per frame) moves the tail. A thread that writes more than RING_SIZE events between
+//two EndFrame calls loses the oldest ones (counted in droppedEvents).
+//Timestamps are rdtsc ticks on x86 (invariant TSC, calibrated against steady_clock), steady_clock nanoseconds elsewhere.
+//Output: a summary per zone (ms per frame, calls) and counter (per frame) on the console, and a Chrome trace
+//(chrome://tracing, Perfetto) with one row per thread and the counters as graphs.
+//Names must be string literals: only the pointer is stored.
+//Built with -DCPU_PROFILER (CMake option CPU_PROFILER, off for Release); without it the macros compile to nothing.
+class CCpuProfiler final{
+public:
+    static const uint32_t RING_SIZE = 1 << 14; //events per thread between two EndFrame calls, power of two
+
+    //settings, before Init (command line: --cpu-profile, --cpu-trace)
+    static bool bEnabled;
+    static std::string tracePath;
+    static uint32_t summaryInterval; //frames between console summaries, 0: only at Destroy
+
+    static void Init();
+    static void Destroy(); //drains the last events, writes the trace and the final summary
+    static void EndFrame(); //main thread, after the frame is presented
+
+    static void SetThreadName(const char *name); //row name in the trace
+    static void Zone(const char *name, uint64_t start, uint64_t end, uint32_t depth);
+    static void Counter(const char *name, uint64_t value); //summed per frame
+
+    static inline uint64_t Now(){
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    static uint32_t &Depth(); //open zones of the calling thread
+
+    static uint64_t frameCount;
+    static uint64_t droppedEvents;
+    static void PrintSummary();
+
+private:
+    enum EventType : uint32_t { EVENT_ZONE, EVENT_COUNTER };
+    struct Event{ //relaxed atomics, Drain may read a slot while its thread writes it again
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start{0}; //counter: value
+        std::atomic<uint64_t> end{0};
+        std::atomic<EventType> type{EVENT_ZONE};
+        std::atomic<uint32_t> depth{0};
+    };
+    static void Push(const char *name, uint64_t start, uint64_t end, EventType type, uint32_t depth);
+    struct ThreadBuffer{
+        Event events[RING_SIZE];
+        std::atomic<uint64_t> head{0}; //written by the owning thread only
+        uint64_t tail = 0;             //read by EndFrame only
+        uint32_t threadId = 0;
+        std::atomic<const char*> name{nullptr};
+        const char *writtenName = nullptr; //last name put into the trace
+        uint32_t depth = 0;
+    };
+    struct ZoneStats{
+        double totalMs = 0;
+        uint64_t calls = 0;
+        double maxFrameMs = 0; //longest frame total
+        double frameMs = 0;    //current frame
+    };
+    struct CounterStats{
+        uint64_t total = 0;
+        uint64_t frameValue = 0; //current frame
+        uint64_t maxFrameValue = 0;
+    };
+
+    static ThreadBuffer &GetThreadBuffer();
+    static void Drain();
+    static void WriteTraceName(const char *name);
+    static double ToMicroseconds(uint64_t ticks);
+    static void Calibrate();
+
+    static std::mutex s_threadsMutex; //guards s_threads, taken once per thread and per EndFrame
+    static std::vector<std::unique_ptr<ThreadBuffer>> s_threads;
+    static std::map<std::string, ZoneStats> s_zones; //the same name in two files may be two literals
+    static std::map<std::string, CounterStats> s_counters;
+    static std::unordered_map<const char*, ZoneStats*> s_zoneLookup; //literal address to entry, saves a string per event
+    static std::unordered_map<const char*, CounterStats*> s_counterLookup;
+    static uint64_t s_baseTicks;
+    static std::chrono::steady_clock::time_point s_baseTime;
+    static double s_ticksPerMicrosecond;
+    static uint64_t s_lastSummaryFrame;
+    static std::ofstream s_trace;
+    static bool s_bFirstTraceEvent;
+};
+
+//Times the enclosing block.
+class CProfileZone final{
+public:
+    explicit CProfileZone(const char *name) : m_name(name){
+        if(!CCpuProfiler::bEnabled) return;
+        m_depth = CCpuProfiler::Depth()++;
+        m_start = CCpuProfiler::Now();
+    }
+    ~CProfileZone(){
+        if(m_start == 0) return;
+        uint64_t end = CCpuProfiler::Now();
+        CCpuProfiler::Depth()--;
+        CCpuProfiler::Zone(m_name, m_start, end, m_depth);
+    }
+    CProfileZone(const CProfileZone&) = delete;
+    CProfileZone &operator=(const CProfileZone&) = delete;
+private:
+    const char *m_name;
+    uint64_t m_start = 0;
+    uint32_t m_depth = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef CPU_PROFILER
+    #define PROFILE_SCOPE(name) CProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+    #define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+    #define PROFILE_COUNTER(name, value) do{ if(CCpuProfiler::bEnabled) CCpuProfiler::Counter(name, (uint64_t)(value)); }while(0)
+    #define PROFILE_THREAD(name) CCpuProfiler::SetThreadName(name)
+    #define PROFILE_FRAME() CCpuProfiler::EndFrame()
+#else
+    #define PROFILE_SCOPE(name) ((void)0)
+    #define PROFILE_FUNCTION() ((void)0)
+    #define PROFILE_COUNTER(name, value) ((void)0)
+    #define PROFILE_THREAD(name) ((void)0)
+    #define PROFILE_FRAME() ((void)0)
+#endif
+
+#endif
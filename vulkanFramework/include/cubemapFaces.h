@@ -0,0 +1,37 @@
+#ifndef H_CUBEMAPFACES
+#define H_CUBEMAPFACES
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+//CPU side cubemap assembly: the 6 faces are written back to back in layer order (right, left, up, bottom, front, back),
+//so only face texels are staged and each face is one tightly packed VkBufferImageCopy region.
+//Sources: a 4x3 cross image, six separate face images, or an equirectangular HDR image.
+class CCubemapFaces final{
+public:
+    enum Face { FACE_RIGHT, FACE_LEFT, FACE_UP, FACE_BOTTOM, FACE_FRONT, FACE_BACK, FACE_COUNT };
+    static const char* GetFaceName(int face); //"right", "left", "up", "bottom", "front", "back"
+
+    //"sky_{face}.png" -> "sky_right.png" ...; false if the name has no {face} token
+    static bool IsFaceFileName(const std::string &texturePath);
+    static std::string GetFaceFileName(const std::string &texturePath, int face);
+
+    /* Standard Skybox Format
+    *			up
+    *	left	front	right	back
+    *			bottom
+    */
+    //cross: crossWidth x crossHeight texels of bytesPerTexel, faces become (crossWidth/4) x (crossHeight/3)
+    static void ExtractFromCross(const void *cross, uint32_t crossWidth, uint32_t crossHeight, uint32_t bytesPerTexel,
+        std::vector<uint8_t> &faces, unsigned threads = 0);
+
+    //rgba: width x height RGBA32F, longitude along x, top row looks up (+Y); faces are RGBA16F, faceSize x faceSize
+    static void FromEquirect(const float *rgba, uint32_t width, uint32_t height, uint32_t faceSize,
+        std::vector<uint8_t> &faces, unsigned threads = 0);
+
+    static uint16_t FloatToHalf(float value);
+    static float HalfToFloat(uint16_t value);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define H_DATABUFFER
 #include "common.h"
 #include "context.h"
+#include "metrics.h"
 
 
 //Uniform Naming Rule: PipelineType_DescriptorType_Purpose
@@ -220,7 +221,9 @@ public:
     CWxjBuffer(): m_size(0){}
     ~CWxjBuffer(){}
 
-    VkResult init(IN VkDeviceSize requiredSize, VkBufferUsageFlags usage) {
+    //concurrentQueueFamilies: if it has 2+ distinct families, the buffer is shared between them without ownership transfer
+    //memoryAllocateFlags: e.g. VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT for buffers referenced from descriptor buffers
+    VkResult init(IN VkDeviceSize requiredSize, VkBufferUsageFlags usage, std::vector<uint32_t> concurrentQueueFamilies = {}, VkMemoryAllocateFlags memoryAllocateFlags = 0) {
         //HERE_I_AM("Init05DataBuffer");
         //Step1:Create Buffer(create buffer)
         VkResult result = VK_SUCCESS;
@@ -234,6 +237,11 @@ public:
         vbci.queueFamilyIndexCount = 0;
         vbci.pQueueFamilyIndices = (const uint32_t *)nullptr;
         vbci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;	// can only use CONCURRENT if .queueFamilyIndexCount > 0
+        if(concurrentQueueFamilies.size() > 1){
+            vbci.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            vbci.queueFamilyIndexCount = static_cast<uint32_t>(concurrentQueueFamilies.size());
+            vbci.pQueueFamilyIndices = concurrentQueueFamilies.data();
+        }
         result = vkCreateBuffer(CContext::GetHandle().GetLogicalDevice(), IN &vbci, PALLOCATOR, OUT &buffer);
         //REPORT("vkCreateBuffer");
 
@@ -252,7 +260,12 @@ public:
         vmai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
         vmai.pNext = nullptr;
         vmai.allocationSize = vmr.size; 
-        vmai.memoryTypeIndex = FindMemoryThatIsHostVisible(vmr.memoryTypeBits);
+        vmai.memoryTypeIndex = bDeviceLocal ? FindMemoryThatIsDeviceLocal(vmr.memoryTypeBits) : 
+            bPreferHostCached ? FindMemoryThatIsHostCached(vmr.memoryTypeBits) : FindMemoryThatIsHostVisible(vmr.memoryTypeBits);
+        VkMemoryAllocateFlagsInfo vmafi{};
+        vmafi.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+        vmafi.flags = memoryAllocateFlags;
+        if(memoryAllocateFlags != 0) vmai.pNext = &vmafi;
         //VkDeviceMemory				vdm;
         result = vkAllocateMemory(CContext::GetHandle().GetLogicalDevice(), IN &vmai, PALLOCATOR, OUT &deviceMemory);
        
@@ -263,6 +276,11 @@ public:
         result = vkBindBufferMemory(CContext::GetHandle().GetLogicalDevice(), buffer, IN deviceMemory, 0);		// 0 is the offset
         //REPORT("vkBindBufferMemory");
 
+        m_memoryType = vmai.memoryTypeIndex;
+        static CMetrics::Gauge &liveBuffers = CMetrics::GetGauge("vk_buffers_live", "Buffers created by CWxjBuffer and not destroyed");
+        liveBuffers.Add(1);
+        CMetrics::TrackGpuMemory(m_memoryType, (int64_t)m_size);
+
         return result;
     }
 
@@ -279,14 +297,23 @@ public:
         if(m_size != 0){
             vkDestroyBuffer(CContext::GetHandle().GetLogicalDevice(), buffer, nullptr);
             vkFreeMemory(CContext::GetHandle().GetLogicalDevice(), deviceMemory, nullptr);
+            static CMetrics::Gauge &liveBuffers = CMetrics::GetGauge("vk_buffers_live", "Buffers created by CWxjBuffer and not destroyed");
+            liveBuffers.Add(-1);
+            CMetrics::TrackGpuMemory(m_memoryType, -(int64_t)m_size);
         }
     }
 
     VkBuffer		buffer;
     VkDeviceMemory		deviceMemory;
+    //set before init() for buffers the CPU reads (readback): CPU reads from uncached memory are very slow.
+    //Cached memory may not be coherent, so readers invalidate the mapped range
+    bool bPreferHostCached = false;
+    //set before init() for buffers the GPU reads every frame (vertex, index): filled through CUploadService, fill() can't map them
+    bool bDeviceLocal = false;
 
 private:
 	VkDeviceSize		m_size;
+    uint32_t m_memoryType = 0; //for CMetrics::TrackGpuMemory
 
     int FindMemoryByFlagAndType(VkMemoryPropertyFlagBits memoryFlagBits, uint32_t  memoryTypeBits) {
         VkPhysicalDeviceMemoryProperties	vpdmp;
@@ -310,6 +337,25 @@ private:
         return FindMemoryByFlagAndType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, memoryTypeBits);
     }
 
+    int FindMemoryThatIsHostCached(uint32_t memoryTypeBits) {
+        VkPhysicalDeviceMemoryProperties	vpdmp;
+        vkGetPhysicalDeviceMemoryProperties(CContext::GetHandle().GetPhysicalDevice(), OUT &vpdmp);
+        const VkMemoryPropertyFlags cachedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        for (unsigned int i = 0; i < vpdmp.memoryTypeCount; i++) {
+            if ((memoryTypeBits & (1 << i)) != 0 && (vpdmp.memoryTypes[i].propertyFlags & cachedFlags) == cachedFlags) return i;
+        }
+        return FindMemoryThatIsHostVisible(memoryTypeBits);
+    }
+
+    int FindMemoryThatIsDeviceLocal(uint32_t memoryTypeBits) {
+        VkPhysicalDeviceMemoryProperties	vpdmp;
+        vkGetPhysicalDeviceMemoryProperties(CContext::GetHandle().GetPhysicalDevice(), OUT &vpdmp);
+        for (unsigned int i = 0; i < vpdmp.memoryTypeCount; i++) {
+            if ((memoryTypeBits & (1 << i)) != 0 && (vpdmp.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0) return i;
+        }
+        throw  std::runtime_error("Could not find device local memory");
+    }
+
 
 };
 
@@ -0,0 +1,98 @@
+#ifndef H_DESCRIPTORALLOCATOR
+#define H_DESCRIPTORALLOCATOR
+
+#include "common.h"
+#include "context.h"
+
+//Descriptor sets from growable pools, one pool chain per registered layout.
+//A pool holds setCapacity sets of its layout; when it is full the next pool doubles the capacity (up to MAX_SETS_PER_POOL).
+//Sets are never freed one by one, all pools are destroyed in Destroy().
+class CDescriptorAllocator final{
+public:
+    static const uint32_t INITIAL_SETS_PER_POOL = 16;
+    static const uint32_t MAX_SETS_PER_POOL = 1024;
+
+    struct Stats{
+        uint32_t layoutCount = 0;
+        uint32_t poolCount = 0;
+        uint32_t setsAllocated = 0;
+        uint32_t setCapacity = 0; //sum of all pools
+    };
+
+    CDescriptorAllocator();
+    ~CDescriptorAllocator();
+
+    //pool sizes are derived from the bindings; expectedSets sizes the first pool
+    void RegisterLayout(VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding> &bindings, uint32_t expectedSets = 0);
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+    void Destroy();
+
+    Stats GetStats();
+
+private:
+    struct Pool{
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        uint32_t capacity = 0;
+        uint32_t allocated = 0;
+    };
+    struct LayoutPools{
+        std::vector<VkDescriptorPoolSize> sizesPerSet;
+        std::vector<Pool> pools; //the last one is the current pool
+        uint32_t nextCapacity = INITIAL_SETS_PER_POOL;
+    };
+    std::unordered_map<VkDescriptorSetLayout, LayoutPools> m_layouts;
+
+    void CreatePool(LayoutPools &layoutPools);
+};
+
+//Shares descriptor sets between users that write identical contents (layout, image views, samplers, buffers).
+//Cached sets are immutable: a user whose resources change looks up the new contents instead of rewriting its set.
+class CDescriptorCache final{
+public:
+    struct Binding{ //one descriptor per binding
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize range = 0;
+        bool operator==(const Binding &other) const;
+    };
+
+    CDescriptorCache();
+    ~CDescriptorCache();
+
+    void Init(CDescriptorAllocator *pAllocator);
+    VkDescriptorSet GetOrCreate(VkDescriptorSetLayout layout, const std::vector<Binding> &bindings);
+    //drop the sets that reference this view and recycle them for later misses of the same layout;
+    //call once no frame in flight can use the view (see CTextureStreamer::Update)
+    void EvictImageView(VkImageView imageView);
+    void Clear();
+
+    unsigned int cacheHitCount = 0;
+    unsigned int cacheMissCount = 0;
+    unsigned int recycledCount = 0;
+    uint32_t GetEntryCount();
+    float GetHitRate() { return (cacheHitCount + cacheMissCount) ? (float)cacheHitCount / (cacheHitCount + cacheMissCount) : 0.0f; }
+
+    static uint64_t Hash(VkDescriptorSetLayout layout, const std::vector<Binding> &bindings); //FNV-1a 64
+    //VkWriteDescriptorSet array for the bindings; image/buffer infos must outlive the writes (also used for push descriptors)
+    static void BuildWrites(VkDescriptorSet set, const std::vector<Binding> &bindings, std::vector<VkWriteDescriptorSet> &descriptorWrites,
+        std::vector<VkDescriptorImageInfo> &imageInfos, std::vector<VkDescriptorBufferInfo> &bufferInfos);
+
+private:
+    struct Entry{
+        VkDescriptorSetLayout layout;
+        std::vector<Binding> bindings;
+        VkDescriptorSet set;
+    };
+    CDescriptorAllocator *m_pAllocator = nullptr;
+    std::unordered_map<uint64_t, std::vector<Entry>> m_entries;
+    std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_freeSets;
+
+    void Write(VkDescriptorSet set, const std::vector<Binding> &bindings);
+};
+
+#endif
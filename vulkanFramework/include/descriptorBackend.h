@@ -0,0 +1,74 @@
+#ifndef H_DESCRIPTORBACKEND
+#define H_DESCRIPTORBACKEND
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "descriptorAllocator.h"
+
+//How graphics descriptors reach the command buffer (YAML feature_graphics_descriptor_backend):
+//MODE_DESCRIPTOR_SETS: cached descriptor sets, vkCmdBindDescriptorSets (default).
+//MODE_PUSH_DESCRIPTOR: VK_KHR_push_descriptor, the texture sampler set (set 1) is written into the command buffer in CObject::Draw;
+//  set 0 stays a descriptor set because push descriptors have no dynamic uniform buffers.
+//MODE_DESCRIPTOR_BUFFER: VK_EXT_descriptor_buffer, every set is a region of a mapped buffer (one buffer per frame in flight)
+//  selected with vkCmdSetDescriptorBufferOffsetsEXT. There are no dynamic offsets, so each object gets its own set 0 region
+//  pointing at its MVP slot; uniform buffers need device addresses.
+class CDescriptorBackend final{
+public:
+    enum Mode { MODE_DESCRIPTOR_SETS, MODE_PUSH_DESCRIPTOR, MODE_DESCRIPTOR_BUFFER };
+
+    CDescriptorBackend();
+    ~CDescriptorBackend();
+
+    //"sets", "push", "buffer" or "auto" (buffer, then push, then sets); unsupported requests fall back to descriptor sets
+    static Mode ParseMode(const std::string &name, bool bPushDescriptor, bool bDescriptorBuffer);
+    static const char *GetModeName(Mode mode);
+
+    //after the logical device exists and before the uniform buffers, layouts and pipelines are created
+    void Init(Mode requestedMode);
+    void Destroy();
+    Mode mode = MODE_DESCRIPTOR_SETS;
+
+    //creation parameters of the objects the backend works with
+    VkDescriptorSetLayoutCreateFlags GetSetLayoutFlags(bool bTextureImageSamplerSet);
+    VkPipelineCreateFlags GetPipelineCreateFlags();
+    VkBufferUsageFlags GetUniformBufferUsage();
+    VkMemoryAllocateFlags GetUniformMemoryFlags();
+    bool UseDynamicUniformBuffers() { return mode != MODE_DESCRIPTOR_BUFFER; }
+
+    //push descriptors
+    void PushDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, const std::vector<CDescriptorCache::Binding> &bindings);
+
+    //descriptor buffers: regions have the same offset in the buffer of every frame
+    void CreateDescriptorBuffers(const std::vector<VkDescriptorSetLayout> &layouts, uint32_t regionCapacity);
+    uint32_t AllocateRegion();
+    void WriteRegion(uint32_t frame, uint32_t region, VkDescriptorSetLayout layout, const std::vector<CDescriptorCache::Binding> &bindings);
+    void BindDescriptorBuffer(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber); //binds once per recording
+    void SetDescriptorBufferOffsets(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const std::vector<uint32_t> &regions); //regions of set 0, 1, ...
+    uint32_t GetRegionCount() { return m_regionCount; }
+
+private:
+    PFN_vkCmdPushDescriptorSetKHR m_vkCmdPushDescriptorSetKHR = nullptr;
+#ifdef VK_EXT_descriptor_buffer
+    PFN_vkGetDescriptorSetLayoutSizeEXT m_vkGetDescriptorSetLayoutSizeEXT = nullptr;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT m_vkGetDescriptorSetLayoutBindingOffsetEXT = nullptr;
+    PFN_vkGetDescriptorEXT m_vkGetDescriptorEXT = nullptr;
+    PFN_vkCmdBindDescriptorBuffersEXT m_vkCmdBindDescriptorBuffersEXT = nullptr;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT m_vkCmdSetDescriptorBufferOffsetsEXT = nullptr;
+    PFN_vkGetBufferDeviceAddressKHR m_vkGetBufferDeviceAddressKHR = nullptr;
+#endif
+
+    std::vector<CWxjBuffer> m_buffers; //one per frame in flight
+    std::vector<uint8_t*> m_buffersMapped;
+    std::vector<uint64_t> m_bufferAddresses; //VkDeviceAddress
+    std::unordered_map<VkBuffer, uint64_t> m_deviceAddresses; //uniform and descriptor buffers
+    VkDeviceSize m_regionSize = 0;
+    uint32_t m_regionCapacity = 0;
+    uint32_t m_regionCount = 0;
+    VkCommandBuffer m_boundCommandBuffer = VK_NULL_HANDLE;
+    uint64_t m_boundFrameNumber = 0;
+
+    uint64_t GetBufferAddress(VkBuffer buffer);
+};
+
+#endif
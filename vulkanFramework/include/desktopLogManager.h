@@ -55,17 +55,7 @@ public:
 	void setVerbose(bool b) { Verbose = b; }
 	bool getVerbose() {return Verbose; }
 
-	void printLog(std::string s);
-	void printLog(std::string s, int n);
-	void printLog(std::string s, int n0, int n1);
-	void printLog(std::string s, int n0, int n1, int n2);
-	void printLog(std::string s, float n);
-	void printLog(std::string s, float n0, float n1);
-	void printLog(std::string s0, std::string s1);
-	void printLog(std::string s, float *n, int size);
-	void printLog(std::string s, int *n, int size);
-	void printLog(std::string s, unsigned long int n);
-	void printLog(std::string s, unsigned int n);
+	void printLog(const std::string &s); //written as is: CLogger hands over whole batches of lines
 
 	void printVkError(VkResult result, std::string prefix);
 
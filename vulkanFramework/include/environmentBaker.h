@@ -0,0 +1,84 @@
+#ifndef H_ENVIRONMENTBAKER
+#define H_ENVIRONMENTBAKER
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "imageBuffer.h"
+#include "shaderManager.h"
+
+//Image based lighting preprocessing with compute shaders on the graphics queue, which owns the sampled results (shaders/environmentBaker):
+//equirectangular .hdr -> environment cube with mips -> diffuse irradiance cube, GGX prefiltered specular cube
+//(one roughness per mip) and the split sum BRDF LUT. All outputs are RGBA16F in GENERAL layout.
+//Results are cached on disk, keyed by a hash of the source file and the settings.
+class CEnvironmentBaker final{
+public:
+    enum Output { OUTPUT_ENVIRONMENT, OUTPUT_IRRADIANCE, OUTPUT_PREFILTERED, OUTPUT_BRDF_LUT, OUTPUT_COUNT };
+    struct Settings{
+        uint32_t maxEnvironmentSize = 1024; //face size is equirect width / 4, clamped to this
+        uint32_t irradianceSize = 32;
+        uint32_t prefilterSize = 128;
+        uint32_t prefilterMips = 6;         //roughness 0 .. 1 across the levels
+        uint32_t brdfLutSize = 256;
+        uint32_t irradianceSteps = 64;      //per axis of the hemisphere grid
+        uint32_t prefilterSamples = 1024;
+        uint32_t brdfLutSamples = 512;
+        bool bCache = true;
+        std::string cacheDirectory = "cache/environment/";
+    };
+    struct Result{
+        CWxjImageBuffer images[OUTPUT_COUNT]; //views are ready to sample (cubes as cube views)
+        uint32_t sizes[OUTPUT_COUNT] = {};
+        uint32_t mipLevels[OUTPUT_COUNT] = {};
+        bool bFromCache = false;
+    };
+    Settings settings;
+
+    CEnvironmentBaker();
+    ~CEnvironmentBaker();
+
+    void Bake(const std::string hdrPath, VkCommandPool &commandPool, Result &result);
+    void Destroy();
+    static bool IsCube(int output) { return output != OUTPUT_BRDF_LUT; }
+
+private:
+    enum Pass { PASS_EQUIRECT, PASS_IRRADIANCE, PASS_PREFILTER, PASS_BRDF_LUT, PASS_COUNT };
+    struct PushConstants{
+        int32_t size;
+        int32_t sourceMip;
+        float roughness;
+        uint32_t sampleCount;
+    };
+    static const uint32_t TIMESTAMP_COUNT = 6;
+
+    bool m_bInitialized = false;
+    CShaderManager m_shaderManager;
+    VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_pipelines[PASS_COUNT] = {};
+    VkSampler m_equirectSampler = VK_NULL_HANDLE;
+    VkSampler m_cubeSampler = VK_NULL_HANDLE;
+    VkQueryPool m_queryPool = VK_NULL_HANDLE; //VK_NULL_HANDLE if the graphics queue has no timestamps
+    float m_timestampPeriod = 1.0f;           //nanoseconds per tick
+    uint64_t m_timestampMask = ~0ull;
+    VkCommandPool *m_pCommandPool = nullptr;
+
+    void Init();
+    VkShaderModule LoadShader(const std::string shaderName);
+    void ReadSourceFile(const std::string hdrPath, std::vector<uint8_t> &file);
+    uint64_t GetCacheKey(const std::vector<uint8_t> &file);
+    std::string GetCachePath(uint64_t key);
+    bool LoadCache(const std::string cachePath, Result &result);
+    void SaveCache(const std::string cachePath, Result &result);
+
+    void CreateOutputs(Result &result, VkImageUsageFlags usage);
+    void CreateSampleViews(Result &result);
+    VkImageView CreateLevelView(VkImage image, uint32_t level, uint32_t layerCount);
+    void Dispatch(VkCommandBuffer commandBuffer, VkDescriptorPool descriptorPool, Pass pass, VkImageView sourceView, VkSampler sampler,
+        VkImageView targetView, uint32_t size, uint32_t layerCount, const PushConstants &pushConstants);
+
+    VkCommandBuffer BeginCommands();
+    void EndCommands(VkCommandBuffer commandBuffer);
+};
+
+#endif
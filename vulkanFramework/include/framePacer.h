@@ -0,0 +1,68 @@
+#ifndef H_FRAMEPACER
+#define H_FRAMEPACER
+
+#include "common.h"
+
+#include <deque>
+
+//When the main loop starts a frame, and how long its input waits to be seen.
+//Limiter (--target-fps): frames start on a fixed schedule. The wait sleeps in 1 ms steps while the remaining time is longer
+//than a step has been seen to take (mean + one standard deviation), then spins to the deadline. A frame that starts late
+//moves the schedule instead of bursting to catch up.
+//Present wait (VK_KHR_present_id + VK_KHR_present_wait, used when the device has them): every present gets an id, and before
+//a frame polls input it waits until the present maxQueuedFrames back is on screen. FIFO then holds at most that many
+//finished frames, instead of filling the swapchain and adding their age to the input latency.
+//Latency: from the oldest input event a frame consumed to the end of the present wait that covered the frame (input to photon;
+//an upper bound when the wait did not block), or to vkQueuePresentKHR without present wait (input to present).
+//Reported as a CPU profiler counter, the input_latency_us metric and a summary at Destroy.
+//Main thread only.
+class CFramePacer final{
+public:
+    //settings, before Init (command line: --target-fps, --max-queued-frames, --no-present-wait)
+    float targetFps = 0;          //0: no limiter
+    uint32_t maxQueuedFrames = 1; //presented frames not yet on screen when a frame starts
+    bool bUsePresentWait = true;  //when the device has it
+
+    void Init();    //after the logical device
+    void Destroy(); //latency summary
+
+    void WaitForNextFrame(); //main loop, before polling input
+    void SetInputTime(std::chrono::steady_clock::time_point time); //oldest input the current frame consumed
+    uint64_t Presenting(VkSwapchainKHR swapchain); //renderer, before vkQueuePresentKHR: the present id to chain, 0 without present wait
+    bool IsPresentWaitEnabled() const { return m_bPresentWait; }
+
+private:
+    struct PendingLatency{
+        uint64_t presentId;
+        std::chrono::steady_clock::time_point inputTime;
+    };
+    void SleepUntil(std::chrono::steady_clock::time_point deadline);
+    void SleepStep(); //about 1 ms, as precise as the platform allows
+    void WaitForPresent();
+    void RecordLatency(std::chrono::steady_clock::time_point inputTime, std::chrono::steady_clock::time_point shownTime);
+
+    bool m_bPresentWait = false;
+#if defined(VK_KHR_present_wait) && defined(VK_KHR_present_id)
+    PFN_vkWaitForPresentKHR m_pfnWaitForPresent = nullptr;
+#endif
+    VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+    uint64_t m_presentId = 0; //last id given to a present
+    uint64_t m_shownId = 0;   //last id known to be on screen
+    std::deque<PendingLatency> m_pendingLatencies;
+    std::chrono::steady_clock::time_point m_inputTime; //of the frame being built, zero: no input
+
+    std::chrono::steady_clock::time_point m_nextFrameTime; //limiter schedule
+    uint32_t m_sleepSamples = 0; //sleep step statistics (Welford), microseconds
+    double m_sleepMean = 0;
+    double m_sleepM2 = 0;
+    double m_sleepEstimate = 2000;
+#ifdef _WIN32
+    void *m_hTimer = nullptr; //high resolution waitable timer, if the system has it
+#endif
+
+    uint64_t m_latencyCount = 0;
+    double m_latencySumMs = 0;
+    double m_latencyMaxMs = 0;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef H_GOLDENIMAGE
+#define H_GOLDENIMAGE
+
+#include "common.h"
+#include "context.h"
+
+//Compares a read-back frame with a stored golden PNG.
+//The metric is perceptual: per pixel CIE76 delta E in Lab space (about 2.3 is a just noticeable difference),
+//and the frame passes when at most maxBadPixelFraction of the pixels exceed deltaEThreshold, so driver rounding and
+//slightly different rasterization on edges do not fail a run. A missing golden image fails the run, unless the update
+//mode writes the frame as the golden image instead: UPDATE_MISSING only where there is none (--create-missing-golden,
+//the ctest runs), UPDATE_ALWAYS over any existing image (--update-golden or VKP_UPDATE_GOLDEN=1).
+class CGoldenImage final{
+public:
+    enum UpdateMode { UPDATE_NEVER, UPDATE_MISSING, UPDATE_ALWAYS };
+    struct Result{
+        bool bPass = false;
+        bool bCreated = false;     //the frame was written as the new golden image (update mode)
+        float badPixelFraction = 0;
+        float maxDeltaE = 0;
+    };
+
+    //pixels: tightly packed RGBA8/BGRA8 (as CImageWriter); on failure a difference image is written to diffPath (if not empty)
+    static Result Compare(const std::string &goldenPath, uint32_t width, uint32_t height, VkFormat format, const void *pixels,
+        float deltaEThreshold = 2.3f, float maxBadPixelFraction = 0.001f, const std::string &diffPath = "", UpdateMode updateMode = UPDATE_NEVER);
+
+private:
+    static void ToLab(const uint8_t *rgb, float lab[3]);
+};
+
+#endif
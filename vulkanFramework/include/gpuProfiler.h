@@ -0,0 +1,86 @@
+#ifndef H_GPUPROFILER
+#define H_GPUPROFILER
+
+#include "common.h"
+#include "context.h"
+
+#include <map>
+
+//GPU time per pass, from timestamp queries.
+//Every frame in flight has its own timestamp pool per queue (graphics, compute), reset at the start of the command
+//buffer, so recording never touches queries the GPU may still write. CRenderer opens a root scope per command buffer
+//and nested scopes around the render pass, each subpass, dispatches and object draws (BeginScope/EndScope can be used
+//by samples too). Resolve() reads the slot after its fence/timeline wait, MAX_FRAMES_IN_FLIGHT frames later, and never
+//waits: results that are not available yet are skipped.
+//Optional pipeline statistics (vertices, vertex/fragment/compute invocations, clipped primitives) cover each command
+//buffer as a whole: statistics queries of the same type can not nest, and a query begun in a subpass must end there.
+//Output: a rolling average per scope name on the console, a CSV row per scope and frame, a Chrome trace (chrome://tracing, Perfetto).
+class CGpuProfiler final{
+public:
+    enum Queue { QUEUE_GRAPHICS, QUEUE_COMPUTE, QUEUE_COUNT };
+    enum Statistic { STAT_VERTICES, STAT_VERTEX_INVOCATIONS, STAT_CLIPPING_PRIMITIVES, STAT_FRAGMENT_INVOCATIONS, STAT_COMPUTE_INVOCATIONS, STAT_COUNT };
+    struct ScopeResult{
+        std::string name;
+        Queue queue;
+        uint32_t depth;    //0: the command buffer
+        double startMs;    //from the first resolved timestamp
+        double durationMs;
+    };
+
+    CGpuProfiler();
+    ~CGpuProfiler();
+
+    //settings, before Init (command line: --gpu-profile, --gpu-csv, --gpu-trace, --pipeline-statistics)
+    bool bEnabled = false;
+    bool bPipelineStatistics = false;
+    std::string csvPath;
+    std::string tracePath;
+    uint32_t summaryInterval = 1000; //frames between console summaries, 0: only at Destroy
+
+    void Init(uint32_t computeQueueFamily, uint32_t maxScopes = 256); //disables itself if the queues have no timestamps
+    void Destroy(); //writes the trace and the final summary
+
+    void BeginCommandBuffer(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue); //outside any render pass
+    void EndCommandBuffer(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue);
+    int BeginScope(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue, const std::string &name); //-1: disabled or full
+    void EndScope(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue, int scope);
+    void Submitted(uint32_t frame, Queue queue, uint64_t frameNumber);
+    void Resolve(uint32_t frame); //after the slot's wait
+
+    std::vector<ScopeResult> lastResults;   //scopes of the latest resolved command buffers
+    std::map<std::string, double> averages; //ms per scope name, moving average
+    uint64_t statistics[QUEUE_COUNT][STAT_COUNT] = {}; //latest resolved command buffer
+    uint32_t droppedScopes = 0; //more scopes than queries in a command buffer
+    void PrintSummary();
+
+private:
+    struct Scope{
+        std::string name;
+        uint32_t depth;
+        bool bClosed;
+    };
+    struct Slot{
+        VkQueryPool timestampPool = VK_NULL_HANDLE;
+        VkQueryPool statisticsPool = VK_NULL_HANDLE;
+        std::vector<Scope> scopes; //kept until the command buffer is recorded again (pre-recorded buffers are resolved every submit)
+        uint32_t depth = 0;
+        bool bPending = false;
+        uint64_t frameNumber = 0;
+    };
+    Slot &GetSlot(uint32_t frame, Queue queue){ return m_slots[frame * QUEUE_COUNT + queue]; }
+    void WriteTraceEvent(const ScopeResult &result, uint64_t frameNumber);
+
+    std::vector<Slot> m_slots; //[frame * QUEUE_COUNT + queue]
+    bool m_bQueueEnabled[QUEUE_COUNT] = {false, false};
+    uint32_t m_maxScopes = 0;
+    float m_timestampPeriod = 1.0f; //ns per tick
+    uint64_t m_timestampMask = ~0ull;
+    uint64_t m_baseTimestamp = 0;
+    bool m_bBaseTimestamp = false;
+    uint64_t m_lastSummaryFrame = 0;
+    std::ofstream m_csv;
+    std::ofstream m_trace;
+    bool m_bFirstTraceEvent = true;
+};
+
+#endif
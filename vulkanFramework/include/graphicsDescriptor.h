@@ -4,6 +4,9 @@
 #include "context.h"
 #include "dataBuffer.hpp"
 #include "../include/texture.h"
+#include "descriptorAllocator.h"
+#include "descriptorBackend.h"
+#include "samplerCache.h"
 
 class CGraphicsDescriptorManager{
 public:
@@ -14,8 +17,11 @@ public:
      * Pool
      ************/
     static int graphicsUniformTypes;
-    static VkDescriptorPool graphicsDescriptorPool;
-    static std::vector<VkDescriptorPoolSize> graphicsDescriptorPoolSizes;
+    static CDescriptorAllocator descriptorAllocator; //growable pools per layout, for the general and texture sampler sets
+    static CDescriptorCache descriptorCache;         //objects with identical textures/samplers share one set
+    static unsigned int expectedObjectCount;         //sizes the first texture sampler pool
+    static CDescriptorBackend descriptorBackend;     //descriptor sets, push descriptors or descriptor buffers
+    static CSamplerCache samplerCache;               //texture and depth samplers, one VkSampler per distinct state
     static void createDescriptorPool(unsigned int object_count = 0);
     
     /************
@@ -32,6 +38,9 @@ public:
      ************/
     std::vector<VkDescriptorSet> descriptorSets_general; //one descriptor set for each host resource (MAX_FRAMES_IN_FLIGHT)
     void createDescriptorSets_General(VkImageView depthImageView);
+    //contents of set 0 for one frame; without dynamic uniform buffers (descriptor buffer backend) MVP/VP point at the object's slot
+    void getBindings_General(size_t frame, int object_id, std::vector<CDescriptorCache::Binding> &bindings);
+    VkImageView m_depthImageView = VK_NULL_HANDLE;
 
     /************
      * 1 GRAPHCIS_UNIFORMBUFFER_CUSTOM
@@ -77,8 +86,8 @@ public:
      * 5 GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE
      ************/
     static unsigned int textureImageSamplerSize;
-    static std::vector<VkSampler> textureImageSamplers;
-    static void addTextureImageSamplerUniformBuffer(std::vector<int> mipLevels);
+    static std::vector<VkSampler> textureImageSamplers; //one per YAML sampler entry (uniform_Sampler_id); entries with the same state share a sampler
+    static void addTextureImageSamplerUniformBuffer(std::vector<CSamplerCache::Key> samplerKeys);
 
     /************
      * 6 GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE
@@ -14,7 +14,9 @@ public:
 	VkImage	image;
 	VkDeviceMemory deviceMemory;
 	VkDeviceSize size;
+    uint32_t memoryType = 0; //of deviceMemory, for CMetrics
     VkImageView view;
+    VkImageCreateFlags createFlags = 0; //extra flags for createImage(), e.g. MUTABLE_FORMAT for a UNORM storage view of an sRGB image
 
     CWxjImageBuffer();
     ~CWxjImageBuffer();
@@ -0,0 +1,24 @@
+#ifndef H_IMAGEWRITER
+#define H_IMAGEWRITER
+
+#include "common.h"
+#include "context.h"
+
+//Writes read-back frames to disk without a third party library:
+//PNG with stored (uncompressed) deflate blocks, OpenEXR with uncompressed 32 bit float scanlines.
+//Input is tightly packed 4 byte pixels of a swapchain-like format (RGBA8/BGRA8, UNORM or SRGB).
+class CImageWriter final{
+public:
+    static bool IsSupportedFormat(VkFormat format);
+
+    //picks PNG or EXR by the extension of path (.exr, anything else is PNG). EXR gets linear values: sRGB formats are decoded
+    static bool Write(const std::string &path, uint32_t width, uint32_t height, VkFormat format, const void *pixels);
+
+    static bool WritePNG(const std::string &path, uint32_t width, uint32_t height, const uint8_t *rgba);
+    static bool WriteEXR(const std::string &path, uint32_t width, uint32_t height, const float *rgba);
+
+    //to RGBA8 in memory order R, G, B, A (swizzles BGRA formats)
+    static void ToRGBA8(uint32_t width, uint32_t height, VkFormat format, const void *pixels, std::vector<uint8_t> &rgba);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef H_INPUTLOG
+#define H_INPUTLOG
+
+#include "common.h"
+
+#include <deque>
+
+//Window system independent camera input, so a run can be recorded and replayed.
+//SDL/GLFW handlers Push() actions instead of changing mainCamera; CApplication::update() collects them before
+//every simulation step (every frame without --fixed-step) and applies them, so live and replayed input take effect
+//at the same step. The log is text: a header, one line per event "step action axis x y", and the number of frames.
+//Replay is frame-exact when the frame clock is fixed too (--fixed-step in a headless run); with the wall clock only the simulation
+//steps are reproducible, not how many of them a frame takes.
+class CInputLog final{
+public:
+    enum Action : uint32_t {
+        CAMERA_VELOCITY,         //axis 0/1/2: Velocity[axis] = x
+        CAMERA_ANGULAR_VELOCITY, //mouse look: AngularVelocity.xy = (x, y), FREE camera only
+        CAMERA_TOGGLE_TYPE,      //LOCK <-> FREE
+        CAMERA_WHEEL,            //x, y: sign of the horizontal/vertical wheel movement
+        FOCUS_NEXT_OBJECT,       //LOCK camera only
+        ACTION_COUNT
+    };
+    struct Event{
+        uint64_t step;
+        Action action;
+        int32_t axis;
+        float x, y;
+    };
+
+    void Push(Action action, int32_t axis = 0, float x = 0, float y = 0); //live input, ignored while replaying
+    void Collect(uint64_t step, std::vector<Event> &events); //events for this step: live ones (recorded), or replayed ones
+    //when the oldest live event collected since the last call was pushed, zero if there was none (input latency)
+    std::chrono::steady_clock::time_point TakeInputTime();
+
+    bool Record(const std::string &path, float fixedStep);
+    bool Replay(const std::string &path, float fixedStep);
+    void Save(uint64_t frames); //writes the recording
+
+    bool bRecording = false;
+    bool bReplaying = false;
+    uint64_t recordedFrames = 0; //frames of the replayed run
+
+private:
+    std::string m_path;
+    float m_fixedStep = 0;
+    std::deque<Event> m_pending;   //live: pushed since the last Collect; replay: not yet due
+    std::vector<Event> m_recorded;
+    float m_lastLook[2] = {0, 0};  //mouse look is pushed every poll, only changes are kept
+    bool m_bLookValid = false;
+    std::chrono::steady_clock::time_point m_pendingTime;   //push of the oldest event in m_pending (live)
+    std::chrono::steady_clock::time_point m_collectedTime; //of the oldest event collected since TakeInputTime
+};
+
+#endif
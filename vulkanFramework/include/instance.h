@@ -12,6 +12,7 @@ public:
     ~CInstance();
 
     VkInstance handle{VK_NULL_HANDLE};
+    uint32_t apiVersion = VK_API_VERSION_1_0; //requested in VkApplicationInfo
     VkInstance getHandle() const{ return handle;}
 
     //CDebugger * debugger;
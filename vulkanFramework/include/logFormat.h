@@ -0,0 +1,95 @@
+#ifndef H_LOGFORMAT
+#define H_LOGFORMAT
+
+//Standard library only: the offline decoder (tools/logdecode) builds this without Vulkan.
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+enum LogLevel : uint32_t { LOG_LEVEL_VERBOSE, LOG_LEVEL_INFO, LOG_LEVEL_WARNING, LOG_LEVEL_ERROR, LOG_LEVEL_COUNT };
+enum LogCategory : uint32_t { LOG_CATEGORY_GENERAL, LOG_CATEGORY_DEVICE, LOG_CATEGORY_SWAPCHAIN, LOG_CATEGORY_TEXTURE, LOG_CATEGORY_RENDERER, LOG_CATEGORY_COUNT };
+
+//What CLogger (text, writer thread) and the binary log decoder share: log arguments, the printf style formatter,
+//level and category names, and the layout of the binary log file written by CBinaryLog.
+class CLogFormat final{
+public:
+    struct Arg{
+        enum Type : uint8_t { INT, UINT, DOUBLE, STRING, POINTER } type;
+        union{
+            int64_t i;
+            uint64_t u;
+            double d;
+            const void *p;
+        };
+        std::string s;
+    };
+
+    //argument type of a C++ type, also its letter in a binary call site signature
+    template<typename T>
+    static constexpr char TypeCode(){
+        using D = std::decay_t<T>;
+        if constexpr(std::is_same_v<D, bool> || std::is_enum_v<D>) return 'i';
+        else if constexpr(std::is_integral_v<D> && std::is_signed_v<D>) return 'i';
+        else if constexpr(std::is_integral_v<D>) return 'u';
+        else if constexpr(std::is_floating_point_v<D>) return 'd';
+        else if constexpr(std::is_same_v<D, char*> || std::is_same_v<D, const char*>) return 's';
+        else if constexpr(std::is_convertible_v<const T&, std::string>) return 's';
+        else if constexpr(std::is_pointer_v<D>) return 'p';
+        else static_assert(sizeof(D) == 0, "log: unsupported argument type");
+    }
+    template<typename T>
+    static Arg MakeArg(const T &value){
+        constexpr char code = TypeCode<T>();
+        Arg arg;
+        if constexpr(code == 'i'){ arg.type = Arg::INT; arg.i = (int64_t)value; }
+        else if constexpr(code == 'u'){ arg.type = Arg::UINT; arg.u = (uint64_t)value; }
+        else if constexpr(code == 'd'){ arg.type = Arg::DOUBLE; arg.d = (double)value; }
+        else if constexpr(code == 'p'){ arg.type = Arg::POINTER; arg.p = (const void*)value; }
+        else if constexpr(std::is_pointer_v<std::decay_t<T>>){ arg.type = Arg::STRING; arg.s = value ? value : "(null)"; }
+        else{ arg.type = Arg::STRING; arg.s = value; }
+        return arg;
+    }
+
+    static std::string Format(const std::string &format, const std::vector<Arg> &args);
+    static std::string FormatList(const std::string &prefix, const std::vector<Arg> &args); //prefix, then "value, " per argument
+    static const char *GetLevelName(LogLevel level);
+    static const char *GetCategoryName(LogCategory category);
+
+    /*******************
+    *	Binary log file: header, call site table, ring of records
+    ********************/
+    static const uint32_t BINARY_VERSION = 1;
+    struct BinaryHeader{
+        char magic[8];           //"VKBLOG1"
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t siteTableSize;  //bytes reserved for call sites, right after the header
+        uint64_t ringSize;       //bytes of the ring after the site table, power of two
+        uint64_t writeOffset;    //bytes ever reserved in the ring (atomic while the process runs)
+        uint64_t siteTableUsed;  //bytes of complete call site entries
+        uint64_t droppedRecords; //call sites that did not fit into the table, oversized records
+        uint64_t baseTicks;      //record ticks at open
+        double ticksPerMicrosecond;
+        int64_t startTime;       //microseconds since 1970 at open
+    };
+    //call site entry: this struct, then file, format and signature (one TypeCode letter per argument), each \0 terminated
+    struct BinarySite{
+        uint32_t size; //of the whole entry, multiple of 8
+        uint32_t id;   //index in the table
+        uint32_t line;
+        uint8_t level;
+        uint8_t category;
+        uint16_t reserved;
+    };
+    //ring record: this struct, then the arguments: 8 bytes each (i, u, d, p), strings as a 32 bit length and the bytes
+    struct BinaryRecord{
+        uint64_t offset; //absolute ring offset of the record, stored last: a record is complete when this matches its position
+        uint32_t size;   //of the whole record, multiple of 8
+        uint32_t site;
+        uint64_t ticks;
+    };
+    static bool DecodeArgs(const char *signature, const uint8_t *payload, size_t size, std::vector<Arg> &args); //false if the payload does not match
+};
+
+#endif
@@ -2,41 +2,42 @@
 #define H_LOGMANAGER
 
 #include "common.h"
+#include "binaryLog.h"
 
-#ifndef ANDROID
-    //#include "..\\..\\windowsFramework\\include\\windowsLogManager.h"
-    #include "desktopLogManager.h"
-#else
-    #include "..\\..\\androidFramework\\include\\androidLogManager.h"
-#endif
-
+//Per class front end of CLogger: knows the class's log file and category.
+//print("format %d %s", n, s) takes any number of arguments of any integer, enum, floating point, string or pointer
+//type; they are copied and formatted later by the writer thread.
 class CLogManager {
 public:
     CLogManager();
     ~CLogManager();
 
-#ifndef ANDROID
-    void setLogFile(std::string s);
-#endif
+    void setLogFile(std::string s, LogCategory category = LOG_CATEGORY_GENERAL); //../logs/s; logcat on Android
+
+    template<typename... Args> void print(const std::string &format, const Args&... args){ log<LOG_LEVEL_INFO>(format, args...); }
+    template<typename... Args> void verbose(const std::string &format, const Args&... args){ log<LOG_LEVEL_VERBOSE>(format, args...); }
+    template<typename... Args> void warning(const std::string &format, const Args&... args){ log<LOG_LEVEL_WARNING>(format, args...); }
+    template<typename... Args> void error(const std::string &format, const Args&... args){ log<LOG_LEVEL_ERROR>(format, args...); }
+    template<typename... Args> void printSite(std::atomic<uint32_t> &site, const char *file, int line, const char *format, const Args&... args){
+        if(CBinaryLog::IsOpen()) CBinaryLog::Log(site, LOG_LEVEL_INFO, m_category, file, line, format, args...);
+        else print(format, args...);
+    }
+    void print(std::string s, float *n, int size){ CLogger::LogList(LOG_LEVEL_INFO, m_category, m_sink, s, n, size); }
+    void print(std::string s, int *n, int size){ CLogger::LogList(LOG_LEVEL_INFO, m_category, m_sink, s, n, size); }
 
-    void print(std::string s);
-    void print(std::string s, int n); 
-    void print(std::string s, int n0, int n1);
-    void print(std::string s, int n0, int n1, int n2);
-    void print(std::string s, float n);
-    void print(std::string s, float n0, float n1);
-    void print(std::string s0, std::string s1);
-    void print(std::string s, float *n, int size);
-    void print(std::string s, int *n, int size);
-    void print(std::string s, unsigned long int n); //uint32_t
-    void print(std::string s, unsigned int n);
+    template<LogLevel level, typename... Args> void log(const std::string &format, const Args&... args){
+        if constexpr(level >= LOG_COMPILE_LEVEL)
+            if((LOG_COMPILE_CATEGORIES >> m_category) & 1u) CLogger::Log(level, m_category, m_sink, format, args...);
+    }
 
 private:
-#ifndef ANDROID
-    CDesktopLogManager desktopLogManager;
-#else
-    CAndroidLogManager androidLogManager;
-#endif
+    LogCategory m_category = LOG_CATEGORY_GENERAL;
+    int m_sink = -1;
 };
 
-#endif
\ No newline at end of file
+//LOG_SITE(logManager, "format %d", n): logManager.print, but a binary record (nothing formatted) when --binary-log is on
+#define LOG_SITE(logManager, ...) do{ \
+    static std::atomic<uint32_t> logSite{CBinaryLog::SITE_NONE}; \
+    (logManager).printSite(logSite, __FILE__, __LINE__, __VA_ARGS__); }while(0)
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef H_LOGGER
+#define H_LOGGER
+
+#include "common.h"
+#include "logFormat.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#ifndef ANDROID
+    #include "desktopLogManager.h"
+#else
+    #include "../../androidFramework/include/androidLogManager.h"
+#endif
+
+//compile time filter: calls below this level, or of a category not in this mask, compile to nothing
+#ifndef LOG_COMPILE_LEVEL
+    #ifdef NDEBUG
+        #define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+    #else
+        #define LOG_COMPILE_LEVEL LOG_LEVEL_VERBOSE
+    #endif
+#endif
+#ifndef LOG_COMPILE_CATEGORIES
+    #define LOG_COMPILE_CATEGORIES 0xffffffffu
+#endif
+
+//Asynchronous log backend behind CLogManager and PRINT.
+//A call copies its format string and arguments into a record and pushes it on a lock-free multi producer, single
+//consumer queue (Vyukov's intrusive list: one atomic exchange per record, producers never wait for each other or the writer).
+//Records come from a preallocated pool (a tagged lock-free free list the writer returns them to); their strings and argument
+//vectors keep their capacity, so a steady log rate allocates nothing. Only a burst larger than the pool falls back to new.
+//The writer thread formats the records (CLogFormat: printf syntax, converted to each argument's real type, so a %d given a float
+//prints the float's value instead of garbage) and writes them to their sinks in one batch every few milliseconds.
+//Sinks are the log files of setLogFile (../logs/), logcat on Android, or stdout. Everything queued is written at
+//Shutdown (registered with atexit), on Flush(), and on a crash signal or std::terminate (best effort: the crash handler never
+//waits on a lock another thread may hold; records it can't give to their file go straight to the stderr file descriptor).
+class CLogger final{
+public:
+    using Arg = CLogFormat::Arg;
+
+    //run time filter (command line: --log-level, --log-categories)
+    static std::atomic<uint32_t> minLevel;
+    static std::atomic<uint32_t> categoryMask;
+
+    static inline bool IsEnabled(LogLevel level, LogCategory category){
+        return level >= minLevel.load(std::memory_order_relaxed) && ((categoryMask.load(std::memory_order_relaxed) >> category) & 1u);
+    }
+    static constexpr bool IsCompiledIn(LogLevel level, LogCategory category){
+        return level >= LOG_COMPILE_LEVEL && ((LOG_COMPILE_CATEGORIES >> category) & 1u);
+    }
+
+    static int AddSink(const std::string &path); //a log file, -1 is stdout (logcat on Android)
+
+    template<typename... Args>
+    static void Log(LogLevel level, LogCategory category, int sink, const std::string &format, const Args&... args){
+        if(!IsEnabled(level, category)) return;
+        Record *record = NewRecord(level, category, sink, format);
+        record->args.reserve(sizeof...(Args));
+        (Capture(record->args, args), ...);
+        Push(record);
+    }
+    template<typename T>
+    static void LogList(LogLevel level, LogCategory category, int sink, const std::string &prefix, const T *values, int size){
+        if(!IsEnabled(level, category)) return;
+        Record *record = NewRecord(level, category, sink, prefix);
+        record->bList = true;
+        for(int i = 0; i < size; i++) Capture(record->args, values[i]);
+        Push(record);
+    }
+
+    static void Flush();    //returns when everything logged before the call is written
+    static void Shutdown(); //flushes and stops the writer; later records are written by the caller
+
+    static bool ParseLevel(const std::string &name, LogLevel &level);
+    static uint32_t ParseCategories(const std::string &list); //comma separated names, or "all"
+
+private:
+    static const uint32_t POOL_SIZE = 4096;
+    static const uint32_t NOT_POOLED = 0xffffffffu;
+    struct Record{
+        std::atomic<Record*> next{nullptr};
+        uint32_t poolIndex = NOT_POOLED;
+        std::atomic<uint32_t> nextFree{0}; //free list link: pool index + 1, 0 ends the list
+        LogLevel level;
+        LogCategory category;
+        int sink;
+        bool bList = false; //format, then every argument followed by ", "
+        double time;        //seconds since the first record
+        std::string format;
+        std::vector<Arg> args;
+    };
+    struct Sink{
+        std::string path;
+#ifndef ANDROID
+        CDesktopLogManager file;
+#endif
+        std::string batch;
+    };
+
+    template<typename T>
+    static void Capture(std::vector<Arg> &args, const T &value){ args.push_back(CLogFormat::MakeArg(value)); }
+
+    static Record *NewRecord(LogLevel level, LogCategory category, int sink, const std::string &format);
+    static void FreeRecord(Record *record); //writer (or crash handler) only
+    static void Push(Record *record);
+    static void Enqueue(Record *record);
+    static Record *Pop(); //writer (or crash handler) only
+    static void Start();
+    static void WriterLoop();
+    static bool WriteBatch(); //false if the queue was empty
+    static void Write(Record &record);
+    static void WriteSinks(); //the batch of every file, s_sinkMutex held
+    static void CrashFlush();
+    static void WriteRaw(const std::string &text); //stderr file descriptor, no locks and no buffers
+    static void OnSignal(int signal);
+
+    static Record s_pool[POOL_SIZE];
+    static std::atomic<uint64_t> s_freeHead; //low 32 bits: pool index + 1 (0: empty), high 32 bits: tag, bumped on every change against ABA
+    static Record s_stub;
+    static std::atomic<Record*> s_head; //producers
+    static Record *s_tail;              //consumer
+    static std::atomic_flag s_consuming; //held while a batch is written, or by the crash handler once it is free
+    static std::atomic<std::thread::id> s_consumer; //thread holding s_consuming
+    static std::atomic<uint64_t> s_pushed;
+    static std::atomic<uint64_t> s_written;
+    static std::once_flag s_startFlag;
+    static std::thread s_writer;
+    static std::mutex s_wakeMutex;
+    static std::condition_variable s_wake;
+    static std::atomic<bool> s_bQuit;
+    static std::atomic<bool> s_bStopped;
+    static std::mutex s_sinkMutex;
+    static std::vector<std::unique_ptr<Sink>> s_sinks;
+    static std::chrono::steady_clock::time_point s_startTime;
+#ifdef ANDROID
+    static CAndroidLogManager s_androidLog;
+#endif
+};
+
+//LOG(LOG_LEVEL_WARNING, LOG_CATEGORY_RENDERER, "format %d", n): compile time filtered, written to stdout/logcat
+#define LOG(level, category, ...) do{ if constexpr(CLogger::IsCompiledIn(level, category)) CLogger::Log(level, category, -1, __VA_ARGS__); }while(0)
+
+#endif
@@ -14,6 +14,11 @@ public:
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
 	VkQueue computeQueue;
+	VkQueue asyncComputeQueue = VK_NULL_HANDLE; //separate queue for compute that can run alongside graphics
+	uint32_t graphicsFamily = 0;
+	uint32_t asyncComputeFamily = 0;
+	VkQueue transferQueue = VK_NULL_HANDLE; //transfer-only queue for uploads
+	uint32_t transferFamily = 0;
 
     //VkDevice handle{VK_NULL_HANDLE};
     //VkDevice getHandle() const{ return handle;}
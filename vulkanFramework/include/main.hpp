@@ -1,11 +1,21 @@
 #ifndef H_MAIN
 #define H_MAIN
 
-int main(){
+//sample.exe [--headless | --headless-surface] [--frames N] [--capture frame.png|frame.exr]
+//           [--golden golden.png] [--tolerance deltaE] [--update-golden | --create-missing-golden] [--report report.json]
+//           [--fixed-step seconds] [--record-input input.log | --replay-input input.log]
+//           [--gpu-profile] [--gpu-csv gpu.csv] [--gpu-trace gpu.json] [--pipeline-statistics]
+//           [--cpu-profile] [--cpu-trace cpu.json]
+//           [--log-level verbose|info|warning|error] [--log-categories device,texture,...|all] [--binary-log log.blog]
+//           [--metrics] [--metrics-port 9100] [--metrics-log seconds]
+//           [--present immediate|mailbox|fifo|fifo-relaxed] [--target-fps 120] [--max-queued-frames 1] [--no-present-wait]
+//           [--descriptor-backend sets|push|buffer|auto]
+int main(int argc, char **argv){
 	TEST_CLASS_NAME app;
 	app.m_sampleName = TOSTRING(TEST_CLASS_NAME);
 
 	try {
+		app.ParseCommandLine(argc, argv);
 		app.run();
 	}
 	catch (const std::exception& e) {
@@ -13,7 +23,7 @@ int main(){
 		return EXIT_FAILURE;
 	}
 
-	return EXIT_SUCCESS;
+	return app.exitCode;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef H_METRICS
+#define H_METRICS
+
+#include "common.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+//Runtime metrics: counters, gauges and frame time histograms, updated by CRenderer (frames), CWxjBuffer and
+//CWxjImageBuffer (live objects and GPU memory per heap), the descriptor managers (pools, sets) and CUploadService (queue depth).
+//Read through a Prometheus text endpoint on 127.0.0.1 (GET /metrics) and a periodic dump to ../logs/metrics.log.
+//Metrics are registered once (the returned reference stays valid) and updated with relaxed atomics from any thread;
+//while bEnabled is false an update is one predictable branch.
+//Command line: --metrics, --metrics-port N, --metrics-log seconds
+class CMetrics final{
+public:
+    class Counter{ //only goes up
+    public:
+        void Add(uint64_t n = 1){ if(bEnabled) m_value.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<uint64_t> m_value{0};
+    };
+    class Gauge{
+    public:
+        void Set(int64_t value){ if(bEnabled) m_value.store(value, std::memory_order_relaxed); }
+        void Add(int64_t n){ if(bEnabled) m_value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<int64_t> m_value{0};
+    };
+    //HDR style: exact below 128 units, then 64 linear buckets per power of two (under 1.6% error), up to 2^40 units.
+    //One atomic add per sample, no allocation; values are in microseconds for frame times.
+    class Histogram{
+    public:
+        static const uint32_t SUB_BUCKETS = 64;
+        static const uint32_t BUCKET_COUNT = 2 * SUB_BUCKETS + 34 * SUB_BUCKETS;
+        void Record(uint64_t value);
+        uint64_t Percentile(double fraction) const; //0..1, bucket midpoint
+        uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+        uint64_t GetSum() const { return m_sum.load(std::memory_order_relaxed); }
+        uint64_t GetMax() const { return m_max.load(std::memory_order_relaxed); }
+    private:
+        static uint32_t BucketOf(uint64_t value);
+        static uint64_t ValueOf(uint32_t bucket);
+        std::atomic<uint64_t> m_buckets[BUCKET_COUNT] = {};
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<uint64_t> m_sum{0};
+        std::atomic<uint64_t> m_max{0};
+    };
+
+    //settings, before Init (command line)
+    static bool bEnabled;
+    static uint16_t httpPort;  //0: no endpoint
+    static float logInterval;  //seconds between dumps to metrics.log, 0: only at Destroy
+
+    static void Init();    //after the command line: starts the endpoint
+    static void Destroy(); //stops the endpoint, writes a last dump
+    static void Update();  //main thread, once per frame: fps, periodic dump
+
+    //name in Prometheus style (snake_case, unit suffix), labels like heap="0"; the same name and labels return the same metric
+    static Counter &GetCounter(const std::string &name, const std::string &help, const std::string &labels = "");
+    static Gauge &GetGauge(const std::string &name, const std::string &help, const std::string &labels = "");
+    static Histogram &GetHistogram(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    static void TrackGpuMemory(uint32_t memoryTypeIndex, int64_t bytes); //device memory allocated (+) or freed (-), per heap
+    static std::string GetText(); //Prometheus text exposition format
+
+private:
+    enum Type { TYPE_COUNTER, TYPE_GAUGE, TYPE_HISTOGRAM };
+    struct Entry{
+        std::string name;
+        std::string labels;
+        std::string help;
+        Type type;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+    static Entry &GetEntry(const std::string &name, const std::string &help, const std::string &labels, Type type);
+    static void Dump();
+    static void ServerLoop();
+
+    static std::mutex s_mutex; //guards s_entries
+    static std::map<std::pair<std::string, std::string>, std::unique_ptr<Entry>> s_entries; //by name, labels: the text output is grouped by name
+    static std::thread s_server;
+    static std::atomic<bool> s_bQuit;
+    static int s_logSink;
+    static std::chrono::steady_clock::time_point s_lastDump;
+    static std::chrono::steady_clock::time_point s_lastFpsTime;
+    static uint64_t s_lastFpsFrames;
+    static std::vector<uint32_t> s_heapOfType;
+};
+
+#endif
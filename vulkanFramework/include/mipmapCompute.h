@@ -0,0 +1,52 @@
+#ifndef H_MIPMAPCOMPUTE
+#define H_MIPMAPCOMPUTE
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "shaderManager.h"
+
+//GPU mip chain builder: one compute dispatch reduces level 0 to up to 12 more levels (single pass downsampler,
+//shaders/mipmapSpd). Every level is bound as an RGBA8 UNORM storage view, sRGB images are converted in the shader,
+//so the image needs STORAGE usage and, when its format is sRGB, VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT.
+//Cubemaps and arrays run one z-slice of workgroups per layer.
+class CMipmapCompute final{
+public:
+    static const uint32_t MAX_LEVELS = 13; //level 0 + 12, level 0 at most 4096
+    static const uint32_t MAX_LAYERS = 6;
+
+    CMipmapCompute();
+    ~CMipmapCompute();
+
+    bool Init(); //false if the shader is missing, callers then fall back to the blit path
+    void Destroy();
+    bool IsAvailable() { return m_pipeline != VK_NULL_HANDLE; }
+    bool bInitTried = false;
+    bool bSubgroup = false; //quad subgroup shader variant in use
+
+    bool CanGenerate(VkFormat format, uint32_t mipLevels, uint32_t width = 0, uint32_t height = 0);
+
+    //layers [0, layerCount) of level 0 are read in oldLayout (TRANSFER_DST or GENERAL), every level ends in finalLayout
+    void Generate(VkCommandPool &commandPool, VkImage image, VkFormat format, uint32_t width, uint32_t height,
+        uint32_t mipLevels, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout finalLayout);
+
+private:
+    CShaderManager m_shaderManager;
+    VkShaderModule m_shaderModule = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+    CWxjBuffer m_counterBuffer; //one atomic counter per layer, the shader resets it after use
+
+    struct PushConstants{
+        int32_t width, height;
+        uint32_t mipCount;
+        uint32_t groupCount;
+        uint32_t bSrgb;
+    };
+
+    bool LoadShader(const std::string shaderName);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef H_MIPMAPGENERATOR
+#define H_MIPMAPGENERATOR
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+//CPU mip chain builder for RGBA 8 bit (sRGB or UNORM) and RGBA 16 bit UNORM texels.
+//Every level is filtered from the previous one in linear float space with a separable kernel, rows are split into
+//bands across threads. The inner loops use AVX2 (build with MIPMAP_AVX2), SSE2 or NEON, with a scalar fallback.
+//Does not need SAMPLED_IMAGE_FILTER_LINEAR support, unlike the vkCmdBlitImage path.
+class CMipmapGenerator final{
+public:
+    enum Filter { FILTER_BOX, FILTER_KAISER, FILTER_LANCZOS };
+    struct Options{
+        Filter filter = FILTER_BOX;
+        bool bSrgb = true;        //8 bit only: RGB is decoded to linear before filtering, alpha is always linear
+        float alphaCutoff = 0.0f; //> 0: scale alpha per level so the alpha test coverage at this cutoff matches level 0
+        unsigned threads = 0;     //0: std::thread::hardware_concurrency()
+    };
+
+    //texels: level 0, RGBA with bytesPerChannel 1 or 2
+    //out receives all mipLevels back to back (level 0 included), level i starts at levelOffsets[i]
+    static void Generate(const void *texels, uint32_t width, uint32_t height, uint32_t bytesPerChannel, uint32_t mipLevels,
+        const Options &options, std::vector<uint8_t> &out, std::vector<size_t> &levelOffsets);
+
+    static Filter ParseFilter(const std::string &name); //"box", "kaiser" or "lanczos"
+    static const char* GetSimdName();
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "entity.h"
 #include "renderProcess.h"
 #include "camera.hpp"
+#include "bindlessTextures.h"
 
 //forward declaration. 
 //Because we dont want to include application.h here, but we want to use CApplciation.
@@ -15,12 +16,13 @@ class CApplication;
 class CObject : public CEntity {
     int m_object_id = 0;
     std::vector<int> m_texture_ids;
+    float m_projectedSize = (float)WINDOW_HEIGHT; //on-screen height in pixels, set by Update
     int m_model_id = 0;
     
     bool bUseMVP_VP = false;
 
     //bool bUseTextureSampler;
-    std::vector<VkDescriptorSet> descriptorSets_graphics_texture_image_sampler; //This descritpor is for texture sampler. one descriptor set for each host resource (MAX_FRAMES_IN_FLIGHT)
+    std::vector<VkDescriptorSet> descriptorSets_graphics_texture_image_sampler; //This descritpor is for texture sampler. one per host resource (MAX_FRAMES_IN_FLIGHT), shared through CGraphicsDescriptorManager::descriptorCache
 
     //These will be used when recording draw cmd
     CRenderer *p_renderer;
@@ -28,12 +30,21 @@ class CObject : public CEntity {
     std::vector<VkDescriptorSet> *p_descriptorSets_graphcis_general;
     VkPipelineLayout *p_graphicsPipelineLayout;
     CTextureManager *p_textureManager;
+    CBindlessTextures *p_bindlessTextures; //enabled: no per-object sampler sets, the texture index goes through push constants
+    CGraphicsDescriptorManager *p_graphicsDescriptorManager;
 
     void CreateDescriptorSets_TextureImageSampler(
-        VkDescriptorPool &descriptorPool, 
         VkDescriptorSetLayout &descriptorSetLayout, 
         std::vector<VkSampler> &samplers, 
         std::vector<VkImageView> *swapchainImageViews = NULL);
+    void UpdateDescriptorSet_TextureImageSampler(size_t frame, std::vector<VkSampler> &samplers);
+    void GetBindings_TextureImageSampler(size_t frame, std::vector<VkSampler> &samplers, std::vector<CDescriptorCache::Binding> &bindings);
+    std::vector<std::vector<uint32_t>> m_boundTextureVersions; //[frame][sampler] CTextureImage::m_version of the set's contents
+
+    //descriptor buffer backend: this object's regions (set 0, then the sampler set), same offsets in every frame's buffer
+    std::vector<uint32_t> m_descriptorRegions;
+    void CreateDescriptorRegions();
+    void WriteDescriptorRegions(size_t frame);
 
     void CleanUp();
 
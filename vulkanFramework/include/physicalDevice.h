@@ -16,6 +16,9 @@ struct QueueFamilyIndices {
     std::optional<uint32_t> computeFamily;
     std::optional<uint32_t> graphicsAndComputeFamily;
 	std::optional<uint32_t> presentFamily;
+	std::optional<uint32_t> asyncComputeFamily; //compute-only family, if there is one
+	uint32_t asyncComputeQueueIndex = 0;
+	std::optional<uint32_t> transferFamily; //transfer-only family (DMA engine), used for background uploads
 	
 
 	bool isComplete() {
@@ -54,9 +57,35 @@ public:
     VkQueue getGraphicsQueue()  {return logicalDevices.back().get()->graphicsQueue; }
     VkQueue getPresentQueue()   {return logicalDevices.back().get()->presentQueue;  }
     VkQueue getComputeQueue()   {return logicalDevices.back().get()->computeQueue;  }
+    VkQueue getAsyncComputeQueue() {return logicalDevices.back().get()->asyncComputeQueue; } //VK_NULL_HANDLE if not available
+    uint32_t getGraphicsQueueFamily() {return logicalDevices.back().get()->graphicsFamily; }
+    uint32_t getAsyncComputeQueueFamily() {return logicalDevices.back().get()->asyncComputeFamily; }
+    VkQueue getTransferQueue() {return logicalDevices.back().get()->transferQueue; } //VK_NULL_HANDLE if not available
+    uint32_t getTransferQueueFamily() {return logicalDevices.back().get()->transferFamily; }
 
     VkSampleCountFlagBits getMaxUsableSampleCount();
 
+    //optional device features, enabled by createLogicalDevices() when the device supports them
+    bool bTimelineSemaphore = false; //VK_KHR_timeline_semaphore
+    bool bPipelineStatisticsQuery = false; //core feature, for the GPU profiler's pipeline statistics
+    bool bPresentWait = false; //VK_KHR_present_id and VK_KHR_present_wait, for CFramePacer
+
+    //subgroup support in compute shaders, queried by createLogicalDevices() when instance and device are 1.1+
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+    uint32_t subgroupSize = 0;
+    bool bSubgroupQuadCompute = false; //GL_KHR_shader_subgroup_quad usable in compute
+
+    //VK_EXT_descriptor_indexing with runtime arrays, partially bound / variable count / update-after-bind sampled images
+    bool bDescriptorIndexing = false;
+    uint32_t maxBindlessTextures = 0; //update-after-bind sampled image limit, 0 without descriptor indexing
+
+    //descriptor backends (feature_graphics_descriptor_backend), see CDescriptorBackend
+    bool bPushDescriptor = false;   //VK_KHR_push_descriptor
+    bool bDescriptorBuffer = false; //VK_EXT_descriptor_buffer with buffer device address
+    VkDeviceSize descriptorBufferOffsetAlignment = 1;
+    size_t uniformBufferDescriptorSize = 0;
+    size_t combinedImageSamplerDescriptorSize = 0;
+
     void displayPhysicalDevices();
     
 private:
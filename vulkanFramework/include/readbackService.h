@@ -0,0 +1,80 @@
+#ifndef H_READBACKSERVICE
+#define H_READBACKSERVICE
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "cpuProfiler.h"
+
+#include <functional>
+#include <deque>
+
+//Asynchronous image copies from the GPU to the CPU (frame capture, golden images, video encoding, thumbnails).
+//RequestImage() takes a slot of a ring of persistently mapped, host-cached staging buffers.
+//The render thread records the copy at the end of the frame's graphics command buffer (RecordCopies), so it is
+//ordered before present; frames without a graphics command buffer (pre-recorded compute modes) are copied by
+//SubmitCopies() in a separate submission with its own fence, which is only valid for images nobody presents (headless).
+//Poll() never waits: finished slots are delivered in request order to the callback, on the render thread.
+//The pixel span is only valid during the callback; copy it out or hand it to a worker for anything slow.
+//A request that finds no free slot is dropped (droppedRequests) instead of stalling the frame.
+class CReadbackService final{
+public:
+    struct Pixels{
+        const uint8_t *data;
+        uint32_t width, height;
+        uint32_t rowPitch; //bytes, rows are tightly packed
+        VkFormat format;
+        uint64_t frameNumber; //frame that recorded the copy
+    };
+    typedef std::function<void(const Pixels &pixels)> Callback;
+
+    CReadbackService();
+    ~CReadbackService();
+
+    void Init(uint32_t slotCount = MAX_FRAMES_IN_FLIGHT + 1);
+    void Destroy();
+
+    //layout is the image's layout when the frame's commands are done; it is restored after the copy
+    bool RequestImage(VkImage image, VkImageLayout layout, uint32_t width, uint32_t height, VkFormat format, Callback callback);
+    static uint32_t GetBytesPerPixel(VkFormat format); //0: not supported
+
+    void RecordCopies(VkCommandBuffer commandBuffer, uint64_t frameNumber); //end of the graphics command buffer, outside the render pass
+    void SubmitCopies(uint64_t frameNumber); //after the frame's submission, for requests that were not recorded
+    void Poll(uint64_t completedFrames);     //delivers slots whose frame (or own fence) is complete
+    void Flush();                            //submits what is left, waits for the graphics queue and delivers everything
+
+    uint64_t readbackBytes = 0;
+    uint32_t deliveredImages = 0;
+    uint32_t droppedRequests = 0;
+    double averageLatency = 0; //ms from request to delivery, moving average
+
+private:
+    enum SlotState { SLOT_FREE, SLOT_QUEUED, SLOT_RECORDED, SLOT_SUBMITTED };
+    struct Slot{
+        SlotState state = SLOT_FREE;
+        CWxjBuffer buffer;
+        VkDeviceSize capacity = 0;
+        uint8_t *mapped = nullptr;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t width = 0, height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkDeviceSize size = 0;
+        uint64_t frameNumber = 0;
+        Callback callback;
+        std::chrono::high_resolution_clock::time_point requestTime;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE; //SubmitCopies only
+        VkFence fence = VK_NULL_HANDLE;
+    };
+
+    void RecordCopy(VkCommandBuffer commandBuffer, Slot &slot);
+    void Deliver(Slot &slot);
+
+    std::vector<Slot> m_slots;
+    std::deque<uint32_t> m_order; //requested slots, oldest first
+    uint32_t m_nextSlot = 0;
+    uint64_t m_lastFrameNumber = 0;
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;
+};
+
+#endif
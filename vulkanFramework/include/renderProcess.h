@@ -46,7 +46,7 @@ public:
     void create_attachment_description_light_depth(VkFormat depthFormat, VkSampleCountFlagBits msaaSamples);
     void create_attachment_description_camera_depth(VkFormat depthFormat, VkSampleCountFlagBits msaaSamples);
     void create_attachment_description_color_resolve(VkFormat swapChainImageFormat,VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-    void create_attachment_description_color_present(VkFormat swapChainImageFormat);
+    void create_attachment_description_color_present(VkFormat swapChainImageFormat, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
     VkAttachmentDescription attachment_description_light_depth{};
     VkAttachmentDescription attachment_description_depth{};
@@ -95,6 +95,7 @@ public:
 
     void createGraphicsPipelineLayout(std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, int graphicsPipelineLayout_id);
     void createGraphicsPipelineLayout(std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, VkPushConstantRange &pushConstantRange, bool bUsePushConstant, int graphicsPipelineLayout_id);
+    void createGraphicsPipelineLayout(std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, std::vector<VkPushConstantRange> &pushConstantRanges, int graphicsPipelineLayout_id); //ranges of different stages, e.g. model matrix + bindless texture index
 
     /*********
     * Pipelines
@@ -107,6 +108,7 @@ public:
     std::vector<VkPipelineLayout> graphicsPipelineLayouts;
     std::vector<VkPipeline> graphicsPipelines;  
     int skyboxID = -1;
+    VkPipelineCreateFlags graphicsPipelineCreateFlags = 0; //e.g. VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
     
     void createComputePipeline(VkShaderModule &computeShaderModule);
 
@@ -142,6 +144,7 @@ public:
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.flags = graphicsPipelineCreateFlags;
        
 
         /*********1 Asemble Shader**********/
@@ -5,6 +5,11 @@
 #include "context.h"
 #include "dataBuffer.hpp"
 #include "swapchain.h"
+#include "uploadService.h"
+#include "readbackService.h"
+#include "gpuProfiler.h"
+#include "cpuProfiler.h"
+#include "framePacer.h"
 
 class CRenderer final{
 public:
@@ -33,6 +38,74 @@ public:
     void WaitForGraphicsFence();
     void SubmitGraphics();
     void PresentSwapchainImage(CSwapchain &swapchain); 
+    //headless: images are CSwapchain::offscreenImages, imageIndex follows currentFrame; no acquire/present semaphores
+    bool bHeadless = false;
+
+    /**************************
+     * 
+     * Frame Scheduler
+     * 
+     * ***********************/
+    //If VK_KHR_timeline_semaphore is enabled, compute and graphics submissions of frame N signal value N+1
+    //on their own timeline and declare dependencies by value. Otherwise the per-frame fences are used.
+    bool bEnableTimelineSemaphore = false;
+    VkSemaphore computeTimelineSemaphore = VK_NULL_HANDLE;
+    VkSemaphore graphicsTimelineSemaphore = VK_NULL_HANDLE;
+    uint64_t frameNumber = 0; //monotonic, unlike currentFrame
+    void WaitForFrameResources(); //CPU waits only until the resources of slot currentFrame can be overwritten
+    void WaitForTimeline(VkSemaphore semaphore, uint64_t value);
+    uint64_t GetCompletedFrameCount(); //frames whose last submission finished on the GPU, never waits
+
+    /**************************
+     * 
+     * Async Compute
+     * 
+     * ***********************/
+    //COMPUTE_GRAPHICS submits compute to a separate queue (compute-only family, or a second queue of the graphics family)
+    //so the simulation of frame N+1 can run while frame N is still rendering
+    bool UseAsyncCompute();
+    std::vector<uint32_t> GetSharedQueueFamilies(); //families for CONCURRENT buffers used by both queues; empty if same family
+    VkQueue m_computeQueue = VK_NULL_HANDLE;
+    VkCommandPool computeCommandPool = VK_NULL_HANDLE; //same as commandPool unless compute runs on another family
+
+    /**************************
+     * 
+     * Queue Timing
+     * 
+     * ***********************/
+    //GPU time of each submitted graphics/compute command buffer, from timestamps written at begin/end
+    bool bEnableQueueTiming = false;
+    VkQueryPool queueTimingQueryPool = VK_NULL_HANDLE; //4 queries per frame in flight: graphics begin/end, compute begin/end
+    std::vector<bool> queueTimingWritten; //[frame*2 + 0 graphics, 1 compute]
+    float timestampPeriod = 1.0f; //ns per tick
+    double graphicsQueueTime = 0; //ms, moving average
+    double computeQueueTime = 0;  //ms, moving average
+    void CreateQueueTiming();
+    void WriteQueueTimestamp(bool bCompute, bool bEnd);
+    void ReadQueueTiming(); //results of the frame that last used slot currentFrame, call after WaitForFrameResources
+
+    /**************************
+     * 
+     * GPU Profiler
+     * 
+     * ***********************/
+    //per pass timestamps (render pass, subpasses, dispatches, object draws), off unless gpuProfiler.bEnabled before CreateSyncObjects
+    CGpuProfiler gpuProfiler;
+    //frame rate limiter, present wait and input latency; settings before CreateSyncObjects, the main loop calls WaitForNextFrame
+    CFramePacer framePacer;
+    int BeginGpuScope(const std::string &name, bool bCompute = false); //in the current graphics/compute command buffer, -1 when off
+    void EndGpuScope(int scope, bool bCompute = false);
+    void NextSubpass(); //vkCmdNextSubpass, with a profiler scope per subpass
+
+    /**************************
+     * 
+     * Uploads
+     * 
+     * ***********************/
+    //background buffer/image uploads on the transfer queue; finished uploads are acquired at the start of the next recorded frame
+    CUploadService uploadService;
+    //image copies to host memory recorded at the end of the frame, delivered by callback once the frame is complete
+    CReadbackService readbackService;
 
 
     /**************************
@@ -109,11 +182,13 @@ public:
 
         //VK_BUFFER_USAGE_TRANSFER_SRC_BIT
         //VkResult result = InitDataBufferHelper(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &vertexDataBuffer);//allocate vertexDataBuffer bufferSize(decided by vertices3D) memory
+        vertexDataBuffer.bDeviceLocal = true;
         VkResult result = vertexDataBuffer.init(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
         //REPORT("InitVertexDataBuffer");
         //FillDataBufferHelper(vertexDataBuffer, (void *)(input.data()));//copy vertices3D to vertexDataBuffer
-        vertexDataBuffer.fill((void *)(input.data()));
+        //staged and copied by the upload service; usable once uploadService.Flush() returned (application does it after the models)
+        uploadService.UploadBuffer(input.data(), bufferSize, vertexDataBuffer.buffer);
 
         vertexDataBuffers.push_back(vertexDataBuffer);
     }
@@ -124,7 +199,7 @@ public:
     void CreateCommandPool(VkSurfaceKHR &surface);
     void CreateGraphicsCommandBuffer();
     void CreateComputeCommandBuffer();
-    void CreateCommandBuffers();
+    void CreateCommandBuffers(VkCommandPool &pool);
 
     void CreateSyncObjects(int swapchainSize);
 
@@ -150,6 +225,31 @@ public:
     std::vector<VkFence> computeInFlightFences;
 private:
     //CDebugger * debugger;
+    PFN_vkWaitSemaphoresKHR m_pfnWaitSemaphores = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR m_pfnGetSemaphoreCounterValue = nullptr;
+    std::vector<uint64_t> m_fenceFrameNumbers; //frame last submitted with the fences of each slot
+    uint64_t m_submittedFrames = 0;
+    std::chrono::steady_clock::time_point m_lastFrameWait; //frame time metric: interval between WaitForFrameResources calls
+    int m_renderPassScope = -1;
+    int m_subpassScope = -1;
+    uint32_t m_subpass = 0;
+
+    struct SubmitSemaphores{
+        uint32_t waitCount = 0;
+        VkSemaphore waitSemaphores[4];
+        uint64_t waitValues[4];
+        VkPipelineStageFlags waitStages[4];
+        uint32_t signalCount = 0;
+        VkSemaphore signalSemaphores[4];
+        uint64_t signalValues[4];
+        void AddWait(VkSemaphore semaphore, VkPipelineStageFlags stage, uint64_t value = 0){
+            waitSemaphores[waitCount] = semaphore; waitStages[waitCount] = stage; waitValues[waitCount] = value; waitCount++;
+        }
+        void AddSignal(VkSemaphore semaphore, uint64_t value = 0){ //value is ignored for binary semaphores
+            signalSemaphores[signalCount] = semaphore; signalValues[signalCount] = value; signalCount++;
+        }
+    };
+    void QueueSubmit(VkQueue queue, VkCommandBuffer &commandBuffer, SubmitSemaphores &semaphores, VkFence fence);
 };
 
 #endif
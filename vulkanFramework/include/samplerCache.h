@@ -0,0 +1,58 @@
+#ifndef H_SAMPLERCACHE
+#define H_SAMPLERCACHE
+
+#include "common.h"
+#include "context.h"
+
+//Shares one VkSampler between all users that ask for the same sampler state.
+//Samplers live until Destroy(); the device limits them to maxSamplerAllocationCount, RESERVED_SAMPLERS of which
+//are left for samplers created outside the cache (e.g. CEnvironmentBaker).
+class CSamplerCache final{
+public:
+    static const uint32_t RESERVED_SAMPLERS = 16;
+
+    struct Key{
+        VkFilter magFilter = VK_FILTER_LINEAR;
+        VkFilter minFilter = VK_FILTER_LINEAR;
+        VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        float maxAnisotropy = 0.0f;  //0: device maximum, <= 1: disabled
+        float mipLodBias = 0.0f;
+        float minLod = 0.0f;
+        float maxLod = VK_LOD_CLAMP_NONE; //all mip levels of the view
+        VkCompareOp compareOp = VK_COMPARE_OP_NEVER; //VK_COMPARE_OP_NEVER: compare disabled
+        VkBorderColor borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        bool operator==(const Key &other) const;
+    };
+
+    CSamplerCache();
+    ~CSamplerCache();
+
+    VkSampler GetOrCreate(const Key &key);
+    void Destroy();
+
+    unsigned int cacheHitCount = 0;
+    unsigned int cacheMissCount = 0;
+    uint32_t GetSamplerCount() { return static_cast<uint32_t>(m_entries.size()); }
+
+    //YAML names (uniform_graphics_texture_image_sampler_*); unknown names keep the default
+    static VkFilter ParseFilter(const std::string &name, VkFilter defaultFilter = VK_FILTER_LINEAR);                    //linear, nearest
+    static VkSamplerMipmapMode ParseMipmapMode(const std::string &name);                                                //linear, nearest
+    static VkSamplerAddressMode ParseAddressMode(const std::string &name);  //repeat, mirrored_repeat, clamp_to_edge, clamp_to_border
+    static VkCompareOp ParseCompareOp(const std::string &name);             //none, less, less_or_equal, greater, greater_or_equal, equal, not_equal, always
+    static VkBorderColor ParseBorderColor(const std::string &name);         //transparent_black, opaque_black, opaque_white
+
+private:
+    struct Entry{
+        Key key;
+        VkSampler sampler;
+    };
+    std::vector<Entry> m_entries; //a handful of distinct states per application, a linear search is enough
+    bool bQueriedLimits = false;
+    float m_maxSamplerAnisotropy = 1.0f;
+    uint32_t m_maxSamplerAllocationCount = 4000; //spec minimum
+};
+
+#endif
@@ -36,6 +36,24 @@ public:
 
     void Destroy();
 
+    /************
+     * Module Cache
+     ************/
+    //modules are keyed by a hash of the SPIR-V words, so the same .spv referenced by several pipelines shares one VkShaderModule
+    //modules stay alive until Destroy() (called in CleanUp), so pipeline variants can be created at runtime
+    std::unordered_map<uint64_t, VkShaderModule> moduleCache;
+    std::unordered_map<std::string, uint64_t> shaderNameToHash;
+    unsigned int cacheHitCount = 0;
+    unsigned int cacheMissCount = 0;
+    static uint64_t HashSpirV(const void *pCode, size_t codeSize); //FNV-1a 64
+    VkShaderModule GetOrCreateShaderModule(const void *pCode, size_t codeSize);
+    VkShaderModule GetShaderModule(const std::string shaderName); //VK_NULL_HANDLE if not loaded yet
+
+    //set if the device reports VK_EXT_shader_module_identifier / VK_KHR_maintenance5 (see QueryShaderModuleFeatures)
+    bool bSupportShaderModuleIdentifier = false;
+    bool bSupportMaintenance5 = false;
+    void QueryShaderModuleFeatures();
+
 #ifndef ANDROID
     bool InitSpirVShader(const std::string shaderName, VkShaderModule *pShaderModule);
 #else
@@ -45,6 +63,20 @@ public:
 #endif
 private:
     bool readFile(const std::string& filename, std::vector<char> &buffer);
+
+    //read-only memory map of a whole file, falls back to readFile if mapping fails
+    struct MappedFile{
+        const char *pData = nullptr;
+        size_t size = 0;
+        std::vector<char> fallback;
+#ifdef _WIN32
+        void *hFile = nullptr;
+        void *hMapping = nullptr;
+#endif
+    };
+    bool mapFile(const std::string& filename, MappedFile &mappedFile);
+    void unmapFile(MappedFile &mappedFile);
+    uint64_t m_lastHash = 0; //hash of the most recent GetOrCreateShaderModule() call
 };
 
 #endif
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef H_SWAPCHAIN
 #define H_SWAPCHAIN
 
-#include "vulkan\vulkan.h"
+#include "vulkan/vulkan.h"
 #include "physicalDevice.h"
 #include "context.h"
 #include "imageBuffer.h"
@@ -24,6 +24,15 @@ public:
     uint32_t imageSize;
 
     bool bComputeSwapChainImage = false; //added VK_IMAGE_USAGE_STORAGE_BIT for image storage
+    bool bTransferSrcImage = false; //images can be read back (vkCmdCopyImageToBuffer)
+
+    //headless: offscreen color images stand in for the swapchain images, one per frame in flight (no surface, nothing is presented)
+    bool bOffscreen = false;
+    std::vector<CWxjImageBuffer> offscreenImages;
+    //layout a frame leaves images[] in: PRESENT_SRC_KHR for a swapchain, TRANSFER_SRC_OPTIMAL for offscreen images
+    //(read back by --capture/--golden, and valid without VK_KHR_surface)
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    void createOffscreenImages(int width, int height);
 
     //Attachments (Resources)
     int iAttachmentDepthLight = -1;
@@ -32,6 +41,12 @@ public:
     int iAttachmentColorPresent = -1;
 
     //1.Resource for swapchain image
+    //requested present mode (command line: --present immediate|mailbox|fifo|fifo-relaxed); when the surface does not support it
+    //immediate falls back to mailbox, everything else to fifo (always supported)
+    VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR; //the one createImages() chose
+    static bool ParsePresentMode(const std::string &name, VkPresentModeKHR &mode);
+    static const char *GetPresentModeName(VkPresentModeKHR mode);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height);
     void createImages(VkSurfaceKHR surface, int width, int height);
@@ -5,6 +5,14 @@
 #include "renderer.h"
 #include "context.h"
 #include "logManager.h"
+#include "compressedTexture.h"
+#include "mipmapGenerator.h"
+#include "mipmapCompute.h"
+#include "cubemapFaces.h"
+#include "environmentBaker.h"
+
+//how mip levels 1..n are built when they are not loaded from a file
+enum MipmapGeneratorType { MIPMAP_GENERATOR_BLIT, MIPMAP_GENERATOR_CPU, MIPMAP_GENERATOR_COMPUTE };
 
 class CTextureImage final{
 public:
@@ -25,6 +33,7 @@ public:
     ********************/
     void CreateTextureImage();
     void CreateImageView(VkImageAspectFlags aspectFlags);
+    void CreateTextureImage_compressed(const std::string texturePath); //KTX2/DDS with all mip levels from the file
     
     /*******************
     *	Texture Image: Transition
@@ -35,6 +44,7 @@ public:
     /*******************
     *	Texture Image: Create(Cubemap)
     ********************/
+    void GetTexels_cubemap(const std::string texturePath); //cross image, {face} files or equirectangular .hdr -> 6 packed faces
     void CreateTextureImage_cubemap();
     void CreateImageView_cubemap(VkImageAspectFlags aspectFlags);
 
@@ -57,6 +67,9 @@ public:
     void generateMipmaps(); //create normal mipmap
     void generateMipmaps(std::string rainbowCheckerboardTexturePath, VkImageUsageFlags usage); //create mix mipmaps
     void generateMipmapsCore(VkImage image, bool bCreateTempTexture = false, bool bCreateMixTexture = false, std::array<CWxjImageBuffer, MIPMAP_TEXTURE_COUNT> *textureImageBuffers_mipmaps = NULL);
+    bool UseCpuMipmaps(); //CPU generator requested, or the blit path can not filter this format
+    void CreateTextureImage_cpu_mipmap(); //whole chain built by CMipmapGenerator, uploaded in one copy
+    bool UseComputeMipmaps(CMipmapCompute *pMipmapCompute); //compute generator requested and usable, prepares usage/create flags
 
 
     /*******************
@@ -78,6 +91,21 @@ public:
 
     uint32_t m_mipLevels = 1; //1 means no mipmap
     uint32_t m_sampler_id = 0;
+    bool m_bMipsLoaded = false; //mip chain came from the file or the CPU generator, generateMipmaps() leaves it alone
+    MipmapGeneratorType m_mipmapGenerator = MIPMAP_GENERATOR_BLIT;
+    CMipmapGenerator::Options m_mipmapOptions;
+    CMipmapCompute *m_pMipmapCompute = nullptr; //set by UseComputeMipmaps(), generateMipmaps() then dispatches instead of blitting
+    bool m_bCubemap = false;
+    std::vector<uint8_t> m_cubeFaceTexels; //GetTexels_cubemap() -> CreateTextureImage_cubemap(), released after upload
+
+    /*******************
+    *	Streaming (see CTextureStreamer)
+    ********************/
+    bool m_bStreaming = false;
+    std::string m_texturePath;
+    uint32_t m_version = 0;       //bumped whenever m_textureImageBuffer.view changes, objects then rewrite their sampler sets
+    uint64_t m_lastUsedFrame = 0; //renderer frameNumber + 1 of the last draw that sampled it (0: never drawn), for LRU eviction
+    float m_requestedSize = 0;    //largest on-screen height in pixels of the objects drawn with it in that frame, selects the mip to stream in
     //bool bEnableMipMap = false;
     //bool bEnableCubemap = false; //when object register, need this information to handle view matrix so the ModelMat has not translate
 };
@@ -93,6 +121,22 @@ public:
     void CreateTextureImage(const std::string texturePath, VkImageUsageFlags usage, VkCommandPool &commandPool, 
         int miplevel, int sampler_id, VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB, unsigned short bitPerTexelPerChannel = 8, bool bCubemap = false);
     void Destroy();
+
+    //Offline cooked textures (tools/texcook): cooked/<name>.ktx2 next to the source is loaded instead when it is up to date
+    bool bPreferCookedTextures = true;
+    std::string GetCookedTexturePath(const std::string texturePath); //"" if there is no usable cooked file
+
+    //YAML: feature_graphics_mipmap_generator, feature_graphics_mipmap_filter, feature_graphics_mipmap_alpha_cutoff
+    //resource_texture_mipmap_generator overrides the generator per texture
+    MipmapGeneratorType mipmapGenerator = MIPMAP_GENERATOR_BLIT;
+    CMipmapGenerator::Options mipmapOptions;
+    static MipmapGeneratorType ParseMipmapGenerator(const std::string &name); //"blit", "cpu" or "compute"
+    CMipmapCompute mipmapCompute; //shared single pass pipeline, created on first use
+
+    //YAML: resource_texture_environment_prefilter. One equirect .hdr -> 4 textures appended in CEnvironmentBaker::Output order
+    //(environment cube, irradiance cube, prefiltered specular cube, BRDF LUT), all sampled with sampler_id
+    CEnvironmentBaker environmentBaker;
+    void CreateEnvironmentTextures(const std::string hdrPath, VkCommandPool &commandPool, int sampler_id);
 };
 
 
@@ -0,0 +1,100 @@
+#ifndef H_TEXTURESTREAMER
+#define H_TEXTURESTREAMER
+
+#include "texture.h"
+#include "renderer.h"
+#include "graphicsDescriptor.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//Texture streaming for RGBA8 2D textures (YAML: resource_texture_streaming: true).
+//At registration a streamed texture is decoded once to build its mip tail (levels <= TAIL_SIZE), which stays resident.
+//When an object draws it larger than the tail, a loader thread decodes the file again, builds the mip chain on the CPU and
+//uploads the levels from the one matching the on-screen size (CObject::m_projectedSize) through renderer.uploadService.
+//Over budget, the least recently drawn full images are evicted back to their tail.
+//A file that can't be read is logged and the texture keeps a 1x1 placeholder.
+//View swaps happen in Update() on the render thread; objects see CTextureImage::m_version change and look up new sampler sets.
+class CTextureStreamer final{
+public:
+    CTextureStreamer();
+    ~CTextureStreamer();
+
+    void Init(CTextureManager *pTextureManager, CRenderer *pRenderer, VkDeviceSize budgetBytes);
+    void Destroy();
+    bool IsEnabled() { return m_pTextureManager != nullptr; }
+
+    //register a texture in textureManager.textureImages, returns its texture id
+    int AddTexture(const std::string texturePath, VkImageUsageFlags usage, int miplevel, int sampler_id, VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB);
+
+    void Update(); //render thread, after WaitForFrameResources and before objects are drawn
+
+    static const uint32_t TAIL_SIZE = 64;
+    VkDeviceSize budget = 0;
+    VkDeviceSize residentBytes = 0; //full images only, tails and placeholder are not counted
+    uint32_t streamedInCount = 0;
+    uint32_t evictedCount = 0;
+
+private:
+    enum StreamState { TAIL, RESIDENT, FAILED }; //FAILED: could not be loaded, keeps its placeholder (or tail) and is not requested again
+    struct Entry{
+        int textureId;
+        StreamState state = FAILED;
+        bool bLoading = false;     //a full image is on its way, the current view stays until it is ready
+        int width = 0, height = 0; //level 0
+        uint32_t mipLevels = 1;    //requested in YAML
+        uint32_t tailFirst = 0;    //first level of the chain in the tail
+        uint32_t residentMip = 0;  //first level of the chain in the full image
+        uint32_t loadingMip = 0;
+        CWxjImageBuffer tail;      //owned
+    };
+    struct Request{
+        size_t entry;
+        std::string path;
+        VkFormat format;
+        VkImageUsageFlags usage;
+        uint32_t firstMip;
+        uint32_t mipLevels;
+    };
+    struct Result{
+        size_t entry;
+        CWxjImageBuffer full;
+        uint32_t firstMip = 0;
+        uint64_t ticket = 0;
+        bool bFailed = false; //the loader threw, nothing was created
+    };
+    struct Retired{
+        CWxjImageBuffer image;
+        uint64_t frameNumber;
+    };
+
+    void LoaderLoop();
+    void Load(Request &request);
+    void LoadTail(Entry &entry, const std::string &path, VkFormat format, VkImageUsageFlags usage);
+    uint64_t UploadLevels(CWxjImageBuffer &image, const std::vector<uint8_t> &texels, const std::vector<VkDeviceSize> &offsets,
+        int width, int height, uint32_t firstLevel, uint32_t levelCount, VkFormat format, VkImageUsageFlags usage);
+    static uint32_t ChainLevels(int width, int height){ return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1; }
+    static VkDeviceSize FullBytes(const Entry &entry, uint32_t firstMip);
+    static uint32_t NeededMip(const Entry &entry, float requestedSize);
+    static void BuildMipChain(const std::string &path, uint32_t levelCount, int &width, int &height, std::vector<uint8_t> &texels, std::vector<VkDeviceSize> &offsets);
+    void Evict(size_t entryIndex);
+    void SetView(Entry &entry, CWxjImageBuffer &image, bool bOwned);
+    void Retire(CWxjImageBuffer &image);
+
+    CTextureManager *m_pTextureManager = nullptr;
+    CRenderer *m_pRenderer = nullptr;
+    CWxjImageBuffer m_placeholder;
+    std::vector<Entry> m_entries;
+    std::vector<Result> m_uploading; //render thread only
+    std::vector<Retired> m_retired;  //render thread only, destroyed once no frame in flight can reference them
+
+    std::mutex m_mutex; //guards m_requests, m_results, m_bQuit
+    std::condition_variable m_cv;
+    std::thread m_loader;
+    bool m_bQuit = false;
+    std::vector<Request> m_requests;
+    std::vector<Result> m_results;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef H_UPLOADSERVICE
+#define H_UPLOADSERVICE
+
+#include "common.h"
+#include "context.h"
+#include "dataBuffer.hpp"
+#include "cpuProfiler.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//Background uploads of buffer and image data.
+//Any thread can queue a job; the data is copied to a staging buffer right away, so the caller can free it.
+//If the device has a transfer-only family, a worker thread batches the queued jobs into one command buffer,
+//submits it to the transfer queue with a fence, and releases the resources to the graphics family.
+//Poll() on the render thread then submits the matching acquire barriers to the graphics queue in their own command buffer with a fence,
+//so pre-recorded frame command buffers never carry them; a ticket is ready once that fence signaled. The render thread never waits.
+//Without a transfer family, jobs are submitted to the graphics queue from Poll() on the render thread (no ownership transfer needed).
+class CUploadService final{
+public:
+    CUploadService();
+    ~CUploadService();
+
+    void Init();
+    void Destroy();
+
+    /*******************
+    *	Jobs (thread safe)
+    ********************/
+    //return a ticket, the resource can be used by the graphics queue once IsReady(ticket)
+    uint64_t UploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+    //copy texels into mip level 0; all mip levels end up in finalLayout (keep TRANSFER_DST_OPTIMAL to generate mipmaps afterwards)
+    uint64_t UploadImage(const void *texels, VkDeviceSize size, VkImage dstImage, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout);
+    //several mip levels/array layers packed in one staging blob, regions[i].bufferOffset is relative to texels
+    uint64_t UploadImage(const void *texels, VkDeviceSize size, VkImage dstImage, const std::vector<VkBufferImageCopy> &regions, uint32_t mipLevels, uint32_t layerCount, VkImageLayout finalLayout);
+    bool IsReady(uint64_t ticket) { return ticket <= m_readyTicket.load(); }
+
+    /*******************
+    *	Render thread
+    ********************/
+    void Poll(); //without a transfer queue: submit queued jobs and retire finished batches; with one: submit and retire acquires
+    void Flush(); //block until every queued job is ready on the graphics queue, for loading screens and shutdown
+
+    bool bDedicatedTransferQueue = false;
+    uint64_t uploadedBytes = 0;
+    uint32_t submittedBatches = 0;
+
+private:
+    struct Job{
+        uint64_t ticket;
+        CWxjBuffer staging;
+        VkDeviceSize size;
+        bool bImage;
+        VkBuffer dstBuffer;
+        VkDeviceSize dstOffset;
+        VkImage dstImage;
+        uint32_t mipLevels, layerCount;
+        std::vector<VkBufferImageCopy> regions;
+        VkImageLayout finalLayout;
+    };
+    struct Batch{
+        uint64_t lastTicket;
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        std::vector<Job> jobs;
+    };
+
+    void QueueJob(Job &job, const void *data);
+    VkCommandBuffer BeginBatch(VkCommandPool pool);
+    void EndBatch(Batch &batch, VkQueue queue);
+    void SubmitBatch(std::vector<Job> &jobs);
+    void RetireBatches(bool bWait);
+    void SubmitAcquires(); //queue family ownership acquire for finished uploads, on the graphics queue
+    void RetireAcquires(bool bWait);
+    void WorkerLoop();
+    void FillOwnershipBarrier(const Job &job, bool bRelease, VkBufferMemoryBarrier &bufferBarrier, VkImageMemoryBarrier &imageBarrier);
+
+    VkQueue m_queue = VK_NULL_HANDLE;
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    uint32_t m_queueFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+
+    std::mutex m_mutex; //guards m_pendingJobs, m_pendingAcquires, m_nextTicket
+    std::condition_variable m_cv;
+    std::thread m_worker;
+    bool m_bQuit = false;
+    uint64_t m_nextTicket = 0;
+    std::vector<Job> m_pendingJobs;
+    std::vector<Job> m_pendingAcquires; //finished on the transfer queue, waiting for the graphics queue to acquire
+    std::vector<Batch> m_inFlightBatches; //only touched by the submitting thread
+    VkCommandPool m_acquirePool = VK_NULL_HANDLE; //graphics family, only with a transfer family
+    std::vector<Batch> m_acquireBatches; //render thread
+    std::atomic<uint64_t> m_completedTicket{0};
+    std::atomic<uint64_t> m_readyTicket{0};
+};
+
+#endif
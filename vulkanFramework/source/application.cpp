@@ -1,4 +1,5 @@
 #include "../include/application.h"
+#include "../include/metrics.h"
 
 //static class members must be defined outside. 
 //otherwise invoke 'undefined reference' error when linking
@@ -9,6 +10,7 @@ bool CApplication::NeedToPause = false;
 int CApplication::focusObjectId = 0;
 std::vector<CObject> CApplication::objects; 
 std::vector<CLight> CApplication::lights; 
+CInputLog CApplication::inputLog;
 
 CApplication::CApplication(){
     //debugger = new CDebugger("../logs/application.log");
@@ -21,17 +23,24 @@ CApplication::CApplication(){
 #ifndef ANDROID
 void CApplication::run(){ //Entrance Function
     CContext::Init();
+    CCpuProfiler::Init();
+    CMetrics::Init();
 
     /**************** 
     * Five steps with third-party(GLFW or SDL) initialization
     * Step 1: Create Window
     *****************/
     m_sampleName.erase(0, 1);
+    if(bHeadless){
+        windowWidth = WINDOW_WIDTH;
+        windowHeight = WINDOW_HEIGHT;
+    }else{
 #ifdef SDL
-    sdlManager.createWindow(OUT windowWidth, OUT windowHeight, m_sampleName);
+        sdlManager.createWindow(OUT windowWidth, OUT windowHeight, m_sampleName);
 #else
-    glfwManager.createWindow(OUT windowWidth, OUT windowHeight, m_sampleName);
+        glfwManager.createWindow(OUT windowWidth, OUT windowHeight, m_sampleName);
 #endif
+    }
 	PRINT("run: Created Window. Window width = %d,  height = %d.", windowWidth, windowHeight);
 
     /**************** 
@@ -43,11 +52,33 @@ void CApplication::run(){ //Entrance Function
     * Step 3: Select required instance extensions
     *****************/
     std::vector<const char*> requiredInstanceExtensions;
+    bool bSurfaceExtension = true;
+    if(bHeadless){
+        //VK_KHR_surface is still enabled when available (VK_KHR_swapchain depends on it); offscreen images end in TRANSFER_SRC, they never need it
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+        auto isAvailable = [&](const char *name){
+            for(auto &extension : availableExtensions) if(strcmp(extension.extensionName, name) == 0) return true;
+            return false;
+        };
+        bSurfaceExtension = isAvailable(VK_KHR_SURFACE_EXTENSION_NAME);
+        if(bSurfaceExtension) requiredInstanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+        else bHeadlessSurface = false;
+#ifdef VK_EXT_headless_surface
+        if(bHeadlessSurface && isAvailable(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME)) requiredInstanceExtensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+        else bHeadlessSurface = false;
+#else
+        bHeadlessSurface = false;
+#endif
+    }else{
 #ifdef SDL
-    sdlManager.queryRequiredInstanceExtensions(OUT requiredInstanceExtensions);
+        sdlManager.queryRequiredInstanceExtensions(OUT requiredInstanceExtensions);
 #else    
-    glfwManager.queryRequiredInstanceExtensions(OUT requiredInstanceExtensions);
+        glfwManager.queryRequiredInstanceExtensions(OUT requiredInstanceExtensions);
 #endif
+    }
     if(enableValidationLayers) requiredInstanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
     /**************** 
@@ -60,12 +91,27 @@ void CApplication::run(){ //Entrance Function
     * Step 5: create surface
     * Surface is to store view format information for creating swapchain. 
     * Only third party(glfw or sdl) knows what kind of surface can be attached to its window.
+    * Headless: no surface (offscreen images), or a VK_EXT_headless_surface that presents nowhere
     *****************/
+    surface = VK_NULL_HANDLE;
+    if(bHeadless){
+#ifdef VK_EXT_headless_surface
+        if(bHeadlessSurface){
+            VkHeadlessSurfaceCreateInfoEXT surfaceInfo{};
+            surfaceInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+            auto pfnCreateHeadlessSurface = (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(instance->getHandle(), "vkCreateHeadlessSurfaceEXT");
+            if(!pfnCreateHeadlessSurface || pfnCreateHeadlessSurface(instance->getHandle(), &surfaceInfo, nullptr, &surface) != VK_SUCCESS)
+                surface = VK_NULL_HANDLE;
+        }
+#endif
+        PRINT("run: Headless, %s.", std::string(surface != VK_NULL_HANDLE ? "VK_EXT_headless_surface swapchain" : "offscreen images"));
+    }else{
 #ifdef SDL   
-    sdlManager.createSurface(IN instance, OUT surface);
+        sdlManager.createSurface(IN instance, OUT surface);
 #else  
-    glfwManager.createSurface(IN instance, OUT surface);
+        glfwManager.createSurface(IN instance, OUT surface);
 #endif
+    }
 
     /**************** 
     * General initialization begins
@@ -73,7 +119,8 @@ void CApplication::run(){ //Entrance Function
     * Select required device extensions
     *****************/
     VkQueueFlagBits requiredQueueFamilies = VK_QUEUE_GRAPHICS_BIT; //& VK_QUEUE_COMPUTE_BIT
-    const std::vector<const char*>  requireDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    std::vector<const char*>  requireDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    if(!bSurfaceExtension) requireDeviceExtensions.clear(); //no VK_KHR_surface, no swapchain
 
     instance->findAllPhysicalDevices();
 
@@ -90,7 +137,10 @@ void CApplication::run(){ //Entrance Function
     //std::cout<<"Surface min extent: width="<<pSurfaceCapabilities->minImageExtent.width<<", Surface min extent: height="<<pSurfaceCapabilities->minImageExtent.height<<std::endl;
     //std::cout<<"Surface max extent: width="<<pSurfaceCapabilities->maxImageExtent.width<<", Surface max extent: height="<<pSurfaceCapabilities->maxImageExtent.height<<std::endl;
 
-    swapchain.createImages(surface, windowWidth, windowHeight);
+    if(surface == VK_NULL_HANDLE){
+        swapchain.createOffscreenImages(windowWidth, windowHeight);
+        renderer.bHeadless = true;
+    }else swapchain.createImages(surface, windowWidth, windowHeight);
 	swapchain.createImageViews(VK_IMAGE_ASPECT_COLOR_BIT);
 
     renderer.CreateCommandPool(surface);
@@ -100,34 +150,195 @@ void CApplication::run(){ //Entrance Function
     std::cout<<"======================================="<<std::endl;
 
     auto startInitialzeTime = std::chrono::high_resolution_clock::now();
-    initialize();
+    {
+        PROFILE_SCOPE("initialize");
+        initialize();
+    }
     auto endInitializeTime = std::chrono::high_resolution_clock::now();
-    auto durationInitializationTime = std::chrono::duration<float, std::chrono::seconds::period>(endInitializeTime - startInitialzeTime).count() * 1000;
-    std::cout<<"Total Initialization cost: "<<durationInitializationTime<<" milliseconds"<<std::endl;
-
+    initTime = std::chrono::duration<float, std::chrono::seconds::period>(endInitializeTime - startInitialzeTime).count() * 1000;
+    std::cout<<"Total Initialization cost: "<<initTime<<" milliseconds"<<std::endl;
+
+    if(!replayInputPath.empty() && inputLog.Replay(replayInputPath, fixedStepTime) && maxFrames == 0)
+        maxFrames = (int)inputLog.recordedFrames; //stop where the recording stopped
+    if(!recordInputPath.empty()) inputLog.Record(recordInputPath, fixedStepTime);
+
+    int frameCount = 0;
+    auto renderFrame = [&](){ //CPU time of each frame, for --report
+        auto startFrameTime = std::chrono::high_resolution_clock::now();
+        UpdateRecordRender();
+        frameTimes.push_back(std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startFrameTime).count());
+        frameCount++;
+        BLOG(LOG_LEVEL_INFO, LOG_CATEGORY_RENDERER, "frame %d: cpu %.3f ms, gpu graphics %.3f ms, compute %.3f ms",
+            frameCount, frameTimes.back(), renderer.graphicsQueueTime, renderer.computeQueueTime);
+        PROFILE_FRAME();
+    };
+    if(bHeadless){
+        while(maxFrames == 0 || frameCount < maxFrames){
+            renderer.framePacer.WaitForNextFrame();
+            renderFrame();
+            if(NeedToExit || NeedToPause) break; //nobody can unpause a headless run
+        }
+    }else{
 #ifdef SDL   
-    while(sdlManager.bStillRunning) {
-        sdlManager.eventHandle();
-        if(!NeedToPause) UpdateRecordRender();
-        if(NeedToExit) break;
-    }
+        //the present mode and the frame pacer set the frame rate; input is polled right after the pacer's wait
+        while(sdlManager.bStillRunning) {
+            if(NeedToPause) SDL_WaitEventTimeout(nullptr, 100); //nothing to render: sleep until there is input
+            else renderer.framePacer.WaitForNextFrame();
+            sdlManager.eventHandle();
+            if(!NeedToPause) renderFrame();
+            if(NeedToExit || (maxFrames > 0 && frameCount >= maxFrames)) break;
+        }
 #else  
-    glfwSwapInterval(1); //set V-Sync. wait a refresh period, normally 16.67ms
-    while (!glfwWindowShouldClose(glfwManager.window)) {
-        glfwPollEvents();
-        if(!NeedToPause) UpdateRecordRender();
-        if(NeedToExit) break;
-
-        if(mainCamera.cameraType == Camera::CameraType::FREE){
-            mainCamera.AngularVelocity.x = 0;
-            mainCamera.AngularVelocity.y = 0;
+        //the present mode and the frame pacer set the frame rate; input is polled right after the pacer's wait
+        while (!glfwWindowShouldClose(glfwManager.window)) {
+            if(NeedToPause) glfwWaitEventsTimeout(0.1); //nothing to render: sleep until there is input
+            else renderer.framePacer.WaitForNextFrame();
+            glfwPollEvents();
+            if(!NeedToPause) renderFrame();
+            if(NeedToExit || (maxFrames > 0 && frameCount >= maxFrames)) break;
+
+            inputLog.Push(CInputLog::CAMERA_ANGULAR_VELOCITY, 0, 0, 0); //GLFW has no motion event when the mouse stops
         }
-
-        glfwWaitEventsTimeout(1.0 / 60.0);
-    }
 #endif
+    }
 
 	vkDeviceWaitIdle(CContext::GetHandle().GetLogicalDevice());//Wait GPU to complete all jobs before CPU destroy resources
+
+    CCpuProfiler::Destroy();
+    CMetrics::Destroy();
+    inputLog.Save(frameCount);
+    if((!capturePath.empty() || !goldenPath.empty()) && frameCount > 0) CaptureFrame();
+    if(!reportPath.empty()) WriteReport(reportPath);
+}
+
+void CApplication::ParseCommandLine(int argc, char **argv){
+    const char *updateGolden = getenv("VKP_UPDATE_GOLDEN"); //so a whole ctest run can rebaseline
+    bUpdateGolden = updateGolden && updateGolden[0] != '\0' && std::string(updateGolden) != "0";
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--headless") bHeadless = true;
+        else if(arg == "--headless-surface") bHeadless = bHeadlessSurface = true;
+        else if(arg == "--frames" && i + 1 < argc) maxFrames = std::max(atoi(argv[++i]), 0);
+        else if(arg == "--capture" && i + 1 < argc) capturePath = argv[++i];
+        else if(arg == "--golden" && i + 1 < argc) goldenPath = argv[++i];
+        else if(arg == "--tolerance" && i + 1 < argc) goldenTolerance = (float)atof(argv[++i]);
+        else if(arg == "--update-golden") bUpdateGolden = true;
+        else if(arg == "--create-missing-golden") bCreateMissingGolden = true;
+        else if(arg == "--report" && i + 1 < argc) reportPath = argv[++i];
+        else if(arg == "--fixed-step" && i + 1 < argc) fixedStepTime = std::max((float)atof(argv[++i]), 0.0f);
+        else if(arg == "--record-input" && i + 1 < argc) recordInputPath = argv[++i];
+        else if(arg == "--replay-input" && i + 1 < argc) replayInputPath = argv[++i];
+        else if(arg == "--gpu-profile") renderer.gpuProfiler.bEnabled = true;
+        else if(arg == "--gpu-csv" && i + 1 < argc) { renderer.gpuProfiler.bEnabled = true; renderer.gpuProfiler.csvPath = argv[++i]; }
+        else if(arg == "--gpu-trace" && i + 1 < argc) { renderer.gpuProfiler.bEnabled = true; renderer.gpuProfiler.tracePath = argv[++i]; }
+        else if(arg == "--pipeline-statistics") renderer.gpuProfiler.bEnabled = renderer.gpuProfiler.bPipelineStatistics = true;
+        else if(arg == "--log-level" && i + 1 < argc){
+            LogLevel level;
+            if(CLogger::ParseLevel(argv[++i], level)) CLogger::minLevel = level;
+            else std::cout<<"Unknown log level: "<<argv[i]<<" (verbose, info, warning, error)"<<std::endl;
+        }
+        else if(arg == "--log-categories" && i + 1 < argc) CLogger::categoryMask = CLogger::ParseCategories(argv[++i]);
+        else if(arg == "--binary-log" && i + 1 < argc) CBinaryLog::Open(argv[++i]);
+        else if(arg == "--present" && i + 1 < argc){
+            if(!CSwapchain::ParsePresentMode(argv[++i], swapchain.preferredPresentMode))
+                std::cout<<"Unknown present mode: "<<argv[i]<<" (immediate, mailbox, fifo, fifo-relaxed)"<<std::endl;
+        }
+        else if(arg == "--target-fps" && i + 1 < argc) renderer.framePacer.targetFps = std::max((float)atof(argv[++i]), 0.0f);
+        else if(arg == "--max-queued-frames" && i + 1 < argc) renderer.framePacer.maxQueuedFrames = (uint32_t)std::max(atoi(argv[++i]), 0);
+        else if(arg == "--no-present-wait") renderer.framePacer.bUsePresentWait = false;
+        else if(arg == "--descriptor-backend" && i + 1 < argc) descriptorBackendName = argv[++i];
+        else if(arg == "--metrics") CMetrics::bEnabled = true;
+        else if(arg == "--metrics-port" && i + 1 < argc) { CMetrics::bEnabled = true; CMetrics::httpPort = (uint16_t)atoi(argv[++i]); }
+        else if(arg == "--metrics-log" && i + 1 < argc) { CMetrics::bEnabled = true; CMetrics::logInterval = std::max((float)atof(argv[++i]), 0.0f); }
+#ifdef CPU_PROFILER
+        else if(arg == "--cpu-profile") CCpuProfiler::bEnabled = true;
+        else if(arg == "--cpu-trace" && i + 1 < argc) { CCpuProfiler::bEnabled = true; CCpuProfiler::tracePath = argv[++i]; }
+#else
+        else if(arg == "--cpu-profile" || arg == "--cpu-trace"){
+            if(arg == "--cpu-trace" && i + 1 < argc) i++;
+            std::cout<<"CPU profiler: built without CPU_PROFILER, "<<arg<<" ignored"<<std::endl;
+        }
+#endif
+        else std::cout<<"Unknown argument: "<<arg<<std::endl;
+    }
+    if(bHeadless && maxFrames == 0) maxFrames = 60; //nobody can close a headless run
+    if((!capturePath.empty() || !goldenPath.empty()) && bHeadlessSurface){
+        std::cout<<"--capture/--golden read offscreen images, ignoring --headless-surface"<<std::endl;
+        bHeadlessSurface = false;
+    }
+}
+
+bool CApplication::CaptureFrame(){
+    //presented swapchain images belong to the presentation engine, only offscreen images can be read back after the loop
+    if(!swapchain.bOffscreen || renderer.m_renderMode == renderer.COMPUTE){
+        std::cout<<"Capture needs --headless and a rendered image, nothing captured"<<std::endl;
+        if(!goldenPath.empty()) exitCode = (renderer.m_renderMode == renderer.COMPUTE) ? EXIT_SKIPPED : EXIT_FAILURE; //compute only: no image to compare
+        return false;
+    }
+    //render pass and compute samples both leave the image in swapchain.finalLayout
+    std::vector<uint8_t> pixels;
+    uint64_t capturedFrame = 0;
+    renderer.readbackService.RequestImage(swapchain.images[renderer.imageIndex], swapchain.finalLayout,
+        swapchain.swapChainExtent.width, swapchain.swapChainExtent.height, swapchain.swapChainImageFormat,
+        [&](const CReadbackService::Pixels &frame){
+            pixels.assign(frame.data, frame.data + (size_t)frame.rowPitch * frame.height);
+            capturedFrame = frame.frameNumber;
+        });
+    renderer.readbackService.Flush();
+    if(pixels.empty()){
+        if(!goldenPath.empty()) exitCode = EXIT_FAILURE;
+        return false;
+    }
+
+    uint32_t width = swapchain.swapChainExtent.width, height = swapchain.swapChainExtent.height;
+    bool bWritten = true;
+    if(!capturePath.empty()){
+        bWritten = CImageWriter::Write(capturePath, width, height, swapchain.swapChainImageFormat, pixels.data());
+        std::cout<<"Capture: frame "<<capturedFrame<<(bWritten ? " written to " : " could not be written to ")<<capturePath<<std::endl;
+    }
+    if(!goldenPath.empty()){
+        CGoldenImage::UpdateMode updateMode = bUpdateGolden ? CGoldenImage::UPDATE_ALWAYS
+            : bCreateMissingGolden ? CGoldenImage::UPDATE_MISSING : CGoldenImage::UPDATE_NEVER;
+        goldenResult = CGoldenImage::Compare(goldenPath, width, height, swapchain.swapChainImageFormat, pixels.data(),
+            goldenTolerance, 0.001f, m_sampleName + "_diff.png", updateMode);
+        bGoldenCompared = true;
+        if(!goldenResult.bPass) exitCode = EXIT_FAILURE;
+        else if(goldenResult.bCreated && updateMode == CGoldenImage::UPDATE_MISSING) exitCode = EXIT_SKIPPED; //nothing was compared
+    }
+    return bWritten;
+}
+
+void CApplication::WriteReport(const std::string &path){
+    //the first frames include pipeline and driver warm-up, they are left out of the frame statistics
+    size_t skip = std::min(frameTimes.size() / 2, (size_t)MAX_FRAMES_IN_FLIGHT);
+    std::vector<float> times(frameTimes.begin() + skip, frameTimes.end());
+    std::sort(times.begin(), times.end());
+    float mean = 0;
+    for(float time : times) mean += time;
+    if(!times.empty()) mean /= times.size();
+    float p95 = times.empty() ? 0 : times[std::min(times.size() - 1, (size_t)(times.size() * 0.95f))];
+    float max = times.empty() ? 0 : times.back();
+
+    std::ofstream report(path);
+    if(!report.is_open()){
+        std::cout<<"Report: could not open "<<path<<std::endl;
+        return;
+    }
+    report<<"{\n";
+    report<<"  \"sample\": \""<<m_sampleName<<"\",\n";
+    report<<"  \"frames\": "<<frameTimes.size()<<",\n";
+    report<<"  \"fixed_step\": "<<fixedStepTime<<",\n";
+    report<<"  \"init_ms\": "<<initTime<<",\n";
+    report<<"  \"cpu_frame_ms\": "<<mean<<",\n";
+    report<<"  \"cpu_frame_p95_ms\": "<<p95<<",\n";
+    report<<"  \"cpu_frame_max_ms\": "<<max<<",\n";
+    report<<"  \"gpu_graphics_ms\": "<<(renderer.bEnableQueueTiming ? renderer.graphicsQueueTime : 0)<<",\n";
+    report<<"  \"gpu_compute_ms\": "<<(renderer.bEnableQueueTiming ? renderer.computeQueueTime : 0)<<",\n";
+    report<<"  \"golden\": \""<<(!bGoldenCompared ? "none" : goldenResult.bCreated ? (bUpdateGolden ? "updated" : "created") : goldenResult.bPass ? "pass" : "fail")<<"\",\n";
+    report<<"  \"golden_bad_pixels\": "<<goldenResult.badPixelFraction<<",\n";
+    report<<"  \"golden_max_delta_e\": "<<goldenResult.maxDeltaE<<"\n";
+    report<<"}\n";
+    std::cout<<"Report: written to "<<path<<std::endl;
 }
 #endif
 
@@ -217,10 +428,15 @@ void CApplication::initialize(){
     ReadMainCamera();
 
     /****************************
-    * 10 Create Sync Objects and Clean up Shaders
+    * 10 Create Sync Objects
+    * Shader modules are kept in shaderManager's cache until CleanUp, for runtime pipeline variants
     ****************************/
     renderer.CreateSyncObjects(swapchain.imageSize);
-    shaderManager.Destroy();
+    LOG(LOG_LEVEL_VERBOSE, LOG_CATEGORY_RENDERER, "Shader module cache: %d modules, %d hits, %d misses",
+        (int)shaderManager.moduleCache.size(), (int)shaderManager.cacheHitCount, (int)shaderManager.cacheMissCount);
+    CDescriptorAllocator::Stats descriptorStats = CGraphicsDescriptorManager::descriptorAllocator.GetStats();
+    std::cout<<"Descriptor set cache: "<<CGraphicsDescriptorManager::descriptorCache.GetEntryCount()<<" sets, hit rate "<<CGraphicsDescriptorManager::descriptorCache.GetHitRate()
+        <<", "<<descriptorStats.poolCount<<" pools ("<<descriptorStats.setsAllocated<<"/"<<descriptorStats.setCapacity<<" sets)"<<std::endl;
 
     // CContext::GetHandle().logManager.print("Test single string!\n");
     // CContext::GetHandle().logManager.print("Test interger: %d!\n", 999);
@@ -243,10 +459,33 @@ void CApplication::update(){
     static auto lastTime = std::chrono::high_resolution_clock::now();
 
     auto currentTime = std::chrono::high_resolution_clock::now();
-    durationTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-    deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
+    float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
     lastTime = currentTime;
 
+    if(fixedStepTime > 0){
+#ifndef ANDROID
+        if(bHeadless) frameTime = fixedStepTime; //one step per frame: headless runs are reproducible, independent of the frame rate
+#endif
+        //the simulation advances in equal steps, the frame renders between the last two of them
+        m_accumulator += std::min(frameTime, 0.25f); //after a long stall, slow down instead of running hundreds of steps
+        while(m_accumulator >= fixedStepTime){
+            SimulateStep(fixedStepTime);
+            m_accumulator -= fixedStepTime;
+        }
+        interpolationAlpha = m_accumulator / fixedStepTime;
+        deltaTime = frameTime;
+        durationTime = std::max(0.0f, ((float)simulationStep - 1.0f + interpolationAlpha) * fixedStepTime);
+        UpdateInterpolated(interpolationAlpha);
+        return;
+    }
+
+    deltaTime = frameTime;
+    durationTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+    std::vector<CInputLog::Event> events; //one step per frame
+    inputLog.Collect(simulationStep++, events);
+    for(auto &event : events) ApplyInput(event);
+
     if(objects.size() > 0 && focusObjectId < objects.size()){
         mainCamera.SetTargetPosition(objects[focusObjectId].Position);
         lightCamera.SetTargetPosition(objects[focusObjectId].Position);
@@ -258,12 +497,104 @@ void CApplication::update(){
     
 }
 
+void CApplication::SimulateStep(float step){
+    PROFILE_SCOPE("simulate step");
+    std::vector<CInputLog::Event> events;
+    inputLog.Collect(simulationStep, events);
+    for(auto &event : events) ApplyInput(event);
+
+    //state before the step: cameras, then objects
+    m_previousStates.resize(objects.size() + 2);
+    m_previousStates[0] = mainCamera;
+    m_previousStates[1] = lightCamera;
+    for(int i = 0; i < objects.size(); i++) m_previousStates[i + 2] = objects[i];
+
+    if(objects.size() > 0 && focusObjectId < objects.size()){
+        mainCamera.SetTargetPosition(objects[focusObjectId].Position);
+        lightCamera.SetTargetPosition(objects[focusObjectId].Position);
+    }
+    mainCamera.update(step);
+    lightCamera.update(step);
+    for(int i = 0; i < objects.size(); i++)
+        if(objects[i].bRegistered && objects[i].bUpdate) objects[i].CEntity::Update(step); //motion only, uniforms are written once per frame
+    simulationStep++;
+}
+
+void CApplication::UpdateInterpolated(float alpha){
+    std::vector<CEntity> &current = m_currentStates; //reused, no allocation per frame
+    current.resize(objects.size() + 2);
+    current[0] = mainCamera;
+    current[1] = lightCamera;
+    for(int i = 0; i < objects.size(); i++) current[i + 2] = objects[i];
+    if(m_previousStates.size() != current.size()) m_previousStates = current; //no step yet, or objects were added
+
+    auto blend = [&](CEntity &entity, size_t i){
+        entity.Position = glm::mix(m_previousStates[i].Position, current[i].Position, alpha);
+        entity.Rotation = glm::mix(m_previousStates[i].Rotation, current[i].Rotation, alpha);
+    };
+    //a zero step moves nothing, it only rebuilds the matrices (and the uniforms) from the blended transforms
+    blend(mainCamera, 0);
+    blend(lightCamera, 1);
+    mainCamera.update(0);
+    lightCamera.update(0);
+    for(int i = 0; i < objects.size(); i++){
+        blend(objects[i], i + 2);
+        objects[i].Update(0, renderer.currentFrame, mainCamera, lightCamera);
+    }
+    for(int i = 0; i < lights.size(); i++) lights[i].Update(deltaTime, renderer.currentFrame, mainCamera);
+
+    //the cameras keep this frame's view matrices, the entities go back to the simulated state
+    static_cast<CEntity&>(mainCamera) = current[0];
+    static_cast<CEntity&>(lightCamera) = current[1];
+    for(int i = 0; i < objects.size(); i++) static_cast<CEntity&>(objects[i]) = current[i + 2];
+}
+
+void CApplication::ApplyInput(const CInputLog::Event &event){
+    switch(event.action){
+        case CInputLog::CAMERA_VELOCITY:
+            if(event.axis >= 0 && event.axis < 3) mainCamera.Velocity[event.axis] = event.x;
+            break;
+        case CInputLog::CAMERA_ANGULAR_VELOCITY:
+            if(mainCamera.cameraType == Camera::CameraType::FREE){
+                mainCamera.AngularVelocity.x = event.x;
+                mainCamera.AngularVelocity.y = event.y;
+            }
+            break;
+        case CInputLog::CAMERA_TOGGLE_TYPE:
+            if(mainCamera.cameraType == Camera::CameraType::LOCK) mainCamera.cameraType = Camera::CameraType::FREE;
+            else if(mainCamera.cameraType == Camera::CameraType::FREE) mainCamera.cameraType = Camera::CameraType::LOCK;
+            break;
+        case CInputLog::CAMERA_WHEEL:
+            if(event.x > 0) mainCamera.MoveRight(1, 2);
+            else if(event.x < 0) mainCamera.MoveLeft(1, 2);
+            if(event.y > 0) mainCamera.MoveForward(1, 2);
+            else if(event.y < 0) mainCamera.MoveBackward(1, 2);
+            break;
+        case CInputLog::FOCUS_NEXT_OBJECT:
+            if(mainCamera.cameraType == Camera::CameraType::LOCK && objects.size() > 0) focusObjectId = (focusObjectId + 1) % objects.size();
+            break;
+        default:
+            break;
+    }
+}
+
 void CApplication::recordGraphicsCommandBuffer(){}
 void CApplication::recordComputeCommandBuffer(){}
 void CApplication::postUpdate(){}
 
 void CApplication::UpdateRecordRender(){
-    update();
+    PROFILE_SCOPE("frame");
+    //must wait until this frame slot's command buffers and uniform buffers are no longer in use
+    //before update() writes the uniforms and the command buffers are recorded
+    renderer.WaitForFrameResources();
+    renderer.readbackService.Poll(renderer.GetCompletedFrameCount()); //deliver finished readbacks, never waits
+    textureStreamer.Update(); //swap streamed textures in/out while no frame in flight uses this slot's sampler sets
+
+    {
+        PROFILE_SCOPE("update");
+        update();
+    }
+    renderer.framePacer.SetInputTime(inputLog.TakeInputTime()); //input latency of this frame's present
 
     /**************************
      * 
@@ -275,19 +606,20 @@ void CApplication::UpdateRecordRender(){
         //case renderer.RENDER_GRAPHICS_Mode:
             //std::cout<<"RENDER_GRAPHICS_Mode"<<std::endl;
 
-            //must wait for fence before record command buffer
-            renderer.WaitForGraphicsFence();
             //must aquire swap image before record command buffer
             renderer.AquireSwapchainImage(swapchain); 
 
             vkResetCommandBuffer(renderer.commandBuffers[renderer.graphicsCmdId][renderer.currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
 
-            renderer.StartRecordGraphicsCommandBuffer(
-                renderProcess.renderPass, 
-                swapchain.swapChainFramebuffers,swapchain.swapChainExtent, 
-                renderProcess.clearValues);
-            recordGraphicsCommandBuffer();
-            renderer.EndRecordGraphicsCommandBuffer();
+            {
+                PROFILE_SCOPE("record graphics");
+                renderer.StartRecordGraphicsCommandBuffer(
+                    renderProcess.renderPass, 
+                    swapchain.swapChainFramebuffers,swapchain.swapChainExtent, 
+                    renderProcess.clearValues);
+                recordGraphicsCommandBuffer();
+                renderer.EndRecordGraphicsCommandBuffer();
+            }
 
             renderer.SubmitGraphics();
 
@@ -296,15 +628,15 @@ void CApplication::UpdateRecordRender(){
         case CRenderer::COMPUTE:
         //case renderer.RENDER_COMPUTE_Mode:
             //std::cout<<"Application: RENDER_COMPUTE_Mode."<<std::endl;
-            renderer.WaitForComputeFence();//must wait for fence before record
-            //std::cout<<"Application: renderer.WaitForComputeFence()"<<std::endl;
-
             vkResetCommandBuffer(renderer.commandBuffers[renderer.computeCmdId][renderer.currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
             //std::cout<<"Application: vkResetCommandBuffer"<<std::endl;
 
-            renderer.StartRecordComputeCommandBuffer(renderProcess.computePipeline, renderProcess.computePipelineLayout);
-            recordComputeCommandBuffer();
-            renderer.EndRecordComputeCommandBuffer();
+            {
+                PROFILE_SCOPE("record compute");
+                renderer.StartRecordComputeCommandBuffer(renderProcess.computePipeline, renderProcess.computePipelineLayout);
+                recordComputeCommandBuffer();
+                renderer.EndRecordComputeCommandBuffer();
+            }
             //std::cout<<"Application: recordComputeCommandBuffer()"<<std::endl;
 
             renderer.SubmitCompute();
@@ -314,8 +646,6 @@ void CApplication::UpdateRecordRender(){
         break;
         case CRenderer::COMPUTE_SWAPCHAIN:
         //case renderer.RENDER_COMPUTE_SWAPCHAIN_Mode:
-            //must wait for fence before record
-            renderer.WaitForComputeFence();
             //must aquire swap image before record command buffer
             renderer.AquireSwapchainImage(swapchain);
             //std::cout<<"Application: renderer.imageIndex = "<<renderer.imageIndex<< std::endl;
@@ -334,23 +664,27 @@ void CApplication::UpdateRecordRender(){
         break;
         case CRenderer::COMPUTE_GRAPHICS:
         //case renderer.RENDER_COMPUTE_GRAPHICS_Mode:
-            renderer.WaitForComputeFence();//must wait for fence before record
-            renderer.WaitForGraphicsFence();//must wait for fence before record
             renderer.AquireSwapchainImage(swapchain);//must aquire swap image before record command buffer
 
             vkResetCommandBuffer(renderer.commandBuffers[renderer.graphicsCmdId][renderer.currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
             vkResetCommandBuffer(renderer.commandBuffers[renderer.computeCmdId][renderer.currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
             
-            renderer.StartRecordComputeCommandBuffer(renderProcess.computePipeline, renderProcess.computePipelineLayout);
-            recordComputeCommandBuffer();
-            renderer.EndRecordComputeCommandBuffer();
-
-            renderer.StartRecordGraphicsCommandBuffer(
-                renderProcess.renderPass, 
-                swapchain.swapChainFramebuffers,swapchain.swapChainExtent, 
-                renderProcess.clearValues);
-            recordGraphicsCommandBuffer();
-            renderer.EndRecordGraphicsCommandBuffer();
+            {
+                PROFILE_SCOPE("record compute");
+                renderer.StartRecordComputeCommandBuffer(renderProcess.computePipeline, renderProcess.computePipelineLayout);
+                recordComputeCommandBuffer();
+                renderer.EndRecordComputeCommandBuffer();
+            }
+
+            {
+                PROFILE_SCOPE("record graphics");
+                renderer.StartRecordGraphicsCommandBuffer(
+                    renderProcess.renderPass, 
+                    swapchain.swapChainFramebuffers,swapchain.swapChainExtent, 
+                    renderProcess.clearValues);
+                recordGraphicsCommandBuffer();
+                renderer.EndRecordGraphicsCommandBuffer();
+            }
             
             renderer.SubmitCompute(); 
             renderer.SubmitGraphics(); 
@@ -361,6 +695,9 @@ void CApplication::UpdateRecordRender(){
         break;
     }
 
+    //readbacks that no graphics command buffer recorded this frame (pre-recorded compute modes)
+    renderer.readbackService.SubmitCopies(renderer.frameNumber);
+
     postUpdate();
 
     renderer.Update(); //update currentFrame    
@@ -387,7 +724,10 @@ void CApplication::CleanUp(){
     //for(int i = 0; i < textureImages.size(); i++) textureImages[i].Destroy();
     //for(int i = 0; i < textureImages1.size(); i++) textureImages1[i].Destroy();
     //for(int i = 0; i < textureImages2.size(); i++) textureImages2[i].Destroy();
+    textureStreamer.Destroy();
+    bindlessTextures.Destroy();
     textureManager.Destroy();
+    shaderManager.Destroy();
     renderer.Destroy();
 
     vkDestroyDevice(CContext::GetHandle().GetLogicalDevice(), nullptr);
@@ -397,7 +737,7 @@ void CApplication::CleanUp(){
         DestroyDebugUtilsMessengerEXT(instance->getHandle(), instance->debugMessenger, nullptr);
 #endif
 
-    vkDestroySurfaceKHR(instance->getHandle(), surface, nullptr);
+    if(surface != VK_NULL_HANDLE) vkDestroySurfaceKHR(instance->getHandle(), surface, nullptr); //headless: none, maybe not even VK_KHR_surface
     vkDestroyInstance(instance->getHandle(), nullptr);
     
     CContext::Quit();
@@ -420,6 +760,26 @@ void CApplication::ReadFeatures(){
     appInfo.Feature.b_feature_graphics_rainbow_mipmap = config["Features"]["feature_graphics_rainbow_mipmap"] ? config["Features"]["feature_graphics_rainbow_mipmap"].as<bool>() : false;
     appInfo.Feature.feature_graphics_pipeline_skybox_id = config["Features"]["feature_graphics_pipeline_skybox_id"] ? config["Features"]["feature_graphics_pipeline_skybox_id"].as<int>() : -1;
     appInfo.Feature.feature_graphics_observe_attachment_id = config["Features"]["feature_graphics_observe_attachment_id"] ? config["Features"]["feature_graphics_observe_attachment_id"].as<int>() : -1;
+    appInfo.Feature.feature_graphics_texture_budget_mb = config["Features"]["feature_graphics_texture_budget_mb"] ? config["Features"]["feature_graphics_texture_budget_mb"].as<int>() : 256;
+    appInfo.Feature.feature_graphics_mipmap_generator = config["Features"]["feature_graphics_mipmap_generator"] ? config["Features"]["feature_graphics_mipmap_generator"].as<std::string>() : "blit";
+    appInfo.Feature.feature_graphics_mipmap_filter = config["Features"]["feature_graphics_mipmap_filter"] ? config["Features"]["feature_graphics_mipmap_filter"].as<std::string>() : "box";
+    appInfo.Feature.feature_graphics_mipmap_alpha_cutoff = config["Features"]["feature_graphics_mipmap_alpha_cutoff"] ? config["Features"]["feature_graphics_mipmap_alpha_cutoff"].as<float>() : 0.0f;
+    appInfo.Feature.feature_graphics_bindless_textures = config["Features"]["feature_graphics_bindless_textures"] ? config["Features"]["feature_graphics_bindless_textures"].as<std::string>() : "none";
+    appInfo.Feature.feature_graphics_descriptor_backend = config["Features"]["feature_graphics_descriptor_backend"] ? config["Features"]["feature_graphics_descriptor_backend"].as<std::string>() : "sets";
+#ifndef ANDROID
+    if(!descriptorBackendName.empty()) appInfo.Feature.feature_graphics_descriptor_backend = descriptorBackendName;
+#endif
+
+    //before any uniform buffer or layout is created: the backend decides their usage and flags.
+    //The bindless sampler array is an update-after-bind descriptor set, so it keeps the descriptor set backend
+    CGraphicsDescriptorManager::descriptorBackend.Init(CDescriptorBackend::ParseMode(
+        appInfo.Feature.feature_graphics_bindless_textures != "none" ? "sets" : appInfo.Feature.feature_graphics_descriptor_backend,
+        (*CContext::GetHandle().physicalDevice)->bPushDescriptor, (*CContext::GetHandle().physicalDevice)->bDescriptorBuffer));
+
+    //rainbow mipmaps blit their own levels
+    textureManager.mipmapGenerator = appInfo.Feature.b_feature_graphics_rainbow_mipmap ? MIPMAP_GENERATOR_BLIT : CTextureManager::ParseMipmapGenerator(appInfo.Feature.feature_graphics_mipmap_generator);
+    textureManager.mipmapOptions.filter = CMipmapGenerator::ParseFilter(appInfo.Feature.feature_graphics_mipmap_filter);
+    textureManager.mipmapOptions.alphaCutoff = appInfo.Feature.feature_graphics_mipmap_alpha_cutoff;
 
     if(appInfo.Feature.b_feature_graphics_push_constant){
         shaderManager.CreatePushConstantRange<ModelPushConstants>(VK_SHADER_STAGE_VERTEX_BIT, 0);
@@ -479,7 +839,7 @@ void CApplication::ReadUniforms(){
 
                 if(appInfo.Uniform.b_uniform_compute_storage)
                     //CComputeDescriptorManager::computeUniformTypes |= COMPUTE_STORAGEBUFFER_DOUBLE;
-                    CComputeDescriptorManager::addStorageBuffer(appInfo.Uniform.ComputeStorageBuffer.Size, appInfo.Uniform.ComputeStorageBuffer.Usage);
+                    CComputeDescriptorManager::addStorageBuffer(appInfo.Uniform.ComputeStorageBuffer.Size, appInfo.Uniform.ComputeStorageBuffer.Usage, renderer.GetSharedQueueFamilies());
 
                 if(appInfo.Uniform.b_uniform_compute_texture_storage)
                     //CComputeDescriptorManager::computeUniformTypes |= COMPUTE_STORAGEIMAGE_TEXTURE;
@@ -492,18 +852,38 @@ void CApplication::ReadUniforms(){
         }
 
         if (uniform["GraphicsTextureImageSamplers"]) {
-            std::vector<int> miplevels;
+            std::vector<CSamplerCache::Key> samplerKeys;
             for (const auto& samplerUniform : uniform["GraphicsTextureImageSamplers"]) {
                 std::string name = samplerUniform["uniform_graphics_texture_image_sampler_name"] ? samplerUniform["uniform_graphics_texture_image_sampler_name"].as<std::string>() : "Default";
                 int miplevel = samplerUniform["uniform_graphics_texture_image_sampler_miplevel"] ? samplerUniform["uniform_graphics_texture_image_sampler_miplevel"].as<int>() : 1;
-                miplevels.push_back(miplevel);
+                samplerKeys.push_back(ReadSamplerKey(samplerUniform, miplevel));
             }
             CGraphicsDescriptorManager::graphicsUniformTypes |= GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE;
-            CGraphicsDescriptorManager::addTextureImageSamplerUniformBuffer(miplevels);
+            CGraphicsDescriptorManager::addTextureImageSamplerUniformBuffer(samplerKeys);
         }
     }
 }
 
+//miplevel > 1 samples the whole mip chain unless uniform_graphics_texture_image_sampler_max_lod limits it; miplevel 1 only the base level
+CSamplerCache::Key CApplication::ReadSamplerKey(const YAML::Node &samplerUniform, int miplevel){
+    CSamplerCache::Key key;
+    std::string addressMode = samplerUniform["uniform_graphics_texture_image_sampler_address_mode"] ? samplerUniform["uniform_graphics_texture_image_sampler_address_mode"].as<std::string>() : "repeat";
+    key.magFilter = CSamplerCache::ParseFilter(samplerUniform["uniform_graphics_texture_image_sampler_mag_filter"] ? samplerUniform["uniform_graphics_texture_image_sampler_mag_filter"].as<std::string>() : "linear");
+    key.minFilter = CSamplerCache::ParseFilter(samplerUniform["uniform_graphics_texture_image_sampler_min_filter"] ? samplerUniform["uniform_graphics_texture_image_sampler_min_filter"].as<std::string>() : "linear");
+    key.mipmapMode = (miplevel > 1) ? CSamplerCache::ParseMipmapMode(samplerUniform["uniform_graphics_texture_image_sampler_mipmap_mode"] ? samplerUniform["uniform_graphics_texture_image_sampler_mipmap_mode"].as<std::string>() : "linear")
+        : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    key.addressModeU = CSamplerCache::ParseAddressMode(samplerUniform["uniform_graphics_texture_image_sampler_address_mode_u"] ? samplerUniform["uniform_graphics_texture_image_sampler_address_mode_u"].as<std::string>() : addressMode);
+    key.addressModeV = CSamplerCache::ParseAddressMode(samplerUniform["uniform_graphics_texture_image_sampler_address_mode_v"] ? samplerUniform["uniform_graphics_texture_image_sampler_address_mode_v"].as<std::string>() : addressMode);
+    key.addressModeW = CSamplerCache::ParseAddressMode(samplerUniform["uniform_graphics_texture_image_sampler_address_mode_w"] ? samplerUniform["uniform_graphics_texture_image_sampler_address_mode_w"].as<std::string>() : addressMode);
+    key.maxAnisotropy = samplerUniform["uniform_graphics_texture_image_sampler_anisotropy"] ? samplerUniform["uniform_graphics_texture_image_sampler_anisotropy"].as<float>() : 0.0f; //0: device maximum
+    key.mipLodBias = samplerUniform["uniform_graphics_texture_image_sampler_lod_bias"] ? samplerUniform["uniform_graphics_texture_image_sampler_lod_bias"].as<float>() : 0.0f;
+    key.minLod = samplerUniform["uniform_graphics_texture_image_sampler_min_lod"] ? samplerUniform["uniform_graphics_texture_image_sampler_min_lod"].as<float>() : 0.0f;
+    key.maxLod = samplerUniform["uniform_graphics_texture_image_sampler_max_lod"] ? samplerUniform["uniform_graphics_texture_image_sampler_max_lod"].as<float>() : ((miplevel > 1) ? VK_LOD_CLAMP_NONE : 0.0f);
+    key.compareOp = CSamplerCache::ParseCompareOp(samplerUniform["uniform_graphics_texture_image_sampler_compare_op"] ? samplerUniform["uniform_graphics_texture_image_sampler_compare_op"].as<std::string>() : "none");
+    key.borderColor = CSamplerCache::ParseBorderColor(samplerUniform["uniform_graphics_texture_image_sampler_border_color"] ? samplerUniform["uniform_graphics_texture_image_sampler_border_color"].as<std::string>() : "opaque_black");
+    return key;
+}
+
 void CApplication::ReadResources(){
     for (const auto& resource : config["Resources"]) {
         if (resource["Models"]) {
@@ -537,9 +917,13 @@ void CApplication::ReadResources(){
                     renderer.CreateIndexBuffer(modelIndices3D);
                 }
             }
+            //models are drawn from the first frame: wait for their copies, the first command buffer acquires them
+            renderer.uploadService.Flush();
         }
 
         if (resource["Textures"]) {
+            //rainbow mipmaps are generated at load time, a cooked mip chain would hide them
+            textureManager.bPreferCookedTextures = !appInfo.Feature.b_feature_graphics_rainbow_mipmap;
             //texture id is allocated by engine, instead of user, in order
             for (const auto& texture : resource["Textures"]) {
                 std::string name = texture["resource_texture_name"].as<std::string>();
@@ -547,6 +931,15 @@ void CApplication::ReadResources(){
                 int miplevel = texture["resource_texture_miplevels"].as<int>();
                 bool enableCubemap = texture["resource_texture_cubmap"].as<bool>();
                 int samplerid = texture["uniform_Sampler_id"].as<int>();
+                bool enableStreaming = texture["resource_texture_streaming"] ? texture["resource_texture_streaming"].as<bool>() : false;
+                std::string mipmapGenerator = texture["resource_texture_mipmap_generator"] ? texture["resource_texture_mipmap_generator"].as<std::string>() : appInfo.Feature.feature_graphics_mipmap_generator;
+                bool enableEnvironmentPrefilter = texture["resource_texture_environment_prefilter"] ? texture["resource_texture_environment_prefilter"].as<bool>() : false;
+
+                //image based lighting from an equirect .hdr: takes 4 texture ids (environment, irradiance, prefiltered, BRDF LUT)
+                if(enableEnvironmentPrefilter){
+                    textureManager.CreateEnvironmentTextures(name, renderer.commandPool, samplerid);
+                    continue;
+                }
 
                 VkImageUsageFlags usage;// = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
                 //VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
@@ -558,6 +951,16 @@ void CApplication::ReadResources(){
                 else 
                     if(CComputeDescriptorManager::computeUniformTypes & COMPUTE_STORAGEIMAGE_TEXTURE) usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
                     else usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+                if(appInfo.Feature.feature_graphics_bindless_textures != "none") usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //small textures may be copied into atlas pages
+                //streaming supports plain RGBA8 2D textures sampled by graphics; others are loaded at startup as usual
+                if(enableStreaming && !enableCubemap && !appInfo.Feature.b_feature_graphics_48pbt && !appInfo.Feature.b_feature_graphics_rainbow_mipmap
+                    && !(CComputeDescriptorManager::computeUniformTypes & (COMPUTE_STORAGEIMAGE_TEXTURE | COMPUTE_STORAGEIMAGE_SWAPCHAIN))){
+                    if(!textureStreamer.IsEnabled()) textureStreamer.Init(&textureManager, &renderer, (VkDeviceSize)appInfo.Feature.feature_graphics_texture_budget_mb << 20);
+                    textureStreamer.AddTexture(name, usage, miplevel, samplerid);
+                    continue;
+                }
+
+                if(!appInfo.Feature.b_feature_graphics_rainbow_mipmap) textureManager.mipmapGenerator = CTextureManager::ParseMipmapGenerator(mipmapGenerator);
                 if(!appInfo.Feature.b_feature_graphics_48pbt) //24bpt
                     if(CComputeDescriptorManager::computeUniformTypes & COMPUTE_STORAGEIMAGE_SWAPCHAIN) textureManager.CreateTextureImage(name, usage, renderer.commandPool, miplevel, samplerid, swapchain.swapChainImageFormat);
                     else textureManager.CreateTextureImage(name, usage, renderer.commandPool, miplevel, samplerid, VK_FORMAT_R8G8B8A8_SRGB, 8, enableCubemap);  
@@ -580,6 +983,7 @@ void CApplication::ReadResources(){
         if (resource["Pipelines"]) {
             appInfo.VertexShader =  std::make_unique<std::vector<std::string>>(std::vector<std::string>());
             appInfo.FragmentShader =  std::make_unique<std::vector<std::string>>(std::vector<std::string>());
+            appInfo.FragmentShaderAtlas =  std::make_unique<std::vector<std::string>>(std::vector<std::string>());
             appInfo.Subpass =  std::make_unique<std::vector<int>>(std::vector<int>());
 
             for (const auto& pipeline : resource["Pipelines"]) {
@@ -587,10 +991,12 @@ void CApplication::ReadResources(){
                 std::string vertexShaderName = pipeline["resource_graphics_pipeline_vertexshader_name"].as<std::string>();
                 std::string fragmentShaderName = pipeline["resource_graphics_pipeline_fragmentshader_name"].as<std::string>();
                 int subpassId = pipeline["subpasses_subpass_id"] ? pipeline["subpasses_subpass_id"].as<int>() : 0;
+                std::string fragmentShaderAtlasName = pipeline["resource_graphics_pipeline_fragmentshader_atlas_name"] ? pipeline["resource_graphics_pipeline_fragmentshader_atlas_name"].as<std::string>() : fragmentShaderName;
 
                 std::cout<<"Pipeline Name: "<<name<<std::endl;
                 appInfo.VertexShader->push_back(vertexShaderName);
                 appInfo.FragmentShader->push_back(fragmentShaderName);
+                appInfo.FragmentShaderAtlas->push_back(fragmentShaderAtlasName);
                 appInfo.Subpass->push_back(subpassId);
             }
 
@@ -653,7 +1059,7 @@ void CApplication::ReadAttachments(){
 
     if(swapchain.iAttachmentColorResovle >= 0){
         swapchain.create_attachment_description_color_resolve(); 
-        renderProcess.create_attachment_description_color_resolve(swapchain.swapChainImageFormat, swapchain.msaaSamples, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR); 
+        renderProcess.create_attachment_description_color_resolve(swapchain.swapChainImageFormat, swapchain.msaaSamples, swapchain.finalLayout); 
         
         renderProcess.m_renderFeature = CRenderProcess::RenderFeatures::PRESENT_DEPTH_MSAA;
     }
@@ -664,7 +1070,7 @@ void CApplication::ReadAttachments(){
     }
 
     if(swapchain.iAttachmentColorPresent >= 0) //dont need create buffer here
-        renderProcess.create_attachment_description_color_present(swapchain.swapChainImageFormat);
+        renderProcess.create_attachment_description_color_present(swapchain.swapChainImageFormat, swapchain.finalLayout);
 }
 
 void CApplication::ReadSubpasses(){
@@ -692,6 +1098,11 @@ void CApplication::CreateUniformDescriptors(bool b_uniform_graphics, bool b_unif
              CGraphicsDescriptorManager::createDescriptorSetLayout_General(&appInfo.Uniform.GraphicsCustom.Binding); 
         else CGraphicsDescriptorManager::createDescriptorSetLayout_General(); 
         if(CGraphicsDescriptorManager::textureImageSamplers.size()>0) CGraphicsDescriptorManager::createDescriptorSetLayout_TextureImageSampler(); 
+
+        //descriptor buffer backend: a set 0 and a sampler region per object
+        std::vector<VkDescriptorSetLayout> regionLayouts = {CGraphicsDescriptorManager::descriptorSetLayout_general};
+        if(CGraphicsDescriptorManager::textureImageSamplers.size()>0) regionLayouts.push_back(CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler);
+        CGraphicsDescriptorManager::descriptorBackend.CreateDescriptorBuffers(regionLayouts, std::max(2 * static_cast<uint32_t>(objects.size()), 1u));
     }
     if(b_uniform_compute){
         if(appInfo.Uniform.b_uniform_compute_custom) CComputeDescriptorManager::createDescriptorSetLayout(&appInfo.Uniform.ComputeCustom.Binding);
@@ -705,6 +1116,10 @@ void CApplication::CreateUniformDescriptors(bool b_uniform_graphics, bool b_unif
         else// if(appInfo.Feature.feature_graphics_observe_attachment_id == 1)
             graphicsDescriptorManager.createDescriptorSets_General(swapchain.depthImageBuffer.view);//TODO: what if no depthImageBuffer is not enable 
     }
+    //one sampler array for all textures instead of per-object sampler sets (set = 1)
+    if(CGraphicsDescriptorManager::textureImageSamplers.size() > 0)
+        bindlessTextures.Init(CBindlessTextures::ParseMode(appInfo.Feature.feature_graphics_bindless_textures, (*CContext::GetHandle().physicalDevice)->bDescriptorIndexing),
+            &textureManager, &CGraphicsDescriptorManager::textureImageSamplers, renderer.commandPool);
     if(b_uniform_compute){
         if(appInfo.Uniform.b_uniform_compute_swapchain_storage) {
             if(appInfo.Uniform.b_uniform_compute_texture_storage)
@@ -750,10 +1165,12 @@ void CApplication::CreatePipelines(){
     /****************************
     * Create Shaders
     ****************************/
+    shaderManager.QueryShaderModuleFeatures();
     if(appInfo.VertexShader != NULL){
         for(int i = 0; i < appInfo.VertexShader->size(); i++){
             shaderManager.CreateShader((*appInfo.VertexShader)[i], shaderManager.VERT);
-            shaderManager.CreateShader((*appInfo.FragmentShader)[i], shaderManager.FRAG);
+            if(bindlessTextures.mode == CBindlessTextures::MODE_ATLAS) shaderManager.CreateShader((*appInfo.FragmentShaderAtlas)[i], shaderManager.FRAG);
+            else shaderManager.CreateShader((*appInfo.FragmentShader)[i], shaderManager.FRAG);
         }
     }
     if(appInfo.ComputeShader != NULL)
@@ -765,6 +1182,7 @@ void CApplication::CreatePipelines(){
     * Create Pipelines
     ****************************/
     if(appInfo.VertexShader != NULL){
+        renderProcess.graphicsPipelineCreateFlags = CGraphicsDescriptorManager::descriptorBackend.GetPipelineCreateFlags();
         std::vector<VkDescriptorSetLayout> dsLayouts; //2 sets for graphics
 
         if((CGraphicsDescriptorManager::graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_CUSTOM) || 
@@ -777,7 +1195,8 @@ void CApplication::CreatePipelines(){
 
         if(CGraphicsDescriptorManager::graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE) {
             if(bVerbose) std::cout<<"CreatePipeline: Add layout set1: sampler(texture) layout"<<std::endl;
-            dsLayouts.push_back(CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler); //set = 1
+            if(bindlessTextures.IsEnabled()) dsLayouts.push_back(bindlessTextures.descriptorSetLayout); //set = 1
+            else dsLayouts.push_back(CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler); //set = 1
         }
 
   
@@ -794,7 +1213,12 @@ void CApplication::CreatePipelines(){
         for(int i = 0; i < appInfo.VertexShader->size(); i++){
             //std::cout<<"test create pipeline"<<std::endl;
             //! All graphics pipelines use the same dsLayouts
-            if(shaderManager.bEnablePushConstant){
+            if(bindlessTextures.IsEnabled()){ //model matrix (vertex, optional) + texture index (fragment)
+                std::vector<VkPushConstantRange> pushConstantRanges;
+                if(shaderManager.bEnablePushConstant) pushConstantRanges.push_back(shaderManager.pushConstantRange);
+                pushConstantRanges.push_back(bindlessTextures.GetPushConstantRange());
+                renderProcess.createGraphicsPipelineLayout(dsLayouts, pushConstantRanges, i);
+            }else if(shaderManager.bEnablePushConstant){
                 if(bVerbose) std::cout<<"CreatePipeline: Try Create Push Constant Layout"<<std::endl;
                 renderProcess.createGraphicsPipelineLayout(dsLayouts,  shaderManager.pushConstantRange, true, i);
                 if(bVerbose) std::cout<<"CreatePipeline: Done Create Push Constant Layout"<<std::endl;
@@ -0,0 +1,176 @@
+#include "../include/binaryLog.h"
+
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+    "the binary log shares 64 bit atomics with its file mapping");
+
+CLogFormat::BinaryHeader *CBinaryLog::s_pHeader = nullptr;
+uint8_t *CBinaryLog::s_pSiteTable = nullptr;
+uint8_t *CBinaryLog::s_pRing = nullptr;
+uint64_t CBinaryLog::s_ringMask = 0;
+uint32_t CBinaryLog::s_siteCount = 0;
+std::mutex CBinaryLog::s_siteMutex;
+size_t CBinaryLog::s_mappingSize = 0;
+std::chrono::steady_clock::time_point CBinaryLog::s_openTime;
+#ifdef _WIN32
+void *CBinaryLog::s_hFile = nullptr;
+void *CBinaryLog::s_hMapping = nullptr;
+#endif
+
+static std::atomic<uint64_t> &AtomicAt(uint64_t *p){ return *reinterpret_cast<std::atomic<uint64_t>*>(p); }
+
+bool CBinaryLog::Open(const std::string &path, uint64_t ringSize){
+    if(s_pHeader) return false;
+    uint64_t size = 64 << 10;
+    while(size < ringSize) size <<= 1;
+    ringSize = size;
+    size_t headerSize = (sizeof(CLogFormat::BinaryHeader) + 63) & ~(size_t)63;
+    s_mappingSize = headerSize + SITE_TABLE_SIZE + ringSize;
+
+    void *pView = nullptr;
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE hMapping = NULL;
+    if(hFile != INVALID_HANDLE_VALUE)
+        hMapping = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, (DWORD)((uint64_t)s_mappingSize >> 32), (DWORD)s_mappingSize, NULL);
+    if(hMapping) pView = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, s_mappingSize);
+    if(!pView){
+        if(hMapping) CloseHandle(hMapping);
+        if(hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+    }else{
+        s_hFile = hFile;
+        s_hMapping = hMapping;
+    }
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd >= 0){
+        if(ftruncate(fd, (off_t)s_mappingSize) == 0){
+            pView = mmap(nullptr, s_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(pView == MAP_FAILED) pView = nullptr;
+        }
+        close(fd); //the mapping keeps its own reference
+    }
+#endif
+    if(!pView){
+        std::cout<<"Binary log: could not map "<<path<<std::endl;
+        return false;
+    }
+
+    //a new file reads as zeros: a slot that was never committed has size 0 and is skipped by the decoder
+    s_pHeader = static_cast<CLogFormat::BinaryHeader*>(pView);
+    memcpy(s_pHeader->magic, "VKBLOG1", 8);
+    s_pHeader->version = CLogFormat::BINARY_VERSION;
+    s_pHeader->headerSize = (uint32_t)headerSize;
+    s_pHeader->siteTableSize = SITE_TABLE_SIZE;
+    s_pHeader->ringSize = ringSize;
+    s_pHeader->startTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    s_pHeader->baseTicks = CCpuProfiler::Now();
+    s_openTime = std::chrono::steady_clock::now();
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2)); //first estimate of the TSC rate, refined at Close
+    Calibrate();
+#else
+    s_pHeader->ticksPerMicrosecond = 1000.0; //steady_clock nanoseconds
+#endif
+    s_pSiteTable = static_cast<uint8_t*>(pView) + headerSize;
+    s_ringMask = ringSize - 1;
+    s_pRing = s_pSiteTable + SITE_TABLE_SIZE;
+
+    static bool bAtExit = false;
+    if(!bAtExit) std::atexit(Close);
+    bAtExit = true;
+    std::cout<<"Binary log: "<<path<<", "<<(ringSize >> 20)<<" MB ring"<<std::endl;
+    return true;
+}
+
+void CBinaryLog::Close(){
+    if(!s_pHeader) return;
+    //the caller makes sure no other thread still logs
+    s_pRing = nullptr;
+    Calibrate();
+    uint64_t written = AtomicAt(&s_pHeader->writeOffset).load();
+    std::cout<<"Binary log: "<<s_siteCount<<" call sites, "<<written<<" bytes written"
+        <<(s_pHeader->droppedRecords ? ", " + std::to_string(s_pHeader->droppedRecords) + " records dropped" : "")<<std::endl;
+#ifdef _WIN32
+    FlushViewOfFile(s_pHeader, 0);
+    UnmapViewOfFile(s_pHeader);
+    CloseHandle(s_hMapping);
+    CloseHandle(s_hFile);
+    s_hMapping = s_hFile = nullptr;
+#else
+    msync(s_pHeader, s_mappingSize, MS_SYNC);
+    munmap(s_pHeader, s_mappingSize);
+#endif
+    s_pHeader = nullptr;
+    s_pSiteTable = nullptr;
+}
+
+void CBinaryLog::Calibrate(){
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    double elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_openTime).count();
+    uint64_t ticks = CCpuProfiler::Now() - s_pHeader->baseTicks;
+    if(elapsedMicroseconds > 1000.0) s_pHeader->ticksPerMicrosecond = (double)ticks / elapsedMicroseconds;
+#endif
+}
+
+/*******************
+*	Logging, any thread
+********************/
+uint32_t CBinaryLog::Register(std::atomic<uint32_t> &site, LogLevel level, LogCategory category, const char *file, int line,
+    const char *format, const char *signature){
+    std::lock_guard<std::mutex> lock(s_siteMutex);
+    uint32_t id = site.load(std::memory_order_relaxed);
+    if(id != SITE_NONE) return id; //another thread was first
+    if(!s_pHeader) return SITE_NONE;
+
+    size_t fileLength = strlen(file) + 1, formatLength = strlen(format) + 1, signatureLength = strlen(signature) + 1;
+    uint64_t size = (sizeof(CLogFormat::BinarySite) + fileLength + formatLength + signatureLength + 7) & ~uint64_t(7);
+    uint64_t used = AtomicAt(&s_pHeader->siteTableUsed).load(std::memory_order_relaxed);
+    if(used + size > SITE_TABLE_SIZE){
+        AtomicAt(&s_pHeader->droppedRecords).fetch_add(1, std::memory_order_relaxed);
+        id = SITE_DROPPED;
+    }else{
+        id = s_siteCount++;
+        CLogFormat::BinarySite entry = {(uint32_t)size, id, (uint32_t)line, (uint8_t)level, (uint8_t)category, 0};
+        uint8_t *p = s_pSiteTable + used;
+        memcpy(p, &entry, sizeof(entry));
+        p += sizeof(entry);
+        memcpy(p, file, fileLength);
+        memcpy(p + fileLength, format, formatLength);
+        memcpy(p + fileLength + formatLength, signature, signatureLength);
+        AtomicAt(&s_pHeader->siteTableUsed).store(used + size, std::memory_order_release); //the entry is in the file before any record uses it
+    }
+    site.store(id, std::memory_order_release);
+    return id;
+}
+
+bool CBinaryLog::Reserve(uint64_t size, uint64_t &offset){
+    if(size > (s_ringMask + 1) / 4){ //would overwrite a good part of the ring at once
+        AtomicAt(&s_pHeader->droppedRecords).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    offset = AtomicAt(&s_pHeader->writeOffset).fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+void CBinaryLog::Copy(uint64_t &position, const void *data, size_t size){
+    size_t start = (size_t)(position & s_ringMask);
+    size_t first = std::min(size, (size_t)(s_ringMask + 1 - start));
+    memcpy(s_pRing + start, data, first);
+    if(first < size) memcpy(s_pRing, static_cast<const uint8_t*>(data) + first, size - first);
+    position += size;
+}
+
+void CBinaryLog::Commit(uint64_t offset){
+    //records and the ring size are multiples of 8: the offset field never wraps
+    AtomicAt(reinterpret_cast<uint64_t*>(s_pRing + (offset & s_ringMask))).store(offset, std::memory_order_release);
+}
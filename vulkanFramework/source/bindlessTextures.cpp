@@ -0,0 +1,315 @@
+#include "../include/bindlessTextures.h"
+
+#include <map>
+
+CBindlessTextures::CBindlessTextures(){}
+CBindlessTextures::~CBindlessTextures(){}
+
+CBindlessTextures::Mode CBindlessTextures::ParseMode(const std::string &name, bool bDescriptorIndexing){
+    if(name == "auto") return bDescriptorIndexing ? MODE_DESCRIPTOR_INDEXING : MODE_ATLAS;
+    if(name == "atlas") return MODE_ATLAS;
+    return MODE_DISABLED;
+}
+
+/*******************
+*	Bindless Textures: Init
+********************/
+void CBindlessTextures::Init(Mode requestedMode, CTextureManager *pTextureManager, std::vector<VkSampler> *pSamplers, VkCommandPool &commandPool){
+    auto startTime = std::chrono::high_resolution_clock::now();
+    mode = requestedMode;
+    if(mode == MODE_DISABLED) return;
+    if(mode == MODE_DESCRIPTOR_INDEXING && !(*CContext::GetHandle().physicalDevice)->bDescriptorIndexing) mode = MODE_ATLAS;
+    m_pTextureManager = pTextureManager;
+    m_pSamplers = pSamplers;
+    m_pCommandPool = &commandPool;
+    if(m_pSamplers->empty()) throw std::runtime_error("failed to create bindless textures: no texture sampler!");
+
+    //Step 1: slots. Atlas pages first, then every 2D texture that is not packed, in texture id order
+    m_placements.assign(m_pTextureManager->textureImages.size(), Placement());
+    if(mode == MODE_ATLAS) BuildAtlas();
+    for(int id = 0; id < (int)m_pTextureManager->textureImages.size(); id++){
+        if(!IsBindable(id) || m_placements[id].bAtlas) continue;
+        m_placements[id].slot = static_cast<uint32_t>(m_slots.size());
+        Slot slot;
+        slot.textureId = id;
+        m_slots.push_back(slot);
+    }
+    if(m_slots.empty()) throw std::runtime_error("failed to create bindless textures: no 2D texture!");
+    uint32_t maxSlots = (mode == MODE_ATLAS) ? ATLAS_SLOTS : std::min(MAX_TEXTURES, (*CContext::GetHandle().physicalDevice)->maxBindlessTextures);
+    if(m_slots.size() > maxSlots) throw std::runtime_error("failed to create bindless textures: too many textures for the sampler array!");
+
+    //Step 2: layout, pool and one set per frame in flight
+    CreateDescriptors();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    PRINT("BindlessTextures: %s", std::string(mode == MODE_ATLAS ? "atlas" : "descriptor indexing"));
+    PRINT("BindlessTextures: %d slots", (int)m_slots.size());
+    PRINT("BindlessTextures: %d textures in %d atlas pages", (int)m_atlasTextureCount, (int)m_atlasPages.size());
+    PRINT("BindlessTextures: init cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+}
+
+void CBindlessTextures::Destroy(){
+    if(mode == MODE_DISABLED) return;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    for(auto &page : m_atlasPages) page.image.destroy();
+    m_atlasPages.clear();
+    //sets are freed with the pool
+    if(m_descriptorPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+    if(descriptorSetLayout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    m_descriptorPool = VK_NULL_HANDLE;
+    descriptorSetLayout = VK_NULL_HANDLE;
+    descriptorSets.clear();
+    m_slots.clear();
+    mode = MODE_DISABLED;
+}
+
+bool CBindlessTextures::IsBindable(int textureId){
+    return !m_pTextureManager->textureImages[textureId].m_bCubemap; //the array is sampler2D
+}
+
+bool CBindlessTextures::IsAtlasCandidate(int textureId){
+    CTextureImage &texture = m_pTextureManager->textureImages[textureId];
+    //streamed textures swap their view at runtime, mipmapped ones would lose their chain (pages have one level)
+    return IsBindable(textureId) && !texture.m_bStreaming && texture.m_mipLevels == 1
+        && (texture.m_usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+        && texture.m_texWidth > 0 && texture.m_texHeight > 0
+        && (uint32_t)texture.m_texWidth <= ATLAS_MAX_TEXTURE_SIZE && (uint32_t)texture.m_texHeight <= ATLAS_MAX_TEXTURE_SIZE
+        && texture.m_sampler_id < m_pSamplers->size();
+}
+
+/*******************
+*	Bindless Textures: Atlas
+********************/
+void CBindlessTextures::BuildAtlas(){
+    //Step 1: shelf packing per (format, sampler), tallest first
+    std::map<std::pair<VkFormat, uint32_t>, std::vector<int>> groups;
+    for(int id = 0; id < (int)m_pTextureManager->textureImages.size(); id++)
+        if(IsAtlasCandidate(id)) groups[{m_pTextureManager->textureImages[id].m_imageFormat, m_pTextureManager->textureImages[id].m_sampler_id}].push_back(id);
+
+    struct Rect{ int textureId; uint32_t page, x, y, w, h; };
+    std::vector<Rect> rects;
+    for(auto &group : groups){
+        std::vector<int> &ids = group.second;
+        if(ids.size() < 2) continue; //a page for one texture saves nothing
+        std::sort(ids.begin(), ids.end(), [&](int a, int b){ return m_pTextureManager->textureImages[a].m_texHeight > m_pTextureManager->textureImages[b].m_texHeight; });
+
+        uint32_t x = 0, y = 0, shelfHeight = 0;
+        AtlasPage page;
+        page.format = group.first.first;
+        page.samplerId = group.first.second;
+        m_atlasPages.push_back(page);
+        for(int id : ids){
+            uint32_t w = (uint32_t)m_pTextureManager->textureImages[id].m_texWidth;
+            uint32_t h = (uint32_t)m_pTextureManager->textureImages[id].m_texHeight;
+            if(x + w > ATLAS_PAGE_SIZE){ x = 0; y += shelfHeight; shelfHeight = 0; }
+            if(y + h > ATLAS_PAGE_SIZE){ x = 0; y = 0; shelfHeight = 0; m_atlasPages.push_back(page); }
+            AtlasPage &current = m_atlasPages.back();
+            rects.push_back({id, static_cast<uint32_t>(m_atlasPages.size() - 1), x, y, w, h});
+            current.width = std::max(current.width, x + w); //pages are trimmed to what is used
+            current.height = std::max(current.height, y + h);
+            x += w;
+            shelfHeight = std::max(shelfHeight, h);
+        }
+    }
+    if(rects.empty()) return;
+
+    //Step 2: pages are the first slots
+    for(uint32_t i = 0; i < m_atlasPages.size(); i++){
+        Slot slot;
+        slot.atlasPage = (int)i;
+        m_slots.push_back(slot);
+    }
+    for(auto &rect : rects){
+        AtlasPage &page = m_atlasPages[rect.page];
+        m_placements[rect.textureId].slot = rect.page;
+        m_placements[rect.textureId].bAtlas = true;
+        m_placements[rect.textureId].uvRect = glm::vec4((float)rect.w / page.width, (float)rect.h / page.height, (float)rect.x / page.width, (float)rect.y / page.height);
+    }
+    m_atlasTextureCount = static_cast<uint32_t>(rects.size());
+
+    //Step 3: copy texels on the GPU; the source textures stay in GENERAL like every texture
+    for(auto &page : m_atlasPages){
+        page.image.createImage(page.width, page.height, 1, VK_SAMPLE_COUNT_1_BIT, page.format, VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        page.image.createImageView(page.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, false);
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = *m_pCommandPool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(CContext::GetHandle().GetLogicalDevice(), &allocInfo, &commandBuffer);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    std::vector<VkImageMemoryBarrier> barriers(m_atlasPages.size());
+    for(uint32_t i = 0; i < m_atlasPages.size(); i++){
+        barriers[i] = {};
+        barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].image = m_atlasPages[i].image.image;
+        barriers[i].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[i].srcAccessMask = 0;
+        barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    for(auto &rect : rects){
+        VkImageCopy region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.dstOffset = {(int32_t)rect.x, (int32_t)rect.y, 0};
+        region.extent = {rect.w, rect.h, 1};
+        vkCmdCopyImage(commandBuffer, m_pTextureManager->textureImages[rect.textureId].m_textureImageBuffer.image, VK_IMAGE_LAYOUT_GENERAL,
+            m_atlasPages[rect.page].image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    for(auto &barrier : barriers){
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    vkEndCommandBuffer(commandBuffer);
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(CContext::GetHandle().GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(CContext::GetHandle().GetGraphicsQueue());
+    vkFreeCommandBuffers(CContext::GetHandle().GetLogicalDevice(), *m_pCommandPool, 1, &commandBuffer);
+}
+
+/*******************
+*	Bindless Textures: Descriptors
+********************/
+void CBindlessTextures::CreateDescriptors(){
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    uint32_t slotCount = static_cast<uint32_t>(m_slots.size());
+    uint32_t arraySize = (mode == MODE_ATLAS) ? ATLAS_SLOTS : std::min(MAX_TEXTURES, (*CContext::GetHandle().physicalDevice)->maxBindlessTextures);
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = arraySize;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    //descriptor indexing: the set is as large as the texture list, slots may be rewritten after the set is bound
+    VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT
+        | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+    if(mode == MODE_DESCRIPTOR_INDEXING){
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layoutInfo.pNext = &bindingFlagsInfo;
+    }
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless descriptor set layout!");
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = ((mode == MODE_ATLAS) ? arraySize : slotCount) * static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = (mode == MODE_DESCRIPTOR_INDEXING) ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT : 0;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+
+    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+    std::vector<uint32_t> variableCounts(MAX_FRAMES_IN_FLIGHT, slotCount);
+    VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableCountInfo{};
+    variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+    variableCountInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    variableCountInfo.pDescriptorCounts = variableCounts.data();
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = (mode == MODE_DESCRIPTOR_INDEXING) ? &variableCountInfo : nullptr;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    allocInfo.pSetLayouts = layouts.data();
+    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate bindless descriptor sets!");
+
+    //atlas: every element of the fixed array must be valid, unused ones repeat slot 0
+    std::vector<uint32_t> slots((mode == MODE_ATLAS) ? arraySize : slotCount);
+    for(uint32_t i = 0; i < slots.size(); i++) slots[i] = i;
+    m_boundVersions.assign(MAX_FRAMES_IN_FLIGHT, std::vector<uint32_t>(slotCount, 0));
+    m_updatedFrameNumbers.assign(MAX_FRAMES_IN_FLIGHT, ~0ull);
+    for(uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) WriteSlots(frame, slots);
+}
+
+void CBindlessTextures::WriteSlots(uint32_t frame, const std::vector<uint32_t> &slots){
+    std::vector<VkDescriptorImageInfo> imageInfos(slots.size());
+    std::vector<VkWriteDescriptorSet> descriptorWrites(slots.size());
+    for(size_t i = 0; i < slots.size(); i++){
+        const Slot &slot = m_slots[slots[i] < m_slots.size() ? slots[i] : 0];
+        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        if(slot.atlasPage >= 0){
+            imageInfos[i].imageView = m_atlasPages[slot.atlasPage].image.view;
+            imageInfos[i].sampler = (*m_pSamplers)[m_atlasPages[slot.atlasPage].samplerId];
+        }else{
+            CTextureImage &texture = m_pTextureManager->textureImages[slot.textureId];
+            imageInfos[i].imageView = texture.m_textureImageBuffer.view;
+            imageInfos[i].sampler = (*m_pSamplers)[texture.m_sampler_id < m_pSamplers->size() ? texture.m_sampler_id : 0];
+            if(slots[i] < m_slots.size()) m_boundVersions[frame][slots[i]] = texture.m_version;
+        }
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = descriptorSets[frame];
+        descriptorWrites[i].dstBinding = 0;
+        descriptorWrites[i].dstArrayElement = slots[i];
+        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pImageInfo = &imageInfos[i];
+    }
+    vkUpdateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
+
+/*******************
+*	Bindless Textures: Draw
+********************/
+VkPushConstantRange CBindlessTextures::GetPushConstantRange(){
+    VkPushConstantRange range{};
+    range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    range.offset = PUSH_CONSTANT_OFFSET;
+    range.size = sizeof(PushConstants);
+    return range;
+}
+
+void CBindlessTextures::GetPushConstants(int textureId, PushConstants &pushConstants){
+    pushConstants = PushConstants();
+    if(textureId < 0 || textureId >= (int)m_placements.size()) return;
+    pushConstants.textureIndex = m_placements[textureId].slot;
+    pushConstants.uvRect = m_placements[textureId].uvRect;
+}
+
+//The slots of frame were last used by the submission that WaitForFrameResources already waited for
+void CBindlessTextures::Update(uint32_t frame, uint64_t frameNumber){
+    if(mode == MODE_DISABLED || m_updatedFrameNumbers[frame] == frameNumber) return;
+    m_updatedFrameNumbers[frame] = frameNumber;
+    std::vector<uint32_t> changed;
+    for(uint32_t i = 0; i < m_slots.size(); i++)
+        if(m_slots[i].textureId >= 0 && m_boundVersions[frame][i] != m_pTextureManager->textureImages[m_slots[i].textureId].m_version) changed.push_back(i);
+    if(!changed.empty()) WriteSlots(frame, changed);
+}
@@ -0,0 +1,314 @@
+#include "../include/compressedTexture.h"
+
+template<typename T> static T ReadValue(const std::vector<uint8_t> &file, size_t offset){
+    if(offset + sizeof(T) > file.size()) throw std::runtime_error("failed to read compressed texture: file is truncated!");
+    T value;
+    memcpy(&value, file.data() + offset, sizeof(T));
+    return value;
+}
+
+static uint32_t MakeFourCC(const char *s){
+    return (uint32_t)s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) | ((uint32_t)s[3] << 24);
+}
+
+bool CCompressedTexture::IsCompressedFile(const std::string &texturePath){
+    std::string extension = texturePath.substr(texturePath.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "ktx2" || extension == "dds";
+}
+
+void CCompressedTexture::ReadFile(const std::string &texturePath, std::vector<uint8_t> &file){
+#ifndef ANDROID
+    std::string fullTexturePath = TEXTURE_PATH + texturePath;
+    std::ifstream stream(fullTexturePath, std::ios::ate | std::ios::binary);
+    if(!stream.is_open()) stream.open("textures/" + texturePath, std::ios::ate | std::ios::binary); //look for texture in 2 locations
+    if(!stream.is_open()) throw std::runtime_error("failed to open compressed texture file!");
+    size_t fileSize = (size_t)stream.tellg();
+    file.resize(fileSize);
+    stream.seekg(0);
+    stream.read((char*)file.data(), fileSize);
+#else
+    std::string fullTexturePath = ANDROID_TEXTURE_PATH + texturePath;
+    CContext::GetHandle().androidFileManager.AssetReadFile(fullTexturePath.c_str(), file);
+#endif
+}
+
+void CCompressedTexture::Load(const std::string &texturePath, bool bSrgb){
+    std::vector<uint8_t> file;
+    ReadFile(texturePath, file);
+
+    std::string extension = texturePath.substr(texturePath.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if(extension == "ktx2") LoadKTX2(file);
+    else LoadDDS(file, bSrgb);
+
+    PRINT("CompressedTexture: format %d", (int)format);
+    PRINT("CompressedTexture: size %d x %d", (int)width, (int)height);
+    PRINT("CompressedTexture: mip levels %d", (int)mipLevels);
+    PRINT("CompressedTexture: faces %d", (int)faceCount);
+}
+
+/*******************
+*	KTX2
+********************/
+void CCompressedTexture::LoadKTX2(const std::vector<uint8_t> &file){
+    static const uint8_t identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    if(file.size() < 80 || memcmp(file.data(), identifier, 12) != 0) throw std::runtime_error("failed to load KTX2 texture: bad identifier!");
+
+    format = (VkFormat)ReadValue<uint32_t>(file, 12);
+    width = ReadValue<uint32_t>(file, 20);
+    height = std::max(ReadValue<uint32_t>(file, 24), 1u);
+    uint32_t depth = ReadValue<uint32_t>(file, 28);
+    uint32_t layerCount = ReadValue<uint32_t>(file, 32);
+    faceCount = ReadValue<uint32_t>(file, 36);
+    mipLevels = std::max(ReadValue<uint32_t>(file, 40), 1u); //0 means the loader should generate mips, treat as base level only
+    uint32_t supercompressionScheme = ReadValue<uint32_t>(file, 44);
+
+    if(format == VK_FORMAT_UNDEFINED || supercompressionScheme != 0) throw std::runtime_error("failed to load KTX2 texture: Basis/zstd supercompression is not supported, cook it with an uncompressed payload!");
+    if(depth > 1 || layerCount > 1 || (faceCount != 1 && faceCount != 6)) throw std::runtime_error("failed to load KTX2 texture: only 2D textures and cubemaps are supported!");
+
+    //level index starts after the 80 byte header + index, level 0 is the base level
+    levelOffsets.resize(mipLevels);
+    levelSizes.resize(mipLevels);
+    VkDeviceSize totalSize = 0;
+    for(uint32_t i = 0; i < mipLevels; i++){
+        levelSizes[i] = ReadValue<uint64_t>(file, 80 + i * 24 + 8);
+        levelOffsets[i] = totalSize;
+        totalSize += levelSizes[i];
+    }
+    data.resize(totalSize);
+    for(uint32_t i = 0; i < mipLevels; i++){
+        uint64_t byteOffset = ReadValue<uint64_t>(file, 80 + i * 24);
+        if(byteOffset + levelSizes[i] > file.size()) throw std::runtime_error("failed to load KTX2 texture: file is truncated!");
+        memcpy(data.data() + levelOffsets[i], file.data() + byteOffset, (size_t)levelSizes[i]);
+    }
+}
+
+/*******************
+*	DDS
+********************/
+void CCompressedTexture::LoadDDS(const std::vector<uint8_t> &file, bool bSrgb){
+    if(file.size() < 128 || ReadValue<uint32_t>(file, 0) != MakeFourCC("DDS ")) throw std::runtime_error("failed to load DDS texture: bad magic!");
+
+    height = ReadValue<uint32_t>(file, 12);
+    width = ReadValue<uint32_t>(file, 16);
+    mipLevels = std::max(ReadValue<uint32_t>(file, 28), 1u);
+    uint32_t pixelFormatFlags = ReadValue<uint32_t>(file, 80);
+    uint32_t fourCC = ReadValue<uint32_t>(file, 84);
+    size_t dataOffset = 128;
+
+    if((pixelFormatFlags & 0x4) && fourCC == MakeFourCC("DX10")){
+        uint32_t dxgiFormat = ReadValue<uint32_t>(file, 128);
+        uint32_t miscFlag = ReadValue<uint32_t>(file, 136);
+        uint32_t arraySize = ReadValue<uint32_t>(file, 140);
+        if((miscFlag & 0x4) || arraySize > 1) throw std::runtime_error("failed to load DDS texture: only 2D textures are supported!");
+        dataOffset = 148;
+        switch(dxgiFormat){
+            case 28: format = VK_FORMAT_R8G8B8A8_UNORM; break;
+            case 29: format = VK_FORMAT_R8G8B8A8_SRGB; break;
+            case 71: format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+            case 72: format = VK_FORMAT_BC1_RGBA_SRGB_BLOCK; break;
+            case 74: format = VK_FORMAT_BC2_UNORM_BLOCK; break;
+            case 75: format = VK_FORMAT_BC2_SRGB_BLOCK; break;
+            case 77: format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+            case 78: format = VK_FORMAT_BC3_SRGB_BLOCK; break;
+            case 80: format = VK_FORMAT_BC4_UNORM_BLOCK; break;
+            case 83: format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+            case 98: format = VK_FORMAT_BC7_UNORM_BLOCK; break;
+            case 99: format = VK_FORMAT_BC7_SRGB_BLOCK; break;
+            default: throw std::runtime_error("failed to load DDS texture: unsupported DXGI format!");
+        }
+    }else if(pixelFormatFlags & 0x4){ //legacy FourCC, color space is not stored
+        if(fourCC == MakeFourCC("DXT1")) format = bSrgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        else if(fourCC == MakeFourCC("DXT3")) format = bSrgb ? VK_FORMAT_BC2_SRGB_BLOCK : VK_FORMAT_BC2_UNORM_BLOCK;
+        else if(fourCC == MakeFourCC("DXT5")) format = bSrgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        else if(fourCC == MakeFourCC("ATI1") || fourCC == MakeFourCC("BC4U")) format = VK_FORMAT_BC4_UNORM_BLOCK;
+        else if(fourCC == MakeFourCC("ATI2") || fourCC == MakeFourCC("BC5U")) format = VK_FORMAT_BC5_UNORM_BLOCK;
+        else throw std::runtime_error("failed to load DDS texture: unsupported FourCC!");
+    }else if((pixelFormatFlags & 0x40) && ReadValue<uint32_t>(file, 88) == 32){ //uncompressed 32 bit
+        uint32_t redMask = ReadValue<uint32_t>(file, 92);
+        if(redMask == 0x000000ff) format = bSrgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        else if(redMask == 0x00ff0000) format = bSrgb ? VK_FORMAT_B8G8R8A8_SRGB : VK_FORMAT_B8G8R8A8_UNORM;
+        else throw std::runtime_error("failed to load DDS texture: unsupported channel masks!");
+    }else throw std::runtime_error("failed to load DDS texture: unsupported pixel format!");
+
+    //levels are stored back to back, largest first
+    levelOffsets.resize(mipLevels);
+    levelSizes.resize(mipLevels);
+    VkDeviceSize totalSize = 0;
+    uint32_t blockSize = GetBlockSize();
+    for(uint32_t i = 0; i < mipLevels; i++){
+        uint32_t levelWidth = std::max(width >> i, 1u), levelHeight = std::max(height >> i, 1u);
+        levelSizes[i] = blockSize ? (VkDeviceSize)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize : (VkDeviceSize)levelWidth * levelHeight * 4;
+        levelOffsets[i] = totalSize;
+        totalSize += levelSizes[i];
+    }
+    if(dataOffset + totalSize > file.size()) throw std::runtime_error("failed to load DDS texture: file is truncated!");
+    data.assign(file.begin() + dataOffset, file.begin() + dataOffset + (size_t)totalSize);
+}
+
+/*******************
+*	Format
+********************/
+uint32_t CCompressedTexture::GetBlockSize(){
+    switch(format){
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK: case VK_FORMAT_BC4_SNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK: case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK: case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0; //uncompressed, or an ASTC footprint other than 4x4 (sizes come from the KTX2 level index)
+    }
+}
+
+bool CCompressedTexture::IsBlockFormat(){
+    return GetBlockSize() != 0 || (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK);
+}
+
+bool CCompressedTexture::IsFormatSupported(){
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(CContext::GetHandle().GetPhysicalDevice(), format, &formatProperties);
+    return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+bool CCompressedTexture::CanDecode(){
+    switch(format){
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK: case VK_FORMAT_BC5_UNORM_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+VkDeviceSize CCompressedTexture::GetRGBA8Size(){
+    VkDeviceSize size = 0;
+    for(uint32_t i = 0; i < mipLevels; i++) size += (VkDeviceSize)std::max(width >> i, 1u) * std::max(height >> i, 1u) * 4 * faceCount;
+    return size;
+}
+
+/*******************
+*	CPU decode (fallback)
+********************/
+//BC1 color block, 4 rgba texels per row. bAlways4Color: BC2/BC3 color blocks ignore the 3-color mode
+static void DecodeColorBlock(const uint8_t *block, uint8_t out[16][4], bool bAlways4Color){
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+    uint8_t palette[4][4];
+    auto expand565 = [](uint16_t c, uint8_t *rgba){
+        rgba[0] = (uint8_t)(((c >> 11) & 31) * 255 / 31);
+        rgba[1] = (uint8_t)(((c >> 5) & 63) * 255 / 63);
+        rgba[2] = (uint8_t)((c & 31) * 255 / 31);
+        rgba[3] = 255;
+    };
+    expand565(c0, palette[0]);
+    expand565(c1, palette[1]);
+    for(int ch = 0; ch < 3; ch++){
+        if(c0 > c1 || bAlways4Color){
+            palette[2][ch] = (uint8_t)((2 * palette[0][ch] + palette[1][ch]) / 3);
+            palette[3][ch] = (uint8_t)((palette[0][ch] + 2 * palette[1][ch]) / 3);
+        }else{
+            palette[2][ch] = (uint8_t)((palette[0][ch] + palette[1][ch]) / 2);
+            palette[3][ch] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = (c0 > c1 || bAlways4Color) ? 255 : 0;
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+    for(int i = 0; i < 16; i++) memcpy(out[i], palette[(indices >> (2 * i)) & 3], 4);
+}
+
+//BC3 alpha / BC4 / BC5 channel block
+static void DecodeChannelBlock(const uint8_t *block, uint8_t out[16][4], int channel){
+    uint8_t a0 = block[0], a1 = block[1];
+    uint8_t palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+    if(a0 > a1){
+        for(int i = 1; i < 7; i++) palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1) / 7);
+    }else{
+        for(int i = 1; i < 5; i++) palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for(int i = 0; i < 6; i++) indices |= (uint64_t)block[2 + i] << (8 * i);
+    for(int i = 0; i < 16; i++) out[i][channel] = palette[(indices >> (3 * i)) & 7];
+}
+
+void CCompressedTexture::DecodeToRGBA8(){
+    if(!CanDecode()) throw std::runtime_error("failed to decode compressed texture: no CPU fallback for this format!");
+
+    bool bSrgb = (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK);
+    uint32_t blockSize = GetBlockSize();
+
+    std::vector<uint8_t> decoded(GetRGBA8Size());
+    std::vector<VkDeviceSize> decodedOffsets(mipLevels), decodedSizes(mipLevels);
+    VkDeviceSize offset = 0;
+    for(uint32_t level = 0; level < mipLevels; level++){
+        uint32_t levelWidth = std::max(width >> level, 1u), levelHeight = std::max(height >> level, 1u);
+        decodedOffsets[level] = offset;
+        decodedSizes[level] = (VkDeviceSize)levelWidth * levelHeight * 4 * faceCount;
+        for(uint32_t face = 0; face < faceCount; face++){
+            uint8_t *dst = decoded.data() + offset + (size_t)levelWidth * levelHeight * 4 * face;
+            const uint8_t *src = data.data() + levelOffsets[level] + levelSizes[level] / faceCount * face;
+
+            uint32_t blocksX = (levelWidth + 3) / 4, blocksY = (levelHeight + 3) / 4;
+            for(uint32_t by = 0; by < blocksY; by++){
+                for(uint32_t bx = 0; bx < blocksX; bx++){
+                    const uint8_t *block = src + (by * blocksX + bx) * blockSize;
+                    uint8_t texels[16][4];
+                    switch(format){
+                        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                            DecodeColorBlock(block, texels, false);
+                            if(format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK)
+                                for(int i = 0; i < 16; i++) texels[i][3] = 255;
+                        break;
+                        case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK:
+                            DecodeColorBlock(block + 8, texels, true);
+                            for(int i = 0; i < 16; i++) texels[i][3] = (uint8_t)(((block[i / 2] >> (4 * (i & 1))) & 15) * 17);
+                        break;
+                        case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+                            DecodeColorBlock(block + 8, texels, true);
+                            DecodeChannelBlock(block, texels, 3);
+                        break;
+                        case VK_FORMAT_BC4_UNORM_BLOCK:
+                            DecodeChannelBlock(block, texels, 0);
+                            for(int i = 0; i < 16; i++){ texels[i][1] = 0; texels[i][2] = 0; texels[i][3] = 255; } //same as sampling an R format
+                        break;
+                        case VK_FORMAT_BC5_UNORM_BLOCK:
+                            DecodeChannelBlock(block, texels, 0);
+                            DecodeChannelBlock(block + 8, texels, 1);
+                            for(int i = 0; i < 16; i++){ texels[i][2] = 0; texels[i][3] = 255; }
+                        break;
+                        default:
+                        break;
+                    }
+                    for(uint32_t y = 0; y < 4 && by * 4 + y < levelHeight; y++)
+                        for(uint32_t x = 0; x < 4 && bx * 4 + x < levelWidth; x++)
+                            memcpy(dst + ((by * 4 + y) * levelWidth + bx * 4 + x) * 4, texels[y * 4 + x], 4);
+                }
+            }
+        }
+        offset += decodedSizes[level];
+    }
+
+    data.swap(decoded);
+    levelOffsets = decodedOffsets;
+    levelSizes = decodedSizes;
+    format = bSrgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
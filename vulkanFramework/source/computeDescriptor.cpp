@@ -1,4 +1,5 @@
 #include "../include/computeDescriptor.h"
+#include "../include/metrics.h"
 
 //Declare static variables here:
 /************
@@ -56,6 +57,8 @@ void CComputeDescriptorManager::createDescriptorPool(){
 	VkResult result = vkCreateDescriptorPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &computeDescriptorPool);
 	if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor pool!");
 	//REPORT("vkCreateDescriptorPool");
+	CMetrics::GetGauge("descriptor_pools", "Live descriptor pools", "owner=\"compute\"").Set(1);
+	CMetrics::GetGauge("descriptor_set_capacity", "Descriptor sets the live pools can hold", "owner=\"compute\"").Set(poolInfo.maxSets);
 }
 
 /************
@@ -149,6 +152,7 @@ void CComputeDescriptorManager::createDescriptorSets(std::vector<CTextureImage>
     //std::cout<<"after vkAllocateDescriptorSets(). "<<std::endl;
     if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate descriptor sets!");
     //REPORT("vkAllocateDescriptorSets");
+    CMetrics::GetGauge("descriptor_sets", "Descriptor sets allocated from the live pools", "owner=\"compute\"").Set((int64_t)descriptorSets.size());
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {///!!!
         std::vector<VkWriteDescriptorSet> descriptorWrites;
@@ -177,7 +181,7 @@ void CComputeDescriptorManager::createDescriptorSets(std::vector<CTextureImage>
         //std::cout<<"m_storageBufferSize = "<<m_storageBufferSize<<std::endl;
         if(computeUniformTypes & COMPUTE_STORAGEBUFFER_DOUBLE){ //for storage buffer 1
             VkDescriptorBufferInfo storageBufferInfo_1{};
-            storageBufferInfo_1.buffer = storageBuffers[(i - 1) % MAX_FRAMES_IN_FLIGHT].buffer; //storage buffer of last frame in flight as compute shader input
+            storageBufferInfo_1.buffer = storageBuffers[(i + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT].buffer; //storage buffer of last frame in flight as compute shader input
             storageBufferInfo_1.offset = 0;
             storageBufferInfo_1.range = m_storageBufferSize;//sizeof(uint32_t) * 4;//sizeof(Particle) * PARTICLE_COUNT;
 
@@ -278,7 +282,7 @@ void CComputeDescriptorManager::addCustomUniformBuffer(VkDeviceSize customUnifor
 std::vector<CWxjBuffer> CComputeDescriptorManager::storageBuffers;
 std::vector<void*> CComputeDescriptorManager::storageBuffersMapped;
 VkDeviceSize CComputeDescriptorManager::m_storageBufferSize;
-void CComputeDescriptorManager::addStorageBuffer(VkDeviceSize storageBufferSize, VkBufferUsageFlags usage){
+void CComputeDescriptorManager::addStorageBuffer(VkDeviceSize storageBufferSize, VkBufferUsageFlags usage, std::vector<uint32_t> concurrentQueueFamilies){
     computeUniformTypes |= COMPUTE_STORAGEBUFFER_DOUBLE;
     //std::cout<<"addStorageBuffer::uniformBufferUsageFlags = " << uniformBufferUsageFlags<<std::endl;
 
@@ -291,7 +295,7 @@ void CComputeDescriptorManager::addStorageBuffer(VkDeviceSize storageBufferSize,
         //VkResult result = InitDataBufferHelper(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &shaderStorageBuffers_compute[i]);// Create a staging buffer used to upload data to the gpu
         //FillDataBufferHelper(shaderStorageBuffers_compute[i], (void *)(particles.data()));// Copy initial particle data to all storage buffers
         //shaderStorageBuffers_compute[i].init(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-        storageBuffers[i].init(storageBufferSize, usage);
+        storageBuffers[i].init(storageBufferSize, usage, concurrentQueueFamilies);
         vkMapMemory(CContext::GetHandle().GetLogicalDevice(), storageBuffers[i].deviceMemory, 0, storageBufferSize, 0, &storageBuffersMapped[i]);
     }
 }
@@ -335,5 +339,8 @@ void CComputeDescriptorManager::DestroyAndFree(){
     }
 
     vkDestroyDescriptorPool(CContext::GetHandle().GetLogicalDevice(), computeDescriptorPool, nullptr);
+    CMetrics::GetGauge("descriptor_pools", "Live descriptor pools", "owner=\"compute\"").Set(0);
+    CMetrics::GetGauge("descriptor_set_capacity", "Descriptor sets the live pools can hold", "owner=\"compute\"").Set(0);
+    CMetrics::GetGauge("descriptor_sets", "Descriptor sets allocated from the live pools", "owner=\"compute\"").Set(0);
     vkDestroyDescriptorSetLayout(CContext::GetHandle().GetLogicalDevice(), descriptorSetLayout, nullptr);
 }
\ No newline at end of file
@@ -24,8 +24,6 @@ VkQueue CContext::GetComputeQueue(){
 
 
 CContext::CContext(){
-#ifndef ANDROID
     logManager.setLogFile("context.log");
-#endif
 }
 CContext::~CContext(){}
@@ -0,0 +1,217 @@
+#include "../include/cpuProfiler.h"
+
+#include <iomanip>
+#include <thread>
+
+bool CCpuProfiler::bEnabled = false;
+std::string CCpuProfiler::tracePath;
+uint32_t CCpuProfiler::summaryInterval = 1000;
+uint64_t CCpuProfiler::frameCount = 0;
+uint64_t CCpuProfiler::droppedEvents = 0;
+std::mutex CCpuProfiler::s_threadsMutex;
+std::vector<std::unique_ptr<CCpuProfiler::ThreadBuffer>> CCpuProfiler::s_threads;
+std::map<std::string, CCpuProfiler::ZoneStats> CCpuProfiler::s_zones;
+std::map<std::string, CCpuProfiler::CounterStats> CCpuProfiler::s_counters;
+std::unordered_map<const char*, CCpuProfiler::ZoneStats*> CCpuProfiler::s_zoneLookup;
+std::unordered_map<const char*, CCpuProfiler::CounterStats*> CCpuProfiler::s_counterLookup;
+uint64_t CCpuProfiler::s_baseTicks = 0;
+std::chrono::steady_clock::time_point CCpuProfiler::s_baseTime;
+double CCpuProfiler::s_ticksPerMicrosecond = 1000.0;
+uint64_t CCpuProfiler::s_lastSummaryFrame = 0;
+std::ofstream CCpuProfiler::s_trace;
+bool CCpuProfiler::s_bFirstTraceEvent = true;
+
+void CCpuProfiler::Init(){
+    if(!bEnabled) return;
+    s_baseTicks = Now();
+    s_baseTime = std::chrono::steady_clock::now();
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2)); //first estimate of the TSC rate, refined every frame
+    Calibrate();
+#endif
+    SetThreadName("main");
+
+    if(!tracePath.empty()){
+        s_trace.open(tracePath);
+        if(s_trace.is_open()) s_trace<<"[\n";
+        else std::cout<<"CPU profiler: could not open "<<tracePath<<std::endl;
+    }
+    std::cout<<"CPU profiler: "<<std::fixed<<std::setprecision(1)<<s_ticksPerMicrosecond<<" ticks per microsecond"<<std::defaultfloat<<std::endl;
+}
+
+void CCpuProfiler::Destroy(){
+    if(!bEnabled) return;
+    Drain();
+    PrintSummary();
+    if(s_trace.is_open()){
+        s_trace<<"\n]\n";
+        s_trace.close();
+    }
+    bEnabled = false;
+}
+
+void CCpuProfiler::Calibrate(){
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    double elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_baseTime).count();
+    uint64_t ticks = Now() - s_baseTicks;
+    if(elapsedMicroseconds > 1000.0) s_ticksPerMicrosecond = (double)ticks / elapsedMicroseconds;
+#endif
+}
+
+double CCpuProfiler::ToMicroseconds(uint64_t ticks){
+    return (double)(int64_t)(ticks - s_baseTicks) / s_ticksPerMicrosecond;
+}
+
+/*******************
+*	Recording, any thread
+********************/
+CCpuProfiler::ThreadBuffer &CCpuProfiler::GetThreadBuffer(){
+    thread_local ThreadBuffer *t_buffer = nullptr;
+    if(!t_buffer){
+        //buffers outlive their threads, events of a finished thread are still drained
+        std::lock_guard<std::mutex> lock(s_threadsMutex);
+        s_threads.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = s_threads.back().get();
+        t_buffer->threadId = (uint32_t)s_threads.size();
+    }
+    return *t_buffer;
+}
+
+uint32_t &CCpuProfiler::Depth(){
+    return GetThreadBuffer().depth;
+}
+
+void CCpuProfiler::SetThreadName(const char *name){
+    if(!bEnabled) return;
+    GetThreadBuffer().name.store(name, std::memory_order_release);
+}
+
+void CCpuProfiler::Push(const char *name, uint64_t start, uint64_t end, EventType type, uint32_t depth){
+    ThreadBuffer &buffer = GetThreadBuffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Event &event = buffer.events[head & (RING_SIZE - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.type.store(type, std::memory_order_relaxed);
+    event.depth.store(depth, std::memory_order_relaxed);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void CCpuProfiler::Zone(const char *name, uint64_t start, uint64_t end, uint32_t depth){
+    Push(name, start, end, EVENT_ZONE, depth);
+}
+
+void CCpuProfiler::Counter(const char *name, uint64_t value){
+    Push(name, value, Now(), EVENT_COUNTER, 0);
+}
+
+/*******************
+*	Frame end, main thread
+********************/
+void CCpuProfiler::EndFrame(){
+    if(!bEnabled) return;
+    Calibrate();
+    Drain();
+
+    double nowMicroseconds = ToMicroseconds(Now());
+    for(auto &zone : s_zones){
+        zone.second.maxFrameMs = std::max(zone.second.maxFrameMs, zone.second.frameMs);
+        zone.second.frameMs = 0;
+    }
+    for(auto &counter : s_counters){
+        CounterStats &stats = counter.second;
+        if(s_trace.is_open()){ //one sample per frame, the per frame sum
+            s_trace<<(s_bFirstTraceEvent ? "" : ",\n")<<"{\"name\":\"";
+            WriteTraceName(counter.first.c_str());
+            s_trace<<"\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+                <<std::fixed<<std::setprecision(3)<<nowMicroseconds<<std::defaultfloat<<",\"args\":{\"value\":"<<stats.frameValue<<"}}";
+            s_bFirstTraceEvent = false;
+        }
+        stats.maxFrameValue = std::max(stats.maxFrameValue, stats.frameValue);
+        stats.frameValue = 0;
+    }
+    frameCount++;
+
+    if(summaryInterval > 0 && frameCount - s_lastSummaryFrame >= summaryInterval){
+        PrintSummary();
+        s_lastSummaryFrame = frameCount;
+    }
+}
+
+void CCpuProfiler::WriteTraceName(const char *name){
+    for(const char *c = name; *c; c++) if(*c != '"' && *c != '\\') s_trace<<*c;
+}
+
+void CCpuProfiler::Drain(){
+    std::lock_guard<std::mutex> lock(s_threadsMutex);
+    for(auto &pBuffer : s_threads){
+        ThreadBuffer &buffer = *pBuffer;
+        const char *name = buffer.name.load(std::memory_order_acquire);
+        if(s_trace.is_open() && name && name != buffer.writtenName){
+            s_trace<<(s_bFirstTraceEvent ? "" : ",\n")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"<<buffer.threadId<<",\"args\":{\"name\":\"";
+            WriteTraceName(name);
+            s_trace<<"\"}}";
+            s_bFirstTraceEvent = false;
+            buffer.writtenName = name;
+        }
+
+        uint64_t head = buffer.head.load(std::memory_order_acquire);
+        if(head - buffer.tail > RING_SIZE){ //the thread went around the ring since the last frame
+            droppedEvents += head - RING_SIZE - buffer.tail;
+            buffer.tail = head - RING_SIZE;
+        }
+        for(uint64_t i = buffer.tail; i < head; i++){
+            const Event &slot = buffer.events[i & (RING_SIZE - 1)];
+            const char *eventName = slot.name.load(std::memory_order_relaxed);
+            uint64_t start = slot.start.load(std::memory_order_relaxed);
+            uint64_t end = slot.end.load(std::memory_order_relaxed);
+            EventType type = slot.type.load(std::memory_order_relaxed);
+            //the writer may have reached this slot again while it was copied, the mixed copy is dropped
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(buffer.head.load(std::memory_order_relaxed) - i >= RING_SIZE){
+                droppedEvents++;
+                continue;
+            }
+
+            if(type == EVENT_COUNTER){
+                CounterStats *&stats = s_counterLookup[eventName];
+                if(!stats) stats = &s_counters[eventName];
+                stats->total += start;
+                stats->frameValue += start;
+                continue;
+            }
+            ZoneStats *&stats = s_zoneLookup[eventName];
+            if(!stats) stats = &s_zones[eventName];
+            double startMicroseconds = ToMicroseconds(start);
+            double durationMicroseconds = (double)(end - start) / s_ticksPerMicrosecond;
+            stats->totalMs += durationMicroseconds / 1000.0;
+            stats->frameMs += durationMicroseconds / 1000.0;
+            stats->calls++;
+            if(s_trace.is_open()){
+                s_trace<<(s_bFirstTraceEvent ? "" : ",\n")<<"{\"name\":\"";
+                WriteTraceName(eventName);
+                s_trace<<"\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":"<<buffer.threadId<<std::fixed<<std::setprecision(3)
+                    <<",\"ts\":"<<startMicroseconds<<",\"dur\":"<<durationMicroseconds<<std::defaultfloat<<"}";
+                s_bFirstTraceEvent = false;
+            }
+        }
+        buffer.tail = head;
+    }
+}
+
+void CCpuProfiler::PrintSummary(){
+    if(frameCount == 0) return;
+    std::vector<std::pair<std::string, ZoneStats>> zones(s_zones.begin(), s_zones.end());
+    std::sort(zones.begin(), zones.end(), [](const auto &a, const auto &b){ return a.second.totalMs > b.second.totalMs; });
+
+    std::cout<<"CPU profiler: "<<frameCount<<" frames"<<(droppedEvents ? ", " + std::to_string(droppedEvents) + " events dropped" : "")<<std::endl;
+    std::cout<<std::fixed<<std::setprecision(3);
+    for(auto &zone : zones) //inclusive: a zone contains the zones opened inside it
+        std::cout<<"  "<<std::left<<std::setw(28)<<zone.first<<std::right<<std::setw(10)<<zone.second.totalMs / frameCount<<" ms/frame, max "
+            <<std::setw(8)<<zone.second.maxFrameMs<<" ms, "<<std::setprecision(1)<<(double)zone.second.calls / frameCount<<" calls/frame"<<std::setprecision(3)<<std::endl;
+    for(auto &counter : s_counters)
+        std::cout<<"  "<<std::left<<std::setw(28)<<counter.first<<std::right<<std::setw(10)<<std::setprecision(1)<<(double)counter.second.total / frameCount
+            <<" /frame, max "<<counter.second.maxFrameValue<<std::setprecision(3)<<std::endl;
+    std::cout<<std::defaultfloat;
+}
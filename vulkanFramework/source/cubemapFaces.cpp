@@ -0,0 +1,177 @@
+#include "../include/cubemapFaces.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <functional>
+
+namespace{
+
+const float PI = 3.14159265358979f;
+
+//rows [0, count) split into bands, one per thread; small jobs stay on the calling thread
+void ParallelRows(int count, unsigned threads, size_t bytesPerRow, const std::function<void(int, int)> &fn){
+    if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned n = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, (size_t)count * bytesPerRow / 262144));
+    n = std::min<unsigned>(n, (unsigned)count);
+    if(n <= 1){
+        fn(0, count);
+        return;
+    }
+    int band = (count + n - 1) / n;
+    std::vector<std::thread> workers;
+    for(unsigned t = 1; t < n; t++){
+        int begin = t * band, end = std::min(count, begin + band);
+        if(begin < end) workers.emplace_back(fn, begin, end);
+    }
+    fn(0, std::min(count, band));
+    for(auto &worker : workers) worker.join();
+}
+
+//texel (u, v) in [-1, 1] of a face -> direction, Vulkan cube face orientation (layer order +X -X +Y -Y +Z -Z)
+void FaceDirection(int face, float u, float v, float dir[3]){
+    switch(face){
+        case CCubemapFaces::FACE_RIGHT:  dir[0] =  1; dir[1] = -v; dir[2] = -u; break;
+        case CCubemapFaces::FACE_LEFT:   dir[0] = -1; dir[1] = -v; dir[2] =  u; break;
+        case CCubemapFaces::FACE_UP:     dir[0] =  u; dir[1] =  1; dir[2] =  v; break;
+        case CCubemapFaces::FACE_BOTTOM: dir[0] =  u; dir[1] = -1; dir[2] = -v; break;
+        case CCubemapFaces::FACE_FRONT:  dir[0] =  u; dir[1] = -v; dir[2] =  1; break;
+        default:                         dir[0] = -u; dir[1] = -v; dir[2] = -1; break;
+    }
+}
+
+}
+
+const char* CCubemapFaces::GetFaceName(int face){
+    static const char *names[FACE_COUNT] = {"right", "left", "up", "bottom", "front", "back"};
+    return (face >= 0 && face < FACE_COUNT) ? names[face] : "";
+}
+
+bool CCubemapFaces::IsFaceFileName(const std::string &texturePath){
+    return texturePath.find("{face}") != std::string::npos;
+}
+
+std::string CCubemapFaces::GetFaceFileName(const std::string &texturePath, int face){
+    std::string name = texturePath;
+    size_t pos = name.find("{face}");
+    if(pos != std::string::npos) name.replace(pos, 6, GetFaceName(face));
+    return name;
+}
+
+/*******************
+*	Cross
+********************/
+void CCubemapFaces::ExtractFromCross(const void *cross, uint32_t crossWidth, uint32_t crossHeight, uint32_t bytesPerTexel,
+        std::vector<uint8_t> &faces, unsigned threads){
+    //column, row of each face in the 4x3 cross, in layer order
+    static const int cell[FACE_COUNT][2] = {{2, 1}, {0, 1}, {1, 0}, {1, 2}, {1, 1}, {3, 1}};
+    uint32_t faceWidth = crossWidth / 4, faceHeight = crossHeight / 3;
+    size_t crossRowBytes = (size_t)crossWidth * bytesPerTexel;
+    size_t faceRowBytes = (size_t)faceWidth * bytesPerTexel;
+    size_t faceBytes = faceRowBytes * faceHeight;
+    faces.resize(faceBytes * FACE_COUNT);
+
+    //all face rows of all faces form one job list, so a thread never waits on a single face
+    const uint8_t *src = static_cast<const uint8_t*>(cross);
+    ParallelRows(FACE_COUNT * (int)faceHeight, threads, faceRowBytes, [&](int begin, int end){
+        for(int row = begin; row < end; row++){
+            int face = row / (int)faceHeight, y = row % (int)faceHeight;
+            const uint8_t *srcRow = src + ((size_t)cell[face][1] * faceHeight + y) * crossRowBytes + (size_t)cell[face][0] * faceRowBytes;
+            memcpy(faces.data() + face * faceBytes + y * faceRowBytes, srcRow, faceRowBytes);
+        }
+    });
+}
+
+/*******************
+*	Equirectangular
+********************/
+void CCubemapFaces::FromEquirect(const float *rgba, uint32_t width, uint32_t height, uint32_t faceSize,
+        std::vector<uint8_t> &faces, unsigned threads){
+    size_t faceRowBytes = (size_t)faceSize * 4 * sizeof(uint16_t);
+    size_t faceBytes = faceRowBytes * faceSize;
+    faces.resize(faceBytes * FACE_COUNT);
+
+    auto fetch = [&](int x, int y, float *out){
+        x = ((x % (int)width) + (int)width) % (int)width; //longitude wraps
+        y = std::min(std::max(y, 0), (int)height - 1);
+        memcpy(out, rgba + ((size_t)y * width + x) * 4, 4 * sizeof(float));
+    };
+
+    ParallelRows(FACE_COUNT * (int)faceSize, threads, faceRowBytes * 4, [&](int begin, int end){
+        for(int row = begin; row < end; row++){
+            int face = row / (int)faceSize, y = row % (int)faceSize;
+            uint16_t *dst = reinterpret_cast<uint16_t*>(faces.data() + face * faceBytes + y * faceRowBytes);
+            float v = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+            for(uint32_t x = 0; x < faceSize; x++){
+                float u = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+                float dir[3];
+                FaceDirection(face, u, v, dir);
+                float length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+
+                //bilinear lookup at (longitude, latitude)
+                float s = (0.5f + std::atan2(dir[2], dir[0]) / (2.0f * PI)) * width - 0.5f;
+                float t = (std::acos(std::min(std::max(dir[1] / length, -1.0f), 1.0f)) / PI) * height - 0.5f;
+                int x0 = (int)std::floor(s), y0 = (int)std::floor(t);
+                float fx = s - x0, fy = t - y0;
+                float c00[4], c10[4], c01[4], c11[4];
+                fetch(x0, y0, c00);
+                fetch(x0 + 1, y0, c10);
+                fetch(x0, y0 + 1, c01);
+                fetch(x0 + 1, y0 + 1, c11);
+                for(int c = 0; c < 4; c++){
+                    float top = c00[c] + (c10[c] - c00[c]) * fx;
+                    float bottom = c01[c] + (c11[c] - c01[c]) * fx;
+                    dst[x * 4 + c] = FloatToHalf(top + (bottom - top) * fy);
+                }
+            }
+        }
+    });
+}
+
+/*******************
+*	Half float
+********************/
+uint16_t CCubemapFaces::FloatToHalf(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if(((bits >> 23) & 0xff) == 0xff) return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0)); //inf / nan
+    if(exponent >= 31) return (uint16_t)(sign | 0x7c00); //too large for half: inf
+    if(exponent <= 0){ //denormal or zero
+        if(exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(rest > halfway || (rest == halfway && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++; //round to nearest even, may carry into the exponent
+    return (uint16_t)half;
+}
+
+float CCubemapFaces::HalfToFloat(uint16_t value){
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if(exponent == 0){
+        if(mantissa == 0) bits = sign;
+        else{ //denormal: normalize
+            exponent = 127 - 15 + 1;
+            while(!(mantissa & 0x400)){ mantissa <<= 1; exponent--; }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }else if(exponent == 31) bits = sign | 0x7f800000 | (mantissa << 13);
+    else bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float result;
+    memcpy(&result, &bits, 4);
+    return result;
+}
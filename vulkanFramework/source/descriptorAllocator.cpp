@@ -0,0 +1,233 @@
+#include "../include/descriptorAllocator.h"
+#include "../include/metrics.h"
+
+//all allocators together; CComputeDescriptorManager reports its pool with owner="compute"
+static CMetrics::Gauge &PoolsGauge(){ static CMetrics::Gauge &gauge = CMetrics::GetGauge("descriptor_pools", "Live descriptor pools", "owner=\"allocator\""); return gauge; }
+static CMetrics::Gauge &CapacityGauge(){ static CMetrics::Gauge &gauge = CMetrics::GetGauge("descriptor_set_capacity", "Descriptor sets the live pools can hold", "owner=\"allocator\""); return gauge; }
+static CMetrics::Gauge &SetsGauge(){ static CMetrics::Gauge &gauge = CMetrics::GetGauge("descriptor_sets", "Descriptor sets allocated from the live pools", "owner=\"allocator\""); return gauge; }
+
+/******************
+* Allocator
+*******************/
+CDescriptorAllocator::CDescriptorAllocator(){}
+CDescriptorAllocator::~CDescriptorAllocator(){}
+
+void CDescriptorAllocator::RegisterLayout(VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding> &bindings, uint32_t expectedSets){
+    LayoutPools &layoutPools = m_layouts[layout];
+    layoutPools.sizesPerSet.clear();
+    for(auto &binding : bindings){
+        auto it = std::find_if(layoutPools.sizesPerSet.begin(), layoutPools.sizesPerSet.end(),
+            [&](const VkDescriptorPoolSize &size){ return size.type == binding.descriptorType; });
+        if(it != layoutPools.sizesPerSet.end()) it->descriptorCount += binding.descriptorCount;
+        else layoutPools.sizesPerSet.push_back({binding.descriptorType, binding.descriptorCount});
+    }
+    //a pool needs at least one size, even for a layout without bindings
+    if(layoutPools.sizesPerSet.empty()) layoutPools.sizesPerSet.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
+    if(expectedSets > 0) layoutPools.nextCapacity = std::min(std::max(expectedSets, 1u), MAX_SETS_PER_POOL);
+}
+
+void CDescriptorAllocator::CreatePool(LayoutPools &layoutPools){
+    Pool pool;
+    pool.capacity = layoutPools.nextCapacity;
+
+    std::vector<VkDescriptorPoolSize> poolSizes = layoutPools.sizesPerSet;
+    for(auto &size : poolSizes) size.descriptorCount *= pool.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = pool.capacity;
+
+    VkResult result = vkCreateDescriptorPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &pool.pool);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor pool!");
+
+    layoutPools.pools.push_back(pool);
+    PoolsGauge().Add(1);
+    CapacityGauge().Add(pool.capacity);
+    layoutPools.nextCapacity = std::min(layoutPools.nextCapacity * 2, MAX_SETS_PER_POOL);
+}
+
+VkDescriptorSet CDescriptorAllocator::Allocate(VkDescriptorSetLayout layout){
+    auto it = m_layouts.find(layout);
+    if(it == m_layouts.end()) throw std::runtime_error("failed to allocate descriptor set: layout is not registered!");
+    LayoutPools &layoutPools = it->second;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    for(int attempt = 0; attempt < 2; attempt++){
+        if(layoutPools.pools.empty() || layoutPools.pools.back().allocated >= layoutPools.pools.back().capacity) CreatePool(layoutPools);
+        Pool &pool = layoutPools.pools.back();
+        allocInfo.descriptorPool = pool.pool;
+        VkResult result = vkAllocateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), &allocInfo, &set);
+        if(result == VK_SUCCESS){
+            pool.allocated++;
+            SetsGauge().Add(1);
+            return set;
+        }
+        if(result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) break;
+        pool.allocated = pool.capacity; //driver says full: continue in a new pool
+    }
+    throw std::runtime_error("failed to allocate descriptor sets!");
+}
+
+CDescriptorAllocator::Stats CDescriptorAllocator::GetStats(){
+    Stats stats;
+    stats.layoutCount = static_cast<uint32_t>(m_layouts.size());
+    for(auto &layout : m_layouts){
+        for(auto &pool : layout.second.pools){
+            stats.poolCount++;
+            stats.setsAllocated += pool.allocated;
+            stats.setCapacity += pool.capacity;
+        }
+    }
+    return stats;
+}
+
+void CDescriptorAllocator::Destroy(){
+    Stats stats = GetStats();
+    PoolsGauge().Add(-(int64_t)stats.poolCount);
+    CapacityGauge().Add(-(int64_t)stats.setCapacity);
+    SetsGauge().Add(-(int64_t)stats.setsAllocated);
+    for(auto &layout : m_layouts)
+        for(auto &pool : layout.second.pools)
+            vkDestroyDescriptorPool(CContext::GetHandle().GetLogicalDevice(), pool.pool, nullptr);
+    m_layouts.clear();
+}
+
+/******************
+* Cache
+*******************/
+bool CDescriptorCache::Binding::operator==(const Binding &other) const{
+    return binding == other.binding && type == other.type
+        && imageView == other.imageView && sampler == other.sampler && imageLayout == other.imageLayout
+        && buffer == other.buffer && offset == other.offset && range == other.range;
+}
+
+CDescriptorCache::CDescriptorCache(){}
+CDescriptorCache::~CDescriptorCache(){}
+
+void CDescriptorCache::Init(CDescriptorAllocator *pAllocator){
+    m_pAllocator = pAllocator;
+}
+
+template <typename T>
+static void HashBits(uint64_t &hash, const T &value){ //handles are pointers or uint64_t depending on the platform
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(&value);
+    for(size_t i = 0; i < sizeof(T); i++){
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+uint64_t CDescriptorCache::Hash(VkDescriptorSetLayout layout, const std::vector<Binding> &bindings){
+    uint64_t hash = 14695981039346656037ULL;
+    HashBits(hash, layout);
+    for(auto &binding : bindings){ //field by field, Binding has padding
+        HashBits(hash, binding.binding);
+        HashBits(hash, binding.type);
+        HashBits(hash, binding.imageView);
+        HashBits(hash, binding.sampler);
+        HashBits(hash, binding.imageLayout);
+        HashBits(hash, binding.buffer);
+        HashBits(hash, binding.offset);
+        HashBits(hash, binding.range);
+    }
+    return hash;
+}
+
+VkDescriptorSet CDescriptorCache::GetOrCreate(VkDescriptorSetLayout layout, const std::vector<Binding> &bindings){
+    uint64_t hash = Hash(layout, bindings);
+    std::vector<Entry> &bucket = m_entries[hash];
+    for(auto &entry : bucket){
+        if(entry.layout == layout && entry.bindings == bindings){
+            cacheHitCount++;
+            return entry.set;
+        }
+    }
+    cacheMissCount++;
+
+    Entry entry;
+    entry.layout = layout;
+    entry.bindings = bindings;
+    std::vector<VkDescriptorSet> &freeSets = m_freeSets[layout];
+    if(!freeSets.empty()){
+        entry.set = freeSets.back();
+        freeSets.pop_back();
+        recycledCount++;
+    }else entry.set = m_pAllocator->Allocate(layout);
+    Write(entry.set, bindings);
+    bucket.push_back(entry);
+    return entry.set;
+}
+
+void CDescriptorCache::BuildWrites(VkDescriptorSet set, const std::vector<Binding> &bindings, std::vector<VkWriteDescriptorSet> &descriptorWrites,
+    std::vector<VkDescriptorImageInfo> &imageInfos, std::vector<VkDescriptorBufferInfo> &bufferInfos){
+    descriptorWrites.assign(bindings.size(), VkWriteDescriptorSet{});
+    imageInfos.assign(bindings.size(), VkDescriptorImageInfo{});
+    bufferInfos.assign(bindings.size(), VkDescriptorBufferInfo{});
+    for(size_t i = 0; i < bindings.size(); i++){
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = set;
+        descriptorWrites[i].dstBinding = bindings[i].binding;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorType = bindings[i].type;
+        descriptorWrites[i].descriptorCount = 1;
+        switch(bindings[i].type){
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                bufferInfos[i].buffer = bindings[i].buffer;
+                bufferInfos[i].offset = bindings[i].offset;
+                bufferInfos[i].range = bindings[i].range;
+                descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+                break;
+            default:
+                imageInfos[i].imageView = bindings[i].imageView;
+                imageInfos[i].sampler = bindings[i].sampler;
+                imageInfos[i].imageLayout = bindings[i].imageLayout;
+                descriptorWrites[i].pImageInfo = &imageInfos[i];
+                break;
+        }
+    }
+}
+
+void CDescriptorCache::Write(VkDescriptorSet set, const std::vector<Binding> &bindings){
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    BuildWrites(set, bindings, descriptorWrites, imageInfos, bufferInfos);
+    vkUpdateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
+
+void CDescriptorCache::EvictImageView(VkImageView imageView){
+    for(auto it = m_entries.begin(); it != m_entries.end();){
+        std::vector<Entry> &bucket = it->second;
+        for(int i = (int)bucket.size() - 1; i >= 0; i--){
+            bool bUsesView = false;
+            for(auto &binding : bucket[i].bindings) if(binding.imageView == imageView) bUsesView = true;
+            if(bUsesView){
+                m_freeSets[bucket[i].layout].push_back(bucket[i].set);
+                bucket.erase(bucket.begin() + i);
+            }
+        }
+        if(bucket.empty()) it = m_entries.erase(it);
+        else ++it;
+    }
+}
+
+uint32_t CDescriptorCache::GetEntryCount(){
+    uint32_t count = 0;
+    for(auto &bucket : m_entries) count += static_cast<uint32_t>(bucket.second.size());
+    return count;
+}
+
+void CDescriptorCache::Clear(){ //the sets belong to the allocator's pools
+    m_entries.clear();
+    m_freeSets.clear();
+}
@@ -0,0 +1,221 @@
+#include "../include/descriptorBackend.h"
+
+CDescriptorBackend::CDescriptorBackend(){}
+CDescriptorBackend::~CDescriptorBackend(){}
+
+CDescriptorBackend::Mode CDescriptorBackend::ParseMode(const std::string &name, bool bPushDescriptor, bool bDescriptorBuffer){
+    if(name == "auto"){
+        if(bDescriptorBuffer) return MODE_DESCRIPTOR_BUFFER;
+        if(bPushDescriptor) return MODE_PUSH_DESCRIPTOR;
+        return MODE_DESCRIPTOR_SETS;
+    }
+    if(name == "buffer" && bDescriptorBuffer) return MODE_DESCRIPTOR_BUFFER;
+    if(name == "push" && bPushDescriptor) return MODE_PUSH_DESCRIPTOR;
+    if(name != "sets") PRINT("DescriptorBackend: %s is not supported, using descriptor sets", name);
+    return MODE_DESCRIPTOR_SETS;
+}
+
+const char *CDescriptorBackend::GetModeName(Mode mode){
+    switch(mode){
+        case MODE_PUSH_DESCRIPTOR: return "push descriptor";
+        case MODE_DESCRIPTOR_BUFFER: return "descriptor buffer";
+        default: return "descriptor sets";
+    }
+}
+
+void CDescriptorBackend::Init(Mode requestedMode){
+    mode = requestedMode;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    if(mode == MODE_PUSH_DESCRIPTOR){
+        m_vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+        if(!m_vkCmdPushDescriptorSetKHR) mode = MODE_DESCRIPTOR_SETS;
+    }
+#ifdef VK_EXT_descriptor_buffer
+    if(mode == MODE_DESCRIPTOR_BUFFER){
+        m_vkGetDescriptorSetLayoutSizeEXT = (PFN_vkGetDescriptorSetLayoutSizeEXT)vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutSizeEXT");
+        m_vkGetDescriptorSetLayoutBindingOffsetEXT = (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+        m_vkGetDescriptorEXT = (PFN_vkGetDescriptorEXT)vkGetDeviceProcAddr(device, "vkGetDescriptorEXT");
+        m_vkCmdBindDescriptorBuffersEXT = (PFN_vkCmdBindDescriptorBuffersEXT)vkGetDeviceProcAddr(device, "vkCmdBindDescriptorBuffersEXT");
+        m_vkCmdSetDescriptorBufferOffsetsEXT = (PFN_vkCmdSetDescriptorBufferOffsetsEXT)vkGetDeviceProcAddr(device, "vkCmdSetDescriptorBufferOffsetsEXT");
+        m_vkGetBufferDeviceAddressKHR = (PFN_vkGetBufferDeviceAddressKHR)vkGetDeviceProcAddr(device, "vkGetBufferDeviceAddressKHR");
+        if(!m_vkGetDescriptorSetLayoutSizeEXT || !m_vkGetDescriptorSetLayoutBindingOffsetEXT || !m_vkGetDescriptorEXT
+            || !m_vkCmdBindDescriptorBuffersEXT || !m_vkCmdSetDescriptorBufferOffsetsEXT || !m_vkGetBufferDeviceAddressKHR) mode = MODE_DESCRIPTOR_SETS;
+    }
+#else
+    if(mode == MODE_DESCRIPTOR_BUFFER) mode = MODE_DESCRIPTOR_SETS; //headers without VK_EXT_descriptor_buffer
+#endif
+    PRINT("DescriptorBackend: %s", std::string(GetModeName(mode)));
+}
+
+void CDescriptorBackend::Destroy(){
+    for(size_t i = 0; i < m_buffers.size(); i++){
+        vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), m_buffers[i].deviceMemory);
+        m_buffers[i].DestroyAndFree();
+    }
+    m_buffers.clear();
+    m_buffersMapped.clear();
+    m_bufferAddresses.clear();
+    m_deviceAddresses.clear();
+    m_regionCount = 0;
+}
+
+/******************
+* Creation parameters
+*******************/
+VkDescriptorSetLayoutCreateFlags CDescriptorBackend::GetSetLayoutFlags(bool bTextureImageSamplerSet){
+    if(mode == MODE_PUSH_DESCRIPTOR && bTextureImageSamplerSet) return VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+#ifdef VK_EXT_descriptor_buffer
+    if(mode == MODE_DESCRIPTOR_BUFFER) return VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+#endif
+    return 0;
+}
+
+VkPipelineCreateFlags CDescriptorBackend::GetPipelineCreateFlags(){
+#ifdef VK_EXT_descriptor_buffer
+    if(mode == MODE_DESCRIPTOR_BUFFER) return VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+#endif
+    return 0;
+}
+
+VkBufferUsageFlags CDescriptorBackend::GetUniformBufferUsage(){
+#ifdef VK_EXT_descriptor_buffer
+    if(mode == MODE_DESCRIPTOR_BUFFER) return VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+#endif
+    return 0;
+}
+
+VkMemoryAllocateFlags CDescriptorBackend::GetUniformMemoryFlags(){
+#ifdef VK_EXT_descriptor_buffer
+    if(mode == MODE_DESCRIPTOR_BUFFER) return VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+#endif
+    return 0;
+}
+
+/******************
+* Push descriptors
+*******************/
+void CDescriptorBackend::PushDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, const std::vector<CDescriptorCache::Binding> &bindings){
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    CDescriptorCache::BuildWrites(VK_NULL_HANDLE, bindings, descriptorWrites, imageInfos, bufferInfos); //dstSet is ignored
+    m_vkCmdPushDescriptorSetKHR(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data());
+}
+
+/******************
+* Descriptor buffers
+*******************/
+void CDescriptorBackend::CreateDescriptorBuffers(const std::vector<VkDescriptorSetLayout> &layouts, uint32_t regionCapacity){
+#ifdef VK_EXT_descriptor_buffer
+    if(mode != MODE_DESCRIPTOR_BUFFER) return;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    VkDeviceSize alignment = std::max((*CContext::GetHandle().physicalDevice)->descriptorBufferOffsetAlignment, (VkDeviceSize)1);
+
+    m_regionSize = 0;
+    for(auto layout : layouts){
+        VkDeviceSize layoutSize = 0;
+        m_vkGetDescriptorSetLayoutSizeEXT(device, layout, &layoutSize);
+        m_regionSize = std::max(m_regionSize, layoutSize);
+    }
+    m_regionSize = (std::max(m_regionSize, (VkDeviceSize)1) + alignment - 1) / alignment * alignment;
+    m_regionCapacity = std::max(regionCapacity, 1u);
+    m_regionCount = 0;
+
+    VkDeviceSize bufferSize = m_regionSize * m_regionCapacity;
+    m_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+    m_buffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+    m_bufferAddresses.resize(MAX_FRAMES_IN_FLIGHT);
+    for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
+        //combined image samplers need the sampler usage, uniform buffers the resource usage
+        VkResult result = m_buffers[i].init(bufferSize,
+            VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            {}, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+        if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor buffer!");
+        void *pMapped = nullptr;
+        vkMapMemory(device, m_buffers[i].deviceMemory, 0, VK_WHOLE_SIZE, 0, &pMapped);
+        m_buffersMapped[i] = static_cast<uint8_t*>(pMapped);
+        memset(m_buffersMapped[i], 0, (size_t)bufferSize);
+        m_bufferAddresses[i] = GetBufferAddress(m_buffers[i].buffer);
+    }
+    PRINT("DescriptorBackend: %d regions of %d bytes per frame", (int)m_regionCapacity, (int)m_regionSize);
+#endif
+}
+
+uint32_t CDescriptorBackend::AllocateRegion(){
+    if(m_regionCount >= m_regionCapacity) throw std::runtime_error("failed to allocate descriptor buffer region!");
+    return m_regionCount++;
+}
+
+uint64_t CDescriptorBackend::GetBufferAddress(VkBuffer buffer){
+#ifdef VK_EXT_descriptor_buffer
+    auto it = m_deviceAddresses.find(buffer);
+    if(it != m_deviceAddresses.end()) return it->second;
+    VkBufferDeviceAddressInfo addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = buffer;
+    VkDeviceAddress address = m_vkGetBufferDeviceAddressKHR(CContext::GetHandle().GetLogicalDevice(), &addressInfo);
+    m_deviceAddresses[buffer] = address;
+    return address;
+#else
+    return 0;
+#endif
+}
+
+//the frame's buffer is not read by the GPU after WaitForFrameResources, so the region can be rewritten in place
+void CDescriptorBackend::WriteRegion(uint32_t frame, uint32_t region, VkDescriptorSetLayout layout, const std::vector<CDescriptorCache::Binding> &bindings){
+#ifdef VK_EXT_descriptor_buffer
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    CPhysicalDevice *pPhysicalDevice = CContext::GetHandle().physicalDevice->get();
+    uint8_t *pRegion = m_buffersMapped[frame] + region * m_regionSize;
+    for(auto &binding : bindings){
+        VkDeviceSize bindingOffset = 0;
+        m_vkGetDescriptorSetLayoutBindingOffsetEXT(device, layout, binding.binding, &bindingOffset);
+
+        VkDescriptorGetInfoEXT getInfo{};
+        getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+        getInfo.type = binding.type;
+        VkDescriptorImageInfo imageInfo{};
+        VkDescriptorAddressInfoEXT addressInfo{};
+        size_t descriptorSize = 0;
+        if(binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER){
+            addressInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+            addressInfo.address = GetBufferAddress(binding.buffer) + binding.offset;
+            addressInfo.range = binding.range;
+            addressInfo.format = VK_FORMAT_UNDEFINED;
+            getInfo.data.pUniformBuffer = &addressInfo;
+            descriptorSize = pPhysicalDevice->uniformBufferDescriptorSize;
+        }else if(binding.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER){
+            imageInfo.imageView = binding.imageView;
+            imageInfo.sampler = binding.sampler;
+            imageInfo.imageLayout = binding.imageLayout;
+            getInfo.data.pCombinedImageSampler = &imageInfo;
+            descriptorSize = pPhysicalDevice->combinedImageSamplerDescriptorSize;
+        }else throw std::runtime_error("failed to write descriptor buffer: unsupported descriptor type!");
+        m_vkGetDescriptorEXT(device, &getInfo, descriptorSize, pRegion + bindingOffset);
+    }
+#endif
+}
+
+void CDescriptorBackend::BindDescriptorBuffer(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber){
+#ifdef VK_EXT_descriptor_buffer
+    if(commandBuffer == m_boundCommandBuffer && frameNumber == m_boundFrameNumber) return;
+    VkDescriptorBufferBindingInfoEXT bindingInfo{};
+    bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+    bindingInfo.address = m_bufferAddresses[frame];
+    bindingInfo.usage = VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
+    m_vkCmdBindDescriptorBuffersEXT(commandBuffer, 1, &bindingInfo);
+    m_boundCommandBuffer = commandBuffer;
+    m_boundFrameNumber = frameNumber;
+#endif
+}
+
+void CDescriptorBackend::SetDescriptorBufferOffsets(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const std::vector<uint32_t> &regions){
+#ifdef VK_EXT_descriptor_buffer
+    if(regions.empty()) return;
+    uint32_t bufferIndices[4] = {0, 0, 0, 0}; //all sets live in the one bound buffer
+    VkDeviceSize offsets[4];
+    uint32_t setCount = std::min(static_cast<uint32_t>(regions.size()), 4u);
+    for(uint32_t i = 0; i < setCount; i++) offsets[i] = regions[i] * m_regionSize;
+    m_vkCmdSetDescriptorBufferOffsetsEXT(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, setCount, bufferIndices, offsets);
+#endif
+}
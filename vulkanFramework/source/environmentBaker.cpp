@@ -0,0 +1,592 @@
+#include "../include/environmentBaker.h"
+#include "../include/cubemapFaces.h"
+#include "../../thirdparty/stb_image.h"
+
+#include <cmath>
+
+#ifndef ANDROID
+#include <filesystem>
+#endif
+
+static const VkFormat ENVIRONMENT_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+static const uint32_t ENVIRONMENT_CACHE_VERSION = 1;
+
+CEnvironmentBaker::CEnvironmentBaker(){}
+CEnvironmentBaker::~CEnvironmentBaker(){}
+
+/*******************
+*	Environment Baker: Init
+********************/
+VkShaderModule CEnvironmentBaker::LoadShader(const std::string shaderName){
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+#ifndef ANDROID
+    bool bOpen = m_shaderManager.InitSpirVShader(SHADER_PATH + shaderName, &shaderModule);
+    if(!bOpen) bOpen = m_shaderManager.InitSpirVShader("shaders/" + shaderName, &shaderModule);
+    if(!bOpen) throw std::runtime_error("failed to open shader: " + shaderName);
+#else
+    std::vector<uint8_t> fileBits;
+    std::string fullShaderName = ANDROID_SHADER_PATH + shaderName;
+    if(!CContext::GetHandle().androidFileManager.AssetReadFile(fullShaderName.c_str(), fileBits)) throw std::runtime_error("failed to open shader: " + shaderName);
+    shaderModule = m_shaderManager.createShaderModule(fileBits);
+#endif
+    return shaderModule;
+}
+
+void CEnvironmentBaker::Init(){
+    if(m_bInitialized) return;
+    m_bInitialized = true;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+
+    //Step 1: set 0 = source (2D equirect or environment cube) + target level as a storage image array
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker descriptor set layout!");
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker pipeline layout!");
+
+    //Step 2: one pipeline per pass, all share the layout
+    static const char *shaderNames[PASS_COUNT] = {
+        "environmentBaker/equirectToCube.comp.spv", "environmentBaker/irradiance.comp.spv",
+        "environmentBaker/prefilter.comp.spv", "environmentBaker/brdfLut.comp.spv"};
+    for(int pass = 0; pass < PASS_COUNT; pass++){
+        VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+        computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        computeShaderStageInfo.module = LoadShader(shaderNames[pass]);
+        computeShaderStageInfo.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.layout = m_pipelineLayout;
+        pipelineInfo.stage = computeShaderStageInfo;
+        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipelines[pass]) != VK_SUCCESS)
+            throw std::runtime_error("failed to create environment baker pipeline!");
+    }
+
+    //Step 3: samplers. Equirect wraps in longitude only; cube lookups use every mip
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &m_equirectSampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker sampler!");
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &m_cubeSampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker sampler!");
+
+    //Step 4: per stage GPU time, if the graphics queue can write timestamps from compute work
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(CContext::GetHandle().GetPhysicalDevice(), &deviceProperties);
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(CContext::GetHandle().GetPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(CContext::GetHandle().GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+    uint32_t graphicsFamily = (*CContext::GetHandle().physicalDevice)->getGraphicsQueueFamily();
+    uint32_t validBits = (graphicsFamily < queueFamilyCount) ? queueFamilies[graphicsFamily].timestampValidBits : 0;
+    if(deviceProperties.limits.timestampComputeAndGraphics && validBits > 0){
+        m_timestampPeriod = deviceProperties.limits.timestampPeriod;
+        m_timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = TIMESTAMP_COUNT;
+        if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &m_queryPool) != VK_SUCCESS) m_queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void CEnvironmentBaker::Destroy(){
+    if(!m_bInitialized) return;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    if(m_queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, m_queryPool, nullptr);
+    vkDestroySampler(device, m_cubeSampler, nullptr);
+    vkDestroySampler(device, m_equirectSampler, nullptr);
+    for(int pass = 0; pass < PASS_COUNT; pass++) if(m_pipelines[pass] != VK_NULL_HANDLE) vkDestroyPipeline(device, m_pipelines[pass], nullptr);
+    vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
+    m_shaderManager.Destroy();
+    m_queryPool = VK_NULL_HANDLE;
+    for(int pass = 0; pass < PASS_COUNT; pass++) m_pipelines[pass] = VK_NULL_HANDLE;
+    m_bInitialized = false;
+}
+
+/*******************
+*	Environment Baker: Cache
+********************/
+void CEnvironmentBaker::ReadSourceFile(const std::string hdrPath, std::vector<uint8_t> &file){
+#ifndef ANDROID
+    std::ifstream stream(TEXTURE_PATH + hdrPath, std::ios::ate | std::ios::binary);
+    if(!stream.is_open()) stream.open("textures/" + hdrPath, std::ios::ate | std::ios::binary); //look for texture in 2 locations
+    if(!stream.is_open()) throw std::runtime_error("failed to open HDR environment image!");
+    size_t fileSize = (size_t)stream.tellg();
+    file.resize(fileSize);
+    stream.seekg(0);
+    stream.read((char*)file.data(), fileSize);
+#else
+    std::string fullTexturePath = ANDROID_TEXTURE_PATH + hdrPath;
+    if(!CContext::GetHandle().androidFileManager.AssetReadFile(fullTexturePath.c_str(), file)) throw std::runtime_error("failed to open HDR environment image!");
+#endif
+}
+
+uint64_t CEnvironmentBaker::GetCacheKey(const std::vector<uint8_t> &file){
+    //source bytes, then every setting that changes the output
+    uint32_t parameters[] = {ENVIRONMENT_CACHE_VERSION, settings.maxEnvironmentSize, settings.irradianceSize, settings.prefilterSize,
+        settings.prefilterMips, settings.brdfLutSize, settings.irradianceSteps, settings.prefilterSamples, settings.brdfLutSamples};
+    return HashBytes(parameters, sizeof(parameters), HashBytes(file.data(), file.size()));
+}
+
+std::string CEnvironmentBaker::GetCachePath(uint64_t key){
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.envcache", (unsigned long long)key);
+    return settings.cacheDirectory + name;
+}
+
+//file: "ENVB", version, sizes[4], mipLevels[4], then every output level by level, faces of a level back to back
+bool CEnvironmentBaker::LoadCache(const std::string cachePath, Result &result){
+#ifndef ANDROID
+    std::ifstream stream(cachePath, std::ios::binary);
+    if(!stream.is_open()) return false;
+    char magic[4];
+    uint32_t version = 0;
+    stream.read(magic, 4);
+    stream.read((char*)&version, 4);
+    stream.read((char*)result.sizes, sizeof(result.sizes));
+    stream.read((char*)result.mipLevels, sizeof(result.mipLevels));
+    if(!stream || memcmp(magic, "ENVB", 4) != 0 || version != ENVIRONMENT_CACHE_VERSION) return false;
+
+    VkDeviceSize totalSize = 0;
+    for(int output = 0; output < OUTPUT_COUNT; output++)
+        for(uint32_t level = 0; level < result.mipLevels[output]; level++)
+            totalSize += (VkDeviceSize)std::max(result.sizes[output] >> level, 1u) * std::max(result.sizes[output] >> level, 1u) * 8 * (IsCube(output) ? 6 : 1);
+    std::vector<uint8_t> texels((size_t)totalSize);
+    stream.read((char*)texels.data(), totalSize);
+    if(!stream) return false;
+
+    //upload all outputs from one staging buffer
+    CreateOutputs(result, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    CWxjBuffer stagingBuffer;
+    stagingBuffer.init(totalSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    void *pGpuMemory;
+    vkMapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory, 0, totalSize, 0, &pGpuMemory);
+    memcpy(pGpuMemory, texels.data(), (size_t)totalSize);
+    vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory);
+
+    VkCommandBuffer commandBuffer = BeginCommands();
+    VkDeviceSize offset = 0;
+    for(int output = 0; output < OUTPUT_COUNT; output++){
+        uint32_t layerCount = IsCube(output) ? 6 : 1;
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = result.images[output].image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, result.mipLevels[output], 0, layerCount};
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        std::vector<VkBufferImageCopy> regions(result.mipLevels[output]);
+        for(uint32_t level = 0; level < result.mipLevels[output]; level++){
+            uint32_t levelSize = std::max(result.sizes[output] >> level, 1u);
+            regions[level] = {};
+            regions[level].bufferOffset = offset;
+            regions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, layerCount};
+            regions[level].imageExtent = {levelSize, levelSize, 1};
+            offset += (VkDeviceSize)levelSize * levelSize * 8 * layerCount;
+        }
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, result.images[output].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    EndCommands(commandBuffer);
+    stagingBuffer.DestroyAndFree();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CEnvironmentBaker::SaveCache(const std::string cachePath, Result &result){
+#ifndef ANDROID
+    //Step 1: read every output back into one host visible buffer
+    VkDeviceSize totalSize = 0;
+    for(int output = 0; output < OUTPUT_COUNT; output++)
+        for(uint32_t level = 0; level < result.mipLevels[output]; level++)
+            totalSize += (VkDeviceSize)std::max(result.sizes[output] >> level, 1u) * std::max(result.sizes[output] >> level, 1u) * 8 * (IsCube(output) ? 6 : 1);
+    CWxjBuffer readbackBuffer;
+    readbackBuffer.init(totalSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    VkCommandBuffer commandBuffer = BeginCommands();
+    VkDeviceSize offset = 0;
+    for(int output = 0; output < OUTPUT_COUNT; output++){
+        uint32_t layerCount = IsCube(output) ? 6 : 1;
+        std::vector<VkBufferImageCopy> regions(result.mipLevels[output]);
+        for(uint32_t level = 0; level < result.mipLevels[output]; level++){
+            uint32_t levelSize = std::max(result.sizes[output] >> level, 1u);
+            regions[level] = {};
+            regions[level].bufferOffset = offset;
+            regions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, layerCount};
+            regions[level].imageExtent = {levelSize, levelSize, 1};
+            offset += (VkDeviceSize)levelSize * levelSize * 8 * layerCount;
+        }
+        vkCmdCopyImageToBuffer(commandBuffer, result.images[output].image, VK_IMAGE_LAYOUT_GENERAL, readbackBuffer.buffer, static_cast<uint32_t>(regions.size()), regions.data());
+    }
+    VkMemoryBarrier hostBarrier{};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+    EndCommands(commandBuffer);
+
+    //Step 2: header + texels
+    std::error_code error;
+    std::filesystem::create_directories(settings.cacheDirectory, error);
+    std::ofstream stream(cachePath, std::ios::binary);
+    if(stream.is_open()){
+        void *pGpuMemory;
+        vkMapMemory(CContext::GetHandle().GetLogicalDevice(), readbackBuffer.deviceMemory, 0, totalSize, 0, &pGpuMemory);
+        stream.write("ENVB", 4);
+        stream.write((const char*)&ENVIRONMENT_CACHE_VERSION, 4);
+        stream.write((const char*)result.sizes, sizeof(result.sizes));
+        stream.write((const char*)result.mipLevels, sizeof(result.mipLevels));
+        stream.write((const char*)pGpuMemory, totalSize);
+        vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), readbackBuffer.deviceMemory);
+    }
+    if(!stream.is_open() || !stream) PRINT("EnvironmentBaker: could not write cache %s", cachePath);
+    readbackBuffer.DestroyAndFree();
+#endif
+}
+
+/*******************
+*	Environment Baker: Images
+********************/
+void CEnvironmentBaker::CreateOutputs(Result &result, VkImageUsageFlags usage){
+    for(int output = 0; output < OUTPUT_COUNT; output++){
+        result.images[output].createImage(result.sizes[output], result.sizes[output], result.mipLevels[output], VK_SAMPLE_COUNT_1_BIT, ENVIRONMENT_FORMAT,
+            VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, IsCube(output));
+    }
+}
+
+void CEnvironmentBaker::CreateSampleViews(Result &result){
+    for(int output = 0; output < OUTPUT_COUNT; output++)
+        result.images[output].createImageView(ENVIRONMENT_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, result.mipLevels[output], IsCube(output));
+}
+
+VkImageView CEnvironmentBaker::CreateLevelView(VkImage image, uint32_t level, uint32_t layerCount){
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.format = ENVIRONMENT_FORMAT;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, layerCount};
+    VkImageView view;
+    if (vkCreateImageView(CContext::GetHandle().GetLogicalDevice(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker image view!");
+    return view;
+}
+
+/*******************
+*	Environment Baker: Bake
+********************/
+VkCommandBuffer CEnvironmentBaker::BeginCommands(){
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = *m_pCommandPool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(CContext::GetHandle().GetLogicalDevice(), &allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+void CEnvironmentBaker::EndCommands(VkCommandBuffer commandBuffer){
+    vkEndCommandBuffer(commandBuffer);
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(CContext::GetHandle().GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(CContext::GetHandle().GetGraphicsQueue());
+    vkFreeCommandBuffers(CContext::GetHandle().GetLogicalDevice(), *m_pCommandPool, 1, &commandBuffer);
+}
+
+void CEnvironmentBaker::Dispatch(VkCommandBuffer commandBuffer, VkDescriptorPool descriptorPool, Pass pass, VkImageView sourceView, VkSampler sampler,
+        VkImageView targetView, uint32_t size, uint32_t layerCount, const PushConstants &pushConstants){
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_descriptorSetLayout;
+    VkDescriptorSet descriptorSet;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate environment baker descriptor set!");
+
+    VkDescriptorImageInfo sourceInfo{sampler, sourceView, VK_IMAGE_LAYOUT_GENERAL};
+    VkDescriptorImageInfo targetInfo{VK_NULL_HANDLE, targetView, VK_IMAGE_LAYOUT_GENERAL};
+    VkWriteDescriptorSet descriptorWrites[2]{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = descriptorSet;
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[0].pImageInfo = &sourceInfo;
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = descriptorSet;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrites[1].pImageInfo = &targetInfo;
+    vkUpdateDescriptorSets(device, 2, descriptorWrites, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[pass]);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, (size + 7) / 8, (size + 7) / 8, layerCount);
+}
+
+void CEnvironmentBaker::Bake(const std::string hdrPath, VkCommandPool &commandPool, Result &result){
+    auto startTime = std::chrono::high_resolution_clock::now();
+    m_pCommandPool = &commandPool;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+
+    std::vector<uint8_t> file;
+    ReadSourceFile(hdrPath, file);
+    uint64_t cacheKey = GetCacheKey(file);
+    std::string cachePath = GetCachePath(cacheKey);
+    if(settings.bCache && LoadCache(cachePath, result)){
+        CreateSampleViews(result);
+        result.bFromCache = true;
+        auto endTime = std::chrono::high_resolution_clock::now();
+        PRINT("EnvironmentBaker: loaded %s", cachePath);
+        PRINT("EnvironmentBaker: cache load cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+        return;
+    }
+    Init();
+
+    //Step 1: equirect source as RGBA16F (linear filtering of RGBA16F is always supported, RGBA32F is not)
+    int width, height, inputChannels;
+    float *pTexels = stbi_loadf_from_memory(file.data(), (int)file.size(), &width, &height, &inputChannels, STBI_rgb_alpha);
+    if(!pTexels) throw std::runtime_error("failed to load HDR environment image!");
+    std::vector<uint16_t> halfTexels((size_t)width * height * 4);
+    for(size_t i = 0; i < halfTexels.size(); i++) halfTexels[i] = CCubemapFaces::FloatToHalf(pTexels[i]);
+    stbi_image_free(pTexels);
+
+    VkDeviceSize sourceSize = halfTexels.size() * sizeof(uint16_t);
+    CWxjBuffer stagingBuffer;
+    stagingBuffer.init(sourceSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    void *pGpuMemory;
+    vkMapMemory(device, stagingBuffer.deviceMemory, 0, sourceSize, 0, &pGpuMemory);
+    memcpy(pGpuMemory, halfTexels.data(), (size_t)sourceSize);
+    vkUnmapMemory(device, stagingBuffer.deviceMemory);
+
+    CWxjImageBuffer source;
+    source.createImage(width, height, 1, VK_SAMPLE_COUNT_1_BIT, ENVIRONMENT_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    source.createImageView(ENVIRONMENT_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, 1, false);
+
+    //Step 2: outputs
+    result.sizes[OUTPUT_ENVIRONMENT] = std::min(std::max((uint32_t)width / 4, 1u), settings.maxEnvironmentSize);
+    result.sizes[OUTPUT_IRRADIANCE] = settings.irradianceSize;
+    result.sizes[OUTPUT_PREFILTERED] = settings.prefilterSize;
+    result.sizes[OUTPUT_BRDF_LUT] = settings.brdfLutSize;
+    result.mipLevels[OUTPUT_ENVIRONMENT] = static_cast<uint32_t>(std::floor(std::log2(result.sizes[OUTPUT_ENVIRONMENT]))) + 1;
+    result.mipLevels[OUTPUT_IRRADIANCE] = 1;
+    result.mipLevels[OUTPUT_PREFILTERED] = std::max(1u, std::min(settings.prefilterMips, static_cast<uint32_t>(std::floor(std::log2(settings.prefilterSize))) + 1));
+    result.mipLevels[OUTPUT_BRDF_LUT] = 1;
+    CreateOutputs(result, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+    //views: environment level 0 (storage), a cube view of the whole chain as the source of the integrals, one per prefiltered level
+    std::vector<VkImageView> views;
+    views.push_back(CreateLevelView(result.images[OUTPUT_ENVIRONMENT].image, 0, 6));
+    views.push_back(result.images[OUTPUT_ENVIRONMENT].createImageView(result.images[OUTPUT_ENVIRONMENT].image, ENVIRONMENT_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, result.mipLevels[OUTPUT_ENVIRONMENT], true));
+    views.push_back(CreateLevelView(result.images[OUTPUT_IRRADIANCE].image, 0, 6));
+    views.push_back(CreateLevelView(result.images[OUTPUT_BRDF_LUT].image, 0, 1));
+    for(uint32_t level = 0; level < result.mipLevels[OUTPUT_PREFILTERED]; level++) views.push_back(CreateLevelView(result.images[OUTPUT_PREFILTERED].image, level, 6));
+
+    uint32_t setCount = 3 + result.mipLevels[OUTPUT_PREFILTERED];
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = setCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = setCount;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    poolInfo.maxSets = setCount;
+    VkDescriptorPool descriptorPool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create environment baker descriptor pool!");
+
+    //Step 3: record every stage in one submission, timestamps between the stages
+    VkCommandBuffer commandBuffer = BeginCommands();
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdResetQueryPool(commandBuffer, m_queryPool, 0, TIMESTAMP_COUNT);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = source.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {(uint32_t)width, (uint32_t)height, 1};
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, source.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkImageMemoryBarrier> outputBarriers(OUTPUT_COUNT, barrier);
+    for(int output = 0; output < OUTPUT_COUNT; output++){
+        outputBarriers[output].image = result.images[output].image;
+        outputBarriers[output].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, result.mipLevels[output], 0, IsCube(output) ? 6u : 1u};
+        outputBarriers[output].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        outputBarriers[output].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        outputBarriers[output].srcAccessMask = 0;
+        outputBarriers[output].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(outputBarriers.size()), outputBarriers.data());
+
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+
+    //equirect -> environment level 0
+    PushConstants pushConstants{};
+    pushConstants.size = (int32_t)result.sizes[OUTPUT_ENVIRONMENT];
+    Dispatch(commandBuffer, descriptorPool, PASS_EQUIRECT, source.view, m_equirectSampler, views[0], result.sizes[OUTPUT_ENVIRONMENT], 6, pushConstants);
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 1);
+
+    //environment mips by blit, all 6 faces per blit; GENERAL is valid for both ends of a blit
+    VkImage environment = result.images[OUTPUT_ENVIRONMENT].image;
+    barrier.image = environment;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    for(uint32_t level = 1; level < result.mipLevels[OUTPUT_ENVIRONMENT]; level++){
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 6};
+        barrier.srcAccessMask = (level == 1) ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, (level == 1) ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        int32_t srcSize = (int32_t)std::max(result.sizes[OUTPUT_ENVIRONMENT] >> (level - 1), 1u);
+        int32_t dstSize = (int32_t)std::max(result.sizes[OUTPUT_ENVIRONMENT] >> level, 1u);
+        VkImageBlit blit{};
+        blit.srcOffsets[1] = {srcSize, srcSize, 1};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 6};
+        blit.dstOffsets[1] = {dstSize, dstSize, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 6};
+        vkCmdBlitImage(commandBuffer, environment, VK_IMAGE_LAYOUT_GENERAL, environment, VK_IMAGE_LAYOUT_GENERAL, 1, &blit, VK_FILTER_LINEAR);
+    }
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, result.mipLevels[OUTPUT_ENVIRONMENT], 0, 6};
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2);
+
+    //irradiance integrates a ~64 texel level, the result is low frequency anyway
+    pushConstants.size = (int32_t)result.sizes[OUTPUT_IRRADIANCE];
+    pushConstants.sourceMip = std::max((int32_t)result.mipLevels[OUTPUT_ENVIRONMENT] - 7, 0);
+    pushConstants.sampleCount = settings.irradianceSteps;
+    Dispatch(commandBuffer, descriptorPool, PASS_IRRADIANCE, views[1], m_cubeSampler, views[2], result.sizes[OUTPUT_IRRADIANCE], 6, pushConstants);
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 3);
+
+    //prefiltered specular, roughness grows linearly with the level
+    for(uint32_t level = 0; level < result.mipLevels[OUTPUT_PREFILTERED]; level++){
+        uint32_t levelSize = std::max(result.sizes[OUTPUT_PREFILTERED] >> level, 1u);
+        pushConstants.size = (int32_t)levelSize;
+        pushConstants.sourceMip = 0;
+        pushConstants.roughness = (result.mipLevels[OUTPUT_PREFILTERED] > 1) ? (float)level / (float)(result.mipLevels[OUTPUT_PREFILTERED] - 1) : 0.0f;
+        pushConstants.sampleCount = settings.prefilterSamples;
+        Dispatch(commandBuffer, descriptorPool, PASS_PREFILTER, views[1], m_cubeSampler, views[4 + level], levelSize, 6, pushConstants);
+    }
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 4);
+
+    pushConstants.size = (int32_t)result.sizes[OUTPUT_BRDF_LUT];
+    pushConstants.roughness = 0.0f;
+    pushConstants.sampleCount = settings.brdfLutSamples;
+    Dispatch(commandBuffer, descriptorPool, PASS_BRDF_LUT, source.view, m_equirectSampler, views[3], result.sizes[OUTPUT_BRDF_LUT], 1, pushConstants);
+    if(m_queryPool != VK_NULL_HANDLE) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 5);
+
+    //outputs stay in GENERAL like the other textures, make the writes visible to sampling and the cache readback
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    EndCommands(commandBuffer);
+
+    //Step 4: per stage GPU time
+    if(m_queryPool != VK_NULL_HANDLE){
+        uint64_t timestamps[TIMESTAMP_COUNT];
+        vkGetQueryPoolResults(device, m_queryPool, 0, TIMESTAMP_COUNT, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        static const char *stageNames[TIMESTAMP_COUNT - 1] = {"equirect to cube", "environment mips", "irradiance", "prefilter", "brdf lut"};
+        for(uint32_t i = 1; i < TIMESTAMP_COUNT; i++){
+            float milliseconds = (float)(((timestamps[i] - timestamps[i - 1]) & m_timestampMask) * m_timestampPeriod / 1000000.0);
+            PRINT("EnvironmentBaker: GPU " + std::string(stageNames[i - 1]) + " %f milliseconds", milliseconds);
+        }
+    }
+
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    for(auto view : views) vkDestroyImageView(device, view, nullptr);
+    source.destroy();
+    stagingBuffer.DestroyAndFree();
+
+    if(settings.bCache) SaveCache(cachePath, result);
+    CreateSampleViews(result);
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    PRINT("EnvironmentBaker: environment %d texels per face", (int)result.sizes[OUTPUT_ENVIRONMENT]);
+    PRINT("EnvironmentBaker: prefiltered levels %d", (int)result.mipLevels[OUTPUT_PREFILTERED]);
+    PRINT("EnvironmentBaker: bake cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+}
@@ -0,0 +1,144 @@
+#include "../include/framePacer.h"
+#include "../include/context.h"
+#include "../include/cpuProfiler.h"
+#include "../include/metrics.h"
+
+#include <cmath>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+static const uint64_t PRESENT_WAIT_TIMEOUT = 100000000; //ns: a hidden window may not show anything for a long time
+
+void CFramePacer::Init(){
+    m_bPresentWait = false;
+#if defined(VK_KHR_present_wait) && defined(VK_KHR_present_id)
+    if(bUsePresentWait && CContext::GetHandle().physicalDevice->get()->bPresentWait){
+        m_pfnWaitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(CContext::GetHandle().GetLogicalDevice(), "vkWaitForPresentKHR");
+        m_bPresentWait = m_pfnWaitForPresent != nullptr;
+    }
+#endif
+#ifdef _WIN32
+    m_hTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS); //Windows 10 1803+
+#endif
+    m_nextFrameTime = std::chrono::steady_clock::time_point();
+    std::cout<<"Frame pacer: "<<(targetFps > 0 ? "limit " + std::to_string((int)targetFps) + " fps" : std::string("no limit"))
+        <<", present wait "<<(m_bPresentWait ? "on, " + std::to_string(maxQueuedFrames) + " queued frames" : std::string("off"))<<std::endl;
+}
+
+void CFramePacer::Destroy(){
+#ifdef _WIN32
+    if(m_hTimer) CloseHandle(m_hTimer);
+    m_hTimer = nullptr;
+#endif
+    if(m_latencyCount == 0) return;
+    std::cout<<"Frame pacer: input to "<<(m_bPresentWait ? "photon" : "present")<<" latency "<<m_latencySumMs / m_latencyCount
+        <<" ms average, "<<m_latencyMaxMs<<" ms max, "<<m_latencyCount<<" frames with input"<<std::endl;
+}
+
+void CFramePacer::WaitForNextFrame(){
+    PROFILE_SCOPE("frame pacing");
+    WaitForPresent();
+    if(targetFps <= 0) return;
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    auto now = std::chrono::steady_clock::now();
+    if(now > m_nextFrameTime + period) m_nextFrameTime = now; //late (or the first frame): restart the schedule
+    else SleepUntil(m_nextFrameTime);
+    m_nextFrameTime += period;
+}
+
+void CFramePacer::SetInputTime(std::chrono::steady_clock::time_point time){
+    if(time == std::chrono::steady_clock::time_point()) return; //no input
+    if(m_inputTime == std::chrono::steady_clock::time_point() || time < m_inputTime) m_inputTime = time;
+}
+
+uint64_t CFramePacer::Presenting(VkSwapchainKHR swapchain){
+    std::chrono::steady_clock::time_point inputTime = m_inputTime;
+    m_inputTime = std::chrono::steady_clock::time_point();
+    bool bInput = inputTime != std::chrono::steady_clock::time_point();
+    if(!m_bPresentWait){
+        if(bInput) RecordLatency(inputTime, std::chrono::steady_clock::now());
+        return 0;
+    }
+    m_swapchain = swapchain;
+    m_presentId++;
+    if(bInput) m_pendingLatencies.push_back({m_presentId, inputTime});
+    return m_presentId;
+}
+
+void CFramePacer::WaitForPresent(){
+#if defined(VK_KHR_present_wait) && defined(VK_KHR_present_id)
+    if(!m_bPresentWait || m_presentId <= maxQueuedFrames) return;
+    uint64_t waitId = m_presentId - maxQueuedFrames;
+    if(waitId <= m_shownId) return;
+
+    PROFILE_SCOPE("present wait");
+    VkResult result = m_pfnWaitForPresent(CContext::GetHandle().GetLogicalDevice(), m_swapchain, waitId, PRESENT_WAIT_TIMEOUT);
+    if(result == VK_TIMEOUT) return; //try again next frame
+    if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
+        std::cout<<"Frame pacer: vkWaitForPresentKHR failed ("<<result<<"), present wait off"<<std::endl;
+        m_bPresentWait = false;
+        m_pendingLatencies.clear();
+        return;
+    }
+    m_shownId = waitId;
+    auto now = std::chrono::steady_clock::now();
+    while(!m_pendingLatencies.empty() && m_pendingLatencies.front().presentId <= waitId){
+        RecordLatency(m_pendingLatencies.front().inputTime, now);
+        m_pendingLatencies.pop_front();
+    }
+#endif
+}
+
+void CFramePacer::RecordLatency(std::chrono::steady_clock::time_point inputTime, std::chrono::steady_clock::time_point shownTime){
+    double us = std::chrono::duration<double, std::micro>(shownTime - inputTime).count();
+    m_latencyCount++;
+    m_latencySumMs += us / 1000.0;
+    m_latencyMaxMs = std::max(m_latencyMaxMs, us / 1000.0);
+    if(m_bPresentWait) PROFILE_COUNTER("input to photon us", us);
+    else PROFILE_COUNTER("input to present us", us);
+    static CMetrics::Histogram &latency = CMetrics::GetHistogram("input_latency_us", "Input to photon (present wait) or to present, microseconds");
+    latency.Record((uint64_t)us);
+}
+
+/*******************
+*	Limiter
+********************/
+void CFramePacer::SleepUntil(std::chrono::steady_clock::time_point deadline){
+    while(std::chrono::duration<double, std::micro>(deadline - std::chrono::steady_clock::now()).count() > m_sleepEstimate){
+        auto start = std::chrono::steady_clock::now();
+        SleepStep();
+        double observed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        //running mean and variance of a step; after 256 steps older steps fade out, so the estimate follows the system load
+        bool bFull = m_sleepSamples == 256;
+        if(!bFull) m_sleepSamples++;
+        else m_sleepM2 *= (double)(m_sleepSamples - 1) / m_sleepSamples;
+        double delta = observed - m_sleepMean;
+        m_sleepMean += delta / m_sleepSamples;
+        m_sleepM2 += delta * (observed - m_sleepMean);
+        if(m_sleepSamples > 1) m_sleepEstimate = m_sleepMean + std::sqrt(m_sleepM2 / (m_sleepSamples - 1));
+    }
+    while(std::chrono::steady_clock::now() < deadline) std::this_thread::yield(); //the last part: sleeping would overshoot
+}
+
+void CFramePacer::SleepStep(){
+#ifdef _WIN32
+    if(m_hTimer){
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -10000; //relative, 100 ns units
+        if(SetWaitableTimer(m_hTimer, &dueTime, 0, NULL, NULL, FALSE)){
+            WaitForSingleObject(m_hTimer, INFINITE);
+            return;
+        }
+    }
+    Sleep(1); //timer resolution, often 15.6 ms: the estimate grows and the spin takes over
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
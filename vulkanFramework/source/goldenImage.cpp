@@ -0,0 +1,86 @@
+#include "../include/goldenImage.h"
+#include "../include/imageWriter.h"
+#include "../../thirdparty/stb_image.h"
+
+#include <filesystem>
+
+void CGoldenImage::ToLab(const uint8_t *rgb, float lab[3]){
+    static float linear[256]; //8 bit sRGB to linear
+    static bool bTable = false;
+    if(!bTable){
+        for(int i = 0; i < 256; i++){
+            float c = i / 255.0f;
+            linear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        bTable = true;
+    }
+    float r = linear[rgb[0]], g = linear[rgb[1]], b = linear[rgb[2]];
+    //sRGB primaries, D65 white
+    float xyz[3] = {
+        (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f,
+        (0.2126f * r + 0.7152f * g + 0.0722f * b),
+        (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f};
+    for(int i = 0; i < 3; i++)
+        xyz[i] = (xyz[i] > 0.008856f) ? std::cbrt(xyz[i]) : (7.787f * xyz[i] + 16.0f / 116.0f);
+    lab[0] = 116.0f * xyz[1] - 16.0f;
+    lab[1] = 500.0f * (xyz[0] - xyz[1]);
+    lab[2] = 200.0f * (xyz[1] - xyz[2]);
+}
+
+CGoldenImage::Result CGoldenImage::Compare(const std::string &goldenPath, uint32_t width, uint32_t height, VkFormat format, const void *pixels,
+    float deltaEThreshold, float maxBadPixelFraction, const std::string &diffPath, UpdateMode updateMode){
+    Result result;
+    std::vector<uint8_t> frame;
+    CImageWriter::ToRGBA8(width, height, format, pixels, frame); //the stored bytes are compared as displayed, like the PNG
+
+    std::error_code error;
+    if(updateMode == UPDATE_ALWAYS || (updateMode == UPDATE_MISSING && !std::filesystem::exists(goldenPath, error))){
+        std::filesystem::path parent = std::filesystem::path(goldenPath).parent_path();
+        if(!parent.empty()) std::filesystem::create_directories(parent, error);
+        result.bCreated = CImageWriter::WritePNG(goldenPath, width, height, frame.data());
+        result.bPass = result.bCreated;
+        std::cout<<"Golden image: "<<goldenPath<<(!result.bCreated ? " could not be written" : updateMode == UPDATE_ALWAYS ? " updated" : " created")<<std::endl;
+        return result;
+    }
+
+    int goldenWidth, goldenHeight, goldenChannels;
+    stbi_uc *golden = stbi_load(goldenPath.c_str(), &goldenWidth, &goldenHeight, &goldenChannels, STBI_rgb_alpha);
+    if(!golden){
+        //a run without its golden image has checked nothing, it must not pass
+        std::cout<<"Golden image: "<<goldenPath<<" FAILED, missing (--create-missing-golden or --update-golden writes it)"<<std::endl;
+        return result;
+    }
+    if(goldenWidth != (int)width || goldenHeight != (int)height){
+        std::cout<<"Golden image: "<<goldenPath<<" is "<<goldenWidth<<"x"<<goldenHeight<<", frame is "<<width<<"x"<<height<<std::endl;
+        stbi_image_free(golden);
+        return result;
+    }
+
+    size_t count = (size_t)width * height;
+    size_t badPixels = 0;
+    std::vector<uint8_t> diff(count * 4);
+    for(size_t i = 0; i < count; i++){
+        float labFrame[3], labGolden[3];
+        ToLab(&frame[i * 4], labFrame);
+        ToLab(&golden[i * 4], labGolden);
+        float deltaE = std::sqrt((labFrame[0] - labGolden[0]) * (labFrame[0] - labGolden[0])
+            + (labFrame[1] - labGolden[1]) * (labFrame[1] - labGolden[1])
+            + (labFrame[2] - labGolden[2]) * (labFrame[2] - labGolden[2]));
+        result.maxDeltaE = std::max(result.maxDeltaE, deltaE);
+        bool bBad = deltaE > deltaEThreshold;
+        if(bBad) badPixels++;
+        //difference image: failing pixels red, the rest a dimmed copy of the golden image
+        diff[i * 4 + 0] = bBad ? 255 : golden[i * 4 + 0] / 4;
+        diff[i * 4 + 1] = bBad ? 0 : golden[i * 4 + 1] / 4;
+        diff[i * 4 + 2] = bBad ? 0 : golden[i * 4 + 2] / 4;
+        diff[i * 4 + 3] = 255;
+    }
+    stbi_image_free(golden);
+
+    result.badPixelFraction = (float)badPixels / (float)count;
+    result.bPass = result.badPixelFraction <= maxBadPixelFraction;
+    std::cout<<"Golden image: "<<goldenPath<<(result.bPass ? " passed" : " FAILED")<<", "<<result.badPixelFraction * 100.0f
+        <<"% of pixels above delta E "<<deltaEThreshold<<", max delta E "<<result.maxDeltaE<<std::endl;
+    if(!result.bPass && !diffPath.empty()) CImageWriter::WritePNG(diffPath, width, height, diff.data());
+    return result;
+}
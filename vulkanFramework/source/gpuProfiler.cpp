@@ -0,0 +1,233 @@
+#include "../include/gpuProfiler.h"
+
+static const char *statisticNames[CGpuProfiler::STAT_COUNT] = {
+    "vertices", "vertex_invocations", "clipping_primitives", "fragment_invocations", "compute_invocations"};
+static const char *queueNames[CGpuProfiler::QUEUE_COUNT] = {"graphics", "compute"};
+
+CGpuProfiler::CGpuProfiler(){}
+CGpuProfiler::~CGpuProfiler(){}
+
+void CGpuProfiler::Init(uint32_t computeQueueFamily, uint32_t maxScopes){
+    if(!bEnabled) return;
+    VkPhysicalDevice physicalDevice = CContext::GetHandle().GetPhysicalDevice();
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+    uint32_t families[QUEUE_COUNT] = {CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily(), computeQueueFamily};
+    uint32_t validBits = 64;
+    for(int queue = 0; queue < QUEUE_COUNT; queue++){
+        uint32_t bits = queueFamilyProperties[families[queue]].timestampValidBits;
+        m_bQueueEnabled[queue] = bits > 0;
+        if(bits > 0) validBits = std::min(validBits, bits);
+    }
+    if(!m_bQueueEnabled[QUEUE_GRAPHICS] && !m_bQueueEnabled[QUEUE_COMPUTE]){
+        std::cout<<"GPU profiler: the queues do not support timestamps, disabled"<<std::endl;
+        bEnabled = false;
+        return;
+    }
+    m_timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+
+    if(bPipelineStatistics && !CContext::GetHandle().physicalDevice->get()->bPipelineStatisticsQuery){
+        std::cout<<"GPU profiler: pipelineStatisticsQuery is not supported, statistics disabled"<<std::endl;
+        bPipelineStatistics = false;
+    }
+
+    m_maxScopes = maxScopes;
+    m_slots.resize(MAX_FRAMES_IN_FLIGHT * QUEUE_COUNT);
+    for(uint32_t i = 0; i < m_slots.size(); i++){
+        Queue queue = (Queue)(i % QUEUE_COUNT);
+        if(!m_bQueueEnabled[queue]) continue;
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = 2 * m_maxScopes; //begin and end
+        if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &m_slots[i].timestampPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create profiler query pool!");
+        if(!bPipelineStatistics) continue;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryPoolInfo.queryCount = 1;
+        //a compute-only family must not query graphics stages
+        queryPoolInfo.pipelineStatistics = (queue == QUEUE_COMPUTE) ? VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT :
+            (VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+             VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+             VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT); //results come in bit order, same as Statistic
+        if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &m_slots[i].statisticsPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create profiler statistics query pool!");
+    }
+
+    if(!csvPath.empty()){
+        m_csv.open(csvPath);
+        if(m_csv.is_open()) m_csv<<"frame,queue,scope,depth,start_ms,duration_ms\n";
+        else std::cout<<"GPU profiler: could not open "<<csvPath<<std::endl;
+    }
+    if(!tracePath.empty()){
+        m_trace.open(tracePath);
+        if(m_trace.is_open()){
+            m_trace<<"[\n";
+            for(int queue = 0; queue < QUEUE_COUNT; queue++)
+                m_trace<<(queue ? ",\n" : "")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"<<queue + 1<<",\"args\":{\"name\":\"GPU "<<queueNames[queue]<<"\"}}";
+            m_bFirstTraceEvent = false;
+        }else std::cout<<"GPU profiler: could not open "<<tracePath<<std::endl;
+    }
+    std::cout<<"GPU profiler: "<<m_maxScopes<<" scopes per command buffer"<<(bPipelineStatistics ? ", pipeline statistics" : "")<<std::endl;
+}
+
+void CGpuProfiler::Destroy(){
+    if(m_slots.empty()) return;
+    PrintSummary();
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    for(auto &slot : m_slots){
+        if(slot.timestampPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, slot.timestampPool, nullptr);
+        if(slot.statisticsPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, slot.statisticsPool, nullptr);
+    }
+    m_slots.clear();
+    if(m_csv.is_open()) m_csv.close();
+    if(m_trace.is_open()){
+        m_trace<<"\n]\n";
+        m_trace.close();
+        std::cout<<"GPU profiler: trace written to "<<tracePath<<std::endl;
+    }
+}
+
+/*******************
+*	Recording
+********************/
+void CGpuProfiler::BeginCommandBuffer(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue){
+    if(!bEnabled || !m_bQueueEnabled[queue]) return;
+    Slot &slot = GetSlot(frame, queue);
+    slot.scopes.clear();
+    slot.depth = 0;
+    vkCmdResetQueryPool(commandBuffer, slot.timestampPool, 0, 2 * m_maxScopes);
+    if(slot.statisticsPool != VK_NULL_HANDLE){
+        vkCmdResetQueryPool(commandBuffer, slot.statisticsPool, 0, 1);
+        vkCmdBeginQuery(commandBuffer, slot.statisticsPool, 0, 0);
+    }
+    BeginScope(commandBuffer, frame, queue, queueNames[queue]);
+}
+
+void CGpuProfiler::EndCommandBuffer(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue){
+    if(!bEnabled || !m_bQueueEnabled[queue]) return;
+    Slot &slot = GetSlot(frame, queue);
+    if(slot.scopes.empty()) return; //BeginCommandBuffer was not called for this recording
+    for(int scope = (int)slot.scopes.size() - 1; scope >= 0; scope--) EndScope(commandBuffer, frame, queue, scope); //every query gets written
+    if(slot.statisticsPool != VK_NULL_HANDLE) vkCmdEndQuery(commandBuffer, slot.statisticsPool, 0);
+}
+
+int CGpuProfiler::BeginScope(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue, const std::string &name){
+    if(!bEnabled || !m_bQueueEnabled[queue]) return -1;
+    Slot &slot = GetSlot(frame, queue);
+    if(slot.scopes.size() >= m_maxScopes){
+        droppedScopes++;
+        return -1;
+    }
+    int scope = (int)slot.scopes.size();
+    slot.scopes.push_back({name, slot.depth++, false});
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.timestampPool, 2 * scope);
+    return scope;
+}
+
+void CGpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t frame, Queue queue, int scope){
+    if(scope < 0 || !bEnabled) return;
+    Slot &slot = GetSlot(frame, queue);
+    if(scope >= slot.scopes.size() || slot.scopes[scope].bClosed) return;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.timestampPool, 2 * scope + 1);
+    slot.scopes[scope].bClosed = true;
+    if(slot.depth > 0) slot.depth--;
+}
+
+void CGpuProfiler::Submitted(uint32_t frame, Queue queue, uint64_t frameNumber){
+    if(!bEnabled || !m_bQueueEnabled[queue]) return;
+    Slot &slot = GetSlot(frame, queue);
+    if(slot.scopes.empty()) return;
+    slot.bPending = true;
+    slot.frameNumber = frameNumber;
+}
+
+/*******************
+*	Results
+********************/
+void CGpuProfiler::Resolve(uint32_t frame){
+    if(!bEnabled) return;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    bool bResolved = false;
+    for(int queue = 0; queue < QUEUE_COUNT; queue++){
+        if(!m_bQueueEnabled[queue]) continue;
+        Slot &slot = GetSlot(frame, (Queue)queue);
+        if(!slot.bPending) continue;
+
+        uint32_t count = (uint32_t)slot.scopes.size();
+        std::vector<uint64_t> timestamps(2 * count);
+        VkResult result = vkGetQueryPoolResults(device, slot.timestampPool, 0, 2 * count, timestamps.size() * sizeof(uint64_t),
+            timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if(result != VK_SUCCESS) continue; //VK_NOT_READY: still in flight, try again next time
+        slot.bPending = false;
+        if(!bResolved) lastResults.clear();
+        bResolved = true;
+
+        if(!m_bBaseTimestamp){
+            m_baseTimestamp = timestamps[0] & m_timestampMask;
+            m_bBaseTimestamp = true;
+        }
+        for(uint32_t i = 0; i < count; i++){
+            uint64_t begin = timestamps[2 * i] & m_timestampMask, end = timestamps[2 * i + 1] & m_timestampMask;
+            ScopeResult scope;
+            scope.name = slot.scopes[i].name;
+            scope.queue = (Queue)queue;
+            scope.depth = slot.scopes[i].depth;
+            scope.startMs = (double)((begin - m_baseTimestamp) & m_timestampMask) * m_timestampPeriod / 1000000.0;
+            scope.durationMs = (double)((end - begin) & m_timestampMask) * m_timestampPeriod / 1000000.0;
+            lastResults.push_back(scope);
+
+            std::string key = std::string(queueNames[queue]) + "/" + scope.name;
+            auto average = averages.find(key);
+            if(average == averages.end()) averages[key] = scope.durationMs;
+            else average->second = average->second * 0.95 + scope.durationMs * 0.05;
+
+            if(m_csv.is_open()) m_csv<<slot.frameNumber<<","<<queueNames[queue]<<","<<scope.name<<","<<scope.depth<<","<<scope.startMs<<","<<scope.durationMs<<"\n";
+            if(m_trace.is_open()) WriteTraceEvent(scope, slot.frameNumber);
+        }
+
+        if(slot.statisticsPool != VK_NULL_HANDLE){
+            uint64_t values[STAT_COUNT] = {};
+            if(vkGetQueryPoolResults(device, slot.statisticsPool, 0, 1, sizeof(values), values, sizeof(values), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS){
+                if(queue == QUEUE_COMPUTE) statistics[queue][STAT_COMPUTE_INVOCATIONS] = values[0];
+                else for(int s = 0; s < STAT_COUNT; s++) statistics[queue][s] = values[s];
+            }
+        }
+
+        if(summaryInterval > 0 && slot.frameNumber >= m_lastSummaryFrame + summaryInterval){
+            m_lastSummaryFrame = slot.frameNumber;
+            PrintSummary();
+        }
+    }
+}
+
+void CGpuProfiler::WriteTraceEvent(const ScopeResult &result, uint64_t frameNumber){
+    //complete events ("X"), microseconds
+    m_trace<<(m_bFirstTraceEvent ? "" : ",\n")<<"{\"name\":\"";
+    for(char c : result.name) if(c != '"' && c != '\\') m_trace<<c;
+    m_trace<<"\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":"<<result.queue + 1
+        <<",\"ts\":"<<result.startMs * 1000.0<<",\"dur\":"<<result.durationMs * 1000.0<<",\"args\":{\"frame\":"<<frameNumber<<"}}";
+    m_bFirstTraceEvent = false;
+}
+
+void CGpuProfiler::PrintSummary(){
+    if(averages.empty()) return;
+    std::cout<<"GPU profile (ms, moving average):"<<std::endl;
+    for(auto &average : averages) std::cout<<"    "<<average.first<<" = "<<average.second<<std::endl;
+    if(bPipelineStatistics){
+        std::cout<<"    pipeline statistics:";
+        for(int queue = 0; queue < QUEUE_COUNT; queue++)
+            for(int s = 0; s < STAT_COUNT; s++)
+                if(statistics[queue][s] > 0) std::cout<<" "<<queueNames[queue]<<"."<<statisticNames[s]<<"="<<statistics[queue][s];
+        std::cout<<std::endl;
+    }
+    if(droppedScopes > 0) std::cout<<"    dropped scopes: "<<droppedScopes<<std::endl;
+}
@@ -5,63 +5,20 @@
 * Pool
 ************/
 int CGraphicsDescriptorManager::graphicsUniformTypes;
-VkDescriptorPool CGraphicsDescriptorManager::graphicsDescriptorPool;
-std::vector<VkDescriptorPoolSize> CGraphicsDescriptorManager::graphicsDescriptorPoolSizes;
+CDescriptorAllocator CGraphicsDescriptorManager::descriptorAllocator;
+CDescriptorCache CGraphicsDescriptorManager::descriptorCache;
+unsigned int CGraphicsDescriptorManager::expectedObjectCount;
+CDescriptorBackend CGraphicsDescriptorManager::descriptorBackend;
+CSamplerCache CGraphicsDescriptorManager::samplerCache;
 unsigned int CGraphicsDescriptorManager::textureImageSamplerSize;
 void CGraphicsDescriptorManager::createDescriptorPool(unsigned int object_count){
     //Descriptor Step 1/3
-    //objectCount = object_count;
-
-	graphicsDescriptorPoolSizes.resize(getPoolSize());
-	int counter = 0;
-    //std::cout<<"createDescriptorPool::textureSamplers.size() = " << textureSamplers.size()<<std::endl;
+    //Pools are created on demand per layout by descriptorAllocator (registered in Step 2), so the
+    //number of objects and sets is not fixed here. The general sets need MAX_FRAMES_IN_FLIGHT sets,
+    //texture sampler sets one per distinct texture combination (at most object_count).
+    expectedObjectCount = object_count;
+    descriptorCache.Init(&descriptorAllocator);
     std::cout<<"Graphics Pool size = " << getPoolSize()<<std::endl;
-
-    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_CUSTOM){
-        //std::cout<<": Custom Buffer";
-        graphicsDescriptorPoolSizes[counter].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	 	graphicsDescriptorPoolSizes[counter].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-		counter++;
-	}
-    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_LIGHTING){
-        //std::cout<<": Lighting Buffer";
-        graphicsDescriptorPoolSizes[counter].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	 	graphicsDescriptorPoolSizes[counter].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-		counter++;
-	}
-	
-    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_MVP || graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_VP){
-        //std::cout<<": MVP";
-        graphicsDescriptorPoolSizes[counter].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	 	graphicsDescriptorPoolSizes[counter].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-		counter++;
-    }
-    if(graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE){
-        //std::cout<<": Sampler("<<samplerCount<<")";
-        for(int i = 0; i < textureImageSamplerSize; i++){
-            graphicsDescriptorPoolSizes[counter].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	 	    graphicsDescriptorPoolSizes[counter].descriptorCount = object_count*static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);//each object has a sampler
-		    counter++;
-        }
-    }
-    if(graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE){
-        //std::cout<<"createDescriptorPool():GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE"<<std::endl;
-        graphicsDescriptorPoolSizes[counter].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        graphicsDescriptorPoolSizes[counter].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);//one depth sampler
-        counter++;
-        
-    }
-    
-
-	VkDescriptorPoolCreateInfo poolInfo{};
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = static_cast<uint32_t>(graphicsDescriptorPoolSizes.size());
-    //std::cout<<"poolInfo.poolSizeCount = "<<poolInfo.poolSizeCount <<std::endl;
-	poolInfo.pPoolSizes = graphicsDescriptorPoolSizes.data();
-	poolInfo.maxSets = ((counter==0)?1:counter)*10*static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);///!!!TODO: currently support 10 sets?
-
-	VkResult result = vkCreateDescriptorPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &graphicsDescriptorPool);
-	if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor pool!");
 }
 
 /************
@@ -98,7 +55,7 @@ void CGraphicsDescriptorManager::createDescriptorSetLayout_General(VkDescriptorS
         //std::cout<<"DEBUG: MVP Layout binding="<<counter<<std::endl;
         graphicsBindings[bindingCounter].binding = bindingCounter;
 		graphicsBindings[bindingCounter].descriptorCount = binding.descriptorCount;
-		graphicsBindings[bindingCounter].descriptorType = binding.descriptorType;
+		graphicsBindings[bindingCounter].descriptorType = descriptorBackend.UseDynamicUniformBuffers() ? binding.descriptorType : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		graphicsBindings[bindingCounter].pImmutableSamplers = binding.pImmutableSamplers;
 		graphicsBindings[bindingCounter].stageFlags = binding.stageFlags;
 		bindingCounter++;
@@ -107,7 +64,7 @@ void CGraphicsDescriptorManager::createDescriptorSetLayout_General(VkDescriptorS
         VkDescriptorSetLayoutBinding binding = VPUniformBufferObject::GetBinding();
         graphicsBindings[bindingCounter].binding = bindingCounter;
 		graphicsBindings[bindingCounter].descriptorCount = binding.descriptorCount;
-		graphicsBindings[bindingCounter].descriptorType = binding.descriptorType;
+		graphicsBindings[bindingCounter].descriptorType = descriptorBackend.UseDynamicUniformBuffers() ? binding.descriptorType : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		graphicsBindings[bindingCounter].pImmutableSamplers = binding.pImmutableSamplers;
 		graphicsBindings[bindingCounter].stageFlags = binding.stageFlags;
 		bindingCounter++;
@@ -128,9 +85,11 @@ void CGraphicsDescriptorManager::createDescriptorSetLayout_General(VkDescriptorS
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = static_cast<uint32_t>(graphicsBindings.size());
 	layoutInfo.pBindings = graphicsBindings.data();
+	layoutInfo.flags = descriptorBackend.GetSetLayoutFlags(false);
 
 	VkResult result = vkCreateDescriptorSetLayout(CContext::GetHandle().GetLogicalDevice(), &layoutInfo, nullptr, OUT &descriptorSetLayout_general);
 	if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor set layout!");
+	if(layoutInfo.flags == 0) descriptorAllocator.RegisterLayout(descriptorSetLayout_general, graphicsBindings, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
 	//REPORT("vkCreateDescriptorSetLayout");
     //std::cout<<"created bindings DONE"<<std::endl;
 }
@@ -155,9 +114,11 @@ void CGraphicsDescriptorManager::createDescriptorSetLayout_TextureImageSampler()
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = static_cast<uint32_t>(graphicsBindings.size());
 	layoutInfo.pBindings = graphicsBindings.data();
+	layoutInfo.flags = descriptorBackend.GetSetLayoutFlags(true);
 
 	VkResult result = vkCreateDescriptorSetLayout(CContext::GetHandle().GetLogicalDevice(), &layoutInfo, nullptr, OUT &descriptorSetLayout_textureImageSampler);
 	if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor set layout!");
+	if(layoutInfo.flags == 0) descriptorAllocator.RegisterLayout(descriptorSetLayout_textureImageSampler, graphicsBindings, std::max(expectedObjectCount, 1u));
 }
 
 /************
@@ -167,122 +128,79 @@ void CGraphicsDescriptorManager::createDescriptorSets_General(VkImageView depthI
 //Descriptor Step 3/3
     //HERE_I_AM("wxjCreateDescriptorSets");
 
-    int descriptorSize = getSetSize_General();
     //std::cout<<"Set(Graphics, Non-sampler) size = "<<getSetSize()<<std::endl;
-
-    VkResult result = VK_SUCCESS;
-
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout_general);///!!!
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = graphicsDescriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);///!!!
-    allocInfo.pSetLayouts = layouts.data();
+    m_depthImageView = depthImageView;
+    if(graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE) std::cout<<"createDescriptorSets_General():GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE"<<std::endl;
+    if(descriptorBackend.mode == CDescriptorBackend::MODE_DESCRIPTOR_BUFFER) return; //objects write their own set 0 regions
 
     descriptorSets_general.resize(MAX_FRAMES_IN_FLIGHT);///!!!
-    //Step 3
-    result = vkAllocateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), &allocInfo, descriptorSets_general.data());
-    if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate descriptor sets!");
-
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {///!!!
-        std::vector<VkWriteDescriptorSet> descriptorWrites;
-        //VkDescriptorBufferInfo storageBufferInfoLastFrame{}; //for compute shader
-        //VkDescriptorBufferInfo storageBufferInfoCurrentFrame{}; //for compute shader
-
-        descriptorWrites.resize(descriptorSize);
-        int counter = 0;
-
-        VkDescriptorBufferInfo customBufferInfo{}; //for custom uniform
-        if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_CUSTOM){
-            customBufferInfo.buffer = customUniformBuffers[i].buffer;
-            customBufferInfo.offset = 0;
-            customBufferInfo.range = m_customUniformBufferSize;
-            descriptorWrites[counter].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[counter].dstSet = descriptorSets_general[i];
-            descriptorWrites[counter].dstBinding = counter;
-            descriptorWrites[counter].dstArrayElement = 0;
-            descriptorWrites[counter].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[counter].descriptorCount = 1;
-            descriptorWrites[counter].pBufferInfo = &customBufferInfo;
-            counter++;
-        }
+        std::vector<CDescriptorCache::Binding> bindings;
+        getBindings_General(i, 0, bindings);
 
-        VkDescriptorBufferInfo lightingBufferInfo{}; //for lighting uniform
-        if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_LIGHTING){
-            lightingBufferInfo.buffer = m_lightingUniformBuffers[i].buffer;
-            lightingBufferInfo.offset = 0;
-            lightingBufferInfo.range = m_lightingUniformBufferSize;
-            descriptorWrites[counter].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[counter].dstSet = descriptorSets_general[i];
-            descriptorWrites[counter].dstBinding = counter;
-            descriptorWrites[counter].dstArrayElement = 0;
-            descriptorWrites[counter].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[counter].descriptorCount = 1;
-            descriptorWrites[counter].pBufferInfo = &lightingBufferInfo;
-            counter++;
-        }
+        //Step 4: per frame buffers differ, so these are misses; frames with identical contents share one set
+        descriptorSets_general[i] = descriptorCache.GetOrCreate(descriptorSetLayout_general, bindings);
+    }
 
-        VkDescriptorBufferInfo mvpBufferInfo{}; //for mvp
-        if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_MVP){ //TODO: Getbinding
-            mvpBufferInfo.buffer = mvpUniformBuffers[i].buffer;
-            mvpBufferInfo.offset = 0;
-            //sizeof(MVPUniformBufferObject) is 512, including 2 mvp matrices. We only use one at a time.
-            //spec requires alighment to be multiple of 256 (1080 TI). Maybe change this later?
-            mvpBufferInfo.range = 256;
-            descriptorWrites[counter].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[counter].dstSet = descriptorSets_general[i];
-            descriptorWrites[counter].dstBinding = counter;
-            descriptorWrites[counter].dstArrayElement = 0;
-            descriptorWrites[counter].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-            descriptorWrites[counter].descriptorCount = 1;
-            descriptorWrites[counter].pBufferInfo = &mvpBufferInfo;
-            counter++;
-        }
-        VkDescriptorBufferInfo vpBufferInfo{}; //for vp
-        if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_VP){
-            vpBufferInfo.buffer = vpUniformBuffers[i].buffer;
-            vpBufferInfo.offset = 0;
-            vpBufferInfo.range = sizeof(VPUniformBufferObject);
-            descriptorWrites[counter].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[counter].dstSet = descriptorSets_general[i];
-            descriptorWrites[counter].dstBinding = counter;
-            descriptorWrites[counter].dstArrayElement = 0;
-            descriptorWrites[counter].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-            descriptorWrites[counter].descriptorCount = 1;
-            descriptorWrites[counter].pBufferInfo = &vpBufferInfo;
-            counter++;
-        }
-        VkDescriptorImageInfo imageInfo{}; //for depth sampler
-        if(graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE){
-            std::cout<<"createDescriptorSets_General():GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE"<<std::endl;
-
-            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;//VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;//VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;//VK_IMAGE_LAYOUT_GENERAL; 
-            imageInfo.imageView = depthImageView; //depth image from swapchain
-            imageInfo.sampler = depthImageSampler; 
-
-            // if(j < m_texture_ids.size()){
-            //     imageInfo[j].imageView = p_textureManager->textureImages[m_texture_ids[j]].m_textureImageBuffer.view;
-            //     imageInfo[j].sampler = samplers[p_textureManager->textureImages[m_texture_ids[j]].m_sampler_id]; 
-            // }else{ //There are more samplers than textures for this object, so use the first texture to fill other samplers
-            //     imageInfo[j].imageView = p_textureManager->textureImages[m_texture_ids[0]].m_textureImageBuffer.view;
-            //     imageInfo[j].sampler = samplers[p_textureManager->textureImages[m_texture_ids[0]].m_sampler_id]; 
-            // }
-            descriptorWrites[counter].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[counter].dstSet = descriptorSets_general[i];
-            descriptorWrites[counter].dstBinding = counter;
-            descriptorWrites[counter].dstArrayElement = 0;
-            descriptorWrites[counter].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrites[counter].descriptorCount = 1;
-            descriptorWrites[counter].pImageInfo = &imageInfo;
-            //counter++;
-        }
+    std::cout<<"createDescriptorSets_General():done"<<std::endl;
+}
 
-        //Step 4
-        vkUpdateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+void CGraphicsDescriptorManager::getBindings_General(size_t frame, int object_id, std::vector<CDescriptorCache::Binding> &bindings){
+    //dynamic uniform buffers get their offset at bind time (256 * object id, see CRenderer::BindDescriptorSets)
+    VkDescriptorType dynamicType = descriptorBackend.UseDynamicUniformBuffers() ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    VkDeviceSize dynamicOffset = descriptorBackend.UseDynamicUniformBuffers() ? 0 : 256 * (VkDeviceSize)object_id;
+    bindings.clear();
+    uint32_t counter = 0;
+
+    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_CUSTOM){ //for custom uniform
+        CDescriptorCache::Binding binding;
+        binding.binding = counter++;
+        binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        binding.buffer = customUniformBuffers[frame].buffer;
+        binding.offset = 0;
+        binding.range = m_customUniformBufferSize;
+        bindings.push_back(binding);
+    }
 
+    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_LIGHTING){ //for lighting uniform
+        CDescriptorCache::Binding binding;
+        binding.binding = counter++;
+        binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        binding.buffer = m_lightingUniformBuffers[frame].buffer;
+        binding.offset = 0;
+        binding.range = m_lightingUniformBufferSize;
+        bindings.push_back(binding);
     }
 
-    std::cout<<"createDescriptorSets_General():done"<<std::endl;
+    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_MVP){ //for mvp. TODO: Getbinding
+        CDescriptorCache::Binding binding;
+        binding.binding = counter++;
+        binding.type = dynamicType;
+        binding.buffer = mvpUniformBuffers[frame].buffer;
+        binding.offset = dynamicOffset;
+        //sizeof(MVPUniformBufferObject) is 512, including 2 mvp matrices. We only use one at a time.
+        //spec requires alighment to be multiple of 256 (1080 TI). Maybe change this later?
+        binding.range = 256;
+        bindings.push_back(binding);
+    }
+    if(graphicsUniformTypes & GRAPHCIS_UNIFORMBUFFER_VP){ //for vp
+        CDescriptorCache::Binding binding;
+        binding.binding = counter++;
+        binding.type = dynamicType;
+        binding.buffer = vpUniformBuffers[frame].buffer;
+        binding.offset = 0; //one VP for all objects
+        binding.range = sizeof(VPUniformBufferObject);
+        bindings.push_back(binding);
+    }
+    if(graphicsUniformTypes & GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE){ //for depth sampler
+        CDescriptorCache::Binding binding;
+        binding.binding = counter++;
+        binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;//VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;//VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;//VK_IMAGE_LAYOUT_GENERAL; 
+        binding.imageView = m_depthImageView; //depth image from swapchain
+        binding.sampler = depthImageSampler; 
+        bindings.push_back(binding);
+    }
 }
 
 
@@ -302,7 +220,7 @@ void CGraphicsDescriptorManager::addCustomUniformBuffer(VkDeviceSize customUnifo
 	m_customUniformBufferSize = customUniformBufferSize;
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		VkResult result = customUniformBuffers[i].init(m_customUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		VkResult result = customUniformBuffers[i].init(m_customUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | descriptorBackend.GetUniformBufferUsage(), {}, descriptorBackend.GetUniformMemoryFlags());
 		vkMapMemory(CContext::GetHandle().GetLogicalDevice(), customUniformBuffers[i].deviceMemory, 0, m_customUniformBufferSize, 0, &customUniformBuffersMapped[i]);
 	}
 }
@@ -326,7 +244,7 @@ void CGraphicsDescriptorManager::addLightingUniformBuffer(){
     //std::cout<<"addLightingUniformBuffer::m_lightingUniformBufferSize = " << m_lightingUniformBufferSize<<std::endl;
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		VkResult result = m_lightingUniformBuffers[i].init( m_lightingUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		VkResult result = m_lightingUniformBuffers[i].init( m_lightingUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | descriptorBackend.GetUniformBufferUsage(), {}, descriptorBackend.GetUniformMemoryFlags());
 		vkMapMemory(CContext::GetHandle().GetLogicalDevice(), m_lightingUniformBuffers[i].deviceMemory, 0,  m_lightingUniformBufferSize, 0, & m_lightingUniformBuffersMapped[i]);
 	}
 }
@@ -346,7 +264,7 @@ void CGraphicsDescriptorManager::addMVPUniformBuffer(){
     mvpUniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkResult result = mvpUniformBuffers[i].init(sizeof(MVPUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        VkResult result = mvpUniformBuffers[i].init(sizeof(MVPUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | descriptorBackend.GetUniformBufferUsage(), {}, descriptorBackend.GetUniformMemoryFlags());
         vkMapMemory(CContext::GetHandle().GetLogicalDevice(), mvpUniformBuffers[i].deviceMemory, 0, sizeof(MVPUniformBufferObject), 0, &mvpUniformBuffersMapped[i]);
     }
 }
@@ -365,7 +283,7 @@ void CGraphicsDescriptorManager::addVPUniformBuffer(){
     vpUniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkResult result = vpUniformBuffers[i].init(sizeof(VPUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        VkResult result = vpUniformBuffers[i].init(sizeof(VPUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | descriptorBackend.GetUniformBufferUsage(), {}, descriptorBackend.GetUniformMemoryFlags());
         vkMapMemory(CContext::GetHandle().GetLogicalDevice(), vpUniformBuffers[i].deviceMemory, 0, sizeof(VPUniformBufferObject), 0, &vpUniformBuffersMapped[i]);
     }
 }
@@ -379,45 +297,14 @@ bool CGraphicsDescriptorManager::CheckMVP(){ //to check if all objects associate
 * 5 GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE
 ************/
 std::vector<VkSampler> CGraphicsDescriptorManager::textureImageSamplers;
-void CGraphicsDescriptorManager::addTextureImageSamplerUniformBuffer(std::vector<int> mipLevels){
+void CGraphicsDescriptorManager::addTextureImageSamplerUniformBuffer(std::vector<CSamplerCache::Key> samplerKeys){
     graphicsUniformTypes |= GRAPHCIS_COMBINEDIMAGESAMPLER_TEXTUREIMAGE;//non-static content
     //std::cout<<"addImageSamplerUniformBuffer::uniformBufferUsageFlags = " << uniformBufferUsageFlags<<std::endl;
 
-    textureImageSamplerSize = mipLevels.size();
-
-    for(int i = 0; i < mipLevels.size(); i++){
-        VkPhysicalDeviceProperties properties{};
-        vkGetPhysicalDeviceProperties(CContext::GetHandle().GetPhysicalDevice(), &properties);
-
-        VkSamplerCreateInfo samplerInfo{};
-        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        samplerInfo.magFilter = VK_FILTER_LINEAR;
-        samplerInfo.minFilter = VK_FILTER_LINEAR;
-        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.anisotropyEnable = VK_TRUE;
-        samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-        samplerInfo.unnormalizedCoordinates = VK_FALSE;
-        samplerInfo.compareEnable = VK_FALSE;
-        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-
-        if (mipLevels[i] > 1) {
-            //std::cout<<"Sampler MipLevels = "<< mipLevels<<"(>1). Enable mipmap for all textures using this sampler"<<std::endl;
-            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;// VK_SAMPLER_MIPMAP_MODE_NEAREST;
-            samplerInfo.minLod = 0.0f;
-            samplerInfo.maxLod = static_cast<float>(mipLevels[i] / 2);
-            samplerInfo.mipLodBias = 0.0f;
-        }
+    textureImageSamplerSize = samplerKeys.size();
 
-        VkSampler sampler;
-        VkResult result = vkCreateSampler(CContext::GetHandle().GetLogicalDevice(), &samplerInfo, nullptr, &sampler);
-        //textureSamplers[textureSamplerCount++]
-        textureImageSamplers.push_back(sampler);
-        //samplerCount++;
-        //REPORT("vkCreateSampler");
-    }
+    for(int i = 0; i < samplerKeys.size(); i++)
+        textureImageSamplers.push_back(samplerCache.GetOrCreate(samplerKeys[i]));
 }
 
 /************
@@ -428,35 +315,10 @@ void CGraphicsDescriptorManager::addDepthImageSamplerUniformBuffer(){
     CGraphicsDescriptorManager::graphicsUniformTypes |= GRAPHCIS_COMBINEDIMAGESAMPLER_DEPTHIMAGE;
     std::cout<<"depthImageSampler()" << std::endl;
 
-    VkPhysicalDeviceProperties properties{};
-    vkGetPhysicalDeviceProperties(CContext::GetHandle().GetPhysicalDevice(), &properties);
-
-    VkSamplerCreateInfo samplerInfo{};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-
-    // if (mipLevels[i] > 1) {
-    //     //std::cout<<"Sampler MipLevels = "<< mipLevels<<"(>1). Enable mipmap for all textures using this sampler"<<std::endl;
-    //     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;// VK_SAMPLER_MIPMAP_MODE_NEAREST;
-    //     samplerInfo.minLod = 0.0f;
-    //     samplerInfo.maxLod = static_cast<float>(mipLevels[i] / 2);
-    //     samplerInfo.mipLodBias = 0.0f;
-    // }
-
-    //VkSampler sampler;
-    VkResult result = vkCreateSampler(CContext::GetHandle().GetLogicalDevice(), &samplerInfo, nullptr, &depthImageSampler);
-    //textureSamplers[textureSamplerCount++]
-    //textureImageSamplers.push_back(sampler);
+    CSamplerCache::Key key; //depth images have a single level
+    key.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    key.maxLod = 0.0f;
+    depthImageSampler = samplerCache.GetOrCreate(key);
 }
 
 
@@ -486,9 +348,9 @@ int CGraphicsDescriptorManager::getSetSize_General(){
     return getLayoutSize_General();
 }
 void CGraphicsDescriptorManager::DestroyAndFree(){
-    for(int i = 0; i < textureImageSamplers.size(); i++)
-        vkDestroySampler(CContext::GetHandle().GetLogicalDevice(), textureImageSamplers[i], nullptr);
-    vkDestroySampler(CContext::GetHandle().GetLogicalDevice(), depthImageSampler, nullptr);
+    //texture and depth samplers may be shared, they are destroyed once by the cache
+    std::cout<<"Sampler cache: "<<samplerCache.GetSamplerCount()<<" samplers, "<<samplerCache.cacheHitCount<<" hits, "<<samplerCache.cacheMissCount<<" misses"<<std::endl;
+    samplerCache.Destroy();
     
     for (size_t i = 0; i < customUniformBuffers.size(); i++) 
         customUniformBuffers[i].DestroyAndFree();
@@ -502,8 +364,13 @@ void CGraphicsDescriptorManager::DestroyAndFree(){
     for (size_t i = 0; i < m_lightingUniformBuffers.size(); i++) 
         m_lightingUniformBuffers[i].DestroyAndFree();
     
-    //no need to destroy descriptorSets, because they are from descriptorPool
-    vkDestroyDescriptorPool(CContext::GetHandle().GetLogicalDevice(), graphicsDescriptorPool, nullptr);//to be move to base class
+    //no need to destroy descriptorSets, because they are from descriptorAllocator's pools
+    CDescriptorAllocator::Stats stats = descriptorAllocator.GetStats();
+    std::cout<<"Descriptor cache: "<<descriptorCache.GetEntryCount()<<" sets, "<<descriptorCache.cacheHitCount<<" hits, "<<descriptorCache.cacheMissCount<<" misses, "
+        <<descriptorCache.recycledCount<<" recycled; pools: "<<stats.poolCount<<", "<<stats.setsAllocated<<"/"<<stats.setCapacity<<" sets used"<<std::endl;
+    descriptorCache.Clear();
+    descriptorAllocator.Destroy();
+    descriptorBackend.Destroy();
     vkDestroyDescriptorSetLayout(CContext::GetHandle().GetLogicalDevice(), descriptorSetLayout_general, nullptr);
     vkDestroyDescriptorSetLayout(CContext::GetHandle().GetLogicalDevice(), descriptorSetLayout_textureImageSampler, nullptr);
 }
@@ -17,10 +17,9 @@ void CWxjImageBuffer::createImage(uint32_t width, uint32_t height, uint32_t mipL
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = mipLevels;
     if(bCubeMap){
-        //imageInfo.extent.width = width / 6; //horizontal skybox
-        //imageInfo.extent.height = height;
-        imageInfo.extent.width = width / 4; //standard skybox
-	    imageInfo.extent.height = height / 3;
+        //width x height is one face, CCubemapFaces unpacks cross/equirect sources before upload
+        imageInfo.extent.width = width;
+	    imageInfo.extent.height = height;
         imageInfo.arrayLayers = 6; //for cubemap
         imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;//for cubemap
     }else{
@@ -28,6 +27,7 @@ void CWxjImageBuffer::createImage(uint32_t width, uint32_t height, uint32_t mipL
         imageInfo.extent.height = height;
         imageInfo.arrayLayers = 1;
     }
+    imageInfo.flags |= createFlags;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -53,6 +53,10 @@ void CWxjImageBuffer::createImage(uint32_t width, uint32_t height, uint32_t mipL
     }
 
     size = allocInfo.allocationSize;
+    memoryType = allocInfo.memoryTypeIndex;
+    static CMetrics::Gauge &liveImages = CMetrics::GetGauge("vk_images_live", "Images created by CWxjImageBuffer and not destroyed");
+    liveImages.Add(1);
+    CMetrics::TrackGpuMemory(memoryType, (int64_t)size);
 
     vkBindImageMemory(CContext::GetHandle().GetLogicalDevice(), image, deviceMemory, 0);
 }
@@ -158,6 +162,9 @@ void CWxjImageBuffer::destroy(){
     if(size != (VkDeviceSize)0){
         vkDestroyImage(CContext::GetHandle().GetLogicalDevice(), image, nullptr);
         vkFreeMemory(CContext::GetHandle().GetLogicalDevice(), deviceMemory, nullptr);
+        static CMetrics::Gauge &liveImages = CMetrics::GetGauge("vk_images_live", "Images created by CWxjImageBuffer and not destroyed");
+        liveImages.Add(-1);
+        CMetrics::TrackGpuMemory(memoryType, -(int64_t)size);
         if(view != NULL)
             vkDestroyImageView(CContext::GetHandle().GetLogicalDevice(), view, nullptr);
     }
@@ -0,0 +1,199 @@
+#include "../include/imageWriter.h"
+
+static bool IsBGRA(VkFormat format){
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+static bool IsSRGB(VkFormat format){
+    return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+bool CImageWriter::IsSupportedFormat(VkFormat format){
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB
+        || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+void CImageWriter::ToRGBA8(uint32_t width, uint32_t height, VkFormat format, const void *pixels, std::vector<uint8_t> &rgba){
+    const uint8_t *src = (const uint8_t*)pixels;
+    size_t count = (size_t)width * height;
+    rgba.resize(count * 4);
+    bool bBGRA = IsBGRA(format);
+    for(size_t i = 0; i < count; i++){
+        rgba[i * 4 + 0] = src[i * 4 + (bBGRA ? 2 : 0)];
+        rgba[i * 4 + 1] = src[i * 4 + 1];
+        rgba[i * 4 + 2] = src[i * 4 + (bBGRA ? 0 : 2)];
+        rgba[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+bool CImageWriter::Write(const std::string &path, uint32_t width, uint32_t height, VkFormat format, const void *pixels){
+    if(!IsSupportedFormat(format)){
+        std::cout<<"ImageWriter: unsupported format "<<format<<" for "<<path<<std::endl;
+        return false;
+    }
+    std::vector<uint8_t> rgba;
+    ToRGBA8(width, height, format, pixels, rgba);
+
+    bool bEXR = path.size() >= 4 && path.compare(path.size() - 4, 4, ".exr") == 0;
+    if(!bEXR) return WritePNG(path, width, height, rgba.data());
+
+    float table[256]; //8 bit to linear
+    for(int i = 0; i < 256; i++){
+        float c = i / 255.0f;
+        table[i] = IsSRGB(format) ? ((c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+    }
+    std::vector<float> linear(rgba.size());
+    for(size_t i = 0; i < rgba.size(); i++) linear[i] = ((i & 3) == 3) ? rgba[i] / 255.0f : table[rgba[i]]; //alpha is always linear
+    return WriteEXR(path, width, height, linear.data());
+}
+
+/*******************
+*	PNG
+********************/
+static uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0xffffffffu){
+    static uint32_t table[256];
+    static bool bTable = false;
+    if(!bTable){
+        for(uint32_t n = 0; n < 256; n++){
+            uint32_t c = n;
+            for(int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        bTable = true;
+    }
+    for(size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void PutBE32(std::vector<uint8_t> &out, uint32_t value){
+    out.push_back((uint8_t)(value >> 24)); out.push_back((uint8_t)(value >> 16));
+    out.push_back((uint8_t)(value >> 8)); out.push_back((uint8_t)value);
+}
+
+static void WriteChunk(std::ofstream &stream, const char *type, const std::vector<uint8_t> &data){
+    std::vector<uint8_t> chunk;
+    PutBE32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    PutBE32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4) ^ 0xffffffffu);
+    stream.write((const char*)chunk.data(), chunk.size());
+}
+
+bool CImageWriter::WritePNG(const std::string &path, uint32_t width, uint32_t height, const uint8_t *rgba){
+    std::ofstream stream(path, std::ios::binary);
+    if(!stream.is_open()){
+        std::cout<<"ImageWriter: could not open "<<path<<std::endl;
+        return false;
+    }
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    stream.write((const char*)signature, 8);
+
+    std::vector<uint8_t> header;
+    PutBE32(header, width);
+    PutBE32(header, height);
+    header.push_back(8); //bit depth
+    header.push_back(6); //RGBA
+    header.push_back(0); header.push_back(0); header.push_back(0); //deflate, adaptive filtering, no interlace
+    WriteChunk(stream, "IHDR", header);
+
+    //scanlines with filter type 0, in a zlib stream of stored blocks
+    size_t rowSize = (size_t)width * 4 + 1;
+    std::vector<uint8_t> raw(rowSize * height);
+    for(uint32_t y = 0; y < height; y++){
+        raw[y * rowSize] = 0;
+        memcpy(&raw[y * rowSize + 1], rgba + (size_t)y * width * 4, (size_t)width * 4);
+    }
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    uint32_t adlerA = 1, adlerB = 0;
+    for(size_t offset = 0; offset < raw.size() || offset == 0; ){
+        uint16_t blockSize = (uint16_t)std::min(raw.size() - offset, (size_t)65535);
+        bool bFinal = offset + blockSize >= raw.size();
+        zlib.push_back(bFinal ? 1 : 0);
+        zlib.push_back((uint8_t)(blockSize & 0xff)); zlib.push_back((uint8_t)(blockSize >> 8));
+        zlib.push_back((uint8_t)(~blockSize & 0xff)); zlib.push_back((uint8_t)((uint16_t)~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        for(size_t i = offset; i < offset + blockSize; i++){
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        offset += blockSize;
+        if(bFinal) break;
+    }
+    PutBE32(zlib, (adlerB << 16) | adlerA);
+    WriteChunk(stream, "IDAT", zlib);
+    WriteChunk(stream, "IEND", {});
+    return (bool)stream;
+}
+
+/*******************
+*	OpenEXR
+********************/
+template <typename T>
+static void PutLE(std::vector<uint8_t> &out, T value){
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(&value); //the file format and all supported platforms are little endian
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+static void PutAttribute(std::vector<uint8_t> &out, const char *name, const char *type, const std::vector<uint8_t> &value){
+    out.insert(out.end(), name, name + strlen(name) + 1);
+    out.insert(out.end(), type, type + strlen(type) + 1);
+    PutLE<int32_t>(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+bool CImageWriter::WriteEXR(const std::string &path, uint32_t width, uint32_t height, const float *rgba){
+    std::ofstream stream(path, std::ios::binary);
+    if(!stream.is_open()){
+        std::cout<<"ImageWriter: could not open "<<path<<std::endl;
+        return false;
+    }
+    const char *channelNames[4] = {"A", "B", "G", "R"}; //channels are stored in alphabetical order
+    const int channelOffsets[4] = {3, 2, 1, 0};
+
+    std::vector<uint8_t> header;
+    PutLE<uint32_t>(header, 20000630); //magic
+    PutLE<uint32_t>(header, 2);        //version 2, single part scanline
+
+    std::vector<uint8_t> value;
+    for(int c = 0; c < 4; c++){
+        value.push_back((uint8_t)channelNames[c][0]); value.push_back(0);
+        PutLE<int32_t>(value, 2); //FLOAT
+        PutLE<uint32_t>(value, 0); //pLinear + reserved
+        PutLE<int32_t>(value, 1); PutLE<int32_t>(value, 1); //x/y sampling
+    }
+    value.push_back(0);
+    PutAttribute(header, "channels", "chlist", value);
+    PutAttribute(header, "compression", "compression", {0}); //NO_COMPRESSION
+    value.clear();
+    PutLE<int32_t>(value, 0); PutLE<int32_t>(value, 0); PutLE<int32_t>(value, (int32_t)width - 1); PutLE<int32_t>(value, (int32_t)height - 1);
+    PutAttribute(header, "dataWindow", "box2i", value);
+    PutAttribute(header, "displayWindow", "box2i", value);
+    PutAttribute(header, "lineOrder", "lineOrder", {0}); //INCREASING_Y
+    value.clear(); PutLE<float>(value, 1.0f);
+    PutAttribute(header, "pixelAspectRatio", "float", value);
+    value.clear(); PutLE<float>(value, 0.0f); PutLE<float>(value, 0.0f);
+    PutAttribute(header, "screenWindowCenter", "v2f", value);
+    value.clear(); PutLE<float>(value, 1.0f);
+    PutAttribute(header, "screenWindowWidth", "float", value);
+    header.push_back(0);
+
+    //offset table, then one chunk per scanline: y, size, channel planes
+    uint32_t lineDataSize = width * 4 * sizeof(float);
+    uint64_t chunkOffset = header.size() + (uint64_t)height * sizeof(uint64_t);
+    for(uint32_t y = 0; y < height; y++){
+        PutLE<uint64_t>(header, chunkOffset);
+        chunkOffset += 8 + lineDataSize;
+    }
+    stream.write((const char*)header.data(), header.size());
+
+    std::vector<uint8_t> line;
+    for(uint32_t y = 0; y < height; y++){
+        line.clear();
+        PutLE<int32_t>(line, (int32_t)y);
+        PutLE<int32_t>(line, (int32_t)lineDataSize);
+        for(int c = 0; c < 4; c++)
+            for(uint32_t x = 0; x < width; x++) PutLE<float>(line, rgba[((size_t)y * width + x) * 4 + channelOffsets[c]]);
+        stream.write((const char*)line.data(), line.size());
+    }
+    return (bool)stream;
+}
@@ -0,0 +1,106 @@
+#include "../include/inputLog.h"
+
+#include <charconv>
+#include <iomanip>
+#include <sstream>
+
+void CInputLog::Push(Action action, int32_t axis, float x, float y){
+    if(bReplaying) return;
+    if(action == CAMERA_ANGULAR_VELOCITY){
+        if(m_bLookValid && x == m_lastLook[0] && y == m_lastLook[1]) return;
+        m_lastLook[0] = x;
+        m_lastLook[1] = y;
+        m_bLookValid = true;
+    }
+    if(action == CAMERA_TOGGLE_TYPE) m_bLookValid = false; //a camera that becomes FREE needs the next mouse look even if unchanged
+    if(m_pending.empty()) m_pendingTime = std::chrono::steady_clock::now();
+    m_pending.push_back({0, action, axis, x, y});
+}
+
+void CInputLog::Collect(uint64_t step, std::vector<Event> &events){
+    events.clear();
+    if(bReplaying){
+        while(!m_pending.empty() && m_pending.front().step <= step){
+            events.push_back(m_pending.front());
+            m_pending.pop_front();
+        }
+        return;
+    }
+    if(!m_pending.empty() && m_collectedTime == std::chrono::steady_clock::time_point()) m_collectedTime = m_pendingTime;
+    for(auto &event : m_pending){
+        event.step = step;
+        events.push_back(event);
+        if(bRecording) m_recorded.push_back(event);
+    }
+    m_pending.clear();
+}
+
+std::chrono::steady_clock::time_point CInputLog::TakeInputTime(){
+    std::chrono::steady_clock::time_point time = m_collectedTime;
+    m_collectedTime = std::chrono::steady_clock::time_point();
+    return time;
+}
+
+bool CInputLog::Record(const std::string &path, float fixedStep){
+    std::ofstream test(path); //fail now rather than after the run
+    if(!test.is_open()){
+        std::cout<<"InputLog: could not open "<<path<<std::endl;
+        return false;
+    }
+    m_path = path;
+    m_fixedStep = fixedStep;
+    m_recorded.clear();
+    bRecording = true;
+    return true;
+}
+
+bool CInputLog::Replay(const std::string &path, float fixedStep){
+    std::ifstream file(path);
+    std::string magic;
+    int version = 0;
+    float recordedStep = 0;
+    if(!(file>>magic>>version>>recordedStep) || magic != "inputlog" || version != 1){
+        std::cout<<"InputLog: "<<path<<" is not an input log"<<std::endl;
+        return false;
+    }
+    if(recordedStep != fixedStep)
+        std::cout<<"InputLog: "<<path<<" was recorded with fixed step "<<recordedStep<<", replaying with "<<fixedStep<<std::endl;
+
+    m_pending.clear();
+    std::string line;
+    int lineNumber = 0; //the first getline returns the rest of the header line
+    while(std::getline(file, line)){
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string first;
+        if(!(stream>>first)) continue;
+        if(first == "frames"){
+            if(!(stream>>recordedFrames)) std::cout<<"InputLog: "<<path<<":"<<lineNumber<<": malformed frame count, ignored"<<std::endl;
+            continue;
+        }
+        Event event;
+        uint32_t action;
+        auto [end, error] = std::from_chars(first.data(), first.data() + first.size(), event.step);
+        if(error != std::errc() || end != first.data() + first.size()
+            || !(stream>>action>>event.axis>>event.x>>event.y) || action >= ACTION_COUNT){
+            std::cout<<"InputLog: "<<path<<":"<<lineNumber<<": malformed event, skipped"<<std::endl;
+            continue;
+        }
+        event.action = (Action)action;
+        m_pending.push_back(event);
+    }
+    bReplaying = true;
+    std::cout<<"InputLog: replaying "<<m_pending.size()<<" events from "<<path<<std::endl;
+    return true;
+}
+
+void CInputLog::Save(uint64_t frames){
+    if(!bRecording) return;
+    std::ofstream file(m_path);
+    file<<"inputlog 1 "<<std::setprecision(9)<<m_fixedStep<<"\n";
+    for(auto &event : m_recorded) //9 significant digits round-trip a float
+        file<<event.step<<" "<<event.action<<" "<<event.axis<<" "<<event.x<<" "<<event.y<<"\n";
+    file<<"frames "<<frames<<"\n";
+    std::cout<<"InputLog: "<<m_recorded.size()<<" events, "<<frames<<" frames written to "<<m_path<<std::endl;
+    bRecording = false;
+}
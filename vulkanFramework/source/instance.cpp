@@ -1,7 +1,7 @@
 #include "../include/instance.h"
 
 #ifdef ANDROID
-#include "..\\..\\androidFramework\\include\\androidFileManager.h"
+#include "../../androidFramework/include/androidFileManager.h"
 #endif
 
 CInstance::CInstance(const std::vector<const char*> &requiredValidationLayers, std::vector<const char*> &requiredExtensions){
@@ -15,7 +15,12 @@ CInstance::CInstance(const std::vector<const char*> &requiredValidationLayers, s
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    //1.1 when the loader has it (subgroup operations, vkGetPhysicalDeviceProperties2); a 1.0 loader rejects anything newer
+    PFN_vkEnumerateInstanceVersion pEnumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    if(pEnumerateInstanceVersion) pEnumerateInstanceVersion(&loaderVersion);
+    apiVersion = (loaderVersion >= VK_API_VERSION_1_1) ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
+    appInfo.apiVersion = apiVersion;
 
 #ifndef ANDROID
     //First make sure required layer(s) are available
@@ -161,6 +166,7 @@ void CInstance::findAllPhysicalDevices(){
     for (auto &physical_device : devices){
         //gpus.push_back(std::make_unique<CPhysicalDevice>(*this, physical_device));
         physicalDevices.push_back(std::make_unique<CPhysicalDevice>(physical_device));
+        physicalDevices.back().get()->instanceApiVersion = apiVersion;
         physicalDevices.back().get()->displayPhysicalDevices();
     }
 
@@ -183,7 +189,8 @@ std::unique_ptr<CPhysicalDevice>* CInstance::pickSuitablePhysicalDevice(VkSurfac
         bool extensionsSupported = phy_device->checkDeviceExtensionSupport(requireDeviceExtensions);
 
         bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        if (extensionsSupported && surface == VK_NULL_HANDLE) swapChainAdequate = true; //headless: offscreen images, no swapchain
+        else if (extensionsSupported) {
             //Test SwapChain
             SwapChainSupportDetails swapChainSupport = phy_device->querySwapChainSupport(surface);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
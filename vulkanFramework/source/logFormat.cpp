@@ -0,0 +1,117 @@
+#include "../include/logFormat.h"
+
+#include <stdio.h>
+#include <cstring>
+#include <cctype>
+
+static const char *levelNames[LOG_LEVEL_COUNT] = {"verbose", "info", "warning", "error"};
+static const char *categoryNames[LOG_CATEGORY_COUNT] = {"general", "device", "swapchain", "texture", "renderer"};
+
+const char *CLogFormat::GetLevelName(LogLevel level){ return level < LOG_LEVEL_COUNT ? levelNames[level] : "?"; }
+const char *CLogFormat::GetCategoryName(LogCategory category){ return category < LOG_CATEGORY_COUNT ? categoryNames[category] : "?"; }
+
+std::string CLogFormat::Format(const std::string &format, const std::vector<Arg> &args){
+    std::string out;
+    out.reserve(format.size() + args.size() * 8);
+    size_t next = 0;
+    char buffer[512];
+    for(size_t i = 0; i < format.size(); i++){
+        if(format[i] != '%'){
+            out.push_back(format[i]);
+            continue;
+        }
+        if(i + 1 < format.size() && format[i + 1] == '%'){
+            out.push_back('%');
+            i++;
+            continue;
+        }
+        //%[flags][width][.precision][length]conversion, the length is replaced by the argument's own
+        std::string spec = "%";
+        size_t j = i + 1;
+        while(j < format.size() && strchr("-+ #0", format[j])) spec.push_back(format[j++]);
+        while(j < format.size() && (isdigit((unsigned char)format[j]) || format[j] == '.')) spec.push_back(format[j++]);
+        while(j < format.size() && strchr("hlLqjzt", format[j])) j++;
+        if(j >= format.size()){
+            out.append(format, i, std::string::npos);
+            break;
+        }
+        char conversion = format[j];
+        i = j;
+        if(next >= args.size()){
+            out.append("<missing>");
+            continue;
+        }
+        const Arg &arg = args[next++];
+        switch(conversion){
+            case 'd': case 'i': case 'c':
+                if(arg.type == Arg::DOUBLE) snprintf(buffer, sizeof(buffer), (spec + "g").c_str(), arg.d);
+                else if(arg.type == Arg::STRING) snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), arg.s.c_str());
+                else if(conversion == 'c') snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int)arg.i);
+                else snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(), (long long)arg.i);
+            break;
+            case 'u': case 'x': case 'X': case 'o':
+                if(arg.type == Arg::DOUBLE) snprintf(buffer, sizeof(buffer), (spec + "g").c_str(), arg.d);
+                else if(arg.type == Arg::STRING) snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), arg.s.c_str());
+                else snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (unsigned long long)arg.u);
+            break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if(arg.type == Arg::STRING) snprintf(buffer, sizeof(buffer), "%s", arg.s.c_str());
+                else snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(),
+                    arg.type == Arg::DOUBLE ? arg.d : arg.type == Arg::INT ? (double)arg.i : (double)arg.u);
+            break;
+            case 's':
+                if(arg.type == Arg::STRING) snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), arg.s.c_str());
+                else if(arg.type == Arg::DOUBLE) snprintf(buffer, sizeof(buffer), "%g", arg.d);
+                else if(arg.type == Arg::INT) snprintf(buffer, sizeof(buffer), "%lld", (long long)arg.i);
+                else snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)arg.u);
+            break;
+            case 'p':
+                snprintf(buffer, sizeof(buffer), "%p", arg.p);
+            break;
+            default:
+                snprintf(buffer, sizeof(buffer), "<%%%c?>", conversion);
+            break;
+        }
+        //strings longer than the buffer are appended whole
+        if(conversion == 's' && arg.type == Arg::STRING && arg.s.size() >= sizeof(buffer) - 1) out.append(arg.s);
+        else out.append(buffer);
+    }
+    return out;
+}
+
+std::string CLogFormat::FormatList(const std::string &prefix, const std::vector<Arg> &args){
+    std::string out = prefix;
+    for(auto &arg : args) out.append(Format(arg.type == Arg::DOUBLE ? "%f, " : "%d, ", {arg}));
+    return out;
+}
+
+bool CLogFormat::DecodeArgs(const char *signature, const uint8_t *payload, size_t size, std::vector<Arg> &args){
+    size_t offset = 0;
+    for(const char *code = signature; *code; code++){
+        Arg arg;
+        if(*code == 's'){
+            uint32_t length;
+            if(offset + sizeof(length) > size) return false;
+            memcpy(&length, payload + offset, sizeof(length));
+            offset += sizeof(length);
+            if(offset + length > size) return false;
+            arg.type = Arg::STRING;
+            arg.s.assign((const char*)payload + offset, length);
+            offset += length;
+        }else{
+            if(offset + 8 > size) return false;
+            uint64_t value;
+            memcpy(&value, payload + offset, 8);
+            offset += 8;
+            switch(*code){
+                case 'i': arg.type = Arg::INT; arg.i = (int64_t)value; break;
+                case 'u': arg.type = Arg::UINT; arg.u = value; break;
+                case 'd': arg.type = Arg::DOUBLE; memcpy(&arg.d, &value, 8); break;
+                case 'p': arg.type = Arg::POINTER; arg.p = (const void*)(uintptr_t)value; break;
+                default: return false;
+            }
+        }
+        args.push_back(std::move(arg));
+    }
+    return (offset + 7) / 8 * 8 >= size; //only the padding to 8 bytes may follow
+}
@@ -0,0 +1,328 @@
+#include "../include/logger.h"
+
+#include <csignal>
+#include <exception>
+#include <sstream>
+#ifndef ANDROID
+#include <filesystem>
+#endif
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+std::atomic<uint32_t> CLogger::minLevel{LOG_LEVEL_VERBOSE};
+std::atomic<uint32_t> CLogger::categoryMask{0xffffffffu};
+CLogger::Record CLogger::s_pool[CLogger::POOL_SIZE];
+std::atomic<uint64_t> CLogger::s_freeHead{0};
+CLogger::Record CLogger::s_stub;
+std::atomic<CLogger::Record*> CLogger::s_head{&CLogger::s_stub};
+CLogger::Record *CLogger::s_tail = &CLogger::s_stub;
+std::atomic_flag CLogger::s_consuming = ATOMIC_FLAG_INIT;
+std::atomic<std::thread::id> CLogger::s_consumer{std::thread::id()};
+std::atomic<uint64_t> CLogger::s_pushed{0};
+std::atomic<uint64_t> CLogger::s_written{0};
+std::once_flag CLogger::s_startFlag;
+std::thread CLogger::s_writer;
+std::mutex CLogger::s_wakeMutex;
+std::condition_variable CLogger::s_wake;
+std::atomic<bool> CLogger::s_bQuit{false};
+std::atomic<bool> CLogger::s_bStopped{false};
+std::mutex CLogger::s_sinkMutex;
+std::vector<std::unique_ptr<CLogger::Sink>> CLogger::s_sinks;
+std::chrono::steady_clock::time_point CLogger::s_startTime = std::chrono::steady_clock::now();
+#ifdef ANDROID
+CAndroidLogManager CLogger::s_androidLog;
+#endif
+
+int CLogger::AddSink(const std::string &path){
+    std::lock_guard<std::mutex> lock(s_sinkMutex);
+    for(size_t i = 0; i < s_sinks.size(); i++) if(s_sinks[i]->path == path) return (int)i;
+#ifndef ANDROID
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if(!parent.empty()) std::filesystem::create_directories(parent, error);
+    s_sinks.push_back(std::make_unique<Sink>());
+    s_sinks.back()->path = path;
+    s_sinks.back()->file.createLogFile(path);
+    return (int)s_sinks.size() - 1;
+#else
+    return -1; //logcat
+#endif
+}
+
+/*******************
+*	Producers, any thread
+********************/
+CLogger::Record *CLogger::NewRecord(LogLevel level, LogCategory category, int sink, const std::string &format){
+    std::call_once(s_startFlag, Start);
+    Record *record = nullptr;
+    uint64_t head = s_freeHead.load(std::memory_order_acquire);
+    while((uint32_t)head != 0){
+        Record *candidate = &s_pool[(uint32_t)head - 1];
+        uint64_t next = ((head >> 32) + 1) << 32 | candidate->nextFree.load(std::memory_order_relaxed);
+        if(s_freeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)){
+            record = candidate;
+            break;
+        }
+    }
+    if(!record) record = new Record; //pool exhausted
+    record->bList = false;
+    record->args.clear();
+    record->level = level;
+    record->category = category;
+    record->sink = sink;
+    record->time = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_startTime).count();
+    record->format = format;
+    return record;
+}
+
+void CLogger::FreeRecord(Record *record){
+    if(record->poolIndex == NOT_POOLED){
+        delete record;
+        return;
+    }
+    uint64_t head = s_freeHead.load(std::memory_order_relaxed);
+    do{
+        record->nextFree.store((uint32_t)head, std::memory_order_relaxed);
+    }while(!s_freeHead.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | (record->poolIndex + 1), std::memory_order_release, std::memory_order_relaxed));
+}
+
+void CLogger::Enqueue(Record *record){
+    record->next.store(nullptr, std::memory_order_relaxed);
+    Record *previous = s_head.exchange(record, std::memory_order_acq_rel);
+    previous->next.store(record, std::memory_order_release); //until here the consumer sees the list end at previous
+}
+
+void CLogger::Push(Record *record){
+    bool bError = record->level >= LOG_LEVEL_ERROR; //the writer may free the record as soon as it is enqueued
+    s_pushed.fetch_add(1, std::memory_order_release);
+    Enqueue(record);
+
+    if(s_bStopped.load(std::memory_order_acquire)) Flush(); //no writer after Shutdown: the caller writes
+    else if(bError) s_wake.notify_one(); //errors often come right before the end, do not wait for the next batch
+}
+
+void CLogger::Flush(){
+    uint64_t target = s_pushed.load(std::memory_order_acquire);
+    if(s_bStopped.load(std::memory_order_acquire) || !s_writer.joinable()){
+        while(s_written.load(std::memory_order_acquire) < target){
+            if(!WriteBatch()) std::this_thread::yield(); //a record being pushed right now
+        }
+        return;
+    }
+    while(s_written.load(std::memory_order_acquire) < target){
+        s_wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+/*******************
+*	Consumer
+********************/
+CLogger::Record *CLogger::Pop(){
+    Record *tail = s_tail;
+    Record *next = tail->next.load(std::memory_order_acquire);
+    if(tail == &s_stub){
+        if(!next) return nullptr;
+        s_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if(next){
+        s_tail = next;
+        return tail;
+    }
+    if(tail != s_head.load(std::memory_order_acquire)) return nullptr; //a producer is between exchange and link
+    Enqueue(&s_stub); //tail is the last record: put the stub behind it so it can be handed out
+    next = tail->next.load(std::memory_order_acquire);
+    if(next){
+        s_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void CLogger::Start(){
+    for(uint32_t i = 0; i < POOL_SIZE; i++){
+        s_pool[i].poolIndex = i;
+        s_pool[i].nextFree.store(i + 1 < POOL_SIZE ? i + 2 : 0, std::memory_order_relaxed);
+    }
+    s_freeHead.store(1, std::memory_order_release);
+    s_writer = std::thread(WriterLoop);
+    std::atexit(Shutdown);
+    //crash: write what is queued, then let the default handler run
+    std::signal(SIGSEGV, OnSignal);
+    std::signal(SIGABRT, OnSignal);
+    std::signal(SIGFPE, OnSignal);
+    std::signal(SIGILL, OnSignal);
+    std::set_terminate([]{
+        CrashFlush();
+        std::abort();
+    });
+}
+
+void CLogger::WriterLoop(){
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(s_wakeMutex);
+            s_wake.wait_for(lock, std::chrono::milliseconds(2), []{ return s_bQuit.load(); });
+        }
+        bool bWritten = WriteBatch();
+        if(s_bQuit.load() && !bWritten && s_written.load() >= s_pushed.load()) break;
+    }
+}
+
+bool CLogger::WriteBatch(){
+    while(s_consuming.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    s_consumer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    uint64_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_sinkMutex);
+        while(Record *record = Pop()){
+            if(record == &s_stub) continue;
+            Write(*record);
+            FreeRecord(record);
+            count++;
+        }
+        WriteSinks();
+    }
+    s_written.fetch_add(count, std::memory_order_release);
+    s_consumer.store(std::thread::id(), std::memory_order_relaxed);
+    s_consuming.clear(std::memory_order_release);
+    return count > 0;
+}
+
+void CLogger::WriteSinks(){
+#ifndef ANDROID
+    for(auto &sink : s_sinks){
+        if(sink->batch.empty()) continue;
+        sink->file.printLog(sink->batch); //one write per file and batch
+        sink->file.flush();
+        sink->batch.clear();
+    }
+#endif
+}
+
+void CLogger::Write(Record &record){
+    std::string text = record.bList ? CLogFormat::FormatList(record.format, record.args) : CLogFormat::Format(record.format, record.args);
+
+#ifndef ANDROID
+    if(record.sink >= 0 && record.sink < (int)s_sinks.size()){
+        //files keep the layout they always had; the level is only marked when it is not info
+        std::string &batch = s_sinks[record.sink]->batch;
+        if(record.level != LOG_LEVEL_INFO) batch.append("[").append(CLogFormat::GetLevelName(record.level)).append("] ");
+        batch.append(text).append("\n");
+        return;
+    }
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "[%8.3f %s %s] ", record.time, CLogFormat::GetLevelName(record.level), CLogFormat::GetCategoryName(record.category));
+    std::cout<<prefix<<text<<"\n";
+    if(record.level >= LOG_LEVEL_WARNING) std::cout.flush();
+#else
+    s_androidLog.printLog(text);
+#endif
+}
+
+void CLogger::Shutdown(){
+    if(s_bStopped.load()) return;
+    if(s_writer.joinable()){
+        s_bQuit.store(true);
+        s_wake.notify_one();
+        s_writer.join();
+    }
+    s_bStopped.store(true, std::memory_order_release);
+    WriteBatch(); //anything pushed while the writer was stopping
+    std::cout.flush();
+}
+
+void CLogger::CrashFlush(){
+    static std::atomic<bool> bCrashing{false};
+    if(bCrashing.exchange(true)) return; //crashed again while flushing
+
+    //the queue has one consumer: take it once the writer's batch is done, or keep it if the crashing thread is the consumer.
+    //A consumer that is still busy after 200 ms is left alone, its records are lost
+    bool bOwnBatch = s_consumer.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    bool bConsumer = bOwnBatch;
+    for(int i = 0; !bConsumer && i < 200; i++){
+        bConsumer = !s_consuming.test_and_set(std::memory_order_acquire);
+        if(!bConsumer) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if(!bConsumer){
+        WriteRaw("Logger: crash while the writer is busy, queued records are lost\n");
+        return;
+    }
+
+    //the files need s_sinkMutex; its owner (this thread inside a batch, or AddSink) may never give it back
+    bool bSinks = false;
+    for(int i = 0; !bOwnBatch && !bSinks && i < 10; i++){
+        bSinks = s_sinkMutex.try_lock();
+        if(!bSinks) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint64_t count = 0;
+    while(Record *record = Pop()){ //not async-signal-safe, the log is worth the risk at this point
+        if(record == &s_stub) continue;
+        if(bSinks) Write(*record);
+        else{
+            char prefix[64];
+            snprintf(prefix, sizeof(prefix), "[%8.3f %s %s] ", record->time, CLogFormat::GetLevelName(record->level), CLogFormat::GetCategoryName(record->category));
+            WriteRaw(prefix + (record->bList ? CLogFormat::FormatList(record->format, record->args) : CLogFormat::Format(record->format, record->args)) + "\n");
+        }
+        FreeRecord(record);
+        count++;
+    }
+    if(bSinks){
+        WriteSinks();
+        s_sinkMutex.unlock();
+    }
+    s_written.fetch_add(count, std::memory_order_release);
+    if(!bOwnBatch) s_consuming.clear(std::memory_order_release); //ours: the writer (if alive) continues with later records
+    std::cout.flush();
+}
+
+void CLogger::WriteRaw(const std::string &text){
+#ifdef _WIN32
+    _write(2, text.data(), (unsigned)text.size());
+#else
+    ssize_t written = ::write(STDERR_FILENO, text.data(), text.size());
+    (void)written;
+#endif
+}
+
+void CLogger::OnSignal(int signal){
+    CrashFlush();
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+bool CLogger::ParseLevel(const std::string &name, LogLevel &level){
+    for(uint32_t i = 0; i < LOG_LEVEL_COUNT; i++){
+        if(name == CLogFormat::GetLevelName((LogLevel)i)){
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t CLogger::ParseCategories(const std::string &list){
+    if(list == "all") return 0xffffffffu;
+    uint32_t mask = 0;
+    std::stringstream stream(list);
+    std::string name;
+    while(std::getline(stream, name, ',')){
+        bool bFound = false;
+        for(uint32_t i = 0; i < LOG_CATEGORY_COUNT; i++){
+            if(name == CLogFormat::GetCategoryName((LogCategory)i)){
+                mask |= 1u << i;
+                bFound = true;
+            }
+        }
+        if(!bFound) std::cout<<"Logger: unknown category "<<name<<std::endl;
+    }
+    return mask;
+}
+
@@ -0,0 +1,271 @@
+#include "../include/metrics.h"
+#include "../include/context.h"
+
+#include <sstream>
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#define SEND_FLAGS 0
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET -1
+#define CLOSE_SOCKET close
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL //a scraper that disconnects early must not raise SIGPIPE and end the process
+#else
+#define SEND_FLAGS 0 //no MSG_NOSIGNAL (macOS): SO_NOSIGPIPE on the client socket instead
+#endif
+#endif
+
+bool CMetrics::bEnabled = false;
+uint16_t CMetrics::httpPort = 0;
+float CMetrics::logInterval = 0;
+std::mutex CMetrics::s_mutex;
+std::map<std::pair<std::string, std::string>, std::unique_ptr<CMetrics::Entry>> CMetrics::s_entries;
+std::thread CMetrics::s_server;
+std::atomic<bool> CMetrics::s_bQuit{false};
+int CMetrics::s_logSink = -1;
+std::chrono::steady_clock::time_point CMetrics::s_lastDump;
+std::chrono::steady_clock::time_point CMetrics::s_lastFpsTime;
+uint64_t CMetrics::s_lastFpsFrames = 0;
+std::vector<uint32_t> CMetrics::s_heapOfType;
+
+void CMetrics::Init(){
+    if(!bEnabled) return;
+    s_logSink = CLogger::AddSink("../logs/metrics.log");
+    s_lastDump = s_lastFpsTime = std::chrono::steady_clock::now();
+    if(httpPort != 0){
+        s_bQuit = false;
+        s_server = std::thread(ServerLoop);
+    }
+}
+
+void CMetrics::Destroy(){
+    if(!bEnabled) return;
+    if(s_server.joinable()){
+        s_bQuit = true;
+        s_server.join();
+    }
+    Dump();
+}
+
+void CMetrics::Update(){
+    if(!bEnabled) return;
+    auto now = std::chrono::steady_clock::now();
+    double fpsSeconds = std::chrono::duration<double>(now - s_lastFpsTime).count();
+    if(fpsSeconds >= 1.0){
+        static Counter &frames = GetCounter("frames_total", "Frames rendered");
+        static Gauge &fps = GetGauge("frames_per_second", "Frames in the last second");
+        uint64_t frameCount = frames.Get();
+        fps.Set((int64_t)((frameCount - s_lastFpsFrames) / fpsSeconds + 0.5));
+        s_lastFpsFrames = frameCount;
+        s_lastFpsTime = now;
+    }
+    if(logInterval > 0 && std::chrono::duration<float>(now - s_lastDump).count() >= logInterval){
+        Dump();
+        s_lastDump = now;
+    }
+}
+
+void CMetrics::Dump(){
+    //the text format without the comment lines, one metric per line
+    std::istringstream text(GetText());
+    std::string line;
+    CLogger::Log(LOG_LEVEL_INFO, LOG_CATEGORY_RENDERER, s_logSink, "metrics");
+    while(std::getline(text, line)) if(!line.empty() && line[0] != '#') CLogger::Log(LOG_LEVEL_INFO, LOG_CATEGORY_RENDERER, s_logSink, "  %s", line);
+}
+
+/*******************
+*	Registry, any thread
+********************/
+CMetrics::Entry &CMetrics::GetEntry(const std::string &name, const std::string &help, const std::string &labels, Type type){
+    std::lock_guard<std::mutex> lock(s_mutex);
+    std::unique_ptr<Entry> &entry = s_entries[{name, labels}];
+    if(!entry){
+        entry = std::make_unique<Entry>();
+        entry->name = name;
+        entry->labels = labels;
+        entry->help = help;
+        entry->type = type;
+        if(type == TYPE_COUNTER) entry->counter = std::make_unique<Counter>();
+        else if(type == TYPE_GAUGE) entry->gauge = std::make_unique<Gauge>();
+        else entry->histogram = std::make_unique<Histogram>();
+    }
+    if(entry->type != type) throw std::runtime_error("failed to register metric " + name + ": registered with another type!");
+    return *entry;
+}
+
+CMetrics::Counter &CMetrics::GetCounter(const std::string &name, const std::string &help, const std::string &labels){
+    return *GetEntry(name, help, labels, TYPE_COUNTER).counter;
+}
+CMetrics::Gauge &CMetrics::GetGauge(const std::string &name, const std::string &help, const std::string &labels){
+    return *GetEntry(name, help, labels, TYPE_GAUGE).gauge;
+}
+CMetrics::Histogram &CMetrics::GetHistogram(const std::string &name, const std::string &help, const std::string &labels){
+    return *GetEntry(name, help, labels, TYPE_HISTOGRAM).histogram;
+}
+
+void CMetrics::TrackGpuMemory(uint32_t memoryTypeIndex, int64_t bytes){
+    if(!bEnabled) return;
+    uint32_t heap = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_heapOfType.empty()){
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            vkGetPhysicalDeviceMemoryProperties(CContext::GetHandle().GetPhysicalDevice(), &memoryProperties);
+            for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) s_heapOfType.push_back(memoryProperties.memoryTypes[i].heapIndex);
+        }
+        if(memoryTypeIndex < s_heapOfType.size()) heap = s_heapOfType[memoryTypeIndex];
+    }
+    GetGauge("gpu_memory_bytes", "Device memory allocated by buffers and images", "heap=\"" + std::to_string(heap) + "\"").Add(bytes);
+}
+
+std::string CMetrics::GetText(){
+    std::ostringstream text;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const std::string *lastName = nullptr;
+    for(auto &item : s_entries){
+        const Entry &entry = *item.second;
+        if(!lastName || *lastName != entry.name){
+            text<<"# HELP "<<entry.name<<" "<<entry.help<<"\n";
+            text<<"# TYPE "<<entry.name<<" "<<(entry.type == TYPE_COUNTER ? "counter" : entry.type == TYPE_GAUGE ? "gauge" : "summary")<<"\n";
+            lastName = &entry.name;
+        }
+        std::string labels = entry.labels.empty() ? "" : "{" + entry.labels + "}";
+        if(entry.type == TYPE_COUNTER) text<<entry.name<<labels<<" "<<entry.counter->Get()<<"\n";
+        else if(entry.type == TYPE_GAUGE) text<<entry.name<<labels<<" "<<entry.gauge->Get()<<"\n";
+        else{
+            const Histogram &histogram = *entry.histogram;
+            std::string separator = entry.labels.empty() ? "" : entry.labels + ",";
+            for(double quantile : {0.5, 0.9, 0.99, 0.999})
+                text<<entry.name<<"{"<<separator<<"quantile=\""<<quantile<<"\"} "<<histogram.Percentile(quantile)<<"\n";
+            text<<entry.name<<"_max"<<labels<<" "<<histogram.GetMax()<<"\n";
+            text<<entry.name<<"_sum"<<labels<<" "<<histogram.GetSum()<<"\n";
+            text<<entry.name<<"_count"<<labels<<" "<<histogram.GetCount()<<"\n";
+        }
+    }
+    return text.str();
+}
+
+/*******************
+*	Histogram
+********************/
+uint32_t CMetrics::Histogram::BucketOf(uint64_t value){
+    if(value < 2 * SUB_BUCKETS) return (uint32_t)value;
+    value = std::min(value, (uint64_t(1) << 40) - 1);
+    uint32_t exponent = 0;
+    while((value >> exponent) >= 2 * SUB_BUCKETS) exponent++; //value >> exponent is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+    return 2 * SUB_BUCKETS + (exponent - 1) * SUB_BUCKETS + (uint32_t)(value >> exponent) - SUB_BUCKETS;
+}
+
+uint64_t CMetrics::Histogram::ValueOf(uint32_t bucket){
+    if(bucket < 2 * SUB_BUCKETS) return bucket;
+    uint32_t exponent = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+    uint64_t sub = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+    return (sub << exponent) + (uint64_t(1) << (exponent - 1)); //middle of the bucket
+}
+
+void CMetrics::Histogram::Record(uint64_t value){
+    if(!bEnabled) return;
+    m_buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while(value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+uint64_t CMetrics::Histogram::Percentile(double fraction) const{
+    uint64_t count = GetCount();
+    if(count == 0) return 0;
+    uint64_t target = std::max((uint64_t)1, (uint64_t)(fraction * count + 0.5));
+    uint64_t seen = 0;
+    for(uint32_t i = 0; i < BUCKET_COUNT; i++){
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if(seen >= target) return std::min(ValueOf(i), GetMax());
+    }
+    return GetMax();
+}
+
+/*******************
+*	HTTP endpoint, server thread
+********************/
+void CMetrics::ServerLoop(){
+#ifdef _WIN32
+    WSADATA wsaData;
+    if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0){
+        std::cout<<"Metrics: WSAStartup failed, no endpoint"<<std::endl;
+        return;
+    }
+#endif
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(httpPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); //local only
+    int reuse = 1;
+    if(listener != INVALID_SOCKET) setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    if(listener == INVALID_SOCKET || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0){
+        std::cout<<"Metrics: can not listen on 127.0.0.1:"<<httpPort<<", no endpoint"<<std::endl;
+        if(listener != INVALID_SOCKET) CLOSE_SOCKET(listener);
+        return;
+    }
+    std::cout<<"Metrics: http://127.0.0.1:"<<httpPort<<"/metrics"<<std::endl;
+
+    while(!s_bQuit.load()){
+        //wake up regularly to see s_bQuit
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(listener, &readSet);
+        timeval timeout = {0, 200000};
+        if(select((int)listener + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+        SocketHandle client = accept(listener, nullptr, nullptr);
+        if(client == INVALID_SOCKET) continue;
+
+        //one request per connection, only the request line matters
+        timeval receiveTimeout = {1, 0};
+#ifdef _WIN32
+        DWORD receiveTimeoutMs = 1000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeoutMs, sizeof(receiveTimeoutMs));
+#else
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+#ifdef SO_NOSIGPIPE
+        int noSigpipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noSigpipe, sizeof(noSigpipe));
+#endif
+#endif
+        std::string request;
+        char buffer[1024];
+        while(request.find("\r\n\r\n") == std::string::npos && request.size() < 8192){
+            int received = (int)recv(client, buffer, sizeof(buffer), 0);
+            if(received <= 0) break;
+            request.append(buffer, received);
+        }
+        std::string status = "200 OK", body;
+        if(request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) body = GetText();
+        else if(request.compare(0, 6, "GET / ") == 0) body = "metrics: /metrics\n";
+        else{
+            status = "404 Not Found";
+            body = "not found\n";
+        }
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+            + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        for(size_t sent = 0; sent < response.size();){
+            int n = (int)send(client, response.data() + sent, (int)(response.size() - sent), SEND_FLAGS);
+            if(n <= 0) break;
+            sent += n;
+        }
+        CLOSE_SOCKET(client);
+    }
+    CLOSE_SOCKET(listener);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
@@ -0,0 +1,260 @@
+#include "../include/mipmapCompute.h"
+
+CMipmapCompute::CMipmapCompute(){}
+CMipmapCompute::~CMipmapCompute(){}
+
+/*******************
+*	Mipmap Compute: Init
+********************/
+bool CMipmapCompute::LoadShader(const std::string shaderName){
+#ifndef ANDROID
+    if(m_shaderManager.InitSpirVShader(SHADER_PATH + shaderName, &m_shaderModule)) return true;
+    return m_shaderManager.InitSpirVShader("shaders/" + shaderName, &m_shaderModule);
+#else
+    std::vector<uint8_t> fileBits;
+    std::string fullShaderName = ANDROID_SHADER_PATH + shaderName;
+    if(!CContext::GetHandle().androidFileManager.AssetReadFile(fullShaderName.c_str(), fileBits) || fileBits.empty()) return false;
+    m_shaderModule = m_shaderManager.createShaderModule(fileBits);
+    return true;
+#endif
+}
+
+bool CMipmapCompute::Init(){
+    if(bInitTried) return IsAvailable();
+    bInitTried = true;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+
+    //the subgroup variant is SPIR-V 1.3, only valid on a 1.1 instance and device with quad operations in compute
+    bool bSubgroupDevice = (*CContext::GetHandle().physicalDevice)->bSubgroupQuadCompute;
+    bSubgroup = bSubgroupDevice && LoadShader("mipmapSpd/shaderSubgroup.comp.spv");
+    if(bSubgroupDevice && !bSubgroup)
+        LOG(LOG_LEVEL_WARNING, LOG_CATEGORY_TEXTURE, "Mipmap compute: mipmapSpd/shaderSubgroup.comp.spv not found, using the shared memory variant");
+    if(!bSubgroup && !LoadShader("mipmapSpd/shader.comp.spv")){
+        //not silent: a missing .spv would otherwise look like a slow compute generator
+        LOG(LOG_LEVEL_WARNING, LOG_CATEGORY_TEXTURE, "Mipmap compute: mipmapSpd/shader.comp.spv not found, textures fall back to blit mipmaps");
+        return false;
+    }
+
+    //Step 1: set 0 = every level as a storage image + the per layer counters
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[0].descriptorCount = MAX_LEVELS;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mipmap compute descriptor set layout!");
+
+    //Step 2: pipeline layout and pipeline
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mipmap compute pipeline layout!");
+
+    VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+    computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    computeShaderStageInfo.module = m_shaderModule;
+    computeShaderStageInfo.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.layout = m_pipelineLayout;
+    pipelineInfo.stage = computeShaderStageInfo;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mipmap compute pipeline!");
+
+    //Step 3: pool for one set, reset after every Generate()
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[0].descriptorCount = MAX_LEVELS;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    poolInfo.maxSets = 1;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mipmap compute descriptor pool!");
+
+    //Step 4: counters start at 0, the last workgroup of a layer sets its counter back to 0
+    VkDeviceSize counterSize = MAX_LAYERS * sizeof(uint32_t);
+    m_counterBuffer.init(counterSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    void *pCounters;
+    vkMapMemory(device, m_counterBuffer.deviceMemory, 0, counterSize, 0, &pCounters);
+    memset(pCounters, 0, (size_t)counterSize);
+    vkUnmapMemory(device, m_counterBuffer.deviceMemory);
+
+    PRINT("CMipmapCompute: single pass mipmap shader loaded, subgroup variant: %d", (int)bSubgroup);
+    return true;
+}
+
+void CMipmapCompute::Destroy(){
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    if(m_descriptorPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+    if(m_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_pipeline, nullptr);
+    if(m_pipelineLayout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+    if(m_descriptorSetLayout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
+    m_counterBuffer.DestroyAndFree();
+    m_shaderManager.Destroy();
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_shaderModule = VK_NULL_HANDLE;
+    bInitTried = false;
+}
+
+bool CMipmapCompute::CanGenerate(VkFormat format, uint32_t mipLevels, uint32_t width, uint32_t height){
+    //the shader stores through rgba8 views; 16 bit textures keep the CPU or blit path
+    if(format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM) return false;
+    if(mipLevels < 2 || mipLevels > MAX_LEVELS) return false;
+    uint32_t maxSize = 1u << (MAX_LEVELS - 1);
+    return width <= maxSize && height <= maxSize;
+}
+
+/*******************
+*	Mipmap Compute: Generate
+********************/
+void CMipmapCompute::Generate(VkCommandPool &commandPool, VkImage image, VkFormat format, uint32_t width, uint32_t height,
+        uint32_t mipLevels, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout finalLayout){
+    if(!Init()) throw std::runtime_error("failed to generate mipmaps: compute shader is not available!");
+    if(!CanGenerate(format, mipLevels, width, height) || layerCount > MAX_LAYERS)
+        throw std::runtime_error("failed to generate mipmaps: image is not supported by the compute generator!");
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+
+    //Step 1: one UNORM 2D array view per level; unused slots repeat the last level (never written, mipCount guards)
+    std::vector<VkImageView> views(mipLevels);
+    for(uint32_t i = 0; i < mipLevels; i++){
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = i;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = layerCount;
+        if (vkCreateImageView(device, &viewInfo, nullptr, &views[i]) != VK_SUCCESS)
+            throw std::runtime_error("failed to create mipmap compute image view!");
+    }
+
+    VkDescriptorImageInfo imageInfos[MAX_LEVELS];
+    for(uint32_t i = 0; i < MAX_LEVELS; i++){
+        imageInfos[i].sampler = VK_NULL_HANDLE;
+        imageInfos[i].imageView = views[std::min(i, mipLevels - 1)];
+        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = m_counterBuffer.buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_descriptorSetLayout;
+    VkDescriptorSet descriptorSet;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate mipmap compute descriptor set!");
+
+    VkWriteDescriptorSet descriptorWrites[2]{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = descriptorSet;
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].descriptorCount = MAX_LEVELS;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrites[0].pImageInfo = imageInfos;
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = descriptorSet;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[1].pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device, 2, descriptorWrites, 0, nullptr);
+
+    //Step 2: record barrier, dispatch, barrier
+    VkCommandBufferAllocateInfo commandBufferInfo{};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layerCount;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    PushConstants pushConstants;
+    pushConstants.width = (int32_t)width;
+    pushConstants.height = (int32_t)height;
+    pushConstants.mipCount = mipLevels;
+    uint32_t groupsX = (width + 63) / 64;
+    uint32_t groupsY = (height + 63) / 64;
+    pushConstants.groupCount = groupsX * groupsY;
+    pushConstants.bSrgb = (format == VK_FORMAT_R8G8B8A8_SRGB) ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, groupsX, groupsY, layerCount);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = finalLayout;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    //Step 3: same synchronous submission as the other texture uploads
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(CContext::GetHandle().GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(CContext::GetHandle().GetGraphicsQueue());
+
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    vkResetDescriptorPool(device, m_descriptorPool, 0);
+    for(auto view : views) vkDestroyImageView(device, view, nullptr);
+}
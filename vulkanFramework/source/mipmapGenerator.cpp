@@ -0,0 +1,377 @@
+#include "../include/mipmapGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <functional>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIPMAP_SIMD_AVX2
+#define MIPMAP_SIMD_SSE
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIPMAP_SIMD_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MIPMAP_SIMD_NEON
+#endif
+
+namespace {
+
+/*******************
+*	Kernels
+********************/
+const float PI = 3.14159265358979f;
+const int ENCODE_TABLE_BITS = 14; //linear -> sRGB8 lookup, fine enough to round the darks correctly
+
+//per destination texel: the source texels (clamped to the edge) and normalized weights
+struct Taps{
+    int maxTaps = 0;
+    std::vector<int> count;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+float Sinc(float x){
+    if(std::fabs(x) < 1e-5f) return 1.0f;
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+//zeroth order modified Bessel function of the first kind, for the Kaiser window
+float BesselI0(float x){
+    float sum = 1.0f, term = 1.0f;
+    for(int k = 1; k < 20; k++){
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+//t is measured in destination texels
+float Kernel(CMipmapGenerator::Filter filter, float t){
+    t = std::fabs(t);
+    if(filter == CMipmapGenerator::FILTER_LANCZOS) return t < 3.0f ? Sinc(t) * Sinc(t / 3.0f) : 0.0f;
+    const float width = 3.0f, alpha = 4.0f; //Kaiser windowed sinc
+    if(t >= width) return 0.0f;
+    float r = t / width;
+    return Sinc(t) * BesselI0(alpha * std::sqrt(1.0f - r * r)) / BesselI0(alpha);
+}
+
+void BuildTaps(CMipmapGenerator::Filter filter, int srcSize, int dstSize, Taps &taps){
+    float scale = (float)srcSize / dstSize; //source texels per destination texel
+    float support = (filter == CMipmapGenerator::FILTER_BOX ? 0.5f : 3.0f) * scale;
+    taps.maxTaps = (int)std::ceil(support * 2.0f) + 2;
+    taps.count.assign(dstSize, 0);
+    taps.index.assign((size_t)dstSize * taps.maxTaps, 0);
+    taps.weight.assign((size_t)dstSize * taps.maxTaps, 0.0f);
+
+    for(int i = 0; i < dstSize; i++){
+        float center = (i + 0.5f) * scale;
+        int first = (int)std::floor(center - support);
+        int last = (int)std::ceil(center + support);
+        int *index = &taps.index[(size_t)i * taps.maxTaps];
+        float *weight = &taps.weight[(size_t)i * taps.maxTaps];
+        int n = 0;
+        float sum = 0.0f;
+        for(int j = first; j < last && n < taps.maxTaps; j++){
+            float w;
+            if(filter == CMipmapGenerator::FILTER_BOX) //area of texel j inside the box, odd sizes get fractional weights
+                w = std::max(0.0f, std::min((float)j + 1.0f, center + support) - std::max((float)j, center - support));
+            else w = Kernel(filter, (j + 0.5f - center) / scale);
+            if(w == 0.0f) continue;
+            index[n] = std::min(std::max(j, 0), srcSize - 1);
+            weight[n] = w;
+            sum += w;
+            n++;
+        }
+        for(int k = 0; k < n; k++) weight[k] /= sum;
+        taps.count[i] = n;
+    }
+}
+
+/*******************
+*	Passes
+********************/
+//returns source row y as linear float RGBA; level 0 is decoded into scratch on the fly instead of being kept as floats
+typedef std::function<const float*(int y, float *scratch)> RowSource;
+
+//split [0, count) into bands, one thread per band; small levels run on the calling thread
+void ParallelFor(int count, unsigned threads, size_t workPerItem, const std::function<void(int, int)> &fn){
+    unsigned n = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, (size_t)count * workPerItem / 65536));
+    n = std::min<unsigned>(n, (unsigned)count);
+    if(n <= 1){
+        fn(0, count);
+        return;
+    }
+    int band = (count + n - 1) / n;
+    std::vector<std::thread> workers;
+    for(unsigned t = 1; t < n; t++){
+        int begin = t * band, end = std::min(count, begin + band);
+        if(begin < end) workers.emplace_back(fn, begin, end);
+    }
+    fn(0, std::min(count, band));
+    for(auto &worker : workers) worker.join();
+}
+
+//horizontal pass: one RGBA texel is one 4 wide vector
+void FilterRows(const RowSource &source, int srcWidth, float *dst, int dstWidth, const Taps &taps, int rowBegin, int rowEnd){
+    std::vector<float> scratch((size_t)srcWidth * 4);
+    for(int y = rowBegin; y < rowEnd; y++){
+        const float *srcRow = source(y, scratch.data());
+        float *dstRow = dst + (size_t)y * dstWidth * 4;
+        for(int x = 0; x < dstWidth; x++){
+            const int *index = &taps.index[(size_t)x * taps.maxTaps];
+            const float *weight = &taps.weight[(size_t)x * taps.maxTaps];
+            int count = taps.count[x];
+#if defined(MIPMAP_SIMD_SSE)
+            __m128 acc = _mm_setzero_ps();
+            for(int k = 0; k < count; k++) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(srcRow + index[k] * 4)));
+            _mm_storeu_ps(dstRow + x * 4, acc);
+#elif defined(MIPMAP_SIMD_NEON)
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for(int k = 0; k < count; k++) acc = vmlaq_n_f32(acc, vld1q_f32(srcRow + index[k] * 4), weight[k]);
+            vst1q_f32(dstRow + x * 4, acc);
+#else
+            float acc[4] = {0, 0, 0, 0};
+            for(int k = 0; k < count; k++)
+                for(int c = 0; c < 4; c++) acc[c] += weight[k] * srcRow[index[k] * 4 + c];
+            memcpy(dstRow + x * 4, acc, sizeof(acc));
+#endif
+        }
+    }
+}
+
+//exact 2x box: both passes in one, each destination texel is the mean of a 2x2 quad
+void DownsampleBox2x(const RowSource &source, int srcWidth, float *dst, int dstWidth, int rowBegin, int rowEnd){
+    std::vector<float> scratch0((size_t)srcWidth * 4), scratch1((size_t)srcWidth * 4);
+    for(int y = rowBegin; y < rowEnd; y++){
+        const float *row0 = source(2 * y, scratch0.data());
+        const float *row1 = source(2 * y + 1, scratch1.data());
+        float *dstRow = dst + (size_t)y * dstWidth * 4;
+        int x = 0;
+#if defined(MIPMAP_SIMD_AVX2)
+        const __m256 quarter8 = _mm256_set1_ps(0.25f);
+        for(; x + 2 <= dstWidth; x += 2){ //texels 4x..4x+3 of both rows, pairs are folded across the 128 bit lanes
+            __m256 a = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+            __m256 b = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+            __m256 sum = _mm256_add_ps(_mm256_permute2f128_ps(a, b, 0x20), _mm256_permute2f128_ps(a, b, 0x31));
+            _mm256_storeu_ps(dstRow + x * 4, _mm256_mul_ps(sum, quarter8));
+        }
+#endif
+#if defined(MIPMAP_SIMD_SSE)
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for(; x < dstWidth; x++){
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4)),
+                                    _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4)));
+            _mm_storeu_ps(dstRow + x * 4, _mm_mul_ps(sum, quarter));
+        }
+#elif defined(MIPMAP_SIMD_NEON)
+        for(; x < dstWidth; x++){
+            float32x4_t sum = vaddq_f32(vaddq_f32(vld1q_f32(row0 + x * 8), vld1q_f32(row0 + x * 8 + 4)),
+                                        vaddq_f32(vld1q_f32(row1 + x * 8), vld1q_f32(row1 + x * 8 + 4)));
+            vst1q_f32(dstRow + x * 4, vmulq_n_f32(sum, 0.25f));
+        }
+#else
+        for(; x < dstWidth; x++)
+            for(int c = 0; c < 4; c++) dstRow[x * 4 + c] = (row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c]) * 0.25f;
+#endif
+    }
+}
+
+//vertical pass: whole rows are weighted and summed, as wide as the instruction set allows
+void FilterColumns(const float *src, float *dst, int rowFloats, const Taps &taps, int rowBegin, int rowEnd){
+    for(int y = rowBegin; y < rowEnd; y++){
+        const int *index = &taps.index[(size_t)y * taps.maxTaps];
+        const float *weight = &taps.weight[(size_t)y * taps.maxTaps];
+        int count = taps.count[y];
+        float *dstRow = dst + (size_t)y * rowFloats;
+        int i = 0;
+#if defined(MIPMAP_SIMD_AVX2)
+        for(; i + 8 <= rowFloats; i += 8){
+            __m256 acc = _mm256_setzero_ps();
+            for(int k = 0; k < count; k++) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weight[k]), _mm256_loadu_ps(src + (size_t)index[k] * rowFloats + i)));
+            _mm256_storeu_ps(dstRow + i, acc);
+        }
+#endif
+#if defined(MIPMAP_SIMD_SSE)
+        for(; i + 4 <= rowFloats; i += 4){
+            __m128 acc = _mm_setzero_ps();
+            for(int k = 0; k < count; k++) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + (size_t)index[k] * rowFloats + i)));
+            _mm_storeu_ps(dstRow + i, acc);
+        }
+#elif defined(MIPMAP_SIMD_NEON)
+        for(; i + 4 <= rowFloats; i += 4){
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for(int k = 0; k < count; k++) acc = vmlaq_n_f32(acc, vld1q_f32(src + (size_t)index[k] * rowFloats + i), weight[k]);
+            vst1q_f32(dstRow + i, acc);
+        }
+#endif
+        for(; i < rowFloats; i++){
+            float acc = 0.0f;
+            for(int k = 0; k < count; k++) acc += weight[k] * src[(size_t)index[k] * rowFloats + i];
+            dstRow[i] = acc;
+        }
+    }
+}
+
+/*******************
+*	Alpha coverage
+********************/
+float Coverage(const std::vector<float> &level, float cutoff, float scale){
+    size_t covered = 0, texelCount = level.size() / 4;
+    for(size_t i = 0; i < texelCount; i++) if(level[i * 4 + 3] * scale > cutoff) covered++;
+    return (float)covered / texelCount;
+}
+
+//smallest alpha scale that reaches the coverage of level 0
+float FindAlphaScale(const std::vector<float> &level, float cutoff, float targetCoverage){
+    float low = 0.0f, high = 4.0f;
+    for(int i = 0; i < 12; i++){
+        float mid = (low + high) * 0.5f;
+        if(Coverage(level, cutoff, mid) < targetCoverage) low = mid;
+        else high = mid;
+    }
+    return high;
+}
+
+float Saturate(float x){ return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }
+
+}
+
+/*******************
+*	Generate
+********************/
+void CMipmapGenerator::Generate(const void *texels, uint32_t width, uint32_t height, uint32_t bytesPerChannel, uint32_t mipLevels,
+        const Options &options, std::vector<uint8_t> &out, std::vector<size_t> &levelOffsets){
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    bool b16Bit = (bytesPerChannel == 2);
+    bool bSrgb = options.bSrgb && !b16Bit;
+    size_t texelBytes = 4 * bytesPerChannel;
+
+    levelOffsets.resize(mipLevels);
+    size_t totalBytes = 0;
+    for(uint32_t i = 0; i < mipLevels; i++){
+        levelOffsets[i] = totalBytes;
+        totalBytes += (size_t)std::max(width >> i, 1u) * std::max(height >> i, 1u) * texelBytes;
+    }
+    out.resize(totalBytes);
+    memcpy(out.data(), texels, (size_t)width * height * texelBytes); //level 0 is the source
+    if(mipLevels <= 1) return;
+
+    //Step 1: level 0 is read through linear float tables, one row at a time
+    float decodeTable[256], alphaTable[256];
+    for(int i = 0; i < 256; i++){
+        float c = i / 255.0f;
+        alphaTable[i] = c;
+        decodeTable[i] = bSrgb ? (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+    }
+    static const std::vector<uint8_t> encodeTable = [](){
+        std::vector<uint8_t> table(1 << ENCODE_TABLE_BITS);
+        for(size_t i = 0; i < table.size(); i++){
+            float c = (float)i / (table.size() - 1);
+            c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            table[i] = (uint8_t)(Saturate(c) * 255.0f + 0.5f);
+        }
+        return table;
+    }();
+
+    auto decodeRow = [&](int y, float *scratch) -> const float*{
+        size_t first = (size_t)y * width * 4;
+        if(b16Bit){
+            const uint16_t *src = (const uint16_t*)texels + first;
+            for(size_t i = 0; i < (size_t)width * 4; i++) scratch[i] = src[i] * (1.0f / 65535.0f);
+        }else{
+            const uint8_t *src = (const uint8_t*)texels + first;
+            for(size_t i = 0; i < (size_t)width * 4; i += 4){
+                scratch[i] = decodeTable[src[i]];
+                scratch[i + 1] = decodeTable[src[i + 1]];
+                scratch[i + 2] = decodeTable[src[i + 2]];
+                scratch[i + 3] = alphaTable[src[i + 3]];
+            }
+        }
+        return scratch;
+    };
+
+    float targetCoverage = 0.0f;
+    if(options.alphaCutoff > 0.0f){
+        size_t covered = 0, texelCount = (size_t)width * height;
+        for(size_t i = 0; i < texelCount; i++){
+            float alpha = b16Bit ? ((const uint16_t*)texels)[i * 4 + 3] / 65535.0f : ((const uint8_t*)texels)[i * 4 + 3] / 255.0f;
+            if(alpha > options.alphaCutoff) covered++;
+        }
+        targetCoverage = (float)covered / texelCount;
+    }
+
+    //Step 2: each level from the previous one, horizontal then vertical pass (or one pass for an exact 2x box)
+    std::vector<float> current, next, temp;
+    int srcWidth = width, srcHeight = height;
+    Taps horizontal, vertical;
+    for(uint32_t level = 1; level < mipLevels; level++){
+        int dstWidth = std::max(srcWidth / 2, 1), dstHeight = std::max(srcHeight / 2, 1);
+        next.resize((size_t)dstWidth * dstHeight * 4);
+        int currentWidth = srcWidth;
+        RowSource source = (level == 1) ? RowSource(decodeRow) : RowSource([&, currentWidth](int y, float*) -> const float*{ return current.data() + (size_t)y * currentWidth * 4; });
+
+        if(options.filter == FILTER_BOX && srcWidth == 2 * dstWidth && srcHeight == 2 * dstHeight){
+            ParallelFor(dstHeight, threads, (size_t)dstWidth * 4, [&](int begin, int end){
+                DownsampleBox2x(source, srcWidth, next.data(), dstWidth, begin, end);
+            });
+        }else{
+            BuildTaps(options.filter, srcWidth, dstWidth, horizontal);
+            BuildTaps(options.filter, srcHeight, dstHeight, vertical);
+            temp.resize((size_t)dstWidth * srcHeight * 4);
+            ParallelFor(srcHeight, threads, (size_t)dstWidth * horizontal.maxTaps, [&](int begin, int end){
+                FilterRows(source, srcWidth, temp.data(), dstWidth, horizontal, begin, end);
+            });
+            ParallelFor(dstHeight, threads, (size_t)dstWidth * vertical.maxTaps, [&](int begin, int end){
+                FilterColumns(temp.data(), next.data(), dstWidth * 4, vertical, begin, end);
+            });
+        }
+
+        //Step 3: encode; the alpha scale only touches the output, the next level is filtered from unscaled alpha
+        float alphaScale = options.alphaCutoff > 0.0f ? FindAlphaScale(next, options.alphaCutoff, targetCoverage) : 1.0f;
+        uint8_t *dst = out.data() + levelOffsets[level];
+        ParallelFor(dstHeight, threads, dstWidth, [&](int begin, int end){
+            size_t first = (size_t)begin * dstWidth * 4, last = (size_t)end * dstWidth * 4;
+            if(b16Bit){
+                uint16_t *dst16 = (uint16_t*)dst;
+                for(size_t i = first; i < last; i++){
+                    float c = (i & 3) == 3 ? next[i] * alphaScale : next[i];
+                    dst16[i] = (uint16_t)(Saturate(c) * 65535.0f + 0.5f);
+                }
+            }else{
+                const float tableScale = (float)((1 << ENCODE_TABLE_BITS) - 1);
+                for(size_t i = first; i < last; i++){
+                    if((i & 3) == 3) dst[i] = (uint8_t)(Saturate(next[i] * alphaScale) * 255.0f + 0.5f);
+                    else if(bSrgb) dst[i] = encodeTable[(int)(Saturate(next[i]) * tableScale + 0.5f)];
+                    else dst[i] = (uint8_t)(Saturate(next[i]) * 255.0f + 0.5f);
+                }
+            }
+        });
+
+        std::swap(current, next);
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+    }
+}
+
+CMipmapGenerator::Filter CMipmapGenerator::ParseFilter(const std::string &name){
+    if(name == "kaiser") return FILTER_KAISER;
+    if(name == "lanczos") return FILTER_LANCZOS;
+    return FILTER_BOX;
+}
+
+const char* CMipmapGenerator::GetSimdName(){
+#if defined(MIPMAP_SIMD_AVX2)
+    return "AVX2";
+#elif defined(MIPMAP_SIMD_SSE)
+    return "SSE2";
+#elif defined(MIPMAP_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
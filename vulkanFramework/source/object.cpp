@@ -36,6 +36,15 @@ CObject::CObject(){
 
     CEntity::Update(deltaTime); //update translateMatrix, RotationMatrix and ScaleMatrix
 
+    //on-screen height in pixels of the bounding sphere, streamed textures load the mip that matches it
+    if(!m_texture_ids.empty()){
+        float diameter = glm::length(Length_original * Scale);
+        float depth = -(mainCamera.matrices.view * glm::vec4(Position, 1.0f)).z;
+        float focal = std::abs(mainCamera.matrices.perspective[1][1]); //1 / tan(fov / 2), negative when y is flipped
+        if(bSticker || bSkybox || diameter == 0 || depth <= mainCamera.znear) m_projectedSize = (float)WINDOW_HEIGHT; //covers the screen, or size unknown
+        else m_projectedSize = std::min(diameter * focal / depth * 0.5f * WINDOW_HEIGHT, (float)WINDOW_HEIGHT);
+    }
+
     /**********
     * Calculate model matrix based on Translation, Rotation and Scale
     **********/
@@ -81,67 +90,66 @@ void CObject::CleanUp(){
     //textureDescriptor.DestroyAndFree();
 }
 
-void CObject::CreateDescriptorSets_TextureImageSampler(VkDescriptorPool &descriptorPool, VkDescriptorSetLayout &descriptorSetLayout, std::vector<VkSampler> &samplers, std::vector<VkImageView> *swapchainImageViews){
+void CObject::CreateDescriptorSets_TextureImageSampler(VkDescriptorSetLayout &descriptorSetLayout, std::vector<VkSampler> &samplers, std::vector<VkImageView> *swapchainImageViews){
     //std::cout<<"TextureDescriptor::createDescriptorSets."<<std::endl;
     if(samplers.size() < 1) return;
-    
-    int descriptorSize = samplers.size();//getDescriptorSize();
-    //std::cout<<"createTextureDescriptorSets::samplers.size(): "<<samplers.size()<<std::endl;
-    //std::cout<<"Object Set(Sampler) size = "<<descriptorSize<<std::endl;
 
-    VkResult result = VK_SUCCESS;
+    //sets come from CGraphicsDescriptorManager::descriptorCache: objects with the same textures get the same set
+    descriptorSets_graphics_texture_image_sampler.resize(MAX_FRAMES_IN_FLIGHT);///!!!
+    m_boundTextureVersions.assign(MAX_FRAMES_IN_FLIGHT, std::vector<uint32_t>(samplers.size(), 0));
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) UpdateDescriptorSet_TextureImageSampler(i, samplers);
 
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);///!!!
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);///!!!
-    allocInfo.pSetLayouts = layouts.data();
+    //std::cout<<"Done set descriptor. "<<std::endl;
+}
 
-    descriptorSets_graphics_texture_image_sampler.resize(MAX_FRAMES_IN_FLIGHT);///!!!
-    //Step 3
-    result = vkAllocateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), &allocInfo, descriptorSets_graphics_texture_image_sampler.data());
-    if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate descriptor sets!");
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        std::vector<VkWriteDescriptorSet> descriptorWrites;
-
-        descriptorWrites.resize(descriptorSize);
-        //int counter = 0;
-
-        VkDescriptorBufferInfo customBufferInfo{}; //for custom uniform
-
-        std::vector<VkDescriptorImageInfo> imageInfo{}; //for texture sampler
-        //if(uniformBufferUsageFlags & UNIFORM_BUFFER_SAMPLER_BIT){
-        imageInfo.resize(samplers.size());
-        for(int j = 0; j < samplers.size(); j++){
-            //std::cout<<"CreateTextureDescriptorSets::samplers:"<<j<<std::endl;
-            imageInfo[j].imageLayout = VK_IMAGE_LAYOUT_GENERAL; //test compute storage image: ?need figure this out. VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            //imageInfo[j].imageView = textureImages[j].m_textureImageBuffer.view;
-            //imageInfo[j].sampler = samplers[j];
-            if(j < m_texture_ids.size()){
-                imageInfo[j].imageView = p_textureManager->textureImages[m_texture_ids[j]].m_textureImageBuffer.view;
-                imageInfo[j].sampler = samplers[p_textureManager->textureImages[m_texture_ids[j]].m_sampler_id]; 
-            }else{ //There are more samplers than textures for this object, so use the first texture to fill other samplers
-                imageInfo[j].imageView = p_textureManager->textureImages[m_texture_ids[0]].m_textureImageBuffer.view;
-                imageInfo[j].sampler = samplers[p_textureManager->textureImages[m_texture_ids[0]].m_sampler_id]; 
-            }
-            descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[j].dstSet = descriptorSets_graphics_texture_image_sampler[i];
-            descriptorWrites[j].dstBinding = j;
-            descriptorWrites[j].dstArrayElement = 0;
-            descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrites[j].descriptorCount = 1;
-            descriptorWrites[j].pImageInfo = &imageInfo[j];
-            //counter++;
-        }
-        //}
+//look up the sampler set of one frame in flight; also called from Draw when a streamed texture changed its view.
+//Cached sets are shared and never rewritten, a changed view selects (or creates) another set.
+void CObject::UpdateDescriptorSet_TextureImageSampler(size_t i, std::vector<VkSampler> &samplers){
+    std::vector<CDescriptorCache::Binding> bindings;
+    GetBindings_TextureImageSampler(i, samplers, bindings);
+    descriptorSets_graphics_texture_image_sampler[i] = CGraphicsDescriptorManager::descriptorCache.GetOrCreate(
+        CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler, bindings);
+}
 
-        //Step 4
-        vkUpdateDescriptorSets(CContext::GetHandle().GetLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+//contents of the sampler set; records the texture versions they were built from
+void CObject::GetBindings_TextureImageSampler(size_t i, std::vector<VkSampler> &samplers, std::vector<CDescriptorCache::Binding> &bindings){
+    bindings.resize(samplers.size());
+    for(int j = 0; j < samplers.size(); j++){
+        //There may be more samplers than textures for this object, so use the first texture to fill other samplers
+        CTextureImage &texture = p_textureManager->textureImages[m_texture_ids[j < m_texture_ids.size() ? j : 0]];
+        bindings[j] = CDescriptorCache::Binding();
+        bindings[j].binding = j;
+        bindings[j].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[j].imageLayout = VK_IMAGE_LAYOUT_GENERAL; //test compute storage image: ?need figure this out. VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        bindings[j].imageView = texture.m_textureImageBuffer.view;
+        bindings[j].sampler = samplers[texture.m_sampler_id];
+        m_boundTextureVersions[i][j] = texture.m_version;
     }
+}
 
-    //std::cout<<"Done set descriptor. "<<std::endl;
+void CObject::CreateDescriptorRegions(){
+    CDescriptorBackend &backend = CGraphicsDescriptorManager::descriptorBackend;
+    if(CGraphicsDescriptorManager::getSetSize_General() > 0) m_descriptorRegions.push_back(backend.AllocateRegion());
+    if(CGraphicsDescriptorManager::textureImageSamplers.size() > 0){
+        m_descriptorRegions.push_back(backend.AllocateRegion());
+        if(m_texture_ids.size() > 0) m_boundTextureVersions.assign(MAX_FRAMES_IN_FLIGHT, std::vector<uint32_t>(CGraphicsDescriptorManager::textureImageSamplers.size(), 0));
+    }
+    for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) WriteDescriptorRegions(i);
+}
+
+//regions are per object, so there is nothing to share: streaming rewrites the region of the frame being recorded
+void CObject::WriteDescriptorRegions(size_t frame){
+    CDescriptorBackend &backend = CGraphicsDescriptorManager::descriptorBackend;
+    std::vector<CDescriptorCache::Binding> bindings;
+    int region = 0;
+    if(CGraphicsDescriptorManager::getSetSize_General() > 0){
+        p_graphicsDescriptorManager->getBindings_General(frame, m_object_id, bindings);
+        backend.WriteRegion(frame, m_descriptorRegions[region++], CGraphicsDescriptorManager::descriptorSetLayout_general, bindings);
+    }
+    if(CGraphicsDescriptorManager::textureImageSamplers.size() > 0 && m_texture_ids.size() > 0){
+        GetBindings_TextureImageSampler(frame, CGraphicsDescriptorManager::textureImageSamplers, bindings);
+        backend.WriteRegion(frame, m_descriptorRegions[region], CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler, bindings);
+    }
 }
 
 void CObject::Register(CApplication *p_app, int object_id, std::vector<int> texture_ids, int model_id, int graphics_pipeline_id){
@@ -171,6 +179,8 @@ void CObject::Register(CApplication *p_app, int object_id, std::vector<int> text
     p_graphicsPipelineLayout = &(p_app->renderProcess.graphicsPipelineLayouts[m_graphics_pipeline_id]);
     p_descriptorSets_graphcis_general = &(p_app->graphicsDescriptorManager.descriptorSets_general);//?
     p_textureManager = &(p_app->textureManager);
+    p_bindlessTextures = &(p_app->bindlessTextures);
+    p_graphicsDescriptorManager = &(p_app->graphicsDescriptorManager);
 
 
     //there are up to 3 samplers, support up to 3 different textures
@@ -178,12 +188,22 @@ void CObject::Register(CApplication *p_app, int object_id, std::vector<int> text
     //    std::cout<<"Register object:"<<m_object_id<<" with texture:"<<m_texture_ids[i]<<" and model:"<<model_id<<" and graphcis pipeline:"<<m_graphics_pipeline_id<<std::endl;
 
     //bUseTextureSampler = true; 
-    if(m_texture_ids.size() > 0){
-        CreateDescriptorSets_TextureImageSampler(
-            CGraphicsDescriptorManager::graphicsDescriptorPool,
-            CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler,
-            CGraphicsDescriptorManager::textureImageSamplers
-        );
+    switch(CGraphicsDescriptorManager::descriptorBackend.mode){
+        case CDescriptorBackend::MODE_DESCRIPTOR_BUFFER: //never combined with bindless textures
+            CreateDescriptorRegions();
+        break;
+        case CDescriptorBackend::MODE_PUSH_DESCRIPTOR: //sampler bindings are pushed in Draw
+            if(m_texture_ids.size() > 0 && !p_bindlessTextures->IsEnabled())
+                m_boundTextureVersions.assign(MAX_FRAMES_IN_FLIGHT, std::vector<uint32_t>(CGraphicsDescriptorManager::textureImageSamplers.size(), 0));
+        break;
+        default:
+            if(m_texture_ids.size() > 0 && !p_bindlessTextures->IsEnabled()){
+                CreateDescriptorSets_TextureImageSampler(
+                    CGraphicsDescriptorManager::descriptorSetLayout_textureImageSampler,
+                    CGraphicsDescriptorManager::textureImageSamplers
+                );
+            }
+        break;
     }
 
     bRegistered = true;
@@ -198,23 +218,71 @@ void CObject::Draw(uint32_t n){
     //std::cout<<"test2. p_graphicsDescriptorSets->size()="<<p_graphicsDescriptorSets->size()<<std::endl;
     //std::cout<<"test2. m_texture_ids.size()="<<m_texture_ids.size()<<std::endl;
 
-    std::vector<std::vector<VkDescriptorSet>> dsSets; 
-    //set = 0 is for general uniform; set = 1 is for texture sampler uniform
-    if(CGraphicsDescriptorManager::getSetSize_General() > 0) dsSets.push_back(*p_descriptorSets_graphcis_general); 
-    if(CGraphicsDescriptorManager::textureImageSamplers.size() > 0) dsSets.push_back(descriptorSets_graphics_texture_image_sampler); 
-    //std::cout<<"test3.dsSets.size()="<<dsSets.size()<<std::endl;
-    
-    if(dsSets.size() > 0){
-        int dynamicOffsetIndex = -1; //-1 means not use dynamic offset (no MVP/VP used)
-        if(bUseMVP_VP) dynamicOffsetIndex = m_object_id; //assume descriptor uniform(MVP/VP) offset is m_id
-        p_renderer->BindGraphicsDescriptorSets(*p_graphicsPipelineLayout, dsSets, dynamicOffsetIndex);
-    }//else std::cout<<"No Descritpor is used."<<std::endl;
+    CDescriptorBackend &backend = CGraphicsDescriptorManager::descriptorBackend;
+    VkCommandBuffer commandBuffer = p_renderer->commandBuffers[p_renderer->graphicsCmdId][p_renderer->currentFrame];
+
+    //streamed textures: report use for LRU and the largest on-screen size of this frame for the mip to load
+    for(int j = 0; j < m_texture_ids.size(); j++){
+        CTextureImage &texture = p_textureManager->textureImages[m_texture_ids[j]];
+        if(texture.m_lastUsedFrame != p_renderer->frameNumber + 1) texture.m_requestedSize = 0;
+        texture.m_requestedSize = std::max(texture.m_requestedSize, m_projectedSize);
+        texture.m_lastUsedFrame = p_renderer->frameNumber + 1;
+    }
+    //look up this frame's sampler set again if a texture swapped its view (push descriptors are rebuilt on every draw)
+    if(!m_texture_ids.empty() && !m_boundTextureVersions.empty()){
+        std::vector<uint32_t> &boundVersions = m_boundTextureVersions[p_renderer->currentFrame];
+        for(int j = 0; j < boundVersions.size() && backend.mode != CDescriptorBackend::MODE_PUSH_DESCRIPTOR; j++){
+            if(boundVersions[j] != p_textureManager->textureImages[m_texture_ids[j < m_texture_ids.size() ? j : 0]].m_version){
+                if(backend.mode == CDescriptorBackend::MODE_DESCRIPTOR_BUFFER) WriteDescriptorRegions(p_renderer->currentFrame);
+                else UpdateDescriptorSet_TextureImageSampler(p_renderer->currentFrame, CGraphicsDescriptorManager::textureImageSamplers);
+                break;
+            }
+        }
+    }
+
+    if(backend.mode == CDescriptorBackend::MODE_DESCRIPTOR_BUFFER){
+        //no vkCmdBindDescriptorSets: select this object's regions of the bound buffer
+        backend.BindDescriptorBuffer(commandBuffer, p_renderer->currentFrame, p_renderer->frameNumber);
+        backend.SetDescriptorBufferOffsets(commandBuffer, *p_graphicsPipelineLayout, m_descriptorRegions);
+    }else{
+        std::vector<std::vector<VkDescriptorSet>> dsSets; 
+        //set = 0 is for general uniform; set = 1 is for texture sampler uniform (or the shared bindless array)
+        if(CGraphicsDescriptorManager::getSetSize_General() > 0) dsSets.push_back(*p_descriptorSets_graphcis_general); 
+        bool bPushSamplers = false;
+        if(p_bindlessTextures->IsEnabled()){
+            p_bindlessTextures->Update(p_renderer->currentFrame, p_renderer->frameNumber);
+            dsSets.push_back(p_bindlessTextures->descriptorSets);
+        }else if(CGraphicsDescriptorManager::textureImageSamplers.size() > 0){
+            if(backend.mode == CDescriptorBackend::MODE_PUSH_DESCRIPTOR) bPushSamplers = !m_boundTextureVersions.empty();
+            else dsSets.push_back(descriptorSets_graphics_texture_image_sampler); 
+        }
+        //std::cout<<"test3.dsSets.size()="<<dsSets.size()<<std::endl;
+        
+        if(dsSets.size() > 0){
+            int dynamicOffsetIndex = -1; //-1 means not use dynamic offset (no MVP/VP used)
+            if(bUseMVP_VP) dynamicOffsetIndex = m_object_id; //assume descriptor uniform(MVP/VP) offset is m_id
+            p_renderer->BindGraphicsDescriptorSets(*p_graphicsPipelineLayout, dsSets, dynamicOffsetIndex);
+        }//else std::cout<<"No Descritpor is used."<<std::endl;
+        if(bPushSamplers){ //the sampler set follows the bound sets
+            std::vector<CDescriptorCache::Binding> bindings;
+            GetBindings_TextureImageSampler(p_renderer->currentFrame, CGraphicsDescriptorManager::textureImageSamplers, bindings);
+            backend.PushDescriptorSet(commandBuffer, *p_graphicsPipelineLayout, static_cast<uint32_t>(dsSets.size()), bindings);
+        }
+    }
+    if(p_bindlessTextures->IsEnabled()){
+        CBindlessTextures::PushConstants pushConstants;
+        p_bindlessTextures->GetPushConstants(m_texture_ids.empty() ? -1 : m_texture_ids[0], pushConstants);
+        VkPushConstantRange pushConstantRange = p_bindlessTextures->GetPushConstantRange();
+        p_renderer->PushConstantToCommand<CBindlessTextures::PushConstants>(pushConstants, *p_graphicsPipelineLayout, pushConstantRange);
+    }
     //std::cout<<"test4."<<std::endl;
     //if(!vertices3D.empty() || !vertices2D.empty()){
     p_renderer->BindVertexBuffer(m_model_id);
     //}//else std::cout<<"No vertex buffer is used."<<std::endl;
     //std::cout<<"test5."<<std::endl;
     //if(indices3D.empty()){
+    int gpuScope = -1; //per object GPU time when the profiler is on
+    if(p_renderer->gpuProfiler.bEnabled) gpuScope = p_renderer->BeginGpuScope(Name.empty() ? "object " + std::to_string(m_object_id) : Name);
     if(p_renderer->indices3Ds.empty()){
         //std::cout<<"No index buffer is used."<<std::endl;
         p_renderer->Draw(n);
@@ -222,6 +290,7 @@ void CObject::Draw(uint32_t n){
         p_renderer->BindIndexBuffer(m_model_id);
         p_renderer->DrawIndexed(m_model_id);
     }
+    p_renderer->EndGpuScope(gpuScope);
    //std::cout<<"test6."<<std::endl;
 }
 
@@ -241,6 +310,9 @@ void CObject::Draw(std::vector<CWxjBuffer> &buffer, uint32_t n){ //const VkBuffe
     //VkDeviceSize offsets[] = { 0 };
     //vkCmdBindVertexBuffers(p_renderer->commandBuffers[p_renderer->graphicsCmdId][p_renderer->currentFrame], 0, 1, &buffer[p_renderer->currentFrame].buffer, offsets);
     p_renderer->BindExternalBuffer(buffer);
+    int gpuScope = -1;
+    if(p_renderer->gpuProfiler.bEnabled) gpuScope = p_renderer->BeginGpuScope(Name.empty() ? "object " + std::to_string(m_object_id) : Name);
     p_renderer->Draw(n);
+    p_renderer->EndGpuScope(gpuScope);
     //std::cout<<"testdraw3"<<std::endl;
 }
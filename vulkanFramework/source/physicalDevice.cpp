@@ -4,9 +4,7 @@
 CPhysicalDevice::CPhysicalDevice(VkPhysicalDevice physical_device) : handle(physical_device) {
     //CPhysicalDevice(CInstance *instance, VkPhysicalDevice physical_device){
     //debugger = new CDebugger("../logs/physicalDevice.log");
-#ifndef ANDROID
-    logManager.setLogFile("physicalDevice.log");
-#endif
+    logManager.setLogFile("physicalDevice.log", LOG_CATEGORY_DEVICE);
 }
 
  //void CPhysicalDevice::setInstance(CInstance *instance){
@@ -58,7 +56,9 @@ QueueFamilyIndices CPhysicalDevice::findQueueFamilies(VkSurfaceKHR surface, std:
         }
 
         VkBool32 presentSupport = false;
-        VkResult result = vkGetPhysicalDeviceSurfaceSupportKHR(handle, i, surface, OUT &presentSupport);
+        if(surface == VK_NULL_HANDLE) //headless: nothing is presented, the graphics queue stands in for the present queue
+            presentSupport = (queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+        else vkGetPhysicalDeviceSurfaceSupportKHR(handle, i, surface, OUT &presentSupport);
         //REPORT("vkGetPhysicalDeviceSurfaceSupportKHR");
 
         if (presentSupport) {
@@ -75,6 +75,25 @@ QueueFamilyIndices CPhysicalDevice::findQueueFamilies(VkSurfaceKHR surface, std:
         i++;
     }
     
+    //async compute: a family that has compute but no graphics (runs on separate hardware queues on most desktop GPUs).
+    //Without one compute stays on the graphics queue, a second queue of the same family has nothing to overlap with
+    for (uint32_t j = 0; j < queueFamilyCount; j++) {
+        if ((queueFamilyProperties[j].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilyProperties[j].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            indices.asyncComputeFamily = j;
+            indices.asyncComputeQueueIndex = 0;
+            break;
+        }
+    }
+
+    //transfer: a family with transfer but neither graphics nor compute, copies there run on the DMA engine
+    for (uint32_t j = 0; j < queueFamilyCount; j++) {
+        VkQueueFlags flags = queueFamilyProperties[j].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT)) {
+            indices.transferFamily = j;
+            break;
+        }
+    }
+
     //if(!selected) debugger->writeMSG("Can NOT find proper queue family!\n");
     return indices;
 }
@@ -130,19 +149,26 @@ void CPhysicalDevice::createLogicalDevices(VkSurfaceKHR surface, const std::vect
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    if (indices.asyncComputeFamily.has_value()) uniqueQueueFamilies.insert(indices.asyncComputeFamily.value());
+    if (indices.transferFamily.has_value()) uniqueQueueFamilies.insert(indices.transferFamily.value());
 
-    float queuePriority = 1.0f;
+    float queuePriorities[2] = {1.0f, 1.0f};
     for (uint32_t queueFamily : uniqueQueueFamilies) {
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount = (indices.asyncComputeFamily.has_value() && queueFamily == indices.asyncComputeFamily.value()) ? indices.asyncComputeQueueIndex + 1 : 1;
+        queueCreateInfo.pQueuePriorities = queuePriorities;
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(handle, &supportedFeatures);
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing; //bindless textures
+    deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery; //GPU profiler
+    bPipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -152,8 +178,173 @@ void CPhysicalDevice::createLogicalDevices(VkSurfaceKHR surface, const std::vect
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(requireDeviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = requireDeviceExtensions.data();
+    //optional extensions: enable them if supported, the renderer falls back to the old path otherwise
+    std::vector<const char*> enabledDeviceExtensions = requireDeviceExtensions;
+    void *pNextFeature = nullptr;
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(handle, &deviceProperties);
+
+    //timeline semaphores: frame sync by value; without them (1.0 instance or device) the renderer keeps its fences
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    if(instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1
+        && checkDeviceExtensionSupport({VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME})){
+        VkPhysicalDeviceFeatures2 deviceFeatures2{};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &timelineSemaphoreFeatures;
+        vkGetPhysicalDeviceFeatures2(handle, &deviceFeatures2);
+        bTimelineSemaphore = timelineSemaphoreFeatures.timelineSemaphore;
+    }else bTimelineSemaphore = false;
+    if(bTimelineSemaphore){
+        enabledDeviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        timelineSemaphoreFeatures = VkPhysicalDeviceTimelineSemaphoreFeaturesKHR{};
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        timelineSemaphoreFeatures.pNext = pNextFeature;
+        pNextFeature = &timelineSemaphoreFeatures;
+    }
+    logManager.print("createLogicalDevices: timeline semaphore %s", bTimelineSemaphore ? "enabled" : "not supported, using fences");
+
+    if(instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1){
+        VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+        subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+        VkPhysicalDeviceProperties2 deviceProperties2{};
+        deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        deviceProperties2.pNext = &subgroupProperties;
+        vkGetPhysicalDeviceProperties2(handle, &deviceProperties2);
+        subgroupSize = subgroupProperties.subgroupSize;
+        bSubgroupQuadCompute = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) && (subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_QUAD_BIT) && subgroupSize >= 4;
+    }
+    logManager.print("createLogicalDevices: subgroup size %d", (int)subgroupSize);
+    logManager.print("createLogicalDevices: quad subgroup operations in compute %s", bSubgroupQuadCompute ? "supported" : "not supported");
+
+    //descriptor indexing (bindless textures): a large update-after-bind sampler array indexed from push constants.
+    //Needs 1.1 for vkGetPhysicalDeviceFeatures2 and maintenance3
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    if(instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1
+        && checkDeviceExtensionSupport({VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME})){
+        VkPhysicalDeviceFeatures2 deviceFeatures2{};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &descriptorIndexingFeatures;
+        vkGetPhysicalDeviceFeatures2(handle, &deviceFeatures2);
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties{};
+        descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 deviceProperties2{};
+        deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        deviceProperties2.pNext = &descriptorIndexingProperties;
+        vkGetPhysicalDeviceProperties2(handle, &deviceProperties2);
+
+        bDescriptorIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing
+            && descriptorIndexingFeatures.runtimeDescriptorArray
+            && descriptorIndexingFeatures.descriptorBindingPartiallyBound
+            && descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount
+            && descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+        maxBindlessTextures = std::min(descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            std::min(descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers));
+    }
+    if(bDescriptorIndexing){
+        enabledDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT enabled{};
+        enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        enabled.runtimeDescriptorArray = VK_TRUE;
+        enabled.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        enabled.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled.shaderSampledImageArrayNonUniformIndexing = descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+        descriptorIndexingFeatures = enabled;
+        descriptorIndexingFeatures.pNext = pNextFeature;
+        pNextFeature = &descriptorIndexingFeatures;
+    }else maxBindlessTextures = 0;
+    logManager.print("createLogicalDevices: descriptor indexing %s", bDescriptorIndexing ? "enabled" : "not supported");
+
+    //push descriptors: set 1 written straight into the command buffer, no descriptor sets for textures
+    bPushDescriptor = instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1
+        && checkDeviceExtensionSupport({VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME});
+    if(bPushDescriptor) enabledDeviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    logManager.print("createLogicalDevices: push descriptor %s", bPushDescriptor ? "enabled" : "not supported");
+
+    //descriptor buffers: descriptors live in a mapped buffer and are selected by offset.
+    //Needs buffer device address for the uniform buffers it references
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures{};
+    descriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bufferDeviceAddressFeatures{};
+    bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+    if(instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1
+        && checkDeviceExtensionSupport({VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
+            VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME})){
+        descriptorBufferFeatures.pNext = &bufferDeviceAddressFeatures;
+        VkPhysicalDeviceFeatures2 deviceFeatures2{};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &descriptorBufferFeatures;
+        vkGetPhysicalDeviceFeatures2(handle, &deviceFeatures2);
+        bDescriptorBuffer = descriptorBufferFeatures.descriptorBuffer && bufferDeviceAddressFeatures.bufferDeviceAddress;
+    }
+    if(bDescriptorBuffer){
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties{};
+        descriptorBufferProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 deviceProperties2{};
+        deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        deviceProperties2.pNext = &descriptorBufferProperties;
+        vkGetPhysicalDeviceProperties2(handle, &deviceProperties2);
+        descriptorBufferOffsetAlignment = descriptorBufferProperties.descriptorBufferOffsetAlignment;
+        uniformBufferDescriptorSize = descriptorBufferProperties.uniformBufferDescriptorSize;
+        combinedImageSamplerDescriptorSize = descriptorBufferProperties.combinedImageSamplerDescriptorSize;
+
+        enabledDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+        enabledDeviceExtensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+        enabledDeviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        if(!bDescriptorIndexing) enabledDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        descriptorBufferFeatures = VkPhysicalDeviceDescriptorBufferFeaturesEXT{};
+        descriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+        descriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+        bufferDeviceAddressFeatures = VkPhysicalDeviceBufferDeviceAddressFeaturesKHR{};
+        bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+        bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+        bufferDeviceAddressFeatures.pNext = pNextFeature;
+        descriptorBufferFeatures.pNext = &bufferDeviceAddressFeatures;
+        pNextFeature = &descriptorBufferFeatures;
+    }
+#endif
+    logManager.print("createLogicalDevices: descriptor buffer %s", bDescriptorBuffer ? "enabled" : "not supported");
+
+    //present id + present wait: the frame pacer waits until a given present is on screen (needs a swapchain)
+#if defined(VK_KHR_present_wait) && defined(VK_KHR_present_id)
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    if(surface != VK_NULL_HANDLE && instanceApiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1
+        && checkDeviceExtensionSupport({VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME})){
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        VkPhysicalDeviceFeatures2 deviceFeatures2{};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(handle, &deviceFeatures2);
+        bPresentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    }
+    if(bPresentWait){
+        enabledDeviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        enabledDeviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentIdFeatures.presentId = VK_TRUE;
+        presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        presentWaitFeatures.pNext = pNextFeature;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        pNextFeature = &presentIdFeatures;
+    }
+#endif
+    logManager.print("createLogicalDevices: present wait %s", bPresentWait ? "enabled" : "not supported");
+
+    createInfo.pNext = pNextFeature;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
 
 #ifndef ANDROID
     if (enableValidationLayers) {
@@ -174,6 +365,17 @@ void CPhysicalDevice::createLogicalDevices(VkSurfaceKHR surface, const std::vect
     vkGetDeviceQueue(logicalDevices.back().get()->logicalDevice, indices.graphicsFamily.value(), 0, &(logicalDevices.back().get()->graphicsQueue)); //graphics queue use physical device's family 0 
     vkGetDeviceQueue(logicalDevices.back().get()->logicalDevice, indices.presentFamily.value(), 0, &(logicalDevices.back().get()->presentQueue)); //present queue use the same family
     vkGetDeviceQueue(logicalDevices.back().get()->logicalDevice, indices.graphicsAndComputeFamily.value(), 0, &(logicalDevices.back().get()->computeQueue));//A physical device has several family, queue is pointing to one of the families
+    logicalDevices.back().get()->graphicsFamily = indices.graphicsFamily.value();
+    if (indices.asyncComputeFamily.has_value()) {
+        vkGetDeviceQueue(logicalDevices.back().get()->logicalDevice, indices.asyncComputeFamily.value(), indices.asyncComputeQueueIndex, &(logicalDevices.back().get()->asyncComputeQueue));
+        logicalDevices.back().get()->asyncComputeFamily = indices.asyncComputeFamily.value();
+        logManager.print("createLogicalDevices: async compute queue family %d, queue index %d", (int)indices.asyncComputeFamily.value(), (int)indices.asyncComputeQueueIndex);
+    } else logManager.print("createLogicalDevices: no async compute queue, compute shares the graphics queue");
+    if (indices.transferFamily.has_value()) {
+        vkGetDeviceQueue(logicalDevices.back().get()->logicalDevice, indices.transferFamily.value(), 0, &(logicalDevices.back().get()->transferQueue));
+        logicalDevices.back().get()->transferFamily = indices.transferFamily.value();
+        logManager.print("createLogicalDevices: transfer queue family %d", (int)indices.transferFamily.value());
+    } else logManager.print("createLogicalDevices: no transfer-only queue, uploads use the graphics queue");
     
 }
 
@@ -0,0 +1,231 @@
+#include "../include/readbackService.h"
+
+CReadbackService::CReadbackService(){}
+CReadbackService::~CReadbackService(){}
+
+void CReadbackService::Init(uint32_t slotCount){
+    m_slots.resize(std::max(slotCount, 1u));
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily();
+    VkResult result = vkCreateCommandPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &m_commandPool);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create readback command pool!");
+}
+
+void CReadbackService::Destroy(){
+    if(m_commandPool == VK_NULL_HANDLE) return;
+    Flush();
+
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    for(auto &slot : m_slots){
+        if(slot.capacity > 0){
+            vkUnmapMemory(device, slot.buffer.deviceMemory);
+            slot.buffer.DestroyAndFree();
+        }
+        if(slot.fence != VK_NULL_HANDLE) vkDestroyFence(device, slot.fence, nullptr);
+    }
+    m_slots.clear();
+    vkDestroyCommandPool(device, m_commandPool, nullptr); //frees the slot command buffers
+    m_commandPool = VK_NULL_HANDLE;
+
+    if(deliveredImages > 0 || droppedRequests > 0)
+        std::cout<<"Readback service: "<<deliveredImages<<" images, "<<readbackBytes<<" bytes, "<<droppedRequests<<" dropped, "
+            <<averageLatency<<" ms average latency"<<std::endl;
+}
+
+uint32_t CReadbackService::GetBytesPerPixel(VkFormat format){
+    switch(format){
+        case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM: case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32: case VK_FORMAT_R32_SFLOAT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+/*******************
+*	Requests
+********************/
+bool CReadbackService::RequestImage(VkImage image, VkImageLayout layout, uint32_t width, uint32_t height, VkFormat format, Callback callback){
+    uint32_t bytesPerPixel = GetBytesPerPixel(format);
+    if(bytesPerPixel == 0 || m_slots.empty()){
+        droppedRequests++;
+        return false;
+    }
+    Slot &slot = m_slots[m_nextSlot];
+    if(slot.state != SLOT_FREE){ //the ring is full: the oldest copy is still in flight or undelivered
+        droppedRequests++;
+        return false;
+    }
+
+    slot.size = (VkDeviceSize)width * height * bytesPerPixel;
+    if(slot.capacity < slot.size){ //grow once to the largest image requested through this slot, then reuse
+        VkDevice device = CContext::GetHandle().GetLogicalDevice();
+        if(slot.capacity > 0){
+            vkUnmapMemory(device, slot.buffer.deviceMemory);
+            slot.buffer.DestroyAndFree();
+        }
+        slot.buffer = CWxjBuffer();
+        slot.buffer.bPreferHostCached = true;
+        slot.buffer.init(slot.size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        void *pGpuMemory;
+        vkMapMemory(device, slot.buffer.deviceMemory, 0, VK_WHOLE_SIZE, 0, &pGpuMemory);
+        slot.mapped = (uint8_t*)pGpuMemory;
+        slot.capacity = slot.size;
+    }
+    slot.image = image;
+    slot.layout = layout;
+    slot.width = width;
+    slot.height = height;
+    slot.format = format;
+    slot.callback = callback;
+    slot.requestTime = std::chrono::high_resolution_clock::now();
+    slot.state = SLOT_QUEUED;
+
+    m_order.push_back(m_nextSlot);
+    m_nextSlot = (m_nextSlot + 1) % m_slots.size();
+    return true;
+}
+
+void CReadbackService::RecordCopy(VkCommandBuffer commandBuffer, Slot &slot){
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = slot.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barrier.oldLayout = slot.layout;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {slot.width, slot.height, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, slot.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer.buffer, 1, &region);
+
+    //back to where the rest of the frame (present) or the next frame expects the image
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = slot.layout;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferMemoryBarrier hostBarrier{};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = slot.buffer.buffer;
+    hostBarrier.offset = 0;
+    hostBarrier.size = slot.size;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+}
+
+void CReadbackService::RecordCopies(VkCommandBuffer commandBuffer, uint64_t frameNumber){
+    m_lastFrameNumber = frameNumber;
+    for(uint32_t id : m_order){
+        Slot &slot = m_slots[id];
+        if(slot.state != SLOT_QUEUED) continue;
+        RecordCopy(commandBuffer, slot);
+        slot.frameNumber = frameNumber;
+        slot.state = SLOT_RECORDED;
+    }
+}
+
+void CReadbackService::SubmitCopies(uint64_t frameNumber){
+    m_lastFrameNumber = frameNumber;
+    VkDevice device = CContext::GetHandle().GetLogicalDevice();
+    for(uint32_t id : m_order){
+        Slot &slot = m_slots[id];
+        if(slot.state != SLOT_QUEUED) continue;
+
+        //the command buffer and fence stay with the slot, a slot is reused only after its fence was seen signaled
+        if(slot.commandBuffer == VK_NULL_HANDLE){
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = m_commandPool;
+            allocInfo.commandBufferCount = 1;
+            vkAllocateCommandBuffers(device, &allocInfo, &slot.commandBuffer);
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(device, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+                throw std::runtime_error("failed to create readback fence!");
+        }else vkResetFences(device, 1, &slot.fence);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+        RecordCopy(slot.commandBuffer, slot); //same queue as the frame, the barrier orders it after the frame's commands
+        vkEndCommandBuffer(slot.commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &slot.commandBuffer;
+        if (vkQueueSubmit(CContext::GetHandle().GetGraphicsQueue(), 1, &submitInfo, slot.fence) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit readback command buffer!");
+        slot.frameNumber = frameNumber;
+        slot.state = SLOT_SUBMITTED;
+    }
+}
+
+/*******************
+*	Delivery
+********************/
+void CReadbackService::Deliver(Slot &slot){
+    PROFILE_SCOPE("readback deliver");
+    VkMappedMemoryRange range{VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr, slot.buffer.deviceMemory, 0, VK_WHOLE_SIZE};
+    vkInvalidateMappedMemoryRanges(CContext::GetHandle().GetLogicalDevice(), 1, &range); //host cached memory may not be coherent
+
+    Pixels pixels;
+    pixels.data = slot.mapped;
+    pixels.width = slot.width;
+    pixels.height = slot.height;
+    pixels.rowPitch = slot.width * GetBytesPerPixel(slot.format);
+    pixels.format = slot.format;
+    pixels.frameNumber = slot.frameNumber;
+    if(slot.callback) slot.callback(pixels);
+
+    double latency = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - slot.requestTime).count();
+    averageLatency = (deliveredImages == 0) ? latency : averageLatency * 0.9 + latency * 0.1;
+    readbackBytes += slot.size;
+    deliveredImages++;
+
+    slot.callback = nullptr;
+    slot.state = SLOT_FREE;
+}
+
+void CReadbackService::Poll(uint64_t completedFrames){
+    //in request order, so a video encoder receives frames in sequence
+    while(!m_order.empty()){
+        Slot &slot = m_slots[m_order.front()];
+        bool bDone = false;
+        if(slot.state == SLOT_RECORDED) bDone = slot.frameNumber < completedFrames;
+        else if(slot.state == SLOT_SUBMITTED) bDone = vkGetFenceStatus(CContext::GetHandle().GetLogicalDevice(), slot.fence) == VK_SUCCESS;
+        if(!bDone) break;
+        Deliver(slot);
+        m_order.pop_front();
+    }
+}
+
+void CReadbackService::Flush(){
+    if(m_order.empty()) return;
+    SubmitCopies(m_lastFrameNumber); //requests made after the last frame copy that frame's result
+    vkQueueWaitIdle(CContext::GetHandle().GetGraphicsQueue());
+    while(!m_order.empty()){
+        Deliver(m_slots[m_order.front()]);
+        m_order.pop_front();
+    }
+}
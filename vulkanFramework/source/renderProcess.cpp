@@ -339,7 +339,7 @@ void CRenderProcess::create_attachment_description_light_depth(VkFormat depthFor
     
 }
 
-void CRenderProcess::create_attachment_description_color_present(VkFormat swapChainImageFormat){  
+void CRenderProcess::create_attachment_description_color_present(VkFormat swapChainImageFormat, VkImageLayout imageLayout){  
 	//bUseAttachmentColorPresent = true;
 
 	attachment_description_color_present.format = swapChainImageFormat;
@@ -349,7 +349,7 @@ void CRenderProcess::create_attachment_description_color_present(VkFormat swapCh
 	attachment_description_color_present.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	attachment_description_color_present.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	attachment_description_color_present.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	attachment_description_color_present.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	attachment_description_color_present.finalLayout = imageLayout;
 }
 
 void CRenderProcess::create_attachment_description_camera_depth(VkFormat depthFormat, VkSampleCountFlagBits msaaSamples){  
@@ -450,6 +450,11 @@ void CRenderProcess::createGraphicsPipelineLayout(std::vector<VkDescriptorSetLay
 	createGraphicsPipelineLayout(descriptorSetLayouts, dummyPushConstantRange, false, graphicsPipelineLayout_id);
 }
 void CRenderProcess::createGraphicsPipelineLayout(std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, VkPushConstantRange &pushConstantRange, bool bUsePushConstant, int graphicsPipelineLayout_id){
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	if(bUsePushConstant) pushConstantRanges.push_back(pushConstantRange);
+	createGraphicsPipelineLayout(descriptorSetLayouts, pushConstantRanges, graphicsPipelineLayout_id);
+}
+void CRenderProcess::createGraphicsPipelineLayout(std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, std::vector<VkPushConstantRange> &pushConstantRanges, int graphicsPipelineLayout_id){
 	VkResult result = VK_SUCCESS;
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -463,9 +468,9 @@ void CRenderProcess::createGraphicsPipelineLayout(std::vector<VkDescriptorSetLay
 	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();//  descriptorSetLayout;//todo: LAYOUT
 	//}
 
-	if(bUsePushConstant){
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if(!pushConstantRanges.empty()){
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 	}
 
 	//Create Graphics Pipeline Layout
@@ -1,4 +1,5 @@
 #include "../include/renderer.h"
+#include "../include/metrics.h"
 
 CRenderer::CRenderer(){
     currentFrame = 0;
@@ -13,6 +14,7 @@ CRenderer::~CRenderer(){
 
 void CRenderer::Update(){
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    frameNumber++;
 }
 
 void CRenderer::CreateIndexBuffer(std::vector<uint32_t> &indices3D){
@@ -24,11 +26,12 @@ void CRenderer::CreateIndexBuffer(std::vector<uint32_t> &indices3D){
 
     //VK_BUFFER_USAGE_TRANSFER_SRC_BIT
     //VkResult result = InitDataBufferHelper(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &indexDataBuffer);
+    indexDataBuffer.bDeviceLocal = true;
     VkResult result = indexDataBuffer.init(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
 	//REPORT("InitIndexDataBuffer");
     //FillDataBufferHelper(indexDataBuffer, (void *)(indices3D.data()));
-	indexDataBuffer.fill((void *)(indices3D.data()));
+    uploadService.UploadBuffer(indices3D.data(), bufferSize, indexDataBuffer.buffer); //see CreateVertexBuffer
 
     indexDataBuffers.push_back(indexDataBuffer);
     indices3Ds.push_back(indices3D);
@@ -56,18 +59,49 @@ void CRenderer::CreateCommandPool(VkSurfaceKHR &surface) {
     result = vkCreateCommandPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &commandPool);
     if (result != VK_SUCCESS) throw std::runtime_error("failed to create graphics command pool!");
     //REPORT("vkCreateCommandPool -- Graphics");
+
+    uploadService.Init();
+    readbackService.Init();
 }
 
 void CRenderer::CreateGraphicsCommandBuffer(){
     graphicsCmdId = commandBuffers.size();
     //std::cout<<"graphicsCmdId="<<graphicsCmdId<<std::endl;
-    CreateCommandBuffers();
+    CreateCommandBuffers(commandPool);
 }
 void CRenderer::CreateComputeCommandBuffer(){
     computeCmdId = commandBuffers.size();
-    CreateCommandBuffers();
+
+    if(UseAsyncCompute()){
+        m_computeQueue = CContext::GetHandle().physicalDevice->get()->getAsyncComputeQueue();
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = CContext::GetHandle().physicalDevice->get()->getAsyncComputeQueueFamily();
+        VkResult result = vkCreateCommandPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &computeCommandPool);
+        if (result != VK_SUCCESS) throw std::runtime_error("failed to create compute command pool!");
+        std::cout<<"Async compute: queue family "<<poolInfo.queueFamilyIndex<<std::endl;
+    }else{
+        m_computeQueue = CContext::GetHandle().GetComputeQueue();
+        computeCommandPool = commandPool;
+    }
+
+    CreateCommandBuffers(computeCommandPool);
+}
+bool CRenderer::UseAsyncCompute(){
+    //other compute modes write swapchain/texture images owned by the graphics family, keep them on the graphics queue.
+    //Only a separate family is worth it: a second queue of the graphics family usually maps to the same hardware queue
+    CPhysicalDevice *physicalDevice = CContext::GetHandle().physicalDevice->get();
+    return m_renderMode == COMPUTE_GRAPHICS && physicalDevice->getAsyncComputeQueue() != VK_NULL_HANDLE
+        && physicalDevice->getAsyncComputeQueueFamily() != physicalDevice->getGraphicsQueueFamily();
+}
+std::vector<uint32_t> CRenderer::GetSharedQueueFamilies(){
+    //Storage buffers are written by compute frame N and read as vertex buffer by graphics frame N, while compute frame N+1 reads them as input.
+    //Exclusive ownership would force compute N+1 to wait for graphics N to release the buffer, so share them concurrently instead.
+    if(!UseAsyncCompute()) return {};
+    return {CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily(), CContext::GetHandle().physicalDevice->get()->getAsyncComputeQueueFamily()};
 }
-void CRenderer::CreateCommandBuffers() {
+void CRenderer::CreateCommandBuffers(VkCommandPool &pool) {
     //commandBuffers.resize(size); //if enable both graphics and compute pipelines, set 2 commandBuffers: 0-GRAPHCIS, 1-COMPUTE
     std::vector<VkCommandBuffer> commandBuffer;
 
@@ -79,7 +113,7 @@ void CRenderer::CreateCommandBuffers() {
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
+    allocInfo.commandPool = pool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = (uint32_t)commandBuffer.size();
 
@@ -113,6 +147,11 @@ void CRenderer::CreateCommandBuffers() {
  * 
  * ***********************/
 void CRenderer::AquireSwapchainImage(CSwapchain &swapchain){
+    PROFILE_SCOPE("acquire");
+    if(bHeadless){
+        imageIndex = currentFrame; //the frame fence/timeline wait already made this image free
+        return;
+    }
     VkResult result = vkAcquireNextImageKHR(CContext::GetHandle().GetLogicalDevice(), swapchain.getHandle(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 }
 
@@ -121,16 +160,15 @@ void CRenderer::WaitForComputeFence(){
 }
 
 void CRenderer::SubmitCompute(){
+    PROFILE_SCOPE("submit compute");
     //if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
     //    vkWaitForFences(CContext::GetHandle().GetLogicalDevice(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
     //}
     //imagesInFlight[imageIndex] = inFlightFences[currentFrame];
-    //vkWaitForFences(CContext::GetHandle().GetLogicalDevice(), 1, &computeInFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
 
     //printf("currentFrame: %d, imageIndex: %d \n", currentFrame, imageIndex);
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    SubmitSemaphores semaphores;
 
     //this code handles compute semaphores
     switch(m_renderMode){
@@ -141,40 +179,33 @@ void CRenderer::SubmitCompute(){
             //Pure compute application doesn't need swap image or present
         break;
         case COMPUTE_SWAPCHAIN:
-        {
             //Because this mode use swap image to present, wait swap image to be ready
-            VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] }; //to wait until image is ready
-            VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = waitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages;
-
+            if(bHeadless) break;
+            semaphores.AddWait(imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
             //Also because this mode need present swap image, need to tell present that compute is finished
-            VkSemaphore signalSemaphores[] = { computeFinishedSemaphores[currentFrame] }; 
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores = signalSemaphores;
-        }
+            semaphores.AddSignal(computeFinishedSemaphores[currentFrame]);
         break;
         case COMPUTE_GRAPHICS:
-        {
             //This mode doesn't interact with swap image, this semaphore is to tell graphics that compute is finished
-            VkSemaphore signalSemaphores[] = { computeFinishedSemaphores[currentFrame] }; 
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores = signalSemaphores;
-        }
+            //(with timeline semaphore, graphics waits on the compute timeline value instead)
+            if(!bEnableTimelineSemaphore) semaphores.AddSignal(computeFinishedSemaphores[currentFrame]);
         break;
         default:
         break;
     }
 
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[computeCmdId][currentFrame];///!!!
-
-    vkResetFences(CContext::GetHandle().GetLogicalDevice(), 1, &computeInFlightFences[currentFrame]);
-
-    if (vkQueueSubmit(CContext::GetHandle().GetComputeQueue(), 1, &submitInfo, computeInFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    if(bEnableTimelineSemaphore){
+        //input storage buffer of this frame is the output of the previous compute submission
+        if(frameNumber > 0) semaphores.AddWait(computeTimelineSemaphore, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, frameNumber);
+        semaphores.AddSignal(computeTimelineSemaphore, frameNumber + 1);
+        QueueSubmit(m_computeQueue, commandBuffers[computeCmdId][currentFrame], semaphores, VK_NULL_HANDLE);
+    }else{
+        vkResetFences(CContext::GetHandle().GetLogicalDevice(), 1, &computeInFlightFences[currentFrame]);
+        QueueSubmit(m_computeQueue, commandBuffers[computeCmdId][currentFrame], semaphores, computeInFlightFences[currentFrame]);
+        m_fenceFrameNumbers[currentFrame] = frameNumber;
     }
+    m_submittedFrames = frameNumber + 1;
+    gpuProfiler.Submitted(currentFrame, CGpuProfiler::QUEUE_COMPUTE, frameNumber);
 }
 
 void CRenderer::WaitForGraphicsFence(){
@@ -185,20 +216,14 @@ void CRenderer::WaitForGraphicsFence(){
 }
 
 void CRenderer::SubmitGraphics(){
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    PROFILE_SCOPE("submit graphics");
+    SubmitSemaphores semaphores;
 
     //this code handles graphics semaphores
     switch(m_renderMode){
         case GRAPHICS:
-        {
             //pure graphics pipeline, need wait swap image is ready
-            VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame] };
-            VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = waitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages;
-        }
+            if(!bHeadless) semaphores.AddWait(imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
         break;
         case COMPUTE:
             //pure compute application doen't need graphics pipeline
@@ -207,42 +232,147 @@ void CRenderer::SubmitGraphics(){
             //if render direct on swap image, doesn't need graphics pipeline
         break;
         case COMPUTE_GRAPHICS:
-        {
             //graphics/compute pipeline hybrid, need wait both swap image and compute are ready
-            VkSemaphore waitSemaphores[] = {computeFinishedSemaphores[currentFrame], imageAvailableSemaphores[currentFrame] };
-            VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            submitInfo.waitSemaphoreCount = 2;
-            submitInfo.pWaitSemaphores = waitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages;
-        }
+            if(bEnableTimelineSemaphore) semaphores.AddWait(computeTimelineSemaphore, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, frameNumber + 1);
+            else semaphores.AddWait(computeFinishedSemaphores[currentFrame], VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+            if(!bHeadless) semaphores.AddWait(imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
         break;
         default:
         break;
     }
-   
 
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[graphicsCmdId][currentFrame];
-
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    vkResetFences(CContext::GetHandle().GetLogicalDevice(), 1, &inFlightFences[currentFrame]);
+    if(!bHeadless) semaphores.AddSignal(renderFinishedSemaphores[currentFrame]); //nothing presents in headless mode
 
     //std::cout<<"before graphics submit. "<<std::endl;
     //GPU read recorded command buffer and execute
-    if (vkQueueSubmit(CContext::GetHandle().GetGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        //debugger->writeMSG("Failed to submit draw command buffer! CurrentFrame: %d\n", currentFrame);
-        throw std::runtime_error("failed to submit draw command buffer!");
+    if(bEnableTimelineSemaphore){
+        semaphores.AddSignal(graphicsTimelineSemaphore, frameNumber + 1);
+        QueueSubmit(CContext::GetHandle().GetGraphicsQueue(), commandBuffers[graphicsCmdId][currentFrame], semaphores, VK_NULL_HANDLE);
+    }else{
+        vkResetFences(CContext::GetHandle().GetLogicalDevice(), 1, &inFlightFences[currentFrame]);
+        QueueSubmit(CContext::GetHandle().GetGraphicsQueue(), commandBuffers[graphicsCmdId][currentFrame], semaphores, inFlightFences[currentFrame]);
+        m_fenceFrameNumbers[currentFrame] = frameNumber;
     }
+    m_submittedFrames = frameNumber + 1;
+    gpuProfiler.Submitted(currentFrame, CGpuProfiler::QUEUE_GRAPHICS, frameNumber);
     //std::cout<<"Done submit. "<<std::endl;
 
     //after command is submitted, reset command buffer
     //vkResetCommandBuffer(commandBuffers[graphicsCmdId][currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
 }
 
+void CRenderer::QueueSubmit(VkQueue queue, VkCommandBuffer &commandBuffer, SubmitSemaphores &semaphores, VkFence fence){
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = semaphores.waitCount;
+    submitInfo.pWaitSemaphores = semaphores.waitSemaphores;
+    submitInfo.pWaitDstStageMask = semaphores.waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = semaphores.signalCount;
+    submitInfo.pSignalSemaphores = semaphores.signalSemaphores;
+
+    //binary semaphores in the same submission ignore their values
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.waitSemaphoreValueCount = semaphores.waitCount;
+    timelineInfo.pWaitSemaphoreValues = semaphores.waitValues;
+    timelineInfo.signalSemaphoreValueCount = semaphores.signalCount;
+    timelineInfo.pSignalSemaphoreValues = semaphores.signalValues;
+    if(bEnableTimelineSemaphore) submitInfo.pNext = &timelineInfo;
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        //debugger->writeMSG("Failed to submit draw command buffer! CurrentFrame: %d\n", currentFrame);
+        throw std::runtime_error("failed to submit draw command buffer!");
+    }
+}
+
+void CRenderer::WaitForFrameResources(){
+    PROFILE_SCOPE("wait frame");
+    if(CMetrics::bEnabled){
+        static CMetrics::Counter &frames = CMetrics::GetCounter("frames_total", "Frames rendered");
+        static CMetrics::Histogram &frameTime = CMetrics::GetHistogram("frame_time_us", "Time between frame starts, microseconds");
+        auto now = std::chrono::steady_clock::now();
+        if(frames.Get() > 0) frameTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastFrameWait).count());
+        m_lastFrameWait = now;
+        frames.Add();
+        CMetrics::Update();
+    }
+    uploadService.Poll(); //submit/retire uploads (or their acquires, with a transfer queue worker), never waits
+
+    if(!bEnableTimelineSemaphore){
+        switch(m_renderMode){
+            case GRAPHICS:
+                WaitForGraphicsFence();
+            break;
+            case COMPUTE:
+            case COMPUTE_SWAPCHAIN:
+                WaitForComputeFence();
+            break;
+            case COMPUTE_GRAPHICS:
+                WaitForComputeFence();
+                WaitForGraphicsFence();
+            break;
+            default:
+            break;
+        }
+        ReadQueueTiming();
+        gpuProfiler.Resolve(currentFrame);
+        return;
+    }
+
+    //slot currentFrame was last used by frame (frameNumber - MAX_FRAMES_IN_FLIGHT), which signaled this value
+    if(frameNumber < MAX_FRAMES_IN_FLIGHT) return;
+    uint64_t slotValue = frameNumber + 1 - MAX_FRAMES_IN_FLIGHT;
+    switch(m_renderMode){
+        case GRAPHICS:
+            WaitForTimeline(graphicsTimelineSemaphore, slotValue);
+        break;
+        case COMPUTE:
+        case COMPUTE_SWAPCHAIN:
+            WaitForTimeline(computeTimelineSemaphore, slotValue);
+        break;
+        case COMPUTE_GRAPHICS:
+            //graphics of that frame waited for its compute on the GPU, so one wait covers both command buffers
+            WaitForTimeline(graphicsTimelineSemaphore, slotValue);
+        break;
+        default:
+        break;
+    }
+    ReadQueueTiming();
+    gpuProfiler.Resolve(currentFrame);
+}
+
+uint64_t CRenderer::GetCompletedFrameCount(){
+    //the last submission of a frame is graphics when there is one, compute otherwise
+    bool bGraphics = (m_renderMode == GRAPHICS || m_renderMode == COMPUTE_GRAPHICS);
+    if(bEnableTimelineSemaphore){
+        uint64_t value = 0; //frame N signals N+1
+        m_pfnGetSemaphoreCounterValue(CContext::GetHandle().GetLogicalDevice(), bGraphics ? graphicsTimelineSemaphore : computeTimelineSemaphore, &value);
+        return value;
+    }
+    //frames finish in submission order, so the oldest frame whose fence is still unsignaled bounds the count
+    uint64_t completed = m_submittedFrames;
+    for(uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
+        VkFence fence = bGraphics ? inFlightFences[i] : computeInFlightFences[i];
+        if(vkGetFenceStatus(CContext::GetHandle().GetLogicalDevice(), fence) != VK_SUCCESS) completed = std::min(completed, m_fenceFrameNumbers[i]);
+    }
+    return completed;
+}
+
+void CRenderer::WaitForTimeline(VkSemaphore semaphore, uint64_t value){
+    VkSemaphoreWaitInfoKHR waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+    m_pfnWaitSemaphores(CContext::GetHandle().GetLogicalDevice(), &waitInfo, UINT64_MAX);
+}
+
 void CRenderer::PresentSwapchainImage(CSwapchain &swapchain){
+    if(bHeadless) return;
+    PROFILE_SCOPE("present");
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -278,6 +408,16 @@ void CRenderer::PresentSwapchainImage(CSwapchain &swapchain){
 
     presentInfo.pImageIndices = &imageIndex;
 
+    //present id: the frame pacer waits for it to be on screen
+    uint64_t presentId = framePacer.Presenting(swapchain.getHandle());
+#if defined(VK_KHR_present_wait) && defined(VK_KHR_present_id)
+    VkPresentIdKHR presentIdInfo{};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+    if(presentId != 0) presentInfo.pNext = &presentIdInfo;
+#endif
+
     VkResult result = vkQueuePresentKHR(CContext::GetHandle().GetPresentQueue(), &presentInfo);
 }
 
@@ -360,6 +500,7 @@ void CRenderer::CreateSyncObjects(int swapchainSize) {
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     //computeFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    m_fenceFrameNumbers.resize(MAX_FRAMES_IN_FLIGHT, 0);
     //computeInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
     computeFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);;
@@ -390,6 +531,124 @@ void CRenderer::CreateSyncObjects(int swapchainSize) {
             //throw std::runtime_error("failed to create compute synchronization objects for a frame!");
         //}
     }
+
+    //timeline semaphores start at 0; frame N signals N+1
+    bEnableTimelineSemaphore = CContext::GetHandle().physicalDevice->get()->bTimelineSemaphore;
+    if(bEnableTimelineSemaphore){
+        m_pfnWaitSemaphores = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(CContext::GetHandle().GetLogicalDevice(), "vkWaitSemaphoresKHR");
+        m_pfnGetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(CContext::GetHandle().GetLogicalDevice(), "vkGetSemaphoreCounterValueKHR");
+        if(m_pfnWaitSemaphores == nullptr || m_pfnGetSemaphoreCounterValue == nullptr) bEnableTimelineSemaphore = false;
+    }
+    if(bEnableTimelineSemaphore){
+        VkSemaphoreTypeCreateInfoKHR timelineCreateInfo{};
+        timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+        timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        timelineCreateInfo.initialValue = 0;
+        VkSemaphoreCreateInfo timelineSemaphoreInfo{};
+        timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineSemaphoreInfo.pNext = &timelineCreateInfo;
+        if (vkCreateSemaphore(CContext::GetHandle().GetLogicalDevice(), &timelineSemaphoreInfo, nullptr, &computeTimelineSemaphore) != VK_SUCCESS ||
+            vkCreateSemaphore(CContext::GetHandle().GetLogicalDevice(), &timelineSemaphoreInfo, nullptr, &graphicsTimelineSemaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timeline semaphores!");
+        }
+    }
+    std::cout<<"Frame scheduler: "<<(bEnableTimelineSemaphore ? "timeline semaphore" : "fence")<<", frames in flight = "<<MAX_FRAMES_IN_FLIGHT<<std::endl;
+
+    CreateQueueTiming();
+    gpuProfiler.Init(UseAsyncCompute() ? CContext::GetHandle().physicalDevice->get()->getAsyncComputeQueueFamily()
+        : CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily());
+    framePacer.Init();
+}
+
+/**************************
+ * 
+ * Queue Timing
+ * 
+ * ***********************/
+void CRenderer::CreateQueueTiming(){
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(CContext::GetHandle().GetPhysicalDevice(), &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    //every queue family that writes timestamps must support them
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(CContext::GetHandle().GetPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(CContext::GetHandle().GetPhysicalDevice(), &queueFamilyCount, queueFamilyProperties.data());
+    bEnableQueueTiming = queueFamilyProperties[CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily()].timestampValidBits > 0;
+    if(UseAsyncCompute()) 
+        bEnableQueueTiming = bEnableQueueTiming && queueFamilyProperties[CContext::GetHandle().physicalDevice->get()->getAsyncComputeQueueFamily()].timestampValidBits > 0;
+    if(!bEnableQueueTiming) return;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 4 * MAX_FRAMES_IN_FLIGHT;
+    if (vkCreateQueryPool(CContext::GetHandle().GetLogicalDevice(), &queryPoolInfo, nullptr, &queueTimingQueryPool) != VK_SUCCESS) 
+        throw std::runtime_error("failed to create timestamp query pool!");
+    queueTimingWritten.assign(2 * MAX_FRAMES_IN_FLIGHT, false);
+}
+
+void CRenderer::WriteQueueTimestamp(bool bCompute, bool bEnd){
+    if(!bEnableQueueTiming) return;
+    uint32_t firstQuery = 4 * currentFrame + 2 * bCompute;
+    VkCommandBuffer commandBuffer = commandBuffers[bCompute ? computeCmdId : graphicsCmdId][currentFrame];
+    if(!bEnd){
+        vkCmdResetQueryPool(commandBuffer, queueTimingQueryPool, firstQuery, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queueTimingQueryPool, firstQuery);
+    }else{
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queueTimingQueryPool, firstQuery + 1);
+        queueTimingWritten[2 * currentFrame + bCompute] = true;
+    }
+}
+
+void CRenderer::ReadQueueTiming(){
+    if(!bEnableQueueTiming) return;
+    for(uint32_t bCompute = 0; bCompute < 2; bCompute++){
+        if(!queueTimingWritten[2 * currentFrame + bCompute]) continue;
+        uint64_t timestamps[2];
+        VkResult result = vkGetQueryPoolResults(CContext::GetHandle().GetLogicalDevice(), queueTimingQueryPool, 4 * currentFrame + 2 * bCompute, 2, 
+            sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if(result != VK_SUCCESS) continue; //VK_NOT_READY: slot is still in flight
+        //pre-recorded buffers (COMPUTE_SWAPCHAIN) reset and write their queries on every submit, keep reading them
+        if(m_renderMode != COMPUTE_SWAPCHAIN) queueTimingWritten[2 * currentFrame + bCompute] = false;
+
+        double time = (double)(timestamps[1] - timestamps[0]) * timestampPeriod / 1000000.0;
+        double &average = bCompute ? computeQueueTime : graphicsQueueTime;
+        average = (average == 0) ? time : average * 0.95 + time * 0.05;
+        static CMetrics::Histogram &graphicsQueueHistogram = CMetrics::GetHistogram("gpu_queue_time_us", "GPU time of a frame's submission, microseconds", "queue=\"graphics\"");
+        static CMetrics::Histogram &computeQueueHistogram = CMetrics::GetHistogram("gpu_queue_time_us", "GPU time of a frame's submission, microseconds", "queue=\"compute\"");
+        (bCompute ? computeQueueHistogram : graphicsQueueHistogram).Record((uint64_t)(time * 1000.0));
+    }
+
+    //always in the report, the binary log and the gpu_queue_time_us metric; printed only next to the GPU profile
+    if(gpuProfiler.bEnabled && gpuProfiler.summaryInterval > 0 && frameNumber > 0 && frameNumber % gpuProfiler.summaryInterval == 0)
+        std::cout<<"Queue time(ms): graphics = "<<graphicsQueueTime<<", compute = "<<computeQueueTime
+            <<(UseAsyncCompute() ? " (async compute queue)" : "")<<std::endl;
+}
+
+/**************************
+ * 
+ * GPU Profiler
+ * 
+ * ***********************/
+int CRenderer::BeginGpuScope(const std::string &name, bool bCompute){
+    if(!gpuProfiler.bEnabled) return -1;
+    return gpuProfiler.BeginScope(commandBuffers[bCompute ? computeCmdId : graphicsCmdId][currentFrame], currentFrame,
+        bCompute ? CGpuProfiler::QUEUE_COMPUTE : CGpuProfiler::QUEUE_GRAPHICS, name);
+}
+
+void CRenderer::EndGpuScope(int scope, bool bCompute){
+    if(scope < 0) return;
+    gpuProfiler.EndScope(commandBuffers[bCompute ? computeCmdId : graphicsCmdId][currentFrame], currentFrame,
+        bCompute ? CGpuProfiler::QUEUE_COMPUTE : CGpuProfiler::QUEUE_GRAPHICS, scope);
+}
+
+void CRenderer::NextSubpass(){
+    EndGpuScope(m_subpassScope);
+    vkCmdNextSubpass(commandBuffers[graphicsCmdId][currentFrame], VK_SUBPASS_CONTENTS_INLINE);
+    m_subpass++;
+    if(gpuProfiler.bEnabled) m_subpassScope = BeginGpuScope("subpass " + std::to_string(m_subpass));
 }
 
 
@@ -398,6 +657,8 @@ void CRenderer::StartRecordGraphicsCommandBuffer(VkRenderPass &renderPass,
         std::vector<VkClearValue> &clearValues){
     //std::cout<<"start record start"<<std::endl;
     BeginCommandBuffer(graphicsCmdId);
+    WriteQueueTimestamp(false, false);
+    gpuProfiler.BeginCommandBuffer(commandBuffers[graphicsCmdId][currentFrame], currentFrame, CGpuProfiler::QUEUE_GRAPHICS);
     //std::cout<<"BeginCommandBuffer done"<<std::endl;
     BeginRenderPass(renderPass, swapChainFramebuffers, extent, clearValues);
     //std::cout<<"BeginRenderPass done"<<std::endl;
@@ -410,6 +671,9 @@ void CRenderer::StartRecordGraphicsCommandBuffer(VkRenderPass &renderPass,
 }
 void CRenderer::EndRecordGraphicsCommandBuffer(){
 	EndRenderPass();
+    readbackService.RecordCopies(commandBuffers[graphicsCmdId][currentFrame], frameNumber); //after the render pass, before present
+    WriteQueueTimestamp(false, true);
+    gpuProfiler.EndCommandBuffer(commandBuffers[graphicsCmdId][currentFrame], currentFrame, CGpuProfiler::QUEUE_GRAPHICS);
 	EndCommandBuffer(graphicsCmdId);
 }
 
@@ -445,7 +709,10 @@ void CRenderer::BeginRenderPass(VkRenderPass &renderPass, std::vector<VkFramebuf
     //}
 
     //Step2
+    m_renderPassScope = BeginGpuScope("render pass");
     vkCmdBeginRenderPass(commandBuffers[graphicsCmdId][currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    m_subpass = 0;
+    m_subpassScope = BeginGpuScope("subpass 0");
 }
 void CRenderer::BindPipeline(VkPipeline &pipeline, VkPipelineBindPoint pipelineBindPoint, int commandBufferIndex){
 	vkCmdBindPipeline(commandBuffers[commandBufferIndex][currentFrame], pipelineBindPoint, pipeline); //renderProcess.graphicsPipeline
@@ -488,6 +755,7 @@ void CRenderer::BindDescriptorSets(VkPipelineLayout &pipelineLayout, std::vector
     //unsigned int setCount = 1;
     //VkDescriptorSet sets[setCount] = { descriptorSets[currentFrame] };
     unsigned int setCount = descriptorSets.size();
+    PROFILE_COUNTER("descriptor binds", 1);
     //std::cout<<"setCount = "<<setCount<<std::endl;
     //VkDescriptorSet sets[setCount] = { descriptorSets[0][currentFrame] };
     //VkDescriptorSet sets[setCount] = { descriptorSets[0][currentFrame], descriptorSets[1][currentFrame] };
@@ -534,14 +802,19 @@ void CRenderer::BindComputeDescriptorSets(VkPipelineLayout &pipelineLayout, std:
 }
 
 void CRenderer::DrawIndexed(int model_id){
+    PROFILE_COUNTER("draws", 1);
 	//vkCmdDrawIndexed(commandBuffers[graphicsCmdId][currentFrame], static_cast<uint32_t>(indices3D.size()), 1, 0, 0, 0);
     vkCmdDrawIndexed(commandBuffers[graphicsCmdId][currentFrame], static_cast<uint32_t>(indices3Ds[model_id].size()), 1, 0, 0, 0);
 }
 void CRenderer::Draw(uint32_t n){
+    PROFILE_COUNTER("draws", 1);
 	vkCmdDraw(commandBuffers[graphicsCmdId][currentFrame], n, 1, 0, 0);
 }
 void CRenderer::EndRenderPass(){
+    EndGpuScope(m_subpassScope);
 	vkCmdEndRenderPass(commandBuffers[graphicsCmdId][currentFrame]);
+    EndGpuScope(m_renderPassScope);
+    m_subpassScope = m_renderPassScope = -1;
 }
 void CRenderer::EndCommandBuffer(int commandBufferIndex){
 	if (vkEndCommandBuffer(commandBuffers[commandBufferIndex][currentFrame]) != VK_SUCCESS) {
@@ -670,6 +943,16 @@ void CRenderer::postRecordComputeCommandBuffer(CSwapchain &swapchain){
 
 void CRenderer::StartRecordComputeCommandBuffer(VkPipeline &pipeline, VkPipelineLayout &pipelineLayout){
     BeginCommandBuffer(computeCmdId);
+    WriteQueueTimestamp(true, false);
+    gpuProfiler.BeginCommandBuffer(commandBuffers[computeCmdId][currentFrame], currentFrame, CGpuProfiler::QUEUE_COMPUTE);
+    if(!bEnableTimelineSemaphore){
+        //input storage buffer was written by the previous compute submission on this queue; timeline path waits on it by value
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffers[computeCmdId][currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
     //BeginRenderPass(renderPass, swapChainFramebuffers, extent, clearValues);
     BindPipeline(pipeline, VK_PIPELINE_BIND_POINT_COMPUTE, computeCmdId);
     //SetViewport(extent);
@@ -678,11 +961,16 @@ void CRenderer::StartRecordComputeCommandBuffer(VkPipeline &pipeline, VkPipeline
 }
 void CRenderer::EndRecordComputeCommandBuffer(){
 	//EndRenderPass();
+    WriteQueueTimestamp(true, true);
+    gpuProfiler.EndCommandBuffer(commandBuffers[computeCmdId][currentFrame], currentFrame, CGpuProfiler::QUEUE_COMPUTE);
 	EndCommandBuffer(computeCmdId);
 }
 
 void CRenderer::Dispatch(int numWorkGroupsX, int numWorkGroupsY, int numWorkGroupsZ){
+    PROFILE_COUNTER("dispatches", 1);
+    int scope = BeginGpuScope("dispatch", true);
     vkCmdDispatch(commandBuffers[computeCmdId][currentFrame], numWorkGroupsX, numWorkGroupsY, numWorkGroupsZ); 
+    EndGpuScope(scope, true);
 }
 
 
@@ -693,6 +981,11 @@ void CRenderer::Dispatch(int numWorkGroupsX, int numWorkGroupsY, int numWorkGrou
  * ***********************/
 
 void CRenderer::Destroy(){
+    uploadService.Destroy();
+    readbackService.Destroy();
+    gpuProfiler.Destroy();
+    framePacer.Destroy();
+
     int size = vertexDataBuffers.size();
     for(size_t i = 0; i < size; i++)  vertexDataBuffers[i].DestroyAndFree();
 
@@ -707,7 +1000,11 @@ void CRenderer::Destroy(){
         vkDestroyFence(CContext::GetHandle().GetLogicalDevice(), computeInFlightFences[i], nullptr);
         vkDestroySemaphore(CContext::GetHandle().GetLogicalDevice(), computeFinishedSemaphores[i], nullptr);
     }
+    if(computeTimelineSemaphore != VK_NULL_HANDLE) vkDestroySemaphore(CContext::GetHandle().GetLogicalDevice(), computeTimelineSemaphore, nullptr);
+    if(graphicsTimelineSemaphore != VK_NULL_HANDLE) vkDestroySemaphore(CContext::GetHandle().GetLogicalDevice(), graphicsTimelineSemaphore, nullptr);
 
+    if(queueTimingQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(CContext::GetHandle().GetLogicalDevice(), queueTimingQueryPool, nullptr);
+    if(computeCommandPool != VK_NULL_HANDLE && computeCommandPool != commandPool) vkDestroyCommandPool(CContext::GetHandle().GetLogicalDevice(), computeCommandPool, nullptr);
     vkDestroyCommandPool(CContext::GetHandle().GetLogicalDevice(), commandPool, nullptr);
 }
 
@@ -0,0 +1,99 @@
+#include "../include/samplerCache.h"
+
+bool CSamplerCache::Key::operator==(const Key &other) const{
+    return magFilter == other.magFilter && minFilter == other.minFilter && mipmapMode == other.mipmapMode
+        && addressModeU == other.addressModeU && addressModeV == other.addressModeV && addressModeW == other.addressModeW
+        && maxAnisotropy == other.maxAnisotropy && mipLodBias == other.mipLodBias
+        && minLod == other.minLod && maxLod == other.maxLod
+        && compareOp == other.compareOp && borderColor == other.borderColor;
+}
+
+CSamplerCache::CSamplerCache(){}
+CSamplerCache::~CSamplerCache(){}
+
+VkSampler CSamplerCache::GetOrCreate(const Key &key){
+    for(auto &entry : m_entries){
+        if(entry.key == key){
+            cacheHitCount++;
+            return entry.sampler;
+        }
+    }
+    cacheMissCount++;
+
+    if(!bQueriedLimits){ //once, not per sampler
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(CContext::GetHandle().GetPhysicalDevice(), &properties);
+        m_maxSamplerAnisotropy = properties.limits.maxSamplerAnisotropy;
+        m_maxSamplerAllocationCount = properties.limits.maxSamplerAllocationCount;
+        bQueriedLimits = true;
+    }
+    if(m_entries.size() + RESERVED_SAMPLERS >= m_maxSamplerAllocationCount)
+        throw std::runtime_error("failed to create sampler: maxSamplerAllocationCount reached!");
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = key.magFilter;
+    samplerInfo.minFilter = key.minFilter;
+    samplerInfo.mipmapMode = key.mipmapMode;
+    samplerInfo.addressModeU = key.addressModeU;
+    samplerInfo.addressModeV = key.addressModeV;
+    samplerInfo.addressModeW = key.addressModeW;
+    float maxAnisotropy = (key.maxAnisotropy == 0.0f) ? m_maxSamplerAnisotropy : std::min(key.maxAnisotropy, m_maxSamplerAnisotropy);
+    samplerInfo.anisotropyEnable = (maxAnisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = std::max(maxAnisotropy, 1.0f);
+    samplerInfo.mipLodBias = key.mipLodBias;
+    samplerInfo.minLod = key.minLod;
+    samplerInfo.maxLod = key.maxLod;
+    samplerInfo.compareEnable = (key.compareOp != VK_COMPARE_OP_NEVER) ? VK_TRUE : VK_FALSE;
+    samplerInfo.compareOp = (key.compareOp != VK_COMPARE_OP_NEVER) ? key.compareOp : VK_COMPARE_OP_ALWAYS;
+    samplerInfo.borderColor = key.borderColor;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+    Entry entry;
+    entry.key = key;
+    VkResult result = vkCreateSampler(CContext::GetHandle().GetLogicalDevice(), &samplerInfo, nullptr, &entry.sampler);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create texture sampler!");
+    m_entries.push_back(entry);
+    return entry.sampler;
+}
+
+void CSamplerCache::Destroy(){
+    for(auto &entry : m_entries)
+        vkDestroySampler(CContext::GetHandle().GetLogicalDevice(), entry.sampler, nullptr);
+    m_entries.clear();
+}
+
+VkFilter CSamplerCache::ParseFilter(const std::string &name, VkFilter defaultFilter){
+    if(name == "nearest") return VK_FILTER_NEAREST;
+    if(name == "linear") return VK_FILTER_LINEAR;
+    return defaultFilter;
+}
+
+VkSamplerMipmapMode CSamplerCache::ParseMipmapMode(const std::string &name){
+    if(name == "nearest") return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+}
+
+VkSamplerAddressMode CSamplerCache::ParseAddressMode(const std::string &name){
+    if(name == "mirrored_repeat") return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+    if(name == "clamp_to_edge") return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if(name == "clamp_to_border") return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+}
+
+VkCompareOp CSamplerCache::ParseCompareOp(const std::string &name){
+    if(name == "less") return VK_COMPARE_OP_LESS;
+    if(name == "less_or_equal") return VK_COMPARE_OP_LESS_OR_EQUAL;
+    if(name == "greater") return VK_COMPARE_OP_GREATER;
+    if(name == "greater_or_equal") return VK_COMPARE_OP_GREATER_OR_EQUAL;
+    if(name == "equal") return VK_COMPARE_OP_EQUAL;
+    if(name == "not_equal") return VK_COMPARE_OP_NOT_EQUAL;
+    if(name == "always") return VK_COMPARE_OP_ALWAYS;
+    return VK_COMPARE_OP_NEVER; //none
+}
+
+VkBorderColor CSamplerCache::ParseBorderColor(const std::string &name){
+    if(name == "transparent_black") return VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    if(name == "opaque_white") return VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    return VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+}
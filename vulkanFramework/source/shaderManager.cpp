@@ -1,5 +1,17 @@
 #include "../include/shaderManager.h"
 
+#ifndef ANDROID
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#endif
+
 CShaderManager::CShaderManager(){
     //debugger = new CDebugger("../logs/shaderManager.log");
     //bEnablePushConstant = false;
@@ -10,76 +22,163 @@ CShaderManager::~CShaderManager(){
 
 
 void CShaderManager::CreateShader(const std::string shaderName, short shaderType){
-    VkShaderModule *pShaderModule;
+    std::vector<VkShaderModule> *pShaderModules;
     switch(shaderType){
-        case VERT:{
-            VkShaderModule newShaderModule;
-            vertShaderModules.push_back(newShaderModule);
-            pShaderModule = &vertShaderModules[vertShaderModules.size()-1];
+        case VERT:
+            pShaderModules = &vertShaderModules;
         break;
-        }
-        case FRAG:{
-            VkShaderModule newShaderModule;
-            fragShaderModules.push_back(newShaderModule);
-            pShaderModule = &fragShaderModules[fragShaderModules.size()-1];
+        case FRAG:
+            pShaderModules = &fragShaderModules;
         break;
-        }
-        case COMP:{
-            //pShaderModule = &compShaderModule;
-            VkShaderModule newShaderModule;
-            compShaderModules.push_back(newShaderModule);
-            pShaderModule = &compShaderModules[compShaderModules.size()-1];
+        case COMP:
+            pShaderModules = &compShaderModules;
         break;
-        }
         default:
             throw std::runtime_error("Invalid shader type!");
         break;
     }
+
+    //same file requested again: skip the file read entirely
+    VkShaderModule shaderModule = GetShaderModule(shaderName);
+    if(shaderModule != VK_NULL_HANDLE){
+        cacheHitCount++;
+        pShaderModules->push_back(shaderModule);
+        return;
+    }
     
 #ifndef ANDROID
-    bool bopen = InitSpirVShader(SHADER_PATH + shaderName, pShaderModule);
-    if(!bopen) bopen = InitSpirVShader("shaders/" + shaderName, pShaderModule);
+    bool bopen = InitSpirVShader(SHADER_PATH + shaderName, &shaderModule);
+    if(!bopen) bopen = InitSpirVShader("shaders/" + shaderName, &shaderModule);
     if(!bopen) throw std::runtime_error("failed to open shader: "+shaderName);
 #else
     std::vector<uint8_t> fileBits;
     std::string fullShaderName = ANDROID_SHADER_PATH + InsertString(shaderName, "shader.", '/');
     CContext::GetHandle().androidFileManager.AssetReadFile(fullShaderName.c_str(), fileBits);
-    *pShaderModule = createShaderModule(fileBits);
-#endif   
+    shaderModule = createShaderModule(fileBits);
+#endif
+    shaderNameToHash[shaderName] = m_lastHash;
+    pShaderModules->push_back(shaderModule);
+}
+
+/************
+ * Module Cache
+ ************/
+uint64_t CShaderManager::HashSpirV(const void *pCode, size_t codeSize){
+    return HashBytes(pCode, codeSize);
+}
+
+VkShaderModule CShaderManager::GetOrCreateShaderModule(const void *pCode, size_t codeSize){
+    m_lastHash = HashSpirV(pCode, codeSize);
+    auto it = moduleCache.find(m_lastHash);
+    if(it != moduleCache.end()){
+        cacheHitCount++; //different file name, identical SPIR-V
+        return it->second;
+    }
+    cacheMissCount++;
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = codeSize;
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(pCode);
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VkResult result = vkCreateShaderModule(CContext::GetHandle().GetLogicalDevice(), &createInfo, PALLOCATOR, &shaderModule);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create shader module!");
+
+    moduleCache[m_lastHash] = shaderModule;
+    return shaderModule;
+}
+
+VkShaderModule CShaderManager::GetShaderModule(const std::string shaderName){
+    auto itName = shaderNameToHash.find(shaderName);
+    if(itName == shaderNameToHash.end()) return VK_NULL_HANDLE;
+    auto itModule = moduleCache.find(itName->second);
+    return (itModule == moduleCache.end()) ? VK_NULL_HANDLE : itModule->second;
+}
+
+void CShaderManager::QueryShaderModuleFeatures(){
+    //Only query here. Pipelines in this framework are built once from VkShaderModule handles,
+    //so the module-less paths (identifier / inline VkShaderModuleCreateInfo) are reported but not used yet
+    bSupportShaderModuleIdentifier = (*CContext::GetHandle().physicalDevice)->checkDeviceExtensionSupport({"VK_EXT_shader_module_identifier"});
+    bSupportMaintenance5 = (*CContext::GetHandle().physicalDevice)->checkDeviceExtensionSupport({"VK_KHR_maintenance5"});
+    LOG(LOG_LEVEL_VERBOSE, LOG_CATEGORY_DEVICE, "Shader module identifier: %s, maintenance5: %s",
+        bSupportShaderModuleIdentifier ? "supported" : "not supported", bSupportMaintenance5 ? "supported" : "not supported");
 }
 
 #ifndef ANDROID
 bool CShaderManager::InitSpirVShader(const std::string shaderName, VkShaderModule *pShaderModule){
-    std::vector<char> shaderCode;
-    bool bOpen = readFile(shaderName.c_str(), shaderCode);
+    MappedFile mappedFile;
+    bool bOpen = mapFile(shaderName, mappedFile);
     //std::cout<<shaderName<<std::endl;
     if(!bOpen) return false;
 
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = shaderCode.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
-
-    VkResult result = vkCreateShaderModule(CContext::GetHandle().GetLogicalDevice(), &createInfo, PALLOCATOR, pShaderModule);
+    *pShaderModule = GetOrCreateShaderModule(mappedFile.pData, mappedFile.size);
+    //vkCreateShaderModule copies the code, so the mapping can be released right away
+    unmapFile(mappedFile);
     //REPORT("vkCreateShaderModule");
     //debugger->writeMSG("Shader Module '%s' successfully loaded\n", shaderName.c_str());
 
     return true;
 }
+
+bool CShaderManager::mapFile(const std::string& filename, MappedFile &mappedFile){
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    HANDLE hMapping = NULL;
+    if(GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+        hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    void *pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if(pView){
+        mappedFile.pData = static_cast<const char*>(pView);
+        mappedFile.size = static_cast<size_t>(fileSize.QuadPart);
+        mappedFile.hFile = hFile;
+        mappedFile.hMapping = hMapping;
+        return true;
+    }
+    if(hMapping) CloseHandle(hMapping);
+    CloseHandle(hFile);
 #else
-VkShaderModule CShaderManager::createShaderModule(const std::vector<uint8_t> &code) {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    void *pView = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size > 0)
+        pView = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //the mapping keeps its own reference
+    if(pView != MAP_FAILED){
+        mappedFile.pData = static_cast<const char*>(pView);
+        mappedFile.size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+#endif
+    //mapping failed (empty file, special filesystem...): read it the old way
+    if(!readFile(filename, mappedFile.fallback)) return false;
+    mappedFile.pData = mappedFile.fallback.data();
+    mappedFile.size = mappedFile.fallback.size();
+    return true;
+}
 
+void CShaderManager::unmapFile(MappedFile &mappedFile){
+    if(mappedFile.pData && mappedFile.fallback.empty()){
+#ifdef _WIN32
+        UnmapViewOfFile(mappedFile.pData);
+        CloseHandle(mappedFile.hMapping);
+        CloseHandle(mappedFile.hFile);
+#else
+        munmap(const_cast<char*>(mappedFile.pData), mappedFile.size);
+#endif
+    }
+    mappedFile.pData = nullptr;
+    mappedFile.size = 0;
+    mappedFile.fallback.clear();
+}
+#else
+VkShaderModule CShaderManager::createShaderModule(const std::vector<uint8_t> &code) {
     // Satisifies alignment requirements since the allocator
     // in vector ensures worst case requirements
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-    VkShaderModule shaderModule;
-    vkCreateShaderModule( CContext::GetHandle().GetLogicalDevice(), &createInfo, nullptr, &shaderModule);
-    //VkResult result = vkCreateShaderModule(CContext::GetHandle().GetLogicalDevice(), &createInfo, PALLOCATOR, pShaderModule);
-
-    return shaderModule;
+    return GetOrCreateShaderModule(code.data(), code.size());
 }
 
 std::string CShaderManager::InsertString(std::string originalString, std::string insertString, char separator){
@@ -152,13 +251,11 @@ std::string CShaderManager::InsertString(std::string originalString, std::string
 }
 
 void CShaderManager::Destroy(){
-    for(int i = 0; i < vertShaderModules.size(); i++) vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), vertShaderModules[i], nullptr);
-    for(int i = 0; i < fragShaderModules.size(); i++) vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), fragShaderModules[i], nullptr);
-    for(int i = 0; i < compShaderModules.size(); i++) vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), compShaderModules[i], nullptr);
-    // if(fragShaderModule)
-    //     vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), fragShaderModule, nullptr);
-    // if(vertShaderModule)
-    //     vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), vertShaderModule, nullptr);
-    // if(compShaderModule)
-    //     vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), compShaderModule, nullptr);
+    //vert/frag/compShaderModules may hold the same handle several times, so destroy through the cache
+    for(auto &entry : moduleCache) vkDestroyShaderModule(CContext::GetHandle().GetLogicalDevice(), entry.second, nullptr);
+    moduleCache.clear();
+    shaderNameToHash.clear();
+    vertShaderModules.clear();
+    fragShaderModules.clear();
+    compShaderModules.clear();
 }
\ No newline at end of file
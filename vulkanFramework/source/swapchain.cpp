@@ -6,9 +6,7 @@ CSwapchain::CSwapchain(){
     imageSize = 0; //0 means the size is not set, will query for the value
     msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
-#ifndef ANDROID
-    logManager.setLogFile("swapChain.log");
-#endif
+    logManager.setLogFile("swapChain.log", LOG_CATEGORY_SWAPCHAIN);
 }
 CSwapchain::~CSwapchain(){
     //if (!debugger) delete debugger;
@@ -75,7 +73,9 @@ void CSwapchain::createImages(VkSurfaceKHR surface, int width, int height){
     //About BGR and RGB: olde graphics hardware (VGA) used to be BGR. Windows still expects BGR by default, and internally display hardware might still be BGR.
     //It is quite common that the display controller in your GPU works with BGRA, not RGBA. So you get your swapchain images in the format that can be displayed so there's no extra hidden conversion needed.
 
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    std::cout<<"Swapchain: present mode "<<GetPresentModeName(presentMode)
+        <<(presentMode != preferredPresentMode ? std::string(" (") + GetPresentModeName(preferredPresentMode) + " not supported)" : "")<<std::endl;
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, width, height);
 
     if(imageSize == 0) imageSize = swapChainSupport.capabilities.minImageCount + 1;
@@ -98,6 +98,8 @@ void CSwapchain::createImages(VkSurfaceKHR surface, int width, int height){
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; 
     if(bComputeSwapChainImage)
         createInfo.imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT; //added VK_IMAGE_USAGE_STORAGE_BIT for image storage
+    bTransferSrcImage = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    if(bTransferSrcImage) createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //frame capture
 
     QueueFamilyIndices indices = CContext::GetHandle().physicalDevice->get()->findQueueFamilies(surface, "Find Queue Families when creating swapchain images");
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
@@ -133,6 +135,33 @@ void CSwapchain::createImages(VkSurfaceKHR surface, int width, int height){
     swapChainExtent = extent;
 }
 
+void CSwapchain::createOffscreenImages(int width, int height){
+    bOffscreen = true;
+    bTransferSrcImage = true;
+    finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    //same format as the windowed path, so shaders and gamma match; storage images need a UNORM format
+    swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if(bComputeSwapChainImage){
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+        swapChainImageFormat = findSupportedFormat({VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM}, VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+    }
+    swapChainExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+
+    //imageIndex follows currentFrame, so the frame fences also protect the images
+    imageSize = MAX_FRAMES_IN_FLIGHT;
+    offscreenImages.resize(imageSize);
+    images.resize(imageSize);
+    for(uint32_t i = 0; i < imageSize; i++){
+        offscreenImages[i].createImage(swapChainExtent.width, swapChainExtent.height, 1, VK_SAMPLE_COUNT_1_BIT, swapChainImageFormat,
+            VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        images[i] = offscreenImages[i].image;
+    }
+    logManager.print("Offscreen images: format %4d, imageSize = %d", swapChainImageFormat, (int)imageSize);
+}
+
 void CSwapchain::createImageViews(VkImageAspectFlags aspectFlags){
     // present views for the double-buffering:
     views.resize(imageSize);
@@ -143,48 +172,48 @@ void CSwapchain::createImageViews(VkImageAspectFlags aspectFlags){
 }
 
 void CSwapchain::displaySwapchainInfo(SwapChainSupportDetails details){
-    logManager.print("vkGetPhysicalDeviceSurfaceCapabilitiesKHR:");
-    logManager.print("\tminImageCount = %d; maxImageCount = %d", (int)details.capabilities.minImageCount, (int)details.capabilities.maxImageCount);
-    logManager.print("\tcurrentExtent = %d x %d", (int)details.capabilities.currentExtent.width, (int)details.capabilities.currentExtent.height);
-    logManager.print("\tminImageExtent = %d x %d", (int)details.capabilities.minImageExtent.width, (int)details.capabilities.minImageExtent.height);
-    logManager.print("\tmaxImageExtent = %d x %d", (int)details.capabilities.maxImageExtent.width, (int)details.capabilities.maxImageExtent.height);
-    logManager.print("\tmaxImageArrayLayers = %d", (int)details.capabilities.maxImageArrayLayers);
-    logManager.print("\tsupportedTransforms = 0x%04x", (int)details.capabilities.supportedTransforms);
-    logManager.print("\tcurrentTransform = 0x%04x", (int)details.capabilities.currentTransform);
-    logManager.print("\tsupportedCompositeAlpha = 0x%04x", (int)details.capabilities.supportedCompositeAlpha);
-    logManager.print("\tsupportedUsageFlags = 0x%04x", (int)details.capabilities.supportedUsageFlags);
+    LOG_SITE(logManager, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR:");
+    LOG_SITE(logManager, "\tminImageCount = %d; maxImageCount = %d", (int)details.capabilities.minImageCount, (int)details.capabilities.maxImageCount);
+    LOG_SITE(logManager, "\tcurrentExtent = %d x %d", (int)details.capabilities.currentExtent.width, (int)details.capabilities.currentExtent.height);
+    LOG_SITE(logManager, "\tminImageExtent = %d x %d", (int)details.capabilities.minImageExtent.width, (int)details.capabilities.minImageExtent.height);
+    LOG_SITE(logManager, "\tmaxImageExtent = %d x %d", (int)details.capabilities.maxImageExtent.width, (int)details.capabilities.maxImageExtent.height);
+    LOG_SITE(logManager, "\tmaxImageArrayLayers = %d", (int)details.capabilities.maxImageArrayLayers);
+    LOG_SITE(logManager, "\tsupportedTransforms = 0x%04x", (int)details.capabilities.supportedTransforms);
+    LOG_SITE(logManager, "\tcurrentTransform = 0x%04x", (int)details.capabilities.currentTransform);
+    LOG_SITE(logManager, "\tsupportedCompositeAlpha = 0x%04x", (int)details.capabilities.supportedCompositeAlpha);
+    LOG_SITE(logManager, "\tsupportedUsageFlags = 0x%04x", (int)details.capabilities.supportedUsageFlags);
    
    
-    logManager.print("\nFound %d Surface Formats:",  (int)details.formats.size());
+    LOG_SITE(logManager, "\nFound %d Surface Formats:",  (int)details.formats.size());
     for (uint32_t i = 0; i < details.formats.size(); i++) {
-        logManager.print("%3d: format %4d, colorSpace %12d", i, details.formats[i].format, details.formats[i].colorSpace); 
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)			    logManager.print("\tVK_COLOR_SPACE_SRGB_NONLINEAR_KHR");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT)		logManager.print("\tVK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT)		logManager.print( "\tVK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DCI_P3_LINEAR_EXT)			    logManager.print("\tVK_COLOR_SPACE_DCI_P3_LINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT)		    logManager.print("\tVK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT709_LINEAR_EXT)			    logManager.print( "\tVK_COLOR_SPACE_BT709_LINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT709_NONLINEAR_EXT)			logManager.print( "\tVK_COLOR_SPACE_BT709_NONLINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT2020_LINEAR_EXT)			    logManager.print("\tVK_COLOR_SPACE_BT2020_LINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_HDR10_ST2084_EXT)			    logManager.print("\tVK_COLOR_SPACE_HDR10_ST2084_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DOLBYVISION_EXT)			    logManager.print( "\tVK_COLOR_SPACE_DOLBYVISION_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_HDR10_HLG_EXT)			        logManager.print("\tVK_COLOR_SPACE_HDR10_HLG_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_ADOBERGB_LINEAR_EXT)			logManager.print("\tVK_COLOR_SPACE_ADOBERGB_LINEAR_EXT");
-        if (details.formats[i].colorSpace == VK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT)		    logManager.print("\tVK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT");
+        LOG_SITE(logManager, "%3d: format %4d, colorSpace %12d", i, details.formats[i].format, details.formats[i].colorSpace); 
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_SRGB_NONLINEAR_KHR");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT)		LOG_SITE(logManager, "\tVK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT)		LOG_SITE(logManager, "\tVK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DCI_P3_LINEAR_EXT)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_DCI_P3_LINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT)		    LOG_SITE(logManager, "\tVK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT709_LINEAR_EXT)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_BT709_LINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT709_NONLINEAR_EXT)			LOG_SITE(logManager, "\tVK_COLOR_SPACE_BT709_NONLINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_BT2020_LINEAR_EXT)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_BT2020_LINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_HDR10_ST2084_EXT)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_HDR10_ST2084_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_DOLBYVISION_EXT)			    LOG_SITE(logManager, "\tVK_COLOR_SPACE_DOLBYVISION_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_HDR10_HLG_EXT)			        LOG_SITE(logManager, "\tVK_COLOR_SPACE_HDR10_HLG_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_ADOBERGB_LINEAR_EXT)			LOG_SITE(logManager, "\tVK_COLOR_SPACE_ADOBERGB_LINEAR_EXT");
+        if (details.formats[i].colorSpace == VK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT)		    LOG_SITE(logManager, "\tVK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT");
     }
 
-    logManager.print("\nFound %d Present Modes:", (int)details.presentModes.size());
+    LOG_SITE(logManager, "\nFound %d Present Modes:", (int)details.presentModes.size());
     for (uint32_t i = 0; i < details.presentModes.size(); i++) {
-        logManager.print("%3d: presentModes %4d", i, details.presentModes[i]);
-        if (details.presentModes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR)			        logManager.print("\tVK_PRESENT_MODE_IMMEDIATE_KHR");
-        if (details.presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)			            logManager.print("\tVK_PRESENT_MODE_MAILBOX_KHR");
-        if (details.presentModes[i] == VK_PRESENT_MODE_FIFO_KHR)			            logManager.print("\tVK_PRESENT_MODE_FIFO_KHR");
-        if (details.presentModes[i] == VK_PRESENT_MODE_FIFO_RELAXED_KHR)		        logManager.print("\tVK_PRESENT_MODE_FIFO_RELAXED_KHR");
-        if (details.presentModes[i] == VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR)	    logManager.print("\tVK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR");
-        if (details.presentModes[i] == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR)	logManager.print("\tVK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR");
+        LOG_SITE(logManager, "%3d: presentModes %4d", i, details.presentModes[i]);
+        if (details.presentModes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR)			        LOG_SITE(logManager, "\tVK_PRESENT_MODE_IMMEDIATE_KHR");
+        if (details.presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)			            LOG_SITE(logManager, "\tVK_PRESENT_MODE_MAILBOX_KHR");
+        if (details.presentModes[i] == VK_PRESENT_MODE_FIFO_KHR)			            LOG_SITE(logManager, "\tVK_PRESENT_MODE_FIFO_KHR");
+        if (details.presentModes[i] == VK_PRESENT_MODE_FIFO_RELAXED_KHR)		        LOG_SITE(logManager, "\tVK_PRESENT_MODE_FIFO_RELAXED_KHR");
+        if (details.presentModes[i] == VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR)	    LOG_SITE(logManager, "\tVK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR");
+        if (details.presentModes[i] == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR)	LOG_SITE(logManager, "\tVK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR");
     }
 
-    logManager.print("");
+    LOG_SITE(logManager, "");
 }
 
 // VkSurfaceFormatKHR CSwapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
@@ -198,15 +227,35 @@ void CSwapchain::displaySwapchainInfo(SwapChainSupportDetails details){
 // }
 
 VkPresentModeKHR CSwapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return availablePresentMode;
-        }
-    }
+    auto isAvailable = [&](VkPresentModeKHR mode){
+        return std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end();
+    };
+    if (isAvailable(preferredPresentMode)) return preferredPresentMode;
+    //uncapped without tearing is the next best thing to uncapped
+    if (preferredPresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR && isAvailable(VK_PRESENT_MODE_MAILBOX_KHR)) return VK_PRESENT_MODE_MAILBOX_KHR;
 
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+bool CSwapchain::ParsePresentMode(const std::string &name, VkPresentModeKHR &mode){
+    if(name == "immediate") mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    else if(name == "mailbox") mode = VK_PRESENT_MODE_MAILBOX_KHR;
+    else if(name == "fifo") mode = VK_PRESENT_MODE_FIFO_KHR;
+    else if(name == "fifo-relaxed") mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    else return false;
+    return true;
+}
+
+const char *CSwapchain::GetPresentModeName(VkPresentModeKHR mode){
+    switch(mode){
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+        default: return "other";
+    }
+}
+
 VkExtent2D CSwapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height) {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
         return capabilities.currentExtent;
@@ -330,7 +379,8 @@ void CSwapchain::CleanUp(){
         vkDestroyImageView(CContext::GetHandle().GetLogicalDevice(), imageView, nullptr);
     }
 
-    vkDestroySwapchainKHR(CContext::GetHandle().GetLogicalDevice(), handle, nullptr);
+    if(bOffscreen) for(auto &offscreenImage : offscreenImages) offscreenImage.destroy();
+    else vkDestroySwapchainKHR(CContext::GetHandle().GetLogicalDevice(), handle, nullptr);
 
     lightDepthImageBuffer.destroy();
     depthImageBuffer.destroy();
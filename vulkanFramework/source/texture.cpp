@@ -1,7 +1,11 @@
 #include "../include/texture.h"
 
 #define STB_IMAGE_IMPLEMENTATION
-#include "../../thirdParty/stb_image.h"
+#include "../../thirdparty/stb_image.h"
+
+#ifndef ANDROID
+#include <filesystem>
+#endif
 
 
 /*******************
@@ -10,9 +14,7 @@
 CTextureManager::CTextureManager(){
 	//std::cout<<"CTextureManager::CTextureManager()"<<std::endl;
 	//textureImages.resize(1);
-#ifndef ANDROID
-    logManager.setLogFile("textureManager.log");
-#endif	
+    logManager.setLogFile("textureManager.log", LOG_CATEGORY_TEXTURE);
 }
 CTextureManager::~CTextureManager(){
 	//std::cout<<"CTextureManager::~CTextureManager()"<<std::endl;
@@ -32,13 +34,32 @@ void CTextureManager::CreateTextureImage(const std::string texturePath, VkImageU
 	textureImage.m_pCommandPool = &commandPool;
 	assert((bitPerTexelPerChannel == 8) || (bitPerTexelPerChannel == 16)); //bitPerTexelPerChannel is default 8
 	textureImage.m_texBptpc = bitPerTexelPerChannel;
-
-	textureImage.GetTexels(texturePath);
-
-	if(!bCubemap){//General texture image
-		textureImage.CreateTextureImage(); 
+	textureImage.m_mipmapGenerator = mipmapGenerator;
+	textureImage.m_mipmapOptions = mipmapOptions;
+	textureImage.m_bCubemap = bCubemap;
+
+	//cooked assets are sampled images with the default format (sRGB RGBA8 or 16 bit UNORM), cubemaps are cooked as 6 face KTX2
+	std::string cookedPath;
+	if(bPreferCookedTextures && !(usage & VK_IMAGE_USAGE_STORAGE_BIT)
+		&& (imageFormat == VK_FORMAT_R8G8B8A8_SRGB || bitPerTexelPerChannel == 16)) cookedPath = GetCookedTexturePath(texturePath);
+
+	if(!cookedPath.empty()){//Cooked texture image with its own mip chain
+		logManager.print("Use cooked texture %s", cookedPath);
+		textureImage.CreateTextureImage_compressed(cookedPath);
+		if(bCubemap) textureImage.CreateImageView_cubemap(VK_IMAGE_ASPECT_COLOR_BIT);
+		else textureImage.CreateImageView(VK_IMAGE_ASPECT_COLOR_BIT);
+	}else if(CCompressedTexture::IsCompressedFile(texturePath)){//Pre-compressed texture image with its own mip chain (KTX2 may be a cubemap)
+		textureImage.CreateTextureImage_compressed(texturePath);
+		if(bCubemap) textureImage.CreateImageView_cubemap(VK_IMAGE_ASPECT_COLOR_BIT);
+		else textureImage.CreateImageView(VK_IMAGE_ASPECT_COLOR_BIT);
+	}else if(!bCubemap){//General texture image
+		textureImage.GetTexels(texturePath);
+		if(textureImage.m_mipLevels > 1 && !textureImage.UseComputeMipmaps(&mipmapCompute) && textureImage.UseCpuMipmaps()) textureImage.CreateTextureImage_cpu_mipmap();
+		else textureImage.CreateTextureImage(); 
 		textureImage.CreateImageView(VK_IMAGE_ASPECT_COLOR_BIT);
 	}else{//Cubemap texture image
+		textureImage.GetTexels_cubemap(texturePath);
+		if(textureImage.m_mipLevels > 1) textureImage.UseComputeMipmaps(&mipmapCompute);
 		textureImage.CreateTextureImage_cubemap();
 		textureImage.CreateImageView_cubemap(VK_IMAGE_ASPECT_COLOR_BIT);
 	}
@@ -60,9 +81,65 @@ void CTextureManager::CreateTextureImage(const std::string texturePath, VkImageU
     //std::cout<<"Load Texture '"<< (*textureNames)[i].first <<"' cost: "<<durationTime<<" milliseconds"<<std::endl;
 }
 
+std::string CTextureManager::GetCookedTexturePath(const std::string texturePath){
+#ifndef ANDROID
+	if(CCompressedTexture::IsCompressedFile(texturePath)) return "";
+	std::string cookedPath = "cooked/" + std::filesystem::path(texturePath).replace_extension(".ktx2").generic_string();
+
+	//same 2 locations as the loaders, the cooked file must sit next to the source it was cooked from
+	for(std::string directory : {std::string(TEXTURE_PATH), std::string("textures/")}){
+		std::error_code error;
+		auto sourceTime = std::filesystem::last_write_time(directory + texturePath, error);
+		if(error) continue;
+		auto cookedTime = std::filesystem::last_write_time(directory + cookedPath, error);
+		if(error || cookedTime < sourceTime) return ""; //missing or stale
+		return cookedPath;
+	}
+#endif
+	return "";
+}
+
+MipmapGeneratorType CTextureManager::ParseMipmapGenerator(const std::string &name){
+	if(name == "cpu") return MIPMAP_GENERATOR_CPU;
+	if(name == "compute") return MIPMAP_GENERATOR_COMPUTE;
+	return MIPMAP_GENERATOR_BLIT;
+}
+
+void CTextureManager::CreateEnvironmentTextures(const std::string hdrPath, VkCommandPool &commandPool, int sampler_id){
+	auto startTextureTime = std::chrono::high_resolution_clock::now();
+
+	CEnvironmentBaker::Result result;
+	environmentBaker.Bake(hdrPath, commandPool, result);
+
+	//the baker leaves every output in GENERAL with its sampling view, nothing is left to upload or mipmap
+	for(int output = 0; output < CEnvironmentBaker::OUTPUT_COUNT; output++){
+		CTextureImage textureImage;
+		textureImage.m_textureImageBuffer = result.images[output];
+		textureImage.m_imageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+		textureImage.m_texWidth = textureImage.m_texHeight = (int32_t)result.sizes[output];
+		textureImage.m_texChannels = 4;
+		textureImage.m_texBptpc = 16;
+		textureImage.m_mipLevels = result.mipLevels[output];
+		textureImage.m_bMipsLoaded = true;
+		textureImage.m_bCubemap = CEnvironmentBaker::IsCube(output);
+		textureImage.m_pCommandPool = &commandPool;
+		textureImage.m_sampler_id = sampler_id;
+		textureImages.push_back(textureImage);
+	}
+
+	auto endTextureTime = std::chrono::high_resolution_clock::now();
+	auto durationTime = std::chrono::duration<float, std::chrono::seconds::period>(endTextureTime - startTextureTime).count()*1000;
+	logManager.print("Load Environment %s", hdrPath);
+	logManager.print("\tfirst texture id: %d", (int)(textureImages.size() - CEnvironmentBaker::OUTPUT_COUNT));
+	logManager.print("\tfrom cache: %d", result.bFromCache);
+	logManager.print("\tcost %f milliseconds", durationTime);
+}
+
 void CTextureManager::Destroy(){
 	//std::cout<<"CTextureManager::Destroy()"<<std::endl;
 	for(int i = 0; i < textureImages.size(); i++) textureImages[i].Destroy();
+	mipmapCompute.Destroy();
+	environmentBaker.Destroy();
 }
 
 
@@ -122,7 +199,7 @@ void CTextureImage::GetTexels(const std::string texturePath) {
 		texels = stbi_load_from_memory(fileBits.data(), fileBits.size(), &texWidth, &texHeight, &texChannels, dstTexChannels);//stbi_uc
 	
 #endif
-	PRINT("CreateTextureImage: Load texels as %d bits per texel per channel", m_texBptpc);
+	PRINT_SITE("CreateTextureImage: Load texels as %d bits per texel per channel", m_texBptpc);
 	//CreateTextureImage(texels, usage, textureImageBuffer, dstTexChannels, bitPerTexelPerChannel); 
 }
 
@@ -146,9 +223,9 @@ void CTextureImage::CreateTextureImage() {
 // #else
 // 	LOGI("imageSize: %d bytes", imageSize);
 // #endif	
-	PRINT("CreateTextureImage: imageSize: %d bytes", (int)imageSize);
-	PRINT("CreateTextureImage: texWidth: %d texels", (int)m_texWidth);
-	PRINT("CreateTextureImage: texHeight: %d texels", (int)m_texHeight);
+	PRINT_SITE("CreateTextureImage: imageSize: %d bytes", (int)imageSize);
+	PRINT_SITE("CreateTextureImage: texWidth: %d texels", (int)m_texWidth);
+	PRINT_SITE("CreateTextureImage: texHeight: %d texels", (int)m_texHeight);
 
 	if(m_imageFormat == VK_FORMAT_R16G16B16A16_SFLOAT){
 // #ifndef ANDROID	
@@ -156,7 +233,7 @@ void CTextureImage::CreateTextureImage() {
 // #else
 // 		LOGI("imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");
 // #endif	
-		PRINT("CreateTextureImage: imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");		
+		PRINT_SITE("CreateTextureImage: imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");		
 		int texelNumber = m_texWidth * m_texHeight * m_texChannels;
 		for(int i = 0; i < texelNumber; i++) ((uint16_t*)m_pTexels)[i] = frac_float16(((uint16_t*)m_pTexels)[i]);
 	}
@@ -193,6 +270,65 @@ void CTextureImage::CreateImageView(VkImageAspectFlags aspectFlags){
     m_textureImageBuffer.createImageView(m_imageFormat, aspectFlags, m_mipLevels, false);
 }
 
+void CTextureImage::CreateTextureImage_compressed(const std::string texturePath){
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	CCompressedTexture compressed;
+	compressed.Load(texturePath, m_imageFormat == VK_FORMAT_R8G8B8A8_SRGB);
+	if(!compressed.IsFormatSupported()){
+		PRINT_SITE("CreateTextureImage: block format %d is not supported by the device, decode on CPU", (int)compressed.format);
+		compressed.DecodeToRGBA8(); //throws if there is no CPU decoder for the format
+	}
+
+	m_imageFormat = compressed.format;
+	m_texWidth = compressed.width;
+	m_texHeight = compressed.height;
+	m_mipLevels = compressed.mipLevels;
+	m_bMipsLoaded = true;
+	if((compressed.faceCount == 6) != m_bCubemap) throw std::runtime_error("failed to load compressed texture: resource_texture_cubmap does not match the file's face count!");
+	if(compressed.IsBlockFormat()) m_usage &= ~VK_IMAGE_USAGE_STORAGE_BIT; //block formats can not be storage images
+
+	//Step 1: staging buffer with every level, back to back
+	VkDeviceSize imageSize = compressed.data.size();
+	CWxjBuffer stagingBuffer;
+	stagingBuffer.init(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	void *pGpuMemory;
+	vkMapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory, 0, imageSize, 0, &pGpuMemory);
+	memcpy(pGpuMemory, compressed.data.data(), (size_t)imageSize);
+	vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory);
+
+	//Step 2: create image with the file's mip count
+	m_textureImageBuffer.createImage(m_texWidth, m_texHeight, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, m_imageFormat, VK_IMAGE_TILING_OPTIMAL, m_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_bCubemap);
+
+	//Step 3: copy all levels in one submission; cubemap faces are consecutive layers of each level
+	if(m_bCubemap) transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	else transitionImageLayout(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	std::vector<VkBufferImageCopy> regions(m_mipLevels);
+	for(uint32_t i = 0; i < m_mipLevels; i++){
+		regions[i] = {};
+		regions[i].bufferOffset = compressed.levelOffsets[i];
+		regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageSubresource.baseArrayLayer = 0;
+		regions[i].imageSubresource.layerCount = compressed.faceCount;
+		regions[i].imageExtent = {std::max((uint32_t)m_texWidth >> i, 1u), std::max((uint32_t)m_texHeight >> i, 1u), 1};
+	}
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	endSingleTimeCommands(commandBuffer);
+	if(m_bCubemap) transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+	else transitionImageLayout(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	stagingBuffer.DestroyAndFree();
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	float durationTime = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000;
+	//comparison against the same mip chain decoded to RGBA8
+	PRINT_SITE("CreateTextureImage: compressed upload %d bytes, RGBA8 would be %d bytes", (int)imageSize, (int)compressed.GetRGBA8Size());
+	PRINT_SITE("CreateTextureImage: GPU memory %d bytes", (int)m_textureImageBuffer.size);
+	PRINT_SITE("CreateTextureImage: load and upload cost %f milliseconds", durationTime);
+}
+
 /*******************
 *	Texture Image: Transition
 ********************/
@@ -281,54 +417,127 @@ void CTextureImage::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t w
 /*******************
 *	Texture Image: Create(Cubemap)
 ********************/
-void CTextureImage::CreateTextureImage_cubemap() {
-	//texWidth/=6;//test
-	VkDeviceSize imageSize = m_texWidth * m_texHeight * m_texChannels * m_texBptpc/8; 
-// #ifndef ANDROID	
-// 	std::cout<<"imageSize: "<<imageSize<<" bytes"<<std::endl;
-// #else
-// 	LOGI("imageSize: %d bytes", imageSize);
-// #endif	
-	PRINT("CreateTextureImage: imageSize: %d bytes", (int)imageSize);
-	PRINT("CreateTextureImage: texWidth: %d texels", (int)m_texWidth);
-	PRINT("CreateTextureImage: texHeight: %d texels", (int)m_texHeight);
-
-	if(m_imageFormat == VK_FORMAT_R16G16B16A16_SFLOAT){
-// #ifndef ANDROID	
-// 		std::cout<<"imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT"<<std::endl;
-// #else
-// 		LOGI("imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");
-// #endif	
-		PRINT("CreateTextureImage: imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");		
-		int texelNumber = m_texWidth * m_texHeight * m_texChannels;
-		for(int i = 0; i < texelNumber; i++) ((uint16_t*)m_pTexels)[i] = frac_float16(((uint16_t*)m_pTexels)[i]);
+void CTextureImage::GetTexels_cubemap(const std::string texturePath){
+	auto startTime = std::chrono::high_resolution_clock::now();
+	std::string extension = texturePath.substr(texturePath.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if(extension == "hdr"){//equirectangular HDR: faces are resampled as RGBA16F
+		int inputTexChannels;
+		float *pTexels = nullptr;
+#ifndef ANDROID
+		std::string fullTexturePath = TEXTURE_PATH + texturePath;
+		pTexels = stbi_loadf(fullTexturePath.c_str(), &m_texWidth, &m_texHeight, &inputTexChannels, STBI_rgb_alpha);
+		if(!pTexels) pTexels = stbi_loadf(("textures/" + texturePath).c_str(), &m_texWidth, &m_texHeight, &inputTexChannels, STBI_rgb_alpha);
+#else
+		std::vector<uint8_t> fileBits;
+		std::string fullTexturePath = ANDROID_TEXTURE_PATH + texturePath;
+		CContext::GetHandle().androidFileManager.AssetReadFile(fullTexturePath.c_str(), fileBits);
+		pTexels = stbi_loadf_from_memory(fileBits.data(), (int)fileBits.size(), &m_texWidth, &m_texHeight, &inputTexChannels, STBI_rgb_alpha);
+#endif
+		if(!pTexels) throw std::runtime_error("failed to load HDR environment image!");
+		uint32_t faceSize = std::max(m_texWidth / 4, 1); //a quarter of the longitude per face keeps the equator resolution
+		CCubemapFaces::FromEquirect(pTexels, m_texWidth, m_texHeight, faceSize, m_cubeFaceTexels);
+		stbi_image_free(pTexels);
+		m_texWidth = m_texHeight = (int32_t)faceSize;
+		m_texChannels = 4;
+		m_texBptpc = 16;
+		m_imageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+	}else if(CCubemapFaces::IsFaceFileName(texturePath)){//six files, the name contains {face}
+		int32_t faceWidth = 0, faceHeight = 0;
+		for(int face = 0; face < CCubemapFaces::FACE_COUNT; face++){
+			GetTexels(CCubemapFaces::GetFaceFileName(texturePath, face));
+			if(face == 0){
+				faceWidth = m_texWidth;
+				faceHeight = m_texHeight;
+				m_cubeFaceTexels.resize((size_t)faceWidth * faceHeight * m_texChannels * m_texBptpc / 8 * CCubemapFaces::FACE_COUNT);
+			}else if(m_texWidth != faceWidth || m_texHeight != faceHeight){
+				stbi_image_free(m_pTexels);
+				throw std::runtime_error("failed to load cubemap: face images have different sizes!");
+			}
+			size_t faceBytes = m_cubeFaceTexels.size() / CCubemapFaces::FACE_COUNT;
+			memcpy(m_cubeFaceTexels.data() + face * faceBytes, m_pTexels, faceBytes);
+			stbi_image_free(m_pTexels);
+		}
+	}else{//4x3 cross: only the 6 face cells are kept
+		GetTexels(texturePath);
+		CCubemapFaces::ExtractFromCross(m_pTexels, m_texWidth, m_texHeight, m_texChannels * m_texBptpc / 8, m_cubeFaceTexels);
+		stbi_image_free(m_pTexels);
+		m_texWidth /= 4;
+		m_texHeight /= 3;
 	}
+	m_pTexels = nullptr;
 
-	//mipLevels = bEnableMipMap ? (static_cast<uint32_t>(std::floor(std::log2(std::max(m_texWidth, m_texHeight)))) + 1) : 1;
+	auto endTime = std::chrono::high_resolution_clock::now();
+	PRINT_SITE("CreateTextureImage: cubemap face size %d x %d", (int)m_texWidth, (int)m_texHeight);
+	PRINT_SITE("CreateTextureImage: cubemap face extraction cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+}
 
-	CWxjBuffer stagingBuffer;
-	VkResult result = stagingBuffer.init(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-	stagingBuffer.fill(m_pTexels);
+void CTextureImage::CreateTextureImage_cubemap() {
+	//m_texWidth x m_texHeight is one face, m_cubeFaceTexels holds the 6 faces in layer order (see GetTexels_cubemap)
+	uint32_t bytesPerTexel = m_texChannels * m_texBptpc / 8;
+	VkDeviceSize faceSize = (VkDeviceSize)m_texWidth * m_texHeight * bytesPerTexel;
+	PRINT_SITE("CreateTextureImage: imageSize: %d bytes", (int)(faceSize * CCubemapFaces::FACE_COUNT));
+	PRINT_SITE("CreateTextureImage: texWidth: %d texels", (int)m_texWidth);
+	PRINT_SITE("CreateTextureImage: texHeight: %d texels", (int)m_texHeight);
+
+	//Step 1: staging data. With CPU mips it is level major (level 0 of every face, then level 1 ...), one region per face and level
+	std::vector<uint8_t> cpuLevels;
+	std::vector<VkBufferImageCopy> regions;
+	const std::vector<uint8_t> *pStaging = &m_cubeFaceTexels;
+	if(m_mipLevels > 1 && !m_pMipmapCompute && UseCpuMipmaps()){
+		uint32_t fullChain = static_cast<uint32_t>(std::floor(std::log2(std::max(m_texWidth, m_texHeight)))) + 1;
+		m_mipLevels = std::min(m_mipLevels, fullChain);
+		CMipmapGenerator::Options options = m_mipmapOptions;
+		options.bSrgb = (m_imageFormat == VK_FORMAT_R8G8B8A8_SRGB);
+		std::vector<uint8_t> faceLevels[CCubemapFaces::FACE_COUNT];
+		std::vector<size_t> levelOffsets;
+		for(int face = 0; face < CCubemapFaces::FACE_COUNT; face++)
+			CMipmapGenerator::Generate(m_cubeFaceTexels.data() + face * faceSize, m_texWidth, m_texHeight, m_texBptpc / 8, m_mipLevels, options, faceLevels[face], levelOffsets);
+		cpuLevels.reserve(faceLevels[0].size() * CCubemapFaces::FACE_COUNT);
+		for(uint32_t level = 0; level < m_mipLevels; level++){
+			size_t levelSize = ((level + 1 < m_mipLevels) ? levelOffsets[level + 1] : faceLevels[0].size()) - levelOffsets[level];
+			for(int face = 0; face < CCubemapFaces::FACE_COUNT; face++){
+				VkBufferImageCopy region{};
+				region.bufferOffset = cpuLevels.size();
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = level;
+				region.imageSubresource.baseArrayLayer = face;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent = {std::max((uint32_t)m_texWidth >> level, 1u), std::max((uint32_t)m_texHeight >> level, 1u), 1};
+				regions.push_back(region);
+				cpuLevels.insert(cpuLevels.end(), faceLevels[face].begin() + levelOffsets[level], faceLevels[face].begin() + levelOffsets[level] + levelSize);
+			}
+		}
+		pStaging = &cpuLevels;
+		m_bMipsLoaded = true;
+		PRINT("generateMipmaps: CPU %d levels per cubemap face", (int)m_mipLevels);
+	}
 
-	stbi_image_free(m_pTexels);
+	VkDeviceSize imageSize = pStaging->size();
+	CWxjBuffer stagingBuffer;
+	stagingBuffer.init(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	void *pGpuMemory;
+	vkMapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory, 0, imageSize, 0, &pGpuMemory);
+	memcpy(pGpuMemory, pStaging->data(), (size_t)imageSize);
+	vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), stagingBuffer.deviceMemory);
 
-	//Step 2: create(allocate) image buffer
+	//Step 2: create(allocate) image buffer, 6 layers of one face each
 	m_textureImageBuffer.createImage(m_texWidth, m_texHeight, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, m_imageFormat, VK_IMAGE_TILING_OPTIMAL, m_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
 
-	//Step 3: copy stagingBuffer(pixels) to imageBuffer(empty)
-	//To perform the copy, need change imageBuffer's layout: undefined->transferDST->shader-read-only 
-	//If the image is mipmap enabled, keep the transferDST layout (it will be mipmaped anyway)
-	//(transfer image in non-DST layout is not optimal???)
-	if(m_mipLevels == 1){
-		transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
- 		copyBufferToImage_cubemap(stagingBuffer.buffer, m_textureImageBuffer.image, static_cast<uint32_t>(m_texWidth), static_cast<uint32_t>(m_texHeight));
-      	transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);//VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ///!!!!
-	}else{
-		transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage_cubemap(stagingBuffer.buffer, m_textureImageBuffer.image, static_cast<uint32_t>(m_texWidth), static_cast<uint32_t>(m_texHeight));
+	//Step 3: copy stagingBuffer(faces) to imageBuffer(empty)
+	//If mips still have to be generated, keep the transferDST layout (it will be mipmaped anyway)
+	transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	if(regions.empty()) copyBufferToImage_cubemap(stagingBuffer.buffer, m_textureImageBuffer.image, static_cast<uint32_t>(m_texWidth), static_cast<uint32_t>(m_texHeight));
+	else{
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+		endSingleTimeCommands(commandBuffer);
 	}
+	if(m_mipLevels == 1 || m_bMipsLoaded) transitionImageLayout_cubemap(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);//VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ///!!!!
 
 	stagingBuffer.DestroyAndFree();
+	std::vector<uint8_t>().swap(m_cubeFaceTexels); //the image owns the texels now, CTextureImage copies stay small
 }
 
 void CTextureImage::CreateImageView_cubemap(VkImageAspectFlags aspectFlags){
@@ -399,59 +608,21 @@ void CTextureImage::transitionImageLayout_cubemap(VkImage image, VkImageLayout o
 void CTextureImage::copyBufferToImage_cubemap(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
+	//width x height is one face; the faces are packed back to back in layer order by CCubemapFaces
 	VkBufferImageCopy regions[6];
 	memset(regions, 0, sizeof(regions));
-
-	/* Horizontal Skybox Format
-	* right,left,up,bottom,front,back
-	* When changing skybox format, remember to change image enxtend in imageBuffer.cpp as well!
-	*/
-	// for(int i = 0; i < 6; i++){
-	// 	regions[i].bufferOffset = i * (width / 6) * 4;// is the offset in bytes from the start of the buffer object where the image data is copied from or to
-	// 	regions[i].bufferRowLength = width; //specify in texels a subregion of a larger two- or three-dimensional image in buffer
-	// 	regions[i].bufferImageHeight = height;
-	// 	regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; //imageSubresource is a VkImageSubresourceLayers used to specify the specific image subresources of the image used for the source or destination image data.
-	// 	regions[i].imageSubresource.mipLevel = 0;
-	// 	regions[i].imageSubresource.baseArrayLayer = i;
-	// 	regions[i].imageSubresource.layerCount = 1;
-	// 	regions[i].imageOffset = { 0, 0, 0 }; //selects the initial x, y, z offsets in texels of the sub-region of the source or destination image data.
-	// 	regions[i].imageExtent = { //is the size in texels of the image to copy in width, height and depth.
-	// 		width/6,
-	// 		height,
-	// 		1
-	// 	};
-	// }
-
-
-	/* Standard Skybox Format
-	*			up
-	*	left	front	right	back
-	*			down
-	*/
-	unsigned int extend_width = width / 4;
-	unsigned int extend_height = height / 3;
+	VkDeviceSize faceSize = (VkDeviceSize)width * height * m_texChannels * m_texBptpc / 8;
 	for(int i = 0; i < 6; i++){
-		regions[i].bufferRowLength = width; //specify in texels a subregion of a larger two- or three-dimensional image in buffer
-		regions[i].bufferImageHeight = height;
+		regions[i].bufferOffset = i * faceSize; //is the offset in bytes from the start of the buffer object where the image data is copied from or to
+		regions[i].bufferRowLength = 0; //tightly packed
+		regions[i].bufferImageHeight = 0;
 		regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; //imageSubresource is a VkImageSubresourceLayers used to specify the specific image subresources of the image used for the source or destination image data.
 		regions[i].imageSubresource.mipLevel = 0;
 		regions[i].imageSubresource.baseArrayLayer = i;
 		regions[i].imageSubresource.layerCount = 1;
 		regions[i].imageOffset = { 0, 0, 0 }; //selects the initial x, y, z offsets in texels of the sub-region of the source or destination image data.
-		regions[i].imageExtent = { //is the size in texels of the image to copy in width, height and depth.
-			extend_width,
-			extend_height,
-			1
-		};
+		regions[i].imageExtent = { width, height, 1 }; //is the size in texels of the image to copy in width, height and depth.
 	}
-	int unit_width = extend_width * 4;
-	int unit_height = extend_height * 4;
-	regions[0].bufferOffset = 1 * unit_height * unit_width + 2 * unit_width; 	//right
-	regions[1].bufferOffset = 1 * unit_height * unit_width; 					//left
-	regions[2].bufferOffset = 0 * unit_height * unit_width + 1 * unit_width; 	//up
-	regions[3].bufferOffset = 2 * unit_height * unit_width + 1 * unit_width; 	//bottom
-	regions[4].bufferOffset = 1 * unit_height * unit_width + 1 * unit_width; 	//front
-	regions[5].bufferOffset = 1 * unit_height * unit_width + 3 * unit_width; 	//back
 
 	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 6, regions);
 
@@ -500,8 +671,96 @@ void CTextureImage::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 *	Texture Image: Mipmap
 ********************/
 void CTextureImage::generateMipmaps(){
-    if(m_mipLevels <= 1) return;
+    if(m_mipLevels <= 1 || m_bMipsLoaded) return;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	if(m_pMipmapCompute){//cube faces are the 6 layers
+		m_pMipmapCompute->Generate(*m_pCommandPool, m_textureImageBuffer.image, m_imageFormat, m_texWidth, m_texHeight, m_mipLevels, m_bCubemap ? 6 : 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+		auto endTime = std::chrono::high_resolution_clock::now();
+		PRINT("generateMipmaps: compute %d levels", (int)m_mipLevels);
+		PRINT("generateMipmaps: compute layers %d", m_bCubemap ? 6 : 1);
+		PRINT("generateMipmaps: compute cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+		return;
+	}
     generateMipmapsCore(m_textureImageBuffer.image);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	PRINT("generateMipmaps: blit %d levels", (int)m_mipLevels);
+	PRINT("generateMipmaps: blit cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
+}
+
+bool CTextureImage::UseCpuMipmaps(){
+	if(m_imageFormat != VK_FORMAT_R8G8B8A8_SRGB && m_imageFormat != VK_FORMAT_R8G8B8A8_UNORM && m_imageFormat != VK_FORMAT_R16G16B16A16_UNORM) return false;
+	if(m_mipmapGenerator == MIPMAP_GENERATOR_CPU) return true;
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(CContext::GetHandle().GetPhysicalDevice(), m_imageFormat, &formatProperties);
+	return !(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
+bool CTextureImage::UseComputeMipmaps(CMipmapCompute *pMipmapCompute){
+	m_pMipmapCompute = nullptr;
+	if(m_mipmapGenerator != MIPMAP_GENERATOR_COMPUTE) return false;
+	if(!pMipmapCompute->CanGenerate(m_imageFormat, m_mipLevels, m_texWidth, m_texHeight) || !pMipmapCompute->Init()){
+		PRINT("generateMipmaps: compute generator can not handle this texture, fall back");
+		return false;
+	}
+	//every level is written through an RGBA8 UNORM storage view, sRGB images must allow that view format
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(CContext::GetHandle().GetPhysicalDevice(), VK_FORMAT_R8G8B8A8_UNORM, &formatProperties);
+	if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) return false;
+	m_usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	if(m_imageFormat == VK_FORMAT_R8G8B8A8_SRGB) m_textureImageBuffer.createFlags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+	m_pMipmapCompute = pMipmapCompute;
+	return true;
+}
+
+void CTextureImage::CreateTextureImage_cpu_mipmap(){
+	auto startTime = std::chrono::high_resolution_clock::now();
+	uint32_t fullChain = static_cast<uint32_t>(std::floor(std::log2(std::max(m_texWidth, m_texHeight)))) + 1;
+	m_mipLevels = std::min(m_mipLevels, fullChain);
+
+	//Step 1: build every level on the CPU, in linear space for sRGB
+	CMipmapGenerator::Options options = m_mipmapOptions;
+	options.bSrgb = (m_imageFormat == VK_FORMAT_R8G8B8A8_SRGB);
+	std::vector<uint8_t> levels;
+	std::vector<size_t> levelOffsets;
+	CMipmapGenerator::Generate(m_pTexels, m_texWidth, m_texHeight, m_texBptpc / 8, m_mipLevels, options, levels, levelOffsets);
+	stbi_image_free(m_pTexels);
+	auto generatedTime = std::chrono::high_resolution_clock::now();
+
+	//Step 2: one staging buffer with all levels
+	VkDeviceSize imageSize = levels.size();
+	CWxjBuffer stagingBuffer;
+	stagingBuffer.init(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	stagingBuffer.fill(levels.data());
+
+	//Step 3: create image and copy all levels in one submission
+	m_textureImageBuffer.createImage(m_texWidth, m_texHeight, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, m_imageFormat, VK_IMAGE_TILING_OPTIMAL, m_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+	transitionImageLayout(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	std::vector<VkBufferImageCopy> regions(m_mipLevels);
+	for(uint32_t i = 0; i < m_mipLevels; i++){
+		regions[i] = {};
+		regions[i].bufferOffset = levelOffsets[i];
+		regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageSubresource.baseArrayLayer = 0;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageExtent = {std::max((uint32_t)m_texWidth >> i, 1u), std::max((uint32_t)m_texHeight >> i, 1u), 1};
+	}
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	endSingleTimeCommands(commandBuffer);
+	transitionImageLayout(m_textureImageBuffer.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	stagingBuffer.DestroyAndFree();
+	m_bMipsLoaded = true;
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	PRINT("generateMipmaps: CPU generator %s", std::string(CMipmapGenerator::GetSimdName()));
+	PRINT("generateMipmaps: CPU %d levels", (int)m_mipLevels);
+	PRINT("generateMipmaps: CPU filter %d", (int)options.filter);
+	PRINT("generateMipmaps: CPU generate cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(generatedTime - startTime).count() * 1000);
+	PRINT("generateMipmaps: generate and upload cost %f milliseconds", std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000);
 }
 
 void CTextureImage::generateMipmapsCore(VkImage image, bool bCreateTempTexture, bool bCreateMixTexture, std::array<CWxjImageBuffer, MIPMAP_TEXTURE_COUNT> *textureImageBuffers_mipmaps) {
@@ -516,6 +775,7 @@ void CTextureImage::generateMipmapsCore(VkImage image, bool bCreateTempTexture,
 	}
 
 	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	uint32_t layerCount = (m_bCubemap && image == m_textureImageBuffer.image) ? 6 : 1; //every cubemap face gets its own chain
 
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -524,7 +784,7 @@ void CTextureImage::generateMipmapsCore(VkImage image, bool bCreateTempTexture,
 	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
+	barrier.subresourceRange.layerCount = layerCount;
 	barrier.subresourceRange.levelCount = 1;
 
 	int32_t mipWidth = m_texWidth;
@@ -549,13 +809,13 @@ void CTextureImage::generateMipmapsCore(VkImage image, bool bCreateTempTexture,
 		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		blit.srcSubresource.mipLevel = i - 1;
 		blit.srcSubresource.baseArrayLayer = 0;
-		blit.srcSubresource.layerCount = 1;
+		blit.srcSubresource.layerCount = layerCount;
 		blit.dstOffsets[0] = { 0, 0, 0 };
 		blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
 		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		blit.dstSubresource.mipLevel = i;
 		blit.dstSubresource.baseArrayLayer = 0;
-		blit.dstSubresource.layerCount = 1;
+		blit.dstSubresource.layerCount = layerCount;
 
 		if (bCreateMixTexture) {
 			int j = i > MIPMAP_TEXTURE_COUNT ? MIPMAP_TEXTURE_COUNT : i;
@@ -608,7 +868,7 @@ void CTextureImage::CreateTextureImage_rainbow_mipmap(void* texels, VkImageUsage
 	VkDeviceSize imageSize = m_texWidth * m_texHeight * m_texChannels * m_texBptpc/8; 
 
 	if(m_imageFormat == VK_FORMAT_R16G16B16A16_SFLOAT){
-		PRINT("CreateTextureImage: imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");		
+		PRINT_SITE("CreateTextureImage: imageFormat: VK_FORMAT_R16G16B16A16_SFLOAT");		
 		int texelNumber = m_texWidth * m_texHeight * m_texChannels;
 		for(int i = 0; i < texelNumber; i++) ((uint16_t*)texels)[i] = frac_float16(((uint16_t*)texels)[i]);
 	}
@@ -636,7 +896,7 @@ void CTextureImage::CreateTextureImage_rainbow_mipmap(void* texels, VkImageUsage
 }
 
 void CTextureImage::generateMipmaps(std::string rainbowCheckerboardTexturePath, VkImageUsageFlags usage){ //rainbow mipmaps case
-    if(m_mipLevels <= 1) return;
+    if(m_mipLevels <= 1 || m_bMipsLoaded) return;
 
 	std::array<CWxjImageBuffer, MIPMAP_TEXTURE_COUNT> tmpTextureBufferForRainbowMipmaps;//create temp mipmaps
 	for (int i = 0; i < MIPMAP_TEXTURE_COUNT; i++) {//fill temp mipmaps
@@ -0,0 +1,340 @@
+#include "../include/textureStreamer.h"
+
+#include "../../thirdparty/stb_image.h"
+
+CTextureStreamer::CTextureStreamer(){}
+CTextureStreamer::~CTextureStreamer(){}
+
+void CTextureStreamer::Init(CTextureManager *pTextureManager, CRenderer *pRenderer, VkDeviceSize budgetBytes){
+    m_pTextureManager = pTextureManager;
+    m_pRenderer = pRenderer;
+    budget = budgetBytes;
+
+    //placeholder: 1x1 grey, sampled by textures whose file could not be read
+    uint8_t grey[4] = {128, 128, 128, 255};
+    m_placeholder.createImage(1, 1, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    m_placeholder.createImageView(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1, false);
+    m_pRenderer->uploadService.UploadImage(grey, sizeof(grey), m_placeholder.image, 1, 1, 1, VK_IMAGE_LAYOUT_GENERAL);
+    m_pRenderer->uploadService.Flush();
+
+    m_loader = std::thread(&CTextureStreamer::LoaderLoop, this);
+
+    std::cout<<"Texture streaming: budget "<<(budget >> 20)<<" MB"<<std::endl;
+}
+
+void CTextureStreamer::Destroy(){
+    if(!m_pTextureManager) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bQuit = true;
+    }
+    m_cv.notify_one();
+    if(m_loader.joinable()) m_loader.join();
+
+    //uploads may still reference the images below
+    m_pRenderer->uploadService.Flush();
+
+    for(auto &result : m_results) result.full.destroy();
+    for(auto &result : m_uploading) result.full.destroy();
+    for(auto &retired : m_retired) retired.image.destroy();
+    for(auto &entry : m_entries) entry.tail.destroy(); //full images are owned by CTextureImage and destroyed by CTextureManager
+    m_placeholder.destroy();
+    m_results.clear();
+    m_uploading.clear();
+    m_retired.clear();
+
+    std::cout<<"Texture streaming: "<<streamedInCount<<" stream-ins, "<<evictedCount<<" evictions"<<std::endl;
+    m_pTextureManager = nullptr;
+}
+
+int CTextureStreamer::AddTexture(const std::string texturePath, VkImageUsageFlags usage, int miplevel, int sampler_id, VkFormat imageFormat){
+    CTextureImage textureImage;
+    textureImage.m_imageFormat = imageFormat;
+    textureImage.m_mipLevels = miplevel;
+    textureImage.m_usage = usage;
+    textureImage.m_sampler_id = sampler_id;
+    textureImage.m_texBptpc = 8;
+    textureImage.m_bStreaming = true;
+    textureImage.m_texturePath = texturePath;
+    textureImage.m_textureImageBuffer = m_placeholder;
+    textureImage.m_textureImageBuffer.size = 0; //borrowed, CTextureImage::Destroy must not free it
+    m_pTextureManager->textureImages.push_back(textureImage);
+
+    Entry entry;
+    entry.textureId = (int)m_pTextureManager->textureImages.size() - 1;
+    entry.mipLevels = (uint32_t)std::max(miplevel, 1);
+    try{
+        LoadTail(entry, texturePath, imageFormat, usage);
+        entry.state = TAIL;
+    }catch(const std::exception &e){
+        m_pTextureManager->logManager.error("Stream texture %s failed: %s", texturePath, std::string(e.what()));
+    }
+    m_entries.push_back(entry);
+    if(entry.state == TAIL) SetView(m_entries.back(), m_entries.back().tail, false);
+
+    m_pTextureManager->logManager.print("Register streamed texture %s", texturePath);
+    return entry.textureId;
+}
+
+/*******************
+*	Render thread
+********************/
+void CTextureStreamer::Update(){
+    if(!m_pTextureManager) return;
+    PROFILE_SCOPE("texture streaming");
+    uint64_t frameNumber = m_pRenderer->frameNumber;
+    std::vector<CTextureImage> &textureImages = m_pTextureManager->textureImages;
+
+    //Step 1: destroy images that no frame in flight can still sample
+    for(int i = (int)m_retired.size() - 1; i >= 0; i--){
+        if(frameNumber >= m_retired[i].frameNumber + MAX_FRAMES_IN_FLIGHT){
+            CGraphicsDescriptorManager::descriptorCache.EvictImageView(m_retired[i].image.view); //its sampler sets can be reused
+            m_retired[i].image.destroy();
+            m_retired.erase(m_retired.begin() + i);
+        }
+    }
+
+    //Step 2: swap in finished loads once the graphics queue owns them
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto &result : m_results) m_uploading.push_back(result);
+        m_results.clear();
+    }
+    for(int i = (int)m_uploading.size() - 1; i >= 0; i--){
+        Result &result = m_uploading[i];
+        Entry &entry = m_entries[result.entry];
+        if(result.bFailed){
+            if(entry.state == RESIDENT) Evict(result.entry);
+            entry.state = FAILED; //keeps its tail
+            entry.bLoading = false;
+            m_uploading.erase(m_uploading.begin() + i);
+            continue;
+        }
+        if(!m_pRenderer->uploadService.IsReady(result.ticket)) continue;
+        if(entry.state == RESIDENT) residentBytes -= FullBytes(entry, entry.residentMip); //replaced by a finer one
+        entry.residentMip = result.firstMip;
+        SetView(entry, result.full, true);
+        entry.state = RESIDENT;
+        entry.bLoading = false;
+        residentBytes += FullBytes(entry, entry.residentMip);
+        streamedInCount++;
+        m_uploading.erase(m_uploading.begin() + i);
+    }
+
+    //Step 3: request the mip that matches last frame's on-screen size when the resident image is coarser,
+    //evicting least recently drawn textures (or those small enough on screen for their tail) to stay in budget
+    auto isDrawn = [&](const Entry &entry){ //m_lastUsedFrame is frameNumber + 1 of the draw
+        uint64_t lastUsedFrame = textureImages[entry.textureId].m_lastUsedFrame;
+        return lastUsedFrame != 0 && lastUsedFrame + 1 >= frameNumber;
+    };
+    VkDeviceSize loadingBytes = 0;
+    for(auto &entry : m_entries) if(entry.bLoading) loadingBytes += FullBytes(entry, entry.loadingMip);
+
+    std::vector<Request> requests;
+    for(size_t i = 0; i < m_entries.size(); i++){
+        Entry &entry = m_entries[i];
+        CTextureImage &texture = textureImages[entry.textureId];
+        if(entry.state == FAILED || entry.bLoading || !isDrawn(entry)) continue;
+        uint32_t mip = NeededMip(entry, texture.m_requestedSize);
+        if(mip >= entry.tailFirst) continue; //the tail is detailed enough
+        if(entry.state == RESIDENT && mip >= entry.residentMip) continue;
+        VkDeviceSize bytes = FullBytes(entry, mip);
+
+        while(residentBytes + loadingBytes + bytes > budget){
+            size_t lru = m_entries.size();
+            for(size_t j = 0; j < m_entries.size(); j++){
+                const Entry &candidate = m_entries[j];
+                if(j == i || candidate.state != RESIDENT || candidate.bLoading) continue;
+                if(isDrawn(candidate) && NeededMip(candidate, textureImages[candidate.textureId].m_requestedSize) < candidate.tailFirst) continue; //still needed
+                if(lru == m_entries.size() || textureImages[candidate.textureId].m_lastUsedFrame < textureImages[m_entries[lru].textureId].m_lastUsedFrame) lru = j;
+            }
+            if(lru == m_entries.size()) break;
+            Evict(lru);
+        }
+        if(residentBytes + loadingBytes + bytes > budget) continue;
+
+        Request request;
+        request.entry = i;
+        request.path = texture.m_texturePath;
+        request.format = texture.m_imageFormat;
+        request.usage = texture.m_usage;
+        request.firstMip = mip;
+        request.mipLevels = std::min(entry.mipLevels, ChainLevels(entry.width, entry.height) - mip);
+        requests.push_back(request);
+        entry.bLoading = true;
+        entry.loadingMip = mip;
+        loadingBytes += bytes;
+    }
+    if(!requests.empty()){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.insert(m_requests.end(), requests.begin(), requests.end());
+        }
+        m_cv.notify_one();
+    }
+}
+
+//bytes of the full image that starts at firstMip
+VkDeviceSize CTextureStreamer::FullBytes(const Entry &entry, uint32_t firstMip){
+    uint32_t levelCount = std::min(entry.mipLevels, ChainLevels(entry.width, entry.height) - firstMip);
+    VkDeviceSize bytes = 0;
+    for(uint32_t level = firstMip; level < firstMip + levelCount; level++)
+        bytes += (VkDeviceSize)std::max(entry.width >> level, 1) * std::max(entry.height >> level, 1) * 4;
+    return bytes;
+}
+
+//the smallest level that is still at least as large as the texture appears on screen
+uint32_t CTextureStreamer::NeededMip(const Entry &entry, float requestedSize){
+    uint32_t chainLevels = ChainLevels(entry.width, entry.height);
+    uint32_t mip = 0;
+    while(mip + 1 < chainLevels && std::max(entry.width >> (mip + 1), entry.height >> (mip + 1)) >= requestedSize) mip++;
+    return mip;
+}
+
+void CTextureStreamer::Evict(size_t entryIndex){
+    Entry &entry = m_entries[entryIndex];
+    residentBytes -= FullBytes(entry, entry.residentMip);
+    SetView(entry, entry.tail, false);
+    entry.state = TAIL;
+    evictedCount++;
+}
+
+void CTextureStreamer::SetView(Entry &entry, CWxjImageBuffer &image, bool bOwned){
+    CTextureImage &texture = m_pTextureManager->textureImages[entry.textureId];
+    if(texture.m_textureImageBuffer.size != 0) Retire(texture.m_textureImageBuffer); //owned full image
+    texture.m_textureImageBuffer = image;
+    if(!bOwned) texture.m_textureImageBuffer.size = 0;
+    texture.m_version++;
+}
+
+void CTextureStreamer::Retire(CWxjImageBuffer &image){
+    //sampler sets of the other frames in flight may still point at it until they are rewritten
+    Retired retired;
+    retired.image = image;
+    retired.frameNumber = m_pRenderer->frameNumber;
+    m_retired.push_back(retired);
+}
+
+/*******************
+*	Loader thread
+********************/
+//2x2 box filter, RGBA8
+static void DownsampleRGBA8(const uint8_t *src, int srcWidth, int srcHeight, uint8_t *dst, int dstWidth, int dstHeight){
+    for(int y = 0; y < dstHeight; y++){
+        int y0 = std::min(2 * y, srcHeight - 1), y1 = std::min(2 * y + 1, srcHeight - 1);
+        for(int x = 0; x < dstWidth; x++){
+            int x0 = std::min(2 * x, srcWidth - 1), x1 = std::min(2 * x + 1, srcWidth - 1);
+            for(int c = 0; c < 4; c++){
+                int sum = src[(y0 * srcWidth + x0) * 4 + c] + src[(y0 * srcWidth + x1) * 4 + c]
+                        + src[(y1 * srcWidth + x0) * 4 + c] + src[(y1 * srcWidth + x1) * 4 + c];
+                dst[(y * dstWidth + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void CTextureStreamer::LoaderLoop(){
+    PROFILE_THREAD("texture loader");
+    while(true){
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_bQuit || !m_requests.empty(); });
+            if(m_bQuit) break;
+            request = m_requests.front();
+            m_requests.erase(m_requests.begin());
+        }
+        try{
+            Load(request);
+        }catch(const std::exception &e){
+            //an exception leaving the thread would terminate the process: report it and let Update() keep the current view
+            m_pTextureManager->logManager.error("Stream texture %s failed: %s", request.path, std::string(e.what()));
+            Result result;
+            result.entry = request.entry;
+            result.bFailed = true;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_results.push_back(result);
+        }
+    }
+}
+
+//decode, then box filter down to levelCount levels (0: down to 1x1); offsets[i] is level i in texels
+void CTextureStreamer::BuildMipChain(const std::string &path, uint32_t levelCount, int &width, int &height, std::vector<uint8_t> &texels, std::vector<VkDeviceSize> &offsets){
+    CTextureImage source;
+    source.m_texBptpc = 8;
+    source.GetTexels(path);
+    width = source.m_texWidth;
+    height = source.m_texHeight;
+    uint32_t chainLevels = ChainLevels(width, height);
+    levelCount = (levelCount == 0) ? chainLevels : std::min(levelCount, chainLevels);
+
+    offsets.resize(levelCount);
+    VkDeviceSize totalSize = 0;
+    for(uint32_t i = 0; i < levelCount; i++){
+        offsets[i] = totalSize;
+        totalSize += (VkDeviceSize)std::max(width >> i, 1) * std::max(height >> i, 1) * 4;
+    }
+    texels.resize(totalSize);
+    memcpy(texels.data(), source.m_pTexels, (size_t)width * height * 4);
+    stbi_image_free(source.m_pTexels);
+    for(uint32_t i = 1; i < levelCount; i++)
+        DownsampleRGBA8(texels.data() + offsets[i-1], std::max(width >> (i-1), 1), std::max(height >> (i-1), 1),
+            texels.data() + offsets[i], std::max(width >> i, 1), std::max(height >> i, 1));
+}
+
+//create an image of levels [firstLevel, firstLevel + levelCount) of the chain (allocation is thread safe) and queue its upload
+uint64_t CTextureStreamer::UploadLevels(CWxjImageBuffer &image, const std::vector<uint8_t> &texels, const std::vector<VkDeviceSize> &offsets,
+    int width, int height, uint32_t firstLevel, uint32_t levelCount, VkFormat format, VkImageUsageFlags usage){
+    std::vector<VkBufferImageCopy> regions(levelCount);
+    for(uint32_t i = 0; i < levelCount; i++){
+        uint32_t level = firstLevel + i;
+        regions[i] = {};
+        regions[i].bufferOffset = offsets[level] - offsets[firstLevel];
+        regions[i].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+        regions[i].imageExtent = {(uint32_t)std::max(width >> level, 1), (uint32_t)std::max(height >> level, 1), 1};
+    }
+    image.createImage(std::max(width >> firstLevel, 1), std::max(height >> firstLevel, 1), levelCount, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+        usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    image.createImageView(format, VK_IMAGE_ASPECT_COLOR_BIT, levelCount, false);
+    VkDeviceSize end = (firstLevel + levelCount < offsets.size()) ? offsets[firstLevel + levelCount] : (VkDeviceSize)texels.size();
+    return m_pRenderer->uploadService.UploadImage(texels.data() + offsets[firstLevel], end - offsets[firstLevel], image.image,
+        regions, levelCount, 1, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+//render thread, at registration: the tail is uploaded before the first frame and never evicted
+void CTextureStreamer::LoadTail(Entry &entry, const std::string &path, VkFormat format, VkImageUsageFlags usage){
+    std::vector<uint8_t> texels;
+    std::vector<VkDeviceSize> offsets;
+    BuildMipChain(path, 0, entry.width, entry.height, texels, offsets);
+    entry.tailFirst = 0;
+    while(std::max(entry.width >> entry.tailFirst, entry.height >> entry.tailFirst) > (int)TAIL_SIZE) entry.tailFirst++; //a texture smaller than the tail is its own tail
+    UploadLevels(entry.tail, texels, offsets, entry.width, entry.height, entry.tailFirst, (uint32_t)offsets.size() - entry.tailFirst, format, usage);
+    m_pRenderer->uploadService.Flush();
+}
+
+void CTextureStreamer::Load(Request &request){
+    PROFILE_SCOPE("texture load");
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    int width = 0, height = 0;
+    std::vector<uint8_t> texels;
+    std::vector<VkDeviceSize> offsets;
+    BuildMipChain(request.path, request.firstMip + request.mipLevels, width, height, texels, offsets);
+
+    Result result;
+    result.entry = request.entry;
+    result.firstMip = request.firstMip;
+    result.ticket = UploadLevels(result.full, texels, offsets, width, height, request.firstMip, request.mipLevels, request.format, request.usage);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.push_back(result);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    float durationTime = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count() * 1000;
+    m_pTextureManager->logManager.print("Stream texture %s from mip %d", request.path, (int)request.firstMip);
+    m_pTextureManager->logManager.print("\tdecode and mips cost %f milliseconds", durationTime);
+}
@@ -0,0 +1,385 @@
+#include "../include/uploadService.h"
+#include "../include/metrics.h"
+
+//jobs queued and not yet usable on the graphics queue
+static CMetrics::Gauge &QueueDepthGauge(){ static CMetrics::Gauge &gauge = CMetrics::GetGauge("upload_queue_depth", "Upload jobs not yet ready for the graphics queue"); return gauge; }
+
+CUploadService::CUploadService(){}
+CUploadService::~CUploadService(){}
+
+void CUploadService::Init(){
+    m_graphicsFamily = CContext::GetHandle().physicalDevice->get()->getGraphicsQueueFamily();
+    VkQueue transferQueue = CContext::GetHandle().physicalDevice->get()->getTransferQueue();
+    bDedicatedTransferQueue = (transferQueue != VK_NULL_HANDLE);
+    if(bDedicatedTransferQueue){
+        m_queue = transferQueue;
+        m_queueFamily = CContext::GetHandle().physicalDevice->get()->getTransferQueueFamily();
+    }else{
+        m_queue = CContext::GetHandle().GetGraphicsQueue();
+        m_queueFamily = m_graphicsFamily;
+    }
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_queueFamily;
+    VkResult result = vkCreateCommandPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &m_commandPool);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create transfer command pool!");
+    if(bDedicatedTransferQueue){
+        poolInfo.queueFamilyIndex = m_graphicsFamily;
+        result = vkCreateCommandPool(CContext::GetHandle().GetLogicalDevice(), &poolInfo, nullptr, &m_acquirePool);
+        if (result != VK_SUCCESS) throw std::runtime_error("failed to create upload acquire command pool!");
+    }
+
+    //the transfer queue and its pool are only used by the worker, so they need no further locking
+    if(bDedicatedTransferQueue) m_worker = std::thread(&CUploadService::WorkerLoop, this);
+
+    std::cout<<"Upload service: "<<(bDedicatedTransferQueue ? "transfer" : "graphics")<<" queue family "<<m_queueFamily<<std::endl;
+}
+
+void CUploadService::Destroy(){
+    if(m_commandPool == VK_NULL_HANDLE) return;
+
+    if(m_worker.joinable()){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bQuit = true;
+        }
+        m_cv.notify_one();
+        m_worker.join(); //worker submits what is left and waits for it before it exits
+    }else Flush();
+    RetireAcquires(true);
+
+    for(auto &job : m_pendingJobs) job.staging.DestroyAndFree();
+    m_pendingJobs.clear();
+    m_pendingAcquires.clear();
+
+    vkDestroyCommandPool(CContext::GetHandle().GetLogicalDevice(), m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+    if(m_acquirePool != VK_NULL_HANDLE) vkDestroyCommandPool(CContext::GetHandle().GetLogicalDevice(), m_acquirePool, nullptr);
+    m_acquirePool = VK_NULL_HANDLE;
+
+    std::cout<<"Upload service: "<<submittedBatches<<" batches, "<<uploadedBytes<<" bytes"<<std::endl;
+}
+
+/*******************
+*	Jobs
+********************/
+uint64_t CUploadService::UploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset){
+    Job job{};
+    job.size = size;
+    job.bImage = false;
+    job.dstBuffer = dstBuffer;
+    job.dstOffset = dstOffset;
+    QueueJob(job, data);
+    return job.ticket;
+}
+
+uint64_t CUploadService::UploadImage(const void *texels, VkDeviceSize size, VkImage dstImage, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout){
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+    return UploadImage(texels, size, dstImage, {region}, mipLevels, 1, finalLayout);
+}
+
+uint64_t CUploadService::UploadImage(const void *texels, VkDeviceSize size, VkImage dstImage, const std::vector<VkBufferImageCopy> &regions, uint32_t mipLevels, uint32_t layerCount, VkImageLayout finalLayout){
+    Job job{};
+    job.size = size;
+    job.bImage = true;
+    job.dstImage = dstImage;
+    job.regions = regions;
+    job.mipLevels = mipLevels;
+    job.layerCount = layerCount;
+    job.finalLayout = finalLayout;
+    QueueJob(job, texels);
+    return job.ticket;
+}
+
+void CUploadService::QueueJob(Job &job, const void *data){
+    //fill the staging buffer on the calling thread, so loader threads do the memcpy and not the worker
+    PROFILE_SCOPE("upload staging");
+    PROFILE_COUNTER("bytes uploaded", job.size);
+    static CMetrics::Counter &uploadedBytesCounter = CMetrics::GetCounter("upload_bytes_total", "Bytes queued on the upload service");
+    uploadedBytesCounter.Add(job.size);
+    job.staging.init(job.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    void *pGpuMemory;
+    vkMapMemory(CContext::GetHandle().GetLogicalDevice(), job.staging.deviceMemory, 0, job.size, 0, &pGpuMemory);
+    memcpy(pGpuMemory, data, (size_t)job.size);
+    vkUnmapMemory(CContext::GetHandle().GetLogicalDevice(), job.staging.deviceMemory);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        job.ticket = ++m_nextTicket;
+        m_pendingJobs.push_back(job);
+    }
+    QueueDepthGauge().Add(1);
+    m_cv.notify_one();
+}
+
+void CUploadService::Flush(){
+    uint64_t lastTicket;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        lastTicket = m_nextTicket;
+    }
+    if(bDedicatedTransferQueue){
+        while(m_completedTicket.load() < lastTicket) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        SubmitAcquires();
+        RetireAcquires(true);
+    }else{
+        Poll();
+        RetireBatches(true);
+    }
+}
+
+/*******************
+*	Submission
+********************/
+void CUploadService::WorkerLoop(){
+    PROFILE_THREAD("upload worker");
+    while(true){
+        std::vector<Job> jobs;
+        bool bQuit;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto hasWork = [this]{ return m_bQuit || !m_pendingJobs.empty(); };
+            //while batches are in flight, wake up regularly to retire them
+            if(m_inFlightBatches.empty()) m_cv.wait(lock, hasWork);
+            else m_cv.wait_for(lock, std::chrono::milliseconds(1), hasWork);
+            jobs.swap(m_pendingJobs);
+            bQuit = m_bQuit;
+            if(bQuit && jobs.empty() && m_inFlightBatches.empty()) break;
+        }
+        if(!jobs.empty()) SubmitBatch(jobs);
+        RetireBatches(bQuit);
+    }
+}
+
+void CUploadService::Poll(){
+    if(bDedicatedTransferQueue){
+        SubmitAcquires();
+        RetireAcquires(false);
+        return;
+    }
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        jobs.swap(m_pendingJobs);
+    }
+    if(!jobs.empty()) SubmitBatch(jobs);
+    RetireBatches(false);
+}
+
+void CUploadService::FillOwnershipBarrier(const Job &job, bool bRelease, VkBufferMemoryBarrier &bufferBarrier, VkImageMemoryBarrier &imageBarrier){
+    //release and acquire must describe the same transfer: same families, same range, same layouts
+    if(job.bImage){
+        imageBarrier = {};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrier.newLayout = job.finalLayout;
+        imageBarrier.srcQueueFamilyIndex = m_queueFamily;
+        imageBarrier.dstQueueFamilyIndex = m_graphicsFamily;
+        imageBarrier.image = job.dstImage;
+        imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = job.mipLevels;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = job.layerCount;
+        imageBarrier.srcAccessMask = bRelease ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+        imageBarrier.dstAccessMask = bRelease ? 0 : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        if(m_queueFamily == m_graphicsFamily){ //plain layout transition
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        }
+    }else{
+        bufferBarrier = {};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcQueueFamilyIndex = m_queueFamily;
+        bufferBarrier.dstQueueFamilyIndex = m_graphicsFamily;
+        bufferBarrier.buffer = job.dstBuffer;
+        bufferBarrier.offset = job.dstOffset;
+        bufferBarrier.size = job.size;
+        bufferBarrier.srcAccessMask = bRelease ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+        bufferBarrier.dstAccessMask = bRelease ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        if(m_queueFamily == m_graphicsFamily){
+            bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            bufferBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        }
+    }
+}
+
+VkCommandBuffer CUploadService::BeginBatch(VkCommandPool pool){
+    VkCommandBuffer commandBuffer;
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(CContext::GetHandle().GetLogicalDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate upload command buffer!");
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+void CUploadService::EndBatch(Batch &batch, VkQueue queue){
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(CContext::GetHandle().GetLogicalDevice(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload fence!");
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, batch.fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to submit upload command buffer!");
+}
+
+void CUploadService::SubmitBatch(std::vector<Job> &jobs){
+    PROFILE_SCOPE("upload submit");
+    Batch batch;
+    batch.jobs.swap(jobs);
+    batch.lastTicket = batch.jobs.back().ticket;
+    batch.commandBuffer = BeginBatch(m_commandPool);
+
+    //Step 1: images to TRANSFER_DST (contents are discarded, so no ownership is needed yet)
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for(auto &job : batch.jobs){
+        if(!job.bImage) continue;
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = job.dstImage;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, job.mipLevels, 0, job.layerCount};
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarriers.push_back(barrier);
+    }
+    if(!imageBarriers.empty())
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    //Step 2: copies
+    for(auto &job : batch.jobs){
+        if(job.bImage){
+            vkCmdCopyBufferToImage(batch.commandBuffer, job.staging.buffer, job.dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(job.regions.size()), job.regions.data());
+        }else{
+            VkBufferCopy region{};
+            region.srcOffset = 0;
+            region.dstOffset = job.dstOffset;
+            region.size = job.size;
+            vkCmdCopyBuffer(batch.commandBuffer, job.staging.buffer, job.dstBuffer, 1, &region);
+        }
+        uploadedBytes += job.size;
+    }
+
+    //Step 3: release to the graphics family (or just transition, if this is the graphics queue)
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    imageBarriers.clear();
+    for(auto &job : batch.jobs){
+        VkBufferMemoryBarrier bufferBarrier;
+        VkImageMemoryBarrier imageBarrier;
+        FillOwnershipBarrier(job, m_queueFamily != m_graphicsFamily, bufferBarrier, imageBarrier);
+        if(job.bImage) imageBarriers.push_back(imageBarrier);
+        else bufferBarriers.push_back(bufferBarrier);
+    }
+    VkPipelineStageFlags dstStage = (m_queueFamily != m_graphicsFamily) ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    EndBatch(batch, m_queue);
+    submittedBatches++;
+    m_inFlightBatches.push_back(std::move(batch));
+}
+
+void CUploadService::RetireBatches(bool bWait){
+    //retire in submission order, so m_completedTicket only moves forward
+    while(!m_inFlightBatches.empty()){
+        Batch &batch = m_inFlightBatches.front();
+        if(bWait) vkWaitForFences(CContext::GetHandle().GetLogicalDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        else if(vkGetFenceStatus(CContext::GetHandle().GetLogicalDevice(), batch.fence) != VK_SUCCESS) break;
+
+        for(auto &job : batch.jobs) job.staging.DestroyAndFree();
+        vkDestroyFence(CContext::GetHandle().GetLogicalDevice(), batch.fence, nullptr);
+        vkFreeCommandBuffers(CContext::GetHandle().GetLogicalDevice(), m_commandPool, 1, &batch.commandBuffer);
+
+        if(m_queueFamily != m_graphicsFamily){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pendingAcquires.insert(m_pendingAcquires.end(), batch.jobs.begin(), batch.jobs.end());
+        }else{
+            m_readyTicket.store(batch.lastTicket);
+            QueueDepthGauge().Add(-(int64_t)batch.jobs.size());
+        }
+        m_completedTicket.store(batch.lastTicket);
+
+        m_inFlightBatches.erase(m_inFlightBatches.begin());
+    }
+}
+
+void CUploadService::SubmitAcquires(){
+    if(m_queueFamily == m_graphicsFamily) return;
+
+    Batch batch;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_pendingAcquires.empty()) return;
+        batch.jobs.swap(m_pendingAcquires);
+    }
+
+    //own command buffer instead of the frame's: pre-recorded frame command buffers would replay the barriers on every submit.
+    //The release was already observed through the fence, so the acquire needs no semaphore
+    PROFILE_SCOPE("upload acquire");
+    batch.commandBuffer = BeginBatch(m_acquirePool);
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    batch.lastTicket = 0;
+    for(auto &job : batch.jobs){
+        VkBufferMemoryBarrier bufferBarrier;
+        VkImageMemoryBarrier imageBarrier;
+        FillOwnershipBarrier(job, false, bufferBarrier, imageBarrier);
+        if(job.bImage) imageBarriers.push_back(imageBarrier);
+        else bufferBarriers.push_back(bufferBarrier);
+        batch.lastTicket = std::max(batch.lastTicket, job.ticket);
+    }
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    EndBatch(batch, CContext::GetHandle().GetGraphicsQueue());
+    m_acquireBatches.push_back(std::move(batch));
+}
+
+void CUploadService::RetireAcquires(bool bWait){
+    //a ticket is ready only when the graphics queue executed its acquire
+    while(!m_acquireBatches.empty()){
+        Batch &batch = m_acquireBatches.front();
+        if(bWait) vkWaitForFences(CContext::GetHandle().GetLogicalDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        else if(vkGetFenceStatus(CContext::GetHandle().GetLogicalDevice(), batch.fence) != VK_SUCCESS) break;
+
+        vkDestroyFence(CContext::GetHandle().GetLogicalDevice(), batch.fence, nullptr);
+        vkFreeCommandBuffers(CContext::GetHandle().GetLogicalDevice(), m_acquirePool, 1, &batch.commandBuffer);
+        m_readyTicket.store(batch.lastTicket);
+        QueueDepthGauge().Add(-(int64_t)batch.jobs.size());
+
+        m_acquireBatches.erase(m_acquireBatches.begin());
+    }
+}